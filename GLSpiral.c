@@ -125,14 +125,70 @@ void SaveCases(const Array_Triangle* tris) {
 	fclose(f);
 }
 
+typedef struct Config {
+	u32 ScreenWidth, ScreenHeight;
+	u32 FPS;
+} Config;
+
+// Read conf.json a little at a time, anything that isn't a setting we know is skipped.
+Config LoadConfig(const char* filename) {
+	Config conf = {1280, 720, 60};
+
+	FILE* f = fopen(filename, "r");
+	if(!f) {
+		Log(WARN, "Config file %s couldn't be opened, using defaults.", filename);
+		return conf;
+	}
+
+	static JSON_Reader r;
+	JSON_Reader_InitStream(&r);
+
+	char buf[256];
+	u32* setting = NULL;
+
+	while(1) {
+		enum JSON_Event e = JSON_Reader_Next(&r);
+
+		if(e == JSON_Event_NeedInput) {
+			u32 n = fread(buf, 1, sizeof(buf), f);
+			JSON_Reader_Feed(&r, buf, n, n < sizeof(buf));
+			continue;
+		}
+
+		if(e == JSON_Event_End || e == JSON_Event_Error) break;
+
+		if(r.Depth == 1 && e == JSON_Event_Key) {
+			if(JSON_Reader_StringIs(&r, "ScreenWidth"))
+				setting = &conf.ScreenWidth;
+			else if(JSON_Reader_StringIs(&r, "ScreenHeight"))
+				setting = &conf.ScreenHeight;
+			else if(JSON_Reader_StringIs(&r, "FPS"))
+				setting = &conf.FPS;
+			else
+				JSON_Reader_Skip(&r);
+		} else if(setting && e == JSON_Event_Number && r.Number > 0) {
+			*setting = r.Number;
+			setting  = NULL;
+		} else {
+			setting = NULL;
+		}
+	}
+
+	fclose(f);
+	return conf;
+}
+
 int main() {
 	u32 StartupTime = SDL_GetTicks();
 	srand(time(NULL));
 
 	Array_Triangle tris = LoadCases();
+	Config conf         = LoadConfig("conf.json");
+
+	RSys_Init(conf.ScreenWidth, conf.ScreenHeight);
+	RSys_SetFPSCap(conf.FPS);
 
-	RSys_Init(1280, 720);
-	RSys_SetFPSCap(60);
+	Job_Init(0);
 
 	RT def = RT_InitScreenSize();
 
@@ -367,6 +423,8 @@ end:
 	SaveCases(&tris);
 	Array_Triangle_Free(&tris);
 
+	// Textures still loading are waited on, so the workers have to outlive the renderer.
 	RSys_Quit();
+	Job_Shutdown();
 	Log(INFO, "[Main] Quit.", "");
 }
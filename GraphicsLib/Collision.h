@@ -37,16 +37,25 @@ struct AABB {
 	Vec3 Max;
 };
 
+// Both boxes have to be fixed, Min <= Max.
 bool8 AABB_Intersect(AABB a, AABB b);
 AABB AABB_Fix(AABB aabb);
 
-// Create a fitting AABB around a transformed one.
+// Create the tightest AABB around a transformed one.
 AABB AABB_ApplyTransform3D(AABB aabb, Transform3D t);
+AABB AABB_ApplyMat4(AABB aabb, const Mat4 m);
+
+// Transform many boxes at once. The strides are in bytes, so the boxes
+// and transforms can be fields inside of bigger structs.
+void AABB_ApplyTransform3D_N(const AABB* boxes, u32 boxStride,
+                             const Transform3D* transforms, u32 transformStride,
+                             AABB* out, u32 count);
 
 // Generate a sum AABB around two others.
 AABB AABB_Add(AABB a, AABB b);
 
-// Oriented bounding box
+// Oriented bounding box, an AABB in the local space of a transform.
+// A NULL transform means the box is already in world space.
 struct OBB {
 	AABB aabb;
 	Transform3D* transform;
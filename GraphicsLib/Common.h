@@ -37,6 +37,7 @@ typedef i32 bool32; // 32-bit boolean
 // Memory management
 //
 
+// With ALLOC_DEBUG every allocation gets tracked, safely from job workers too.
 u32 Alloc_GetTotalSize();
 void Alloc_PrintInfo();
 void Alloc_FreeAll();
@@ -64,6 +65,8 @@ i32 String_ToI32_N(const char*, u32 len);
 r32 String_ToR32(const char*);
 r32 String_ToR32_N(const char*, u32 len);
 
+r64 String_ToR64_N(const char*, u32 len);
+
 //
 // Pi, degrees and radians
 //
@@ -126,6 +129,13 @@ i32 File_ReadToBuffer(const char* filename, u8* buf, u32 bufSize, u32* realSize)
 // Dump the contents of a buffer to a file.
 void File_DumpBuffer(const char* filename, const u8* buf, u32 bufSize);
 
+// Map a whole file into memory as read-only, without copying it.
+// Returns NULL if the file can't be opened or is empty.
+const u8* File_Map(const char* filename, u32* outSize);
+
+// Release a mapping made by File_Map().
+void File_Unmap(const u8* data, u32 size);
+
 //
 // Array
 //
@@ -273,6 +283,9 @@ u128 Hash_String_MD5(const char* str);
 // Compare two hashes for equality.
 bool8 Hash_Equal(const u128* a, const u128* b);
 
+// Compute the 64-bit FNV-1a hash of an array of bytes, much cheaper than MD5.
+u64 Hash_FNV1a(const u8* bytes, u32 length);
+
 // Create a struct and prototype functions for a hashmap type HashMap_##name.
 #define DEF_HASHMAP(name, type)                                                               \
 	typedef struct HashMap_##name HashMap_##name;                                             \
@@ -368,6 +381,90 @@ DEF_HASHMAP(i16, i16);
 DEF_HASHMAP(i32, i32);
 DEF_HASHMAP(i64, i64);
 
+//
+// Arena
+//
+
+// Hands out memory from big blocks and frees all of it at once.
+// Good for lots of small allocations that all die together.
+typedef struct Arena Arena;
+typedef struct Arena_Block Arena_Block;
+
+struct Arena {
+	Arena_Block* Blocks; // Newest first
+	u32 BlockSize;
+};
+
+void Arena_Init(Arena* a, u32 blockSize);
+void* Arena_Alloc(Arena* a, u32 size); // Aligned to 8 bytes.
+void Arena_Reset(Arena* a);            // Forget every allocation but keep one block around.
+void Arena_Free(Arena* a);             // Give all of the memory back.
+
+//
+// Jobs
+//
+
+// A pool of worker threads that run small functions (jobs) in parallel.
+// Every thread has its own queue that it pushes to and pops from at the back,
+// threads that run out of work steal from the front of somebody else's.
+// Thank you,
+// https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+//
+// The thread that calls Job_Init() gets a queue too, and runs jobs while it waits for them.
+// Before Job_Init(), and on threads that aren't part of the pool, jobs just run right away,
+// so code that uses jobs works the same with or without the workers.
+
+#define JOB_MAX_THREADS 64
+#define JOB_QUEUE_SIZE  1024 // Jobs per thread, more than that and they run right away.
+
+typedef void (*Job_Func)(void* data);
+typedef void (*Job_ForFunc)(void* data, u32 begin, u32 end);
+
+typedef struct Job Job;
+typedef struct Job_Counter Job_Counter;
+
+// How many jobs haven't finished yet. Start it at zero,
+// and keep it around until it gets back to zero.
+struct Job_Counter {
+	volatile i32 Value;
+	Job* Waiting; // Jobs that start once Value gets to zero.
+};
+
+void Job_Init(u32 numWorkers); // 0 starts one worker for every core but this one.
+void Job_Shutdown();           // Stop the workers, wait for everything first.
+u32 Job_NumThreads();          // The workers and the thread that started them.
+
+// Queue up func(data). The counter goes up by one right away and back down when
+// the job is done, it can be NULL.
+void Job_Run(Job_Func func, void* data, Job_Counter* counter);
+
+// Same as Job_Run(), but the job only starts once `dependency` gets to zero.
+void Job_RunAfter(Job_Counter* dependency, Job_Func func, void* data, Job_Counter* counter);
+
+// Run other jobs until the counter gets to zero.
+void Job_Wait(Job_Counter* counter);
+
+// Check whether the counter got to zero, without waiting for it.
+bool8 Job_IsDone(Job_Counter* counter);
+
+// Start it at zero. Lazy setup that any thread might get to first goes through Job_RunOnce().
+typedef volatile i32 Job_Once;
+
+// Run func(data) the first time this is called on `once`. Threads that get here while it's
+// running wait for it, and everything it wrote is there for them once it returns.
+void Job_RunOnce(Job_Once* once, Job_Func func, void* data);
+
+// Start it at zero, it works before Job_Init() too. Only for keeping other threads out of
+// code that isn't thread safe, waiting threads just yield and don't run jobs meanwhile.
+typedef volatile i32 Job_Mutex;
+
+void Job_Lock(Job_Mutex* mutex);
+void Job_Unlock(Job_Mutex* mutex);
+
+// Split [0, count) into pieces no longer than `batch` and run func() on all of them in parallel,
+// returns once they're all done. With a batch of 0 every thread gets a few pieces.
+void Job_ParallelFor(u32 count, u32 batch, Job_ForFunc func, void* data);
+
 //
 // Size units
 //
@@ -4,16 +4,21 @@
 #include "Common.h"
 #include "Math3D.h"
 
-// TODO: Finish reading the spec
-//       (https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#concepts)
+// Loader for glTF 2.0 assets, both .gltf (JSON) and .glb (binary).
+// (https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#concepts)
 //
 // The units for all linear distances are meters.
 // All angles are in radians.
 // Positive rotation is counterclockwise.
+//
+// .glb files and external .bin buffers are mapped into memory and never copied,
+// accessors point straight into them. Everything stays valid until GLTF_Free().
 
 typedef struct GLTF_Accessor GLTF_Accessor;
 typedef struct GLTF_BufferView GLTF_BufferView;
 typedef struct GLTF_Buffer GLTF_Buffer;
+typedef struct GLTF_Primitive GLTF_Primitive;
+typedef struct GLTF_Mesh GLTF_Mesh;
 typedef struct GLTF_Node GLTF_Node;
 typedef struct GLTF_Scene GLTF_Scene;
 typedef struct GLTF_Asset GLTF_Asset;
@@ -21,6 +26,7 @@ typedef struct GLTF_Asset GLTF_Asset;
 struct GLTF_Accessor {
 	const char* name;
 
+	// NULL if the accessor is all zeroes.
 	GLTF_BufferView* bufferView;
 	u32 byteOffset;
 
@@ -67,13 +73,39 @@ struct GLTF_BufferView {
 	GLTF_Buffer* buffer;
 	u32 offset;
 	u32 length;
+	u32 stride; // 0 means the elements are tightly packed.
 	u32 target;
 };
 
 struct GLTF_Buffer {
 	const char* name;
 	u32 size;
-	u8* data;
+	const u8* data;
+
+	// Where `data` came from, so GLTF_Free() knows how to let go of it.
+	enum {
+		Storage_GLB,       // Inside the .glb's BIN chunk
+		Storage_Mapped,    // A mapped external file
+		Storage_Allocated, // Decoded from a data: URI
+	} storage;
+};
+
+struct GLTF_Primitive {
+	// Any of these may be NULL if the primitive doesn't have them.
+	GLTF_Accessor* position;
+	GLTF_Accessor* normal;
+	GLTF_Accessor* texCoord;
+	GLTF_Accessor* indices;
+
+	u32 mode;     // Same values as GL_POINTS, GL_LINES, GL_TRIANGLES, etc.
+	i32 material; // -1 if there's none.
+};
+
+struct GLTF_Mesh {
+	const char* name;
+
+	u32 numPrimitives;
+	GLTF_Primitive* primitives;
 };
 
 struct GLTF_Node {
@@ -82,17 +114,23 @@ struct GLTF_Node {
 
 	const char* name;
 
+	// NULL if the node is just a transform.
+	GLTF_Mesh* mesh;
+
 	enum { Transform_TRS, Transform_Mat4 } transformType;
 
 	union {
 		// Translation, rotation, scale
 		Transform3D trs;
-		// A 4x4 matrix
+		// A 4x4 matrix, already converted to row major.
 		Mat4 matrix;
 	};
 };
 
 struct GLTF_Scene {
+	const char* name;
+
+	u32 numRootNodes;
 	GLTF_Node** rootNodes;
 };
 
@@ -102,14 +140,39 @@ struct GLTF_Scene {
 struct GLTF_Asset {
 	u32 numScenes;
 	u32 numNodes;
+	u32 numMeshes;
+	u32 numAccessors;
+	u32 numBufferViews;
+	u32 numBuffers;
 
 	GLTF_Scene* scenes;
 	GLTF_Node* nodes;
+	GLTF_Mesh* meshes;
+	GLTF_Accessor* accessors;
+	GLTF_BufferView* bufferViews;
+	GLTF_Buffer* buffers;
 
-	// Scene to show after loading has finished.
+	// Scene to show after loading has finished, may be NULL.
 	GLTF_Scene* firstScene;
+
+	// The mapped file itself, .glb buffers point inside of it.
+	const u8* file;
+	u32 fileSize;
 };
 
 GLTF_Asset* GLTF_LoadFile(const char* filename);
+void GLTF_Free(GLTF_Asset* asset);
+
+// Number of components in one element (1 for scalars, 3 for Vec3, 16 for Mat4...)
+u32 GLTF_Accessor_NumComponents(const GLTF_Accessor* a);
+
+// Size of a single element, in bytes.
+u32 GLTF_Accessor_ElementSize(const GLTF_Accessor* a);
+
+// Distance between elements, in bytes.
+u32 GLTF_Accessor_Stride(const GLTF_Accessor* a);
+
+// Pointer to the first element, or NULL if the accessor has no buffer view.
+const u8* GLTF_Accessor_Data(const GLTF_Accessor* a);
 
 #endif
@@ -0,0 +1,119 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "Common.h"
+
+//
+// Images on the CPU
+//
+
+// Getting pixels ready before they go to the GPU: mipmaps, block compression and KTX files.
+// Nothing in here needs a GL context, so tools can use it too (see tools/TexCook.c).
+
+#define IMAGE_MAX_LEVELS 16 // Enough mip levels for 32768x32768.
+
+enum Image_Format {
+	ImageFormat_R8,    // One channel, a byte each.
+	ImageFormat_RG8,   // Two channels, a byte each.
+	ImageFormat_RGBA8, // Four channels, a byte each.
+
+	// Compressed in 4x4 blocks, they're called the same in D3D.
+	ImageFormat_BC1, // RGB and 1-bit alpha, 8 bytes a block.
+	ImageFormat_BC3, // RGBA, 16 bytes a block.
+	ImageFormat_BC4, // One channel, 8 bytes a block.
+	ImageFormat_BC5, // Two channels, 16 bytes a block.
+
+	ImageFormat_Count
+};
+
+// How many bytes one level of an image takes up.
+u32 Image_Size(enum Image_Format format, u32 width, u32 height);
+
+// Turn RGBA8 pixels into `format`. One and two channel formats take red and green,
+// anything that wants a different channel has to be shuffled around first.
+// Blocks are encoded in parallel if there are job workers.
+void Image_Encode(enum Image_Format format, const u8* rgba, u32 width, u32 height, u8* out);
+
+//
+// Mipmaps
+//
+
+// Made on the CPU so they can be made on job workers, filtered better than glGenerateMipmap()
+// does, and compressed along with the rest of the image.
+
+enum Image_MipFilter {
+	ImageMipFilter_Box,    // Averages 2x2 pixels, cheap but blurry.
+	ImageMipFilter_Kaiser, // Windowed sinc, keeps more detail. Sharp edges ring a little.
+};
+
+typedef struct Image_MipOptions Image_MipOptions;
+
+struct Image_MipOptions {
+	enum Image_MipFilter Filter;
+
+	// The colour channels are sRGB, so they get averaged as linear light and converted back.
+	// Alpha never is.
+	bool8 SRGB;
+
+	// For alpha tested cutouts, 0 for blended alpha. Each level's alpha gets scaled so that
+	// as many of its pixels are above the cutoff as in the full size image, otherwise
+	// leaves and fences fade away in the distance.
+	r32 AlphaCutoff;
+};
+
+// How many levels it takes to get an image down to 1x1, at most IMAGE_MAX_LEVELS.
+u32 Image_NumLevels(u32 width, u32 height);
+
+// Make levels 1 to numLevels - 1 from the image in levels[0]. Each one is half the size of
+// the one before, rounded down but never below 1. Pixels are `channels` bytes, and only the
+// 4th one is alpha. The new levels are allocated and have to be freed.
+// Rows get filtered in parallel if there are job workers.
+// Returns 0, with no levels made, if the image is too big or memory runs out.
+bool8 Image_GenMips(u8** levels, u32 width, u32 height, u32 channels, u32 numLevels, const Image_MipOptions* options);
+
+//
+// KTX
+//
+
+// Textures with all of their mip levels, ready to go to GL without decoding anything.
+// Only the first version of the format, with plain 2D textures.
+
+typedef struct Image_KTX Image_KTX;
+
+struct Image_KTX {
+	// Straight from the file, these are GL's own enums. GLType is 0 for compressed formats.
+	u32 GLType, GLFormat, GLInternalFormat, GLBaseInternalFormat;
+
+	u32 Width, Height;
+	u32 NumLevels; // 0 means the file wants mipmaps generated when it's loaded.
+
+	const u8* Levels[IMAGE_MAX_LEVELS]; // Point into the file's data.
+	u32 LevelSizes[IMAGE_MAX_LEVELS];
+
+	// Bytes in a row of each level, with the padding to 4 bytes. Compressed levels have rows
+	// of 4x4 blocks, and 0 if the format isn't one of the BCn ones above.
+	u32 RowBytes[IMAGE_MAX_LEVELS];
+
+	// Where each channel comes from, "rgba" unless the file says otherwise.
+	// '0' and '1' are constants.
+	char Swizzle[4];
+};
+
+// Does the data start like a KTX file?
+bool8 Image_IsKTX(const u8* data, u32 size);
+
+// Check a KTX file and find its levels, returns 0 if it's broken or isn't a plain 2D texture.
+bool8 Image_ParseKTX(const u8* data, u32 size, Image_KTX* out);
+
+// Write levels in `format` into a KTX file, each one half the size of the one before.
+// `swizzle` can be NULL, returns 0 if the file couldn't be written.
+bool8 Image_WriteKTX(const char* filename,
+                     enum Image_Format format,
+                     bool8 srgb,
+                     const char* swizzle,
+                     u32 width,
+                     u32 height,
+                     u32 numLevels,
+                     const u8* const* levels);
+
+#endif
@@ -4,11 +4,10 @@
 #include "Common.h"
 
 typedef struct JSON_Value JSON_Value;
+typedef struct JSON_Member JSON_Member;
 
-DEF_ARRAY(Hash, u128);
-DEF_ARRAY(String, char *);
-DEF_ARRAY(JSON_Value, JSON_Value);
-DEF_HASHMAP(JSON_Value, JSON_Value);
+// Objects with more members than this get a hash index for JSON_ObjectFind().
+#define JSON_INDEX_THRESHOLD 16
 
 struct JSON_Value {
 	enum {
@@ -25,17 +24,38 @@ struct JSON_Value {
 	} Type;
 
 	union {
-		char* String;
-		r32   Number;
+		// Unescaped and NULL-terminated, may contain NULLs if the JSON had "\u0000".
+		struct {
+			char* String;
+			u32 StringLength;
+		};
+
+		r64   Number;
 		bool8 Boolean;
 
-		struct Array_JSON_Value Array;
+		struct {
+			JSON_Value* Data;
+			u32 Size;
+		} Array;
 
+		// Members are kept in the order they appear in.
 		struct {
-			Array_String       StringKeys;
-			HashMap_JSON_Value Map;
+			JSON_Member* Members;
+			u32 Size;
+
+			u32 IndexMask; // Index size - 1, the index is NULL for small objects.
+			u32* Index;    // Member index + 1, 0 means empty.
 		} Object;
 	};
+
+	// Only set on the root value, everything inside it comes from this arena.
+	Arena* Arena;
+};
+
+struct JSON_Member {
+	const char* Key;
+	u32 KeyLength;
+	JSON_Value Value;
 };
 
 JSON_Value* JSON_ObjectFind(const JSON_Value* object, const char* key); // Search an object for a given key.
@@ -44,6 +64,154 @@ JSON_Value JSON_FromString(const char* str);            // Parse JSON from a C s
 JSON_Value JSON_FromString_N(const char* str, u32 len); // Parse JSON from a C string with a specfied length.
 JSON_Value JSON_FromFile(const char* filename);         // Load a JSON file from disk.
 
+// Parse JSON without copying it, strings are unescaped in place and point inside `str`.
+// `str` has to outlive the result.
+JSON_Value JSON_ParseInSitu(char* str, u32 len);
+
 void JSON_Free(JSON_Value *v); // Free an allocated JSON structure.
 
+//
+// Streaming reader
+//
+
+// Pull-style reader, for when only a few fields out of a document are needed.
+// It never allocates and doesn't build anything, it just hands out one event at a time.
+// Input can be one whole buffer, or chunks that are fed in as they arrive.
+
+// Longest string, number or literal that can be split between two chunks,
+// and the longest string with escapes in it that can be unescaped.
+#define JSON_READER_CARRY_SIZE 4096
+#define JSON_READER_MAX_DEPTH  256
+
+typedef struct JSON_Reader JSON_Reader;
+
+enum JSON_Event {
+	JSON_Event_Error = -1,
+	JSON_Event_NeedInput, // Call JSON_Reader_Feed() with the next chunk.
+	JSON_Event_End,       // The document is over.
+
+	JSON_Event_BeginObject,
+	JSON_Event_EndObject,
+	JSON_Event_BeginArray,
+	JSON_Event_EndArray,
+
+	JSON_Event_Key,     // String and StringLength are set.
+	JSON_Event_String,  // String and StringLength are set.
+	JSON_Event_Number,  // Number is set.
+	JSON_Event_Boolean, // Boolean is set.
+	JSON_Event_Null,
+};
+
+struct JSON_Reader {
+	// The value of the last event. Strings are unescaped but not NULL terminated,
+	// and only stay valid until the next call.
+	const char* String;
+	u32 StringLength;
+	r64 Number;
+	bool8 Boolean;
+
+	u32 Depth; // How many objects and arrays are open.
+
+	// Internal state
+	const char* Curr;
+	const char* End;
+	bool8 LastChunk;
+
+	u8 State;
+	enum JSON_Event LastEvent;
+	u8 Stack[JSON_READER_MAX_DEPTH / 8]; // One bit per level, set for objects.
+
+	bool8 Skipping;
+	u32 SkipDepth;
+
+	// A token split between chunks is put back together here.
+	char Carry[JSON_READER_CARRY_SIZE];
+	u32 CarrySize;
+	bool8 CarryEscaped, CarryReady;
+
+	char Scratch[JSON_READER_CARRY_SIZE];
+};
+
+void JSON_Reader_Init(JSON_Reader* r, const char* str, u32 len); // Read a whole document from memory.
+void JSON_Reader_InitStream(JSON_Reader* r);                     // Read a document that'll be fed in chunks.
+
+// Give the reader the next chunk, `last` marks the end of the document.
+// The chunk has to stay around until Next() asks for more input.
+void JSON_Reader_Feed(JSON_Reader* r, const char* chunk, u32 len, bool8 last);
+
+enum JSON_Event JSON_Reader_Next(JSON_Reader* r);
+
+// Skip the value after a Key event, or the rest of an object/array right after it begins.
+// The next call to Next() returns whatever comes after it.
+void JSON_Reader_Skip(JSON_Reader* r);
+
+// Check whether the current key or string is equal to `str`.
+bool8 JSON_Reader_StringIs(const JSON_Reader* r, const char* str);
+
+//
+// Writing
+//
+
+// Builds JSON text one value at a time, commas and indentation are taken care of.
+// Output goes into a growing buffer, or through a fixed buffer straight into a file descriptor.
+// Buffers come from a small pool, so writing lots of little documents doesn't keep allocating.
+
+#define JSON_WRITER_MAX_DEPTH 256
+
+typedef struct JSON_Writer JSON_Writer;
+
+struct JSON_Writer {
+	// The text so far, NULL terminated by JSON_Writer_Finish(). When writing
+	// to a file descriptor this only holds what hasn't been flushed yet.
+	char* Data;
+	u32 Size;
+	u32 Capacity;
+
+	i32 FD;     // -1 when writing to memory.
+	u32 Indent; // Spaces per level, 0 writes everything on one line.
+
+	u32 Depth;
+	bool8 AfterKey; // A key was just written, its value comes next without a comma.
+	bool8 Failed;   // Writing to the file descriptor failed, or the nesting got too deep.
+
+	u8 HasItems[JSON_WRITER_MAX_DEPTH / 8]; // One bit per level, set once something's in it.
+};
+
+void JSON_Writer_Init(JSON_Writer* w, u32 indent);           // Write into memory.
+void JSON_Writer_InitFD(JSON_Writer* w, i32 fd, u32 indent); // Write into a file descriptor.
+
+// Flush whatever's left to the file descriptor, returns 0 if anything went wrong.
+bool8 JSON_Writer_Finish(JSON_Writer* w);
+
+// Give the buffer back to the pool.
+void JSON_Writer_Free(JSON_Writer* w);
+
+// Take the text out of the writer, free it with Free().
+char* JSON_Writer_Detach(JSON_Writer* w, u32* outSize);
+
+void JSON_Writer_BeginObject(JSON_Writer* w);
+void JSON_Writer_EndObject(JSON_Writer* w);
+void JSON_Writer_BeginArray(JSON_Writer* w);
+void JSON_Writer_EndArray(JSON_Writer* w);
+
+void JSON_Writer_Key(JSON_Writer* w, const char* key);
+void JSON_Writer_Key_N(JSON_Writer* w, const char* key, u32 len);
+
+void JSON_Writer_String(JSON_Writer* w, const char* str);
+void JSON_Writer_String_N(JSON_Writer* w, const char* str, u32 len);
+void JSON_Writer_Number(JSON_Writer* w, r64 n); // Shortest text that reads back as the same double.
+void JSON_Writer_Float(JSON_Writer* w, r32 n);  // Shortest text that reads back as the same float.
+void JSON_Writer_Integer(JSON_Writer* w, i64 n);
+void JSON_Writer_Boolean(JSON_Writer* w, bool8 b);
+void JSON_Writer_Null(JSON_Writer* w);
+
+// Write out a whole parsed value.
+void JSON_Writer_Value(JSON_Writer* w, const JSON_Value* v);
+
+// Turn a value into text, free it with Free().
+char* JSON_ToString(const JSON_Value* v, u32 indent, u32* outSize);
+
+// Write a value into a file, returns 0 on failure.
+bool8 JSON_ToFile(const JSON_Value* v, const char* filename, u32 indent);
+
 #endif
@@ -0,0 +1,128 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "Camera.h"
+#include "Common.h"
+#include "Math3D.h"
+#include "WavefrontOBJ.h"
+
+//
+// Mesh simplification
+//
+
+// Simplify an indexed triangle mesh with quadric error metrics (Garland & Heckbert).
+//
+// Vertices are never moved or removed, only the index list shrinks, so every
+// simplified version can keep using the original vertex buffer. Vertices that
+// share a position but have different UVs/normals (seams) are never collapsed.
+//
+// Positions are read from `positions` every `stride` bytes.
+// `outIndices` must have room for `numIndices` indices.
+// Stops once `targetIndices` is reached or the next collapse would be
+// worse than `maxError` (in mesh units).
+//
+// Returns the number of indices written, the resulting error is put in outError.
+u32 Mesh_Simplify(u32* outIndices,
+                  const u32* indices,
+                  u32 numIndices,
+                  const Vec3* positions,
+                  const Vec3* normals, // May be NULL
+                  const Vec2* uvs,     // May be NULL
+                  u32 numVertices,
+                  u32 stride,
+                  u32 targetIndices,
+                  r32 maxError,
+                  r32* outError);
+
+//
+// Levels of detail
+//
+
+// Build a chain of progressively simpler index lists for an object.
+// Each level keeps roughly `reduction` (0 to 1) of the previous level's triangles.
+// Levels that fail to reduce the mesh meaningfully end the chain early.
+void WObj_BuildLODs(WObj_Object* obj, u32 numLevels, r32 reduction);
+
+// Free an object's LOD chain.
+void WObj_FreeLODs(WObj_Object* obj);
+
+// How many pixels tall a geometric error of `error` units looks
+// when it's at `position`, with `screenHeight` pixels on screen.
+r32 Mesh_ScreenSpaceError(r32 error, Camera cam, Vec3 position, r32 screenHeight);
+
+// Pick the coarsest level whose error is at most `maxPixelError` pixels on screen.
+// `errors[0]` is expected to be the full-resolution mesh (error 0).
+u32 Mesh_SelectLOD(const r32* errors,
+                   u32 numLevels,
+                   Camera cam,
+                   Transform3D transform,
+                   r32 screenHeight,
+                   r32 maxPixelError);
+
+//
+// Meshlets
+//
+
+#define MESHLET_MAX_VERTICES  64
+#define MESHLET_MAX_TRIANGLES 124
+
+typedef struct Meshlet Meshlet;
+typedef struct Mesh_Meshlets Mesh_Meshlets;
+
+// A small cluster of triangles that can be culled as a whole.
+struct Meshlet {
+	u32 VertexOffset;   // First vertex inside Mesh_Meshlets.Vertices
+	u32 TriangleOffset; // First triangle inside Mesh_Meshlets.Triangles
+	u32 NumVertices;    // At most MESHLET_MAX_VERTICES
+	u32 NumTriangles;   // At most MESHLET_MAX_TRIANGLES
+
+	// Bounding sphere
+	Vec3 Center;
+	r32 Radius;
+
+	// Normal cone. The meshlet faces away from the camera when
+	// dot(normalize(ConeApex - cameraPos), ConeAxis) >= ConeCutoff.
+	// A cutoff of 1 means the normals are too spread out to ever cull.
+	Vec3 ConeApex;
+	Vec3 ConeAxis;
+	r32 ConeCutoff;
+};
+
+struct Mesh_Meshlets {
+	u32 NumMeshlets;
+	Meshlet* Meshlets;
+
+	u32 NumVertices;
+	u32* Vertices; // Indices into the source vertex buffer
+
+	u32 NumTriangles;
+	u8* Triangles; // 3 indices per triangle into the meshlet's own vertices
+};
+
+// Split an indexed triangle mesh into meshlets, growing each one
+// through neighbouring triangles to keep them compact.
+Mesh_Meshlets Mesh_BuildMeshlets(const u32* indices,
+                                 u32 numIndices,
+                                 const Vec3* positions,
+                                 u32 numVertices,
+                                 u32 stride);
+
+Mesh_Meshlets WObj_BuildMeshlets(const WObj_Object* obj);
+
+void Mesh_Meshlets_Free(Mesh_Meshlets* m);
+
+// Turn the meshlets back into a regular index buffer, where meshlet i
+// owns indices [TriangleOffset * 3, (TriangleOffset + NumTriangles) * 3).
+// outIndices must hold NumTriangles * 3 indices.
+void Mesh_Meshlets_Unpack(const Mesh_Meshlets* m, u32* outIndices);
+
+// Frustum and backface cull meshlets seen through `cam`, for a mesh placed with `transform`.
+// Neighbouring visible meshlets are merged into one range.
+// Writes the first index and index count of each range, and returns the number of ranges.
+u32 Mesh_Meshlets_Cull(const Mesh_Meshlets* m,
+                       Camera cam,
+                       Transform3D transform,
+                       u32* outFirstIndex,
+                       u32* outCount);
+
+#endif
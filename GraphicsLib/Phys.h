@@ -9,6 +9,7 @@ typedef struct Intersection Intersection;
 typedef struct Ray          Ray;
 typedef struct AABB         AABB;
 typedef struct TriHull      TriHull;
+typedef struct TriHull_BVH  TriHull_BVH;
 
 struct Plane {
 	Vec3 Normal;
@@ -35,6 +36,11 @@ enum HSRes HalfSpaceTest(Vec3 planeNormal, Vec3 planePoint, Vec3 point);
 struct Intersection {
 	bool8 Occurred;
 	Vec3 Point;
+
+	// Only set for rays. The normal of the triangle that got hit, facing back
+	// towards the ray, and how far along the ray it is (Point = Start + Dir * T).
+	Vec3 Normal;
+	r32 T;
 };
 
 struct Ray {
@@ -47,21 +53,260 @@ struct AABB {
 	Vec3 Max;
 };
 
-bool8 AABB_Intersect        (AABB a, AABB b);
+bool8 AABB_Intersect        (AABB a, AABB b); // Both boxes have to be fixed, Min <= Max.
 AABB  AABB_Fix              (AABB aabb);
-AABB  AABB_ApplyTransform3D (AABB aabb, Transform3D t);
+AABB  AABB_ApplyTransform3D (AABB aabb, Transform3D t); // The tightest AABB around a transformed one.
+AABB  AABB_ApplyMat4        (AABB aabb, const Mat4 m);
 AABB  AABB_Add              (AABB a, AABB b); // Generate a sum AABB around two others.
 
+// Transform many boxes at once. The strides are in bytes, so the boxes
+// and transforms can be fields inside of bigger structs.
+void AABB_ApplyTransform3D_N(const AABB* boxes, u32 boxStride,
+                             const Transform3D* transforms, u32 transformStride,
+                             AABB* out, u32 count);
+
 struct TriHull { 
 	Vec3 *TriPoints;
 	u32 NumTris;
 	Transform3D *Transform;
+
+	TriHull_BVH* BVH; // Made by TriHull_Build(), NULL means every triangle gets tested.
+};
+
+typedef struct TriHull_BVHNode  TriHull_BVHNode;
+typedef struct TriHull_TriBlock TriHull_TriBlock;
+
+struct TriHull_BVHNode {
+	AABB Box;
+	u32 Index; // First triangle for leaves, always a multiple of 4. For inner nodes,
+	           // the second child (the first one is right after this node).
+	u32 Count; // Number of triangles, 0 for inner nodes.
 };
 
+// Four triangles as one corner and two edges each, split up by component,
+// so a ray can be tested against all of them at once.
+struct TriHull_TriBlock {
+	r32 V0[3][4];
+	r32 E1[3][4];
+	r32 E2[3][4];
+};
+
+// Bounding volume hierarchy over a hull's triangles, in the hull's local space.
+struct TriHull_BVH {
+	TriHull_BVHNode* Nodes;
+	u32 NumNodes;
+
+	// Copy of the triangles, in the order the leaves use them. Every leaf starts
+	// on a new block, the gaps at the end of a leaf are never hit.
+	Vec3* Tris;
+	TriHull_TriBlock* Blocks;
+};
+
+// Build a BVH for the hull, so rays and other hulls only test the triangles near them.
+// The triangles can't change after this, but the transform can.
+void TriHull_Build(TriHull* hull);
+void TriHull_Free(TriHull* hull); // Free the BVH.
+
 Intersection TriTri_Intersect(const Vec3 a[3], const Vec3 b[3]);
-Intersection TriHull_RayIntersect(TriHull hull, Ray ray);
+
+// How many of `count` triangles one triangle hits, the same as TriTri_Intersect() on each.
+// They're laid out like a BVH leaf's, three corners each in `tris` and four to a block in
+// `blocks`, so with SSE four get tested at once.
+u32 TriTri_CountHits(const Vec3 tri[3], const Vec3* tris, const TriHull_TriBlock* blocks, u32 count);
+Intersection TriHull_RayIntersect(TriHull hull, Ray ray); // The closest hit along the ray.
+
+// The closest hit for each of a bunch of rays. Rays that start close together and point
+// the same way, like ones from a camera or under the mouse, go through the BVH together.
+void TriHull_RayIntersectMany(TriHull hull, const Ray* rays, u32 numRays, Intersection* out);
 Intersection TriHull_Intersect(TriHull a, TriHull b);
 
+//
+// Dynamic AABB tree
+//
+
+// Thank you,
+// https://box2d.org/files/ErinCatto_DynamicBVH_Full.pdf
+//
+// A bounding volume hierarchy that can be changed one box at a time. Leaves hold
+// fattened boxes, so objects that move a little don't have to be moved in the tree.
+// Queries and ray casts only visit the branches they touch, so they're O(log n).
+
+typedef struct AABBTree      AABBTree;
+typedef struct AABBTree_Node AABBTree_Node;
+
+// How much leaf boxes are grown on every side.
+#define AABBTREE_MARGIN 0.1f
+
+struct AABBTree_Node {
+	AABB Box; // Fattened for leaves.
+
+	i32 Parent; // Next free node, for nodes that aren't in use.
+	i32 Child1; // -1 for leaves.
+	i32 Child2;
+	i32 Height; // 0 for leaves, -1 for nodes that aren't in use.
+
+	u32 Data;    // Whatever the leaf was inserted with.
+	bool8 Moved; // Set when the leaf gets (re)inserted.
+};
+
+struct AABBTree {
+	AABBTree_Node* Nodes;
+	u32 NumNodes, Capacity;
+
+	i32 Root;
+	i32 FreeList;
+};
+
+// Called for every leaf that overlaps the query box, return 0 to stop the query.
+typedef bool8 (*AABBTree_QueryFunc)(void* user, u32 data);
+
+// Called for every leaf the ray goes through. Return maxT to carry on,
+// something smaller to shorten the ray, or 0 to stop.
+typedef r32 (*AABBTree_RayFunc)(void* user, u32 data, Ray ray, r32 maxT);
+
+void AABBTree_Init(AABBTree* tree);
+void AABBTree_Free(AABBTree* tree);
+
+i32  AABBTree_Insert(AABBTree* tree, AABB box, u32 data); // Returns the leaf's index.
+void AABBTree_Remove(AABBTree* tree, i32 leaf);
+
+// Update a leaf's box, `displacement` is how far it's expected to move next,
+// the fattened box is stretched that way. Returns 1 if the leaf had to be moved in the tree.
+bool8 AABBTree_Move(AABBTree* tree, i32 leaf, AABB box, Vec3 displacement);
+
+void AABBTree_Query(const AABBTree* tree, AABB box, AABBTree_QueryFunc func, void* user);
+
+// Go through the leaves along the ray, from Start to Start + Dir * maxT.
+void AABBTree_RayCast(const AABBTree* tree, Ray ray, r32 maxT, AABBTree_RayFunc func, void* user);
+
+//
+// Convex shapes
+//
+
+// Thank you,
+// https://box2d.org/files/ErinCatto_GJK_GDC2010.pdf
+// http://www.dtecta.com/papers/gdc2001depth.pdf
+//
+// Contacts between convex shapes, from GJK for the distance and EPA for how deep they
+// overlap. Both only need the point of a shape furthest along a direction, so a contact
+// costs about as much as the shapes have corners, instead of every triangle against every other.
+
+typedef struct PhysShape   PhysShape;
+typedef struct PhysContact PhysContact;
+typedef struct GJK_Cache   GJK_Cache;
+
+struct PhysShape {
+	enum {
+		PhysShapeType_None, // Nothing convex, contacts fall back on the TriHull.
+		PhysShapeType_Sphere,
+		PhysShapeType_Box,
+		PhysShapeType_Capsule, // Standing up along the Y axis.
+		PhysShapeType_Convex,
+	} Type;
+
+	// Spheres and capsules. A non-uniform scale doesn't squash them,
+	// the radius gets scaled by the biggest of the three instead.
+	r32 Radius;
+
+	union {
+		Vec3 HalfExtents; // Boxes
+		r32  HalfHeight;  // Capsules, from the middle to the center of either cap.
+
+		// Convex hulls, the points with the duplicates taken out. If the mesh they came from
+		// was closed and convex, the points it joins with edges are kept too (Neighbours[NeighbourStart[i]]
+		// up to Neighbours[NeighbourStart[i + 1]]), otherwise they're NULL.
+		struct {
+			Vec3* Points;
+			u32 NumPoints;
+
+			u32* Neighbours;
+			u32* NeighbourStart;
+		};
+	};
+};
+
+struct PhysContact {
+	bool8 Touching; // Distance <= 0.
+
+	r32 Distance; // Between the shapes, negative is how far they go into each other.
+	Vec3 Normal;  // From A towards B, in world space. Zero if it can't be told.
+
+	// Closest points in world space, or the deepest ones when the shapes overlap.
+	Vec3 PointA, PointB;
+};
+
+// The simplex GJK ended up with last time. Keeping one for each pair of shapes and
+// handing it back every frame lets GJK pick up where it left off, which is usually done in a step or two.
+struct GJK_Cache {
+	u32 Count; // 0 means there's nothing cached.
+	u32 IndexA[4], IndexB[4];
+};
+
+PhysShape PhysShape_Sphere(r32 radius);
+PhysShape PhysShape_Box(Vec3 halfExtents);
+PhysShape PhysShape_Capsule(r32 radius, r32 halfHeight);
+PhysShape PhysShape_FromTriHull(const TriHull* hull); // The convex hull around all of the hull's points.
+void      PhysShape_Free(PhysShape* shape);
+
+Vec3 PhysShape_Support(const PhysShape* shape, Vec3 dir); // Furthest point along `dir`, in local space.
+AABB PhysShape_AABB(const PhysShape* shape);              // In local space.
+
+// How far apart two shapes are, or how deep they overlap. The transforms may be NULL,
+// and so may the cache. Returns 1 if the shapes touch.
+bool8 PhysShape_Contact(const PhysShape* a, const Transform3D* ta, const PhysShape* b, const Transform3D* tb,
+                        GJK_Cache* cache, PhysContact* out);
+
+// When two moving shapes first get within `distance` of each other, a negative one is how deep
+// they go into each other. Both go in a straight line at `v` and spin at `w` (radians per second,
+// in world space) for `dt` seconds, shapes with a NULL transform stay put. Returns how far into `dt`
+// that happens (0 to 1), or 1 if it doesn't or they're moving apart, along with the contact at that moment.
+r32 PhysShape_TimeOfImpact(const PhysShape* a, const Transform3D* ta, Vec3 va, Vec3 wa,
+                           const PhysShape* b, const Transform3D* tb, Vec3 vb, Vec3 wb,
+                           r32 dt, r32 distance, PhysContact* out);
+
+// Where a ray first hits a shape, before `maxT`. The transform may be NULL.
+Intersection PhysShape_RayIntersect(const PhysShape* shape, const Transform3D* t, Ray ray, r32 maxT);
+
+//
+// Rigid bodies
+//
+
+// Thank you,
+// https://box2d.org/files/ErinCatto_SequentialImpulses_GDC2006.pdf
+// https://github.com/bulletphysics/bullet3/blob/master/src/BulletCollision/NarrowPhaseCollision/btPersistentManifold.cpp
+//
+// Rigid bodies get pushed apart wherever they touch, one contact point at a time, over and
+// over until they all agree. The points are kept from one update to the next, along with how
+// hard each one pushed, so the solver starts close to the answer instead of from nothing.
+//
+// Bodies that touch each other make up an island. Islands don't share anything that moves,
+// so each one gets solved on its own, spread over the job system's threads once Job_Init()
+// has been called. Islands that stay still for a while fall asleep.
+
+typedef struct PhysManifold      PhysManifold;
+typedef struct PhysManifoldPoint PhysManifoldPoint;
+
+#define PHYSMANIFOLD_MAX_POINTS 4
+
+struct PhysManifoldPoint {
+	// Where the point is on each object, relative to its position and rotation, but not scaled.
+	Vec3 LocalA, LocalB;
+
+	Vec3 Normal;  // From A towards B, in world space.
+	r32 Distance; // Negative when the objects overlap there.
+
+	// How hard the solver pushed here last time.
+	r32 NormalImpulse;
+	r32 TangentImpulse[2];
+};
+
+// Contact points between two objects. GJK only gives back one point at a time, so they're
+// gathered over a few updates, which lets a box rest on a whole face instead of wobbling on a corner.
+struct PhysManifold {
+	PhysManifoldPoint Points[PHYSMANIFOLD_MAX_POINTS];
+	u32 NumPoints;
+};
+
 typedef struct PhysObject      PhysObject;
 typedef struct PhysWorld       PhysWorld;
 typedef struct PhysWorld_Cache PhysWorld_Cache;
@@ -80,31 +325,186 @@ struct PhysObject {
 	} Type;
 
 	Vec3 Velocity;
+	Vec3 AngularVelocity; // Radians per second, in world space.
 
-	r32 Mass;
+	r32 Mass; // Rigid bodies without any mass don't move.
 	
 	// Float from 0.0 to 1.0 of how much an object 
 	// will bounce when colliding with another.
 	r32 Bounciness;
 
+	// 0 slides like ice, around 0.5 for most things.
+	// Two objects touching use the square root of theirs multiplied.
+	r32 Friction;
+
+	// Rigid bodies that barely move for a while fall asleep, and stay where they are without
+	// costing anything until something awake touches them or their velocity gets set.
+	bool8 Asleep;
+	r32 SleepTime; // How long it's been barely moving, in seconds.
+
+	// Rigid bodies going faster than this, in meters per second, get swept along the whole way
+	// they move every update, so they can't skip past thin walls and floors. 0 turns it off.
+	// It needs a PhysShape, and only stops them at objects that aren't awake rigid bodies.
+	r32 SweepSpeed;
+
+	// Which layers the object is in, as bits. Rays only hit the layers in their mask. 0 is the same as 1.
+	u32 Layers;
+
 	Transform3D Transform;
 
-	AABB    AABB;
-	TriHull Hull;
+	AABB      AABB; // In local space, Transform is applied on top of it.
+	TriHull   Hull;
+	PhysShape Shape; // Used for contacts when both objects have one.
 };
 
 DEF_ARRAY(PhysObject, PhysObject);
 
+typedef struct PhysPair PhysPair;
+
+// Two objects whose boxes overlap, as indices into PhysWorld.Objects (A < B).
+struct PhysPair {
+	u32 A, B;
+
+	// How the objects themselves touch. Objects without a PhysShape only get
+	// Touching and a point on the hulls, and nothing if just one of them has one.
+	PhysContact Contact;
+	GJK_Cache Cache;
+
+	// Where they've been touching lately, only objects with a PhysShape get one.
+	PhysManifold Manifold;
+
+	// Where both objects were the last time the contact was worked out, and how far apart they
+	// were if that was too far to touch. Until they could have moved closer than that, or if
+	// they haven't moved at all, the contact is kept as it is and the narrowphase is skipped.
+	bool8 Known;
+	r32 Separation;
+	Transform3D PoseA, PoseB;
+};
+
+DEF_ARRAY(PhysPair, PhysPair);
+
 struct PhysWorld {
-	r32 Gravity;
+	r32 Gravity; // Pulls rigid bodies down the Y axis.
+
+	// How many times the solver goes over every contact, more is stiffer but slower.
+	u32 Iterations;
 
 	Array_PhysObject Objects;
 
+	// Where the pair list comes from. Ray casts and box queries always use the tree.
+	enum PhysBroadphase {
+		PhysBroadphase_SweepAndPrune, // Best when lots of objects move a little every frame.
+		PhysBroadphase_Tree,          // Best when most objects sit still, or are spread far apart.
+		PhysBroadphase_Grid,          // Best when lots of objects about the same size all move around.
+	} Broadphase;
+
 	PhysWorld_Cache *_cache;
 };
 
 void        PhysWorld_Init(PhysWorld* world);
+void        PhysWorld_Free(PhysWorld* world);
+void        PhysWorld_Update(PhysWorld* world, r32 dt); // Find what touches and move the rigid bodies.
+
+// Queries see the world as it was at the last PhysWorld_Update().
+
+// The closest object hit by the ray, NULL if there's none.
 PhysObject* PhysWorld_RayCollide(const PhysWorld* world, Ray ray);
-void        PhysWorld_Update(PhysWorld* world, r32 dt);
+
+// Push the index of every object whose box overlaps `box` onto `outObjects`.
+void PhysWorld_QueryAABB(const PhysWorld* world, AABB box, Array_u32* outObjects);
+
+// Lots of rays at once, for when gameplay or AI needs hundreds of them every frame.
+// Each hits the first object's hull, or its shape if it doesn't have one, or its box if it has neither.
+
+#define PHYSRAY_BATCH 32 // Rays per job, fewer than this just get cast one by one.
+
+typedef struct PhysRay    PhysRay;
+typedef struct PhysRayHit PhysRayHit;
+
+struct PhysRay {
+	Ray Ray;
+	r32 MaxT; // How far along the ray to look, in lengths of Dir. 0 means all the way.
+	u32 Mask; // Which of PhysObject.Layers it can hit, 0 means all of them.
+};
+
+struct PhysRayHit {
+	i32 Object;  // Index into PhysWorld.Objects, -1 if the ray didn't hit anything.
+	Vec3 Point;
+	Vec3 Normal; // Facing back towards the ray.
+	r32 T;       // Point = Start + Dir * T
+};
+
+// The closest hit for every ray, in the same order. They're spread over the job system's threads.
+void PhysWorld_RayCastMany(const PhysWorld* world, const PhysRay* rays, u32 numRays, PhysRayHit* out);
+
+// Pairs of objects whose boxes overlapped at the last PhysWorld_Update(), with their contacts.
+// Pairs of two static objects are left out. The list is kept between updates,
+// only the pairs that started or stopped overlapping get added or removed.
+// With the tree broadphase, pairs are found with the fattened boxes, so some
+// of them may not quite touch.
+const PhysPair* PhysWorld_GetPairs(const PhysWorld* world, u32* outNumPairs);
+
+typedef struct PhysWorld_Stats PhysWorld_Stats;
+
+// What happened to the pairs at the last update. The pair cache's hit rate
+// is Cached / (Cached + Tested), or TotalCached / (TotalCached + TotalTested) over time.
+struct PhysWorld_Stats {
+	u32 Pairs;   // All of them.
+	u32 Resting; // Both objects static or asleep, their contacts were left alone.
+	u32 Cached;  // Skipped, they couldn't have moved close enough to touch, or didn't move at all.
+	u32 Tested;  // Went through the narrowphase.
+
+	u64 TotalCached, TotalTested; // Since the world was made.
+};
+
+PhysWorld_Stats PhysWorld_GetStats(const PhysWorld* world);
+
+//
+// Fixed steps
+//
+
+// Steps a world at a fixed rate however often it gets called, and carries the time that's
+// left over to the next call. Drawing blends between the last two steps, so motion stays smooth
+// when frames and steps don't line up, and physics costs the same at any frame rate.
+// Thank you,
+// https://gafferongames.com/post/fix_your_timestep/
+
+typedef struct PhysSim PhysSim;
+
+struct PhysSim {
+	PhysWorld* World;
+
+	r32 Step;     // Seconds per step.
+	u32 MaxSteps; // After a long frame, time that would take more steps than this is dropped.
+
+	r32 Accumulator; // Time that hasn't been stepped yet, less than one step.
+	r32 Alpha;       // How far the frame is from Previous to Current, 0 to 1.
+
+	// Every object's transform before and after the last step, in the same order as World->Objects.
+	Transform3D* Previous;
+	Transform3D* Current;
+	u32 NumTransforms;
+
+	// Where steps running as a job put their results until PhysSim_Finish().
+	Transform3D* _next[2];
+	u32 _capacity;
+	u32 _steps;
+	r32 _alpha;
+	Job_Counter _running;
+};
+
+void PhysSim_Init(PhysSim* sim, PhysWorld* world, r32 step); // A step of 0 means 60 per second.
+void PhysSim_Free(PhysSim* sim);
+
+// Take every step that fits in the time since the last call, returns how many there were.
+u32 PhysSim_Advance(PhysSim* sim, r32 frameTime);
+
+// Same as PhysSim_Advance(), but the steps run as a job. The world can't be touched until
+// PhysSim_Finish(), but the transforms can, they show the steps before this one.
+void PhysSim_Start(PhysSim* sim, r32 frameTime);
+u32 PhysSim_Finish(PhysSim* sim); // Wait for the steps and switch over to them.
+
+// Where an object should be drawn, between its last two steps.
+Transform3D PhysSim_Transform(const PhysSim* sim, u32 object);
 
 #endif
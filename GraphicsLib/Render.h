@@ -62,6 +62,8 @@ struct Texture {
 	enum Texture_Filter Filter; // Magnification and minification filter
 	enum Texture_Wrap Wrap;     // How to wrap the texture if we read outside its bounds
 	bool8 HasMipmaps;           // Whether the texture has smaller versions of itself generated
+	bool8 SRGB;                 // Colours are in sRGB, set it before Texture_SetData()
+	GLenum InternalFormat;      // How the GPU stores the pixels, R8, RGBA8, compressed...
 };
 
 Texture Texture_Init(u32 Width,                  // Width in pixels
@@ -76,10 +78,49 @@ void Texture_SetData(Texture* Texture, // Target texture
                      u32 Height,
                      bool8 GenMipmaps);
 
+// Load an image, or a .ktx file with its mipmaps and compression (see tools/TexCook.c).
 Texture Texture_FromFile(const char* File);
+Texture Texture_FromMemory(const u8* Data, u32 Size); // Decode an image file that's already been read in.
 
 void Texture_Free(Texture);
 
+// Roughly how much video memory the texture takes up.
+u64 Texture_MemorySize(const Texture* Texture);
+
+//
+// Loading textures in the background
+//
+
+// Images are decoded and get their mipmaps made on worker threads (see Job_Init()), then
+// they're uploaded a few rows at a time through a pixel buffer by RSys_FinishFrame(),
+// so loading doesn't stall frames.
+
+#define TEXTURE_UPLOAD_BUDGET_DEFAULT (4 * 1024 * 1024) // Bytes of pixels uploaded per frame.
+
+// Called on the render thread once the texture is ready to use. If the image couldn't be
+// loaded, `loaded` is 0 and the texture keeps its placeholder.
+typedef void (*Texture_LoadedFunc)(Texture* texture, bool8 loaded, void* data);
+
+// Start loading an image into `texture`, which gets a grey placeholder until it's uploaded.
+// The texture has to stay where it is, and not be freed, until `onLoaded` gets called.
+// `srgb` is for colour images, mipmaps get averaged as linear light and the texture ends up
+// with SRGB set. Leave it off for normal maps and other data.
+// KTX files go up level by level as they are, with `srgb` and mipmaps coming from the file.
+void Texture_FromFileAsync(Texture* texture, const char* file, bool8 srgb, Texture_LoadedFunc onLoaded, void* data);
+
+// How many bytes of pixels get uploaded each frame, at least one row (of blocks) always goes.
+void Texture_SetUploadBudget(u32 bytesPerFrame);
+
+// Upload what's been decoded so far and call back whatever's ready. RSys_FinishFrame() calls this.
+void Texture_UpdateAsync(void);
+
+// How many textures haven't finished loading yet.
+u32 Texture_NumLoading(void);
+
+// Throw away whatever's still loading, without calling anything back. It waits for images
+// that are still being decoded, so it has to happen before Job_Shutdown(). RSys_Quit() calls it.
+void Texture_CancelAsync(void);
+
 // Render target type.
 typedef struct RT RT;
 
@@ -255,6 +296,11 @@ struct Actor {
 
 	bool8 CastShadow;
 	GLuint VAO, ElementBuffer;
+
+	GLenum Mode;      // GL_TRIANGLES, GL_LINES, etc.
+	GLenum IndexType; // GL_UNSIGNED_BYTE/SHORT/INT, or 0 to draw without indices.
+	u32 IndexOffset;  // In bytes, inside the element buffer.
+	u32 Count;        // Number of indices, or vertices when there are none.
 };
 
 enum R3D_Light_Type {
@@ -340,6 +386,7 @@ void Scene_Render(R3D_Scene*); // Draw a scene.
 
 R3D_Node* R3D_Node_Create(enum R3D_Node_Type);
 R3D_Node* R3D_Node_AttachNew(enum R3D_Node_Type);
+void R3D_Node_Free(R3D_Node*); // Free a node made with R3D_Node_Create() and all its children.
 void R3D_CalcTransform(const R3D_Node*, Mat4 out);
 
 #endif
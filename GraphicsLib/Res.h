@@ -4,10 +4,50 @@
 #include "Common.h"
 #include "Render.h"
 
+//
+// Textures
+//
+
+// Textures are kept by path, so asking for the same file again hands back the same texture.
+// Files with the same contents share one texture too, even if they're under different paths.
+//
+// Every Res_Texture_GetOrLoad() holds on to the texture until it's given back with
+// Res_Texture_Release(). Textures nothing holds on to stay loaded in case they're wanted
+// again, and once textures take up more than the budget the least recently used of those
+// get freed.
+//
+// All of this has to happen on the thread with the GL context.
+
 /// Is the texture with the given filename residing somewhere in memory already?
 bool8 Res_Texture_InCache(const char* filename);
 
 /// Load a texture from disk or get it from the cache if it's there.
+/// Returns NULL if the file couldn't be loaded, the texture stays valid until it's released.
 Texture* Res_Texture_GetOrLoad(const char* filename);
 
+/// Give back a texture from Res_Texture_GetOrLoad().
+void Res_Texture_Release(Texture* texture);
+
+/// How much video memory textures can take up before unused ones get freed, 0 means no limit.
+void Res_SetBudget(u64 bytes);
+
+typedef struct Res_Stats Res_Stats;
+
+struct Res_Stats {
+	u64 Hits;    // Res_Texture_GetOrLoad() calls for a path that was already loaded.
+	u64 Misses;  // Calls that had to read the file.
+	u64 Deduped; // Misses where the file turned out to be the same as a loaded texture.
+	u64 Evicted; // Textures freed to stay under the budget.
+
+	u32 Textures;      // Loaded right now.
+	u32 Unused;        // Loaded, but nothing holds on to them.
+	u64 BytesResident; // Roughly how much video memory the loaded textures take up.
+	u64 Budget;
+};
+
+Res_Stats Res_GetStats(void);
+
+/// Free every texture, even ones that are still held on to, and forget every path.
+void Res_FreeAll(void);
+
 #endif
@@ -1,6 +1,10 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "Camera.h"       // For Camera
+#include "GLTF.h"         // For GLTF_Asset
+#include "Mesh.h"         // For Mesh_Meshlets
+#include "Render.h"       // For R3D_Node
 #include "WavefrontOBJ.h" // For WObj_Object
 #include "glad/glad.h"    // For GLuint
 
@@ -10,9 +14,51 @@ typedef struct GPUModel {
 	GLuint ElementBuffer;
 	u32 NumVertices;
 	u32 NumIndices;
+
+	// Level 0 is the full mesh, the rest come from the object's LOD chain.
+	// All levels live one after another inside ElementBuffer.
+	u32 NumLODs;
+	u32 LODOffsets[WOBJ_MAX_LODS + 1]; // First index of each level
+	u32 LODCounts[WOBJ_MAX_LODS + 1];  // Number of indices in each level
+	r32 LODErrors[WOBJ_MAX_LODS + 1];  // Geometric error of each level
+
+	// Optional meshlet version of the full mesh, see GPUModel_SetMeshlets().
+	GLuint MeshletBuffer;
+	const Mesh_Meshlets* Meshlets;
+	GLsizei* MeshletCounts;
+	void** MeshletOffsets;
+	u32* MeshletRanges; // Scratch space for culling, first and count of every draw range.
 } GPUModel;
 
 void GPUModel_Render(const GPUModel* model);
+void GPUModel_RenderLOD(const GPUModel* model, u32 lod);
+
+// Pick the coarsest level of detail that's off by at most maxPixelError pixels.
+u32 GPUModel_SelectLOD(const GPUModel* model,
+                       Camera cam,
+                       Transform3D transform,
+                       r32 screenHeight,
+                       r32 maxPixelError);
 void WObj_ToGPUModel(GPUModel* out, const WObj_Object* obj);
 
+// Delete the model's buffers and VAO, along with its meshlets.
+void GPUModel_Free(GPUModel* model);
+
+// Upload meshlets built from the same object as the model.
+// The model keeps a pointer to them, so they have to outlive it.
+void GPUModel_SetMeshlets(GPUModel* model, const Mesh_Meshlets* meshlets);
+
+// Go back to drawing the whole mesh, the meshlets themselves are left alone.
+void GPUModel_FreeMeshlets(GPUModel* model);
+
+// Cull the model's meshlets and draw what's left with one glMultiDrawElements() call.
+// Returns the number of triangles drawn.
+u32 GPUModel_RenderMeshlets(GPUModel* model, Camera cam, Transform3D transform);
+
+// Upload a glTF scene and turn it into a node tree, with an Actor for every primitive.
+// The returned root node has the scene's root nodes as its children.
+// Vertex data is uploaded straight from the asset's buffers, so the asset can be freed afterwards.
+// GPU buffers go away together with the actors' VAOs in R3D_Node_Free().
+R3D_Node* GLTF_ToNodes(const GLTF_Asset* asset, const GLTF_Scene* scene);
+
 #endif
@@ -21,6 +21,7 @@ enum WObj_IllumMode {
 
 typedef struct WObj_Material WObj_Material;
 typedef struct WObj_Vertex   WObj_Vertex;
+typedef struct WObj_LOD      WObj_LOD;
 typedef struct WObj_Object   WObj_Object;
 typedef struct WObj_Library  WObj_Library;
 
@@ -55,6 +56,16 @@ struct WObj_Vertex {
 	Vec3 Normal;
 };
 
+// Maximum number of simplified levels kept per object (see Mesh.h).
+#define WOBJ_MAX_LODS 8
+
+// A simplified version of an object, sharing the object's vertices.
+struct WObj_LOD {
+	u32  NumIndices;
+	u32* Indices;
+	r32  Error; // Geometric error compared to the full mesh, in mesh units.
+};
+
 struct WObj_Object {
 	char *Name;
 
@@ -65,6 +76,10 @@ struct WObj_Object {
 
 	u32  NumIndices;
 	u32*    Indices;
+
+	// Simplified levels, from most to least detailed. Empty until WObj_BuildLODs().
+	u32      NumLODs;
+	WObj_LOD LODs[WOBJ_MAX_LODS];
 };
 
 struct WObj_Library {
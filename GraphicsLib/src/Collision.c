@@ -1,6 +1,7 @@
 #include "../Collision.h"
 
 #include <float.h>
+#include <math.h>
 
 // To get a point on a plane:
 //   Multiply the normal by the distance from origin
@@ -43,14 +44,11 @@ static bool8 AABB_CheckInside(AABB a, AABB b)
 		&& InRange_R32(b.Max.z, a.Min.z, a.Max.z);
 }
 
-bool8 AABB_CheckCollision(AABB a, AABB b)
+bool8 AABB_Intersect(AABB a, AABB b)
 {
-	a = AABB_Fix(a);
-	b = AABB_Fix(b);
-
-	return RangesOverlap_R32(a.Min.x, a.Max.x, b.Min.x, b.Max.x)
-		&& RangesOverlap_R32(a.Min.y, a.Max.y, b.Min.y, b.Max.y)
-		&& RangesOverlap_R32(a.Min.z, a.Max.z, b.Min.z, b.Max.z);
+	return a.Min.x <= b.Max.x && b.Min.x <= a.Max.x
+		&& a.Min.y <= b.Max.y && b.Min.y <= a.Max.y
+		&& a.Min.z <= b.Max.z && b.Min.z <= a.Max.z;
 }
 
 AABB AABB_Fix(AABB aabb)
@@ -79,13 +77,201 @@ AABB AABB_Add(AABB a, AABB b)
 	};
 }
 
-AABB AABB_ApplyTransform3D(AABB aabb, Transform3D t)
+// Rotation and scale of a transform as a row-major 3x3, without going through
+// Transform3D_Mat4() and its three 4x4 multiplies.
+static void Transform3D_Basis(Transform3D t, Mat3 out)
+{
+	Quat q = t.Rotation;
+
+	out[0] = (1 - 2 * q.y * q.y - 2 * q.z * q.z) * t.Scale.x;
+	out[1] = (2 * q.x * q.y - 2 * q.z * q.w)     * t.Scale.y;
+	out[2] = (2 * q.x * q.z + 2 * q.y * q.w)     * t.Scale.z;
+
+	out[3] = (2 * q.x * q.y + 2 * q.z * q.w)     * t.Scale.x;
+	out[4] = (1 - 2 * q.x * q.x - 2 * q.z * q.z) * t.Scale.y;
+	out[5] = (2 * q.y * q.z - 2 * q.x * q.w)     * t.Scale.z;
+
+	out[6] = (2 * q.x * q.z - 2 * q.y * q.w)     * t.Scale.x;
+	out[7] = (2 * q.y * q.z + 2 * q.x * q.w)     * t.Scale.y;
+	out[8] = (1 - 2 * q.x * q.x - 2 * q.y * q.y) * t.Scale.z;
+}
+
+// Every corner of the box gets mapped, so the result is the tightest box around
+// the transformed one: the center moves like a point, and each half extent is
+// the sum of the old ones projected onto that axis.
+//
+// Thank you,
+// https://github.com/erich666/GraphicsGems/blob/master/gems/TransBox.c
+static AABB AABB_Transform(AABB aabb, const r32* basis, u32 rowStride, Vec3 translation)
 {
-	Mat4 model;
-	Transform3D_Mat4(t, model);
+	Vec3 center = V3C((aabb.Min.x + aabb.Max.x) * 0.5f,
+	                  (aabb.Min.y + aabb.Max.y) * 0.5f,
+	                  (aabb.Min.z + aabb.Max.z) * 0.5f);
+	Vec3 half   = V3C(fabsf(aabb.Max.x - aabb.Min.x) * 0.5f,
+	                  fabsf(aabb.Max.y - aabb.Min.y) * 0.5f,
+	                  fabsf(aabb.Max.z - aabb.Min.z) * 0.5f);
 
 	AABB res;
-	res.Min = Mat4_MultVec4(model, V4_V3(aabb.Min, 1)).xyz;
-	res.Max = Mat4_MultVec4(model, V4_V3(aabb.Max, 1)).xyz;
-	return AABB_Fix(res);
+	for(u32 i = 0; i < 3; i++) {
+		const r32* row = &basis[i * rowStride];
+
+		r32 c = translation.d[i] + row[0] * center.x + row[1] * center.y + row[2] * center.z;
+		r32 e = fabsf(row[0]) * half.x + fabsf(row[1]) * half.y + fabsf(row[2]) * half.z;
+
+		res.Min.d[i] = c - e;
+		res.Max.d[i] = c + e;
+	}
+	return res;
+}
+
+AABB AABB_ApplyTransform3D(AABB aabb, Transform3D t)
+{
+	Mat3 basis;
+	Transform3D_Basis(t, basis);
+	return AABB_Transform(aabb, basis, 3, t.Position);
+}
+
+AABB AABB_ApplyMat4(AABB aabb, const Mat4 m)
+{
+	return AABB_Transform(aabb, m, 4, V3(m[3], m[7], m[11]));
+}
+
+void AABB_ApplyTransform3D_N(const AABB* boxes, u32 boxStride,
+                             const Transform3D* transforms, u32 transformStride,
+                             AABB* out, u32 count)
+{
+	const u8* box = (const u8*) boxes;
+	const u8* t   = (const u8*) transforms;
+
+	for(u32 i = 0; i < count; i++, box += boxStride, t += transformStride)
+		out[i] = AABB_ApplyTransform3D(*(const AABB*) box, *(const Transform3D*) t);
+}
+
+//
+// OBB
+//
+
+// An OBB in world space. Scale gets applied before rotation, so even a non-uniform
+// one keeps the box a box, it only stretches the half extents.
+typedef struct {
+	Vec3 Center;
+	Vec3 Axes[3]; // Unit length
+	r32  Half[3];
+} OBB_Frame;
+
+static OBB_Frame OBB_FrameFromAABB(AABB aabb)
+{
+	OBB_Frame f = {
+		.Center = V3C((aabb.Min.x + aabb.Max.x) * 0.5f,
+		              (aabb.Min.y + aabb.Max.y) * 0.5f,
+		              (aabb.Min.z + aabb.Max.z) * 0.5f),
+		.Axes   = { V3C(1, 0, 0), V3C(0, 1, 0), V3C(0, 0, 1) },
+		.Half   = { fabsf(aabb.Max.x - aabb.Min.x) * 0.5f,
+		            fabsf(aabb.Max.y - aabb.Min.y) * 0.5f,
+		            fabsf(aabb.Max.z - aabb.Min.z) * 0.5f },
+	};
+	return f;
+}
+
+static OBB_Frame OBB_FrameFromOBB(OBB o)
+{
+	OBB_Frame f = OBB_FrameFromAABB(o.aabb);
+	if(!o.transform)
+		return f;
+
+	Mat3 basis;
+	Transform3D_Basis(*o.transform, basis);
+
+	Vec3 c   = f.Center;
+	Vec3 pos = o.transform->Position;
+	f.Center.x = pos.x + basis[0] * c.x + basis[1] * c.y + basis[2] * c.z;
+	f.Center.y = pos.y + basis[3] * c.x + basis[4] * c.y + basis[5] * c.z;
+	f.Center.z = pos.z + basis[6] * c.x + basis[7] * c.y + basis[8] * c.z;
+
+	for(u32 j = 0; j < 3; j++) {
+		r32 len = sqrtf(basis[j] * basis[j] + basis[3 + j] * basis[3 + j] + basis[6 + j] * basis[6 + j]);
+		if(len <= 0)
+			continue;
+
+		f.Axes[j].x = basis[j]     / len;
+		f.Axes[j].y = basis[3 + j] / len;
+		f.Axes[j].z = basis[6 + j] / len;
+		f.Half[j]  *= len;
+	}
+	return f;
+}
+
+// Vec3_Dot() lives in another file and doesn't get inlined.
+static inline r32 Dot3(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// Separating axis test, the 3 face normals of each box and the 9 cross products of their edges.
+//
+// Thank you,
+// Christer Ericson, Real-Time Collision Detection, 4.4.1
+static bool8 OBB_FramesIntersect(const OBB_Frame* a, const OBB_Frame* b)
+{
+	// Keeps the cross products of nearly parallel edges from turning into noise.
+	static const r32 epsilon = 1e-6f;
+
+	r32 R[3][3], absR[3][3];
+	for(u32 i = 0; i < 3; i++) {
+		for(u32 j = 0; j < 3; j++) {
+			R[i][j]    = Dot3(a->Axes[i], b->Axes[j]);
+			absR[i][j] = fabsf(R[i][j]) + epsilon;
+		}
+	}
+
+	// Offset between the centers, in a's frame.
+	Vec3 d   = V3C(b->Center.x - a->Center.x, b->Center.y - a->Center.y, b->Center.z - a->Center.z);
+	r32 t[3] = { Dot3(d, a->Axes[0]), Dot3(d, a->Axes[1]), Dot3(d, a->Axes[2]) };
+
+	const r32* ea = a->Half;
+	const r32* eb = b->Half;
+	r32 ra, rb;
+
+	// a's axes
+	for(u32 i = 0; i < 3; i++) {
+		ra = ea[i];
+		rb = eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2];
+		if(fabsf(t[i]) > ra + rb)
+			return 0;
+	}
+
+	// b's axes
+	for(u32 j = 0; j < 3; j++) {
+		ra = ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j];
+		rb = eb[j];
+		if(fabsf(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]) > ra + rb)
+			return 0;
+	}
+
+	// a's axis i crossed with b's axis j
+	for(u32 i = 0; i < 3; i++) {
+		u32 i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+
+		for(u32 j = 0; j < 3; j++) {
+			u32 j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+
+			ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+			rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+			if(fabsf(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb)
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+bool8 OBB_Intersect(OBB a, OBB b)
+{
+	OBB_Frame fa = OBB_FrameFromOBB(a);
+	OBB_Frame fb = OBB_FrameFromOBB(b);
+	return OBB_FramesIntersect(&fa, &fb);
+}
+
+bool8 OBB_AABB_Intersect(OBB a, AABB b)
+{
+	OBB_Frame fa = OBB_FrameFromOBB(a);
+	OBB_Frame fb = OBB_FrameFromAABB(b);
+	return OBB_FramesIntersect(&fa, &fb);
 }
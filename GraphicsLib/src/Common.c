@@ -7,6 +7,25 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+// wingdi.h has its own ERROR, which would clash with the log levels.
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
 //
 // Arrays
 //
@@ -94,6 +113,17 @@ r32 String_ToR32_N(const char* str, u32 len) {
 	return res;
 }
 
+r64 String_ToR64_N(const char* str, u32 len) {
+	char tmp[64];
+	char* buf = (len < sizeof(tmp) ? tmp : Allocate(len + 1));
+	memcpy(buf, str, len);
+	buf[len] = '\0';
+
+	r64 res = strtod(buf, NULL);
+	if(buf != tmp) Free(buf);
+	return res;
+}
+
 i32 String_ToI32(const char* str) { return String_ToI32_N(str, strlen(str)); }
 
 i32 String_ToI32_N(const char* str, u32 len) {
@@ -184,6 +214,55 @@ void File_DumpBuffer(const char* filename, const u8* buf, u32 bufSize) {
 	fclose(File);
 }
 
+#ifndef _WIN32
+
+const u8* File_Map(const char* filename, u32* outSize) {
+	if(outSize) *outSize = 0;
+
+	int fd = open(filename, O_RDONLY);
+	if(fd < 0) return NULL;
+
+	struct stat st;
+	if(fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // The mapping stays valid after closing.
+
+	if(data == MAP_FAILED) return NULL;
+
+	if(outSize) *outSize = st.st_size;
+	return data;
+}
+
+void File_Unmap(const u8* data, u32 size) {
+	if(data) munmap((void*) data, size);
+}
+
+#else
+
+// No mmap() here, fall back to reading the whole file.
+const u8* File_Map(const char* filename, u32* outSize) {
+	u32 size = 0;
+	u8* data = File_ReadToBuffer_Alloc(filename, &size);
+
+	if(data && !size) {
+		Free(data);
+		data = NULL;
+	}
+
+	if(outSize) *outSize = size;
+	return data;
+}
+
+void File_Unmap(const u8* data, u32 size) {
+	if(data) Free((void*) data);
+}
+
+#endif
+
 u64 Bytes(u32 amt) { return amt; }
 u64 Kilobytes(u32 amt) { return amt * 1024; }
 u64 Megabytes(u32 amt) { return amt * 1024 * 1024; }
@@ -204,13 +283,22 @@ bool8 Hash_Equal(const u128* a, const u128* b) {
 	return memcmp(a, b, sizeof(u128)) == 0;
 }
 
+// Thank you, http://www.isthe.com/chongo/tech/comp/fnv/
+u64 Hash_FNV1a(const u8* bytes, u32 length) {
+	u64 h = 0xcbf29ce484222325;
+	for(u32 i = 0; i < length; i++) {
+		h ^= bytes[i];
+		h *= 0x100000001b3;
+	}
+	return h;
+}
+
 u128 Hash_String_MD5(const char* str) {
 	return Hash_MD5((const u8*) str, strlen(str));
 }
 
 // Thank you,
 // https://en.wikipedia.org/wiki/MD5#Pseudocode
-// FIXME: Function produces incorrect output.
 u128 Hash_MD5(const u8* bytes, u32 length) {
 	u32 shiftAmts[64] = {
 	    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, //  0 - 15
@@ -259,11 +347,11 @@ u128 Hash_MD5(const u8* bytes, u32 length) {
 	buf[length] = 0x80;
 
 	// append 0x00 until length % 64 = 56
-	memset(buf + length + 1, 0x00, bufLength - length);
+	memset(buf + length + 1, 0x00, bufLength - length - 1);
 
 	// append original length in bits mod 2^64 to message
-	u64 modlen = (length * 8) % ((u64) 1 << 63);
-	memcpy(buf + (bufLength - 1 - sizeof(u64)), &modlen, sizeof(u64));
+	u64 modlen = (u64) length * 8;
+	memcpy(buf + (bufLength - sizeof(u64)), &modlen, sizeof(u64));
 	/*
 	Log(INFO, 
 	    "Length: %d, Padding: %d, Buffer length: %d, Length*8 mod 2^64: %lu", 
@@ -272,7 +360,7 @@ u128 Hash_MD5(const u8* bytes, u32 length) {
 
 	for(u32 i = 0; i < bufLength; i += 64) {
 		u32 A = a0, B = b0, C = c0, D = d0;
-		u32* M = (u32*) buf + i;
+		u32* M = (u32*) (buf + i);
 
 		for(u32 j = 0; j < 64; j++) {
 			u32 F, g;
@@ -309,6 +397,558 @@ u128 Hash_MD5(const u8* bytes, u32 length) {
 	return res;
 }
 
+// --- Arena --- //
+
+struct Arena_Block {
+	Arena_Block* Next;
+	u32 Size, Used;
+	u64 Data[]; // u64 keeps the data aligned to 8 bytes.
+};
+
+void Arena_Init(Arena* a, u32 blockSize) {
+	a->Blocks    = NULL;
+	a->BlockSize = MAX(blockSize, 1024);
+}
+
+void* Arena_Alloc(Arena* a, u32 size) {
+	size = (size + 7) & ~7u;
+
+	Arena_Block* b = a->Blocks;
+	if(!b || b->Size - b->Used < size) {
+		// Big allocations get a block of their own.
+		u32 blockSize = MAX(size, a->BlockSize);
+
+		b       = Allocate(sizeof(Arena_Block) + blockSize);
+		b->Size = blockSize;
+		b->Used = 0;
+
+		// Keep filling the current block if the new one is already used up.
+		if(size >= a->BlockSize && a->Blocks) {
+			b->Next         = a->Blocks->Next;
+			a->Blocks->Next = b;
+		} else {
+			b->Next   = a->Blocks;
+			a->Blocks = b;
+		}
+	}
+
+	void* res = (u8*) b->Data + b->Used;
+	b->Used += size;
+	return res;
+}
+
+void Arena_Reset(Arena* a) {
+	if(!a->Blocks) return;
+
+	Arena_Block* b = a->Blocks->Next;
+	while(b) {
+		Arena_Block* next = b->Next;
+		Free(b);
+		b = next;
+	}
+
+	a->Blocks->Next = NULL;
+	a->Blocks->Used = 0;
+}
+
+void Arena_Free(Arena* a) {
+	Arena_Reset(a);
+	Free(a->Blocks);
+	a->Blocks = NULL;
+}
+
+// --- Jobs --- //
+
+// Atomics, the C11 ones aren't there with MSVC.
+#ifdef _MSC_VER
+#	include <intrin.h>
+
+// Plain volatile reads and writes already acquire and release on x86.
+static inline i32 Atomic_Load(volatile i32* p) {
+	i32 v = *p;
+	_ReadWriteBarrier();
+	return v;
+}
+
+static inline void Atomic_Store(volatile i32* p, i32 v) {
+	_ReadWriteBarrier();
+	*p = v;
+}
+
+static inline i32 Atomic_Add(volatile i32* p, i32 v) { return _InterlockedExchangeAdd((volatile long*) p, v) + v; }
+static inline bool8 Atomic_CAS(volatile i32* p, i32 expected, i32 desired) {
+	return _InterlockedCompareExchange((volatile long*) p, desired, expected) == expected;
+}
+static inline void Atomic_Fence() { MemoryBarrier(); }
+#	define THREAD_LOCAL __declspec(thread)
+#else
+static inline i32 Atomic_Load(volatile i32* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void Atomic_Store(volatile i32* p, i32 v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline i32 Atomic_Add(volatile i32* p, i32 v) { return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST); }
+static inline bool8 Atomic_CAS(volatile i32* p, i32 expected, i32 desired) {
+	return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+static inline void Atomic_Fence() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#	define THREAD_LOCAL _Thread_local
+#endif
+
+static inline void Thread_Pause() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	_mm_pause();
+#endif
+}
+
+#ifdef _WIN32
+typedef HANDLE Thread;
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Cond;
+
+#define MUTEX_INITIALIZER SRWLOCK_INIT
+
+static void Mutex_Init(Mutex* m) { InitializeSRWLock(m); }
+static void Mutex_Destroy(Mutex* m) { (void) m; }
+static void Mutex_Lock(Mutex* m) { AcquireSRWLockExclusive(m); }
+static void Mutex_Unlock(Mutex* m) { ReleaseSRWLockExclusive(m); }
+
+static void Cond_Init(Cond* c) { InitializeConditionVariable(c); }
+static void Cond_Destroy(Cond* c) { (void) c; }
+static void Cond_Wait(Cond* c, Mutex* m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void Cond_Signal(Cond* c) { WakeConditionVariable(c); }
+static void Cond_Broadcast(Cond* c) { WakeAllConditionVariable(c); }
+
+static void Thread_Yield() { SwitchToThread(); }
+
+static u32 Thread_NumCores() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+#else
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Cond;
+
+#define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+static void Mutex_Init(Mutex* m) { pthread_mutex_init(m, NULL); }
+static void Mutex_Destroy(Mutex* m) { pthread_mutex_destroy(m); }
+static void Mutex_Lock(Mutex* m) { pthread_mutex_lock(m); }
+static void Mutex_Unlock(Mutex* m) { pthread_mutex_unlock(m); }
+
+static void Cond_Init(Cond* c) { pthread_cond_init(c, NULL); }
+static void Cond_Destroy(Cond* c) { pthread_cond_destroy(c); }
+static void Cond_Wait(Cond* c, Mutex* m) { pthread_cond_wait(c, m); }
+static void Cond_Signal(Cond* c) { pthread_cond_signal(c); }
+static void Cond_Broadcast(Cond* c) { pthread_cond_broadcast(c); }
+
+static void Thread_Yield() { sched_yield(); }
+
+static u32 Thread_NumCores() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? n : 1;
+}
+#endif
+
+struct Job {
+	Job_Func Func;
+	Job_ForFunc ForFunc; // Set instead of Func for a piece of Job_ParallelFor().
+	void* Data;
+	u32 Begin, End, Batch;
+
+	Job_Counter* Counter;
+	Job* Next; // In a counter's waiting list.
+};
+
+// The owner pushes and pops at Bottom, everyone else steals at Top.
+// Both only ever go up and wrap around, (i32)(Bottom - Top) is how many jobs there are.
+// The two ends get their own cache lines so the owner and the thieves don't fight over them.
+typedef struct {
+	volatile i32 Top;
+	u8 _pad0[60];
+	volatile i32 Bottom;
+	u8 _pad1[60];
+
+	Job Jobs[JOB_QUEUE_SIZE];
+} Job_Queue;
+
+static struct {
+	bool8 Initialized;
+	u32 NumThreads;
+
+	Job_Queue* Queues; // One per thread, the one that called Job_Init() is 0.
+	Thread Workers[JOB_MAX_THREADS];
+
+	volatile i32 Queued;   // Jobs sitting in any of the queues.
+	volatile i32 Sleepers; // Workers waiting on WorkReady.
+	volatile i32 Quit;
+
+	Mutex SleepLock;
+	Cond WorkReady;
+
+	Mutex WaitingLock; // Guards every counter's waiting list.
+} Jobs;
+
+// -1 on threads outside of the pool.
+static THREAD_LOCAL i32 Job_ThreadIndex = -1;
+static THREAD_LOCAL u32 Job_Random      = 0;
+
+static void Job_Execute(Job job);
+
+static bool8 Job_Queue_Push(Job_Queue* q, const Job* job) {
+	u32 b = Atomic_Load(&q->Bottom);
+	u32 t = Atomic_Load(&q->Top);
+
+	if((i32) (b - t) >= JOB_QUEUE_SIZE) return 0;
+
+	q->Jobs[b % JOB_QUEUE_SIZE] = *job;
+	Atomic_Store(&q->Bottom, b + 1);
+	return 1;
+}
+
+static bool8 Job_Queue_Pop(Job_Queue* q, Job* out) {
+	u32 b = (u32) Atomic_Load(&q->Bottom) - 1;
+	Atomic_Store(&q->Bottom, b);
+	Atomic_Fence();
+	u32 t = Atomic_Load(&q->Top);
+
+	if((i32) (b - t) < 0) {
+		Atomic_Store(&q->Bottom, b + 1);
+		return 0;
+	}
+
+	*out = q->Jobs[b % JOB_QUEUE_SIZE];
+	if(b != t) return 1;
+
+	// The last job, a thief might be going for it too.
+	bool8 won = Atomic_CAS(&q->Top, t, t + 1);
+	Atomic_Store(&q->Bottom, b + 1);
+	return won;
+}
+
+static bool8 Job_Queue_Steal(Job_Queue* q, Job* out) {
+	u32 t = Atomic_Load(&q->Top);
+	Atomic_Fence();
+	u32 b = Atomic_Load(&q->Bottom);
+
+	if((i32) (b - t) <= 0) return 0;
+
+	// This copy might be torn if the owner wraps around onto it, but then Top
+	// has moved on and the CAS throws it away.
+	*out = q->Jobs[t % JOB_QUEUE_SIZE];
+	return Atomic_CAS(&q->Top, t, t + 1);
+}
+
+static void Job_Push(const Job* job) {
+	if(Job_ThreadIndex < 0 || !Job_Queue_Push(&Jobs.Queues[Job_ThreadIndex], job)) {
+		Job_Execute(*job);
+		return;
+	}
+
+	Atomic_Add(&Jobs.Queued, 1);
+	Atomic_Fence();
+
+	if(Atomic_Load(&Jobs.Sleepers)) {
+		Mutex_Lock(&Jobs.SleepLock);
+		Cond_Signal(&Jobs.WorkReady);
+		Mutex_Unlock(&Jobs.SleepLock);
+	}
+}
+
+// Pop a job off this thread's queue, or steal one from somebody else's.
+static bool8 Job_Take(Job* out) {
+	i32 self = Job_ThreadIndex;
+
+	if(self >= 0 && Job_Queue_Pop(&Jobs.Queues[self], out)) {
+		Atomic_Add(&Jobs.Queued, -1);
+		return 1;
+	}
+
+	// xorshift, so every thief starts looking somewhere else.
+	u32 r = Job_Random ? Job_Random : (u32) (self + 2) * 2654435761u;
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	Job_Random = r;
+
+	for(u32 i = 0; i < Jobs.NumThreads; i++) {
+		u32 victim = (r + i) % Jobs.NumThreads;
+		if((i32) victim == self) continue;
+
+		if(Job_Queue_Steal(&Jobs.Queues[victim], out)) {
+			Atomic_Add(&Jobs.Queued, -1);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void Job_Finish(Job_Counter* c) {
+	if(!c) return;
+
+	for(;;) {
+		i32 v = Atomic_Load(&c->Value);
+
+		if(v > 1) {
+			if(Atomic_CAS(&c->Value, v, v - 1)) return;
+			continue;
+		}
+
+		// The last one. The counter can go away as soon as it reads zero,
+		// so the waiting list has to be taken off it before that.
+		Mutex_Lock(&Jobs.WaitingLock);
+		Job* waiting = c->Waiting;
+		c->Waiting   = NULL;
+
+		bool8 last = Atomic_CAS(&c->Value, 1, 0);
+		if(!last) c->Waiting = waiting;
+		Mutex_Unlock(&Jobs.WaitingLock);
+
+		if(!last) continue;
+
+		while(waiting) {
+			Job* next = waiting->Next;
+			Job_Push(waiting);
+			Free(waiting);
+			waiting = next;
+		}
+		return;
+	}
+}
+
+static void Job_Execute(Job job) {
+	if(job.ForFunc) {
+		// Keep handing off the back half until the piece is small enough,
+		// idle threads steal those and split them further.
+		while(job.End - job.Begin > job.Batch) {
+			Job half   = job;
+			half.Begin = job.Begin + (job.End - job.Begin) / 2;
+			job.End    = half.Begin;
+
+			Atomic_Add(&job.Counter->Value, 1);
+			Job_Push(&half);
+		}
+
+		job.ForFunc(job.Data, job.Begin, job.End);
+	} else {
+		job.Func(job.Data);
+	}
+
+	Job_Finish(job.Counter);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI Job_Worker(LPVOID arg)
+#else
+static void* Job_Worker(void* arg)
+#endif
+{
+	Job_ThreadIndex = (i32) (size_t) arg;
+
+	// Quitting waits for the queues to empty, jobs that are running can still queue up more.
+	u32 idle = 0;
+	while(!Atomic_Load(&Jobs.Quit) || Atomic_Load(&Jobs.Queued)) {
+		Job job;
+		if(Job_Take(&job)) {
+			Job_Execute(job);
+			idle = 0;
+			continue;
+		}
+
+		// Spin for a bit in case more work shows up soon, then go to sleep.
+		if(++idle < 256) {
+			Thread_Pause();
+			continue;
+		}
+		idle = 0;
+
+		Mutex_Lock(&Jobs.SleepLock);
+		Atomic_Add(&Jobs.Sleepers, 1);
+		Atomic_Fence();
+
+		while(!Atomic_Load(&Jobs.Queued) && !Atomic_Load(&Jobs.Quit))
+			Cond_Wait(&Jobs.WorkReady, &Jobs.SleepLock);
+
+		Atomic_Add(&Jobs.Sleepers, -1);
+		Mutex_Unlock(&Jobs.SleepLock);
+	}
+
+	return 0;
+}
+
+void Job_Init(u32 numWorkers) {
+	if(Jobs.Initialized) {
+		Log(WARN, "[Job] Already initialized.", "");
+		return;
+	}
+
+	if(!numWorkers) numWorkers = Thread_NumCores() - 1;
+	numWorkers = MIN(numWorkers, JOB_MAX_THREADS - 1);
+
+	Jobs.NumThreads = numWorkers + 1;
+	Jobs.Queues     = Allocate(sizeof(Job_Queue) * Jobs.NumThreads);
+	memset(Jobs.Queues, 0, sizeof(Job_Queue) * Jobs.NumThreads);
+
+	Jobs.Queued   = 0;
+	Jobs.Sleepers = 0;
+	Jobs.Quit     = 0;
+
+	Mutex_Init(&Jobs.SleepLock);
+	Mutex_Init(&Jobs.WaitingLock);
+	Cond_Init(&Jobs.WorkReady);
+
+	Job_ThreadIndex  = 0;
+	Jobs.Initialized = 1;
+
+	for(u32 i = 1; i < Jobs.NumThreads; i++) {
+#ifdef _WIN32
+		Jobs.Workers[i] = CreateThread(NULL, 0, Job_Worker, (LPVOID) (size_t) i, 0, NULL);
+		if(!Jobs.Workers[i])
+#else
+		if(pthread_create(&Jobs.Workers[i], NULL, Job_Worker, (void*) (size_t) i))
+#endif
+			Log(FATAL, "[Job] Couldn't start worker thread %u.", i);
+	}
+
+	Log(INFO, "[Job] Started %u worker threads.", numWorkers);
+}
+
+void Job_Shutdown() {
+	if(!Jobs.Initialized) return;
+
+	// Run whatever's still queued, so every counter gets back to zero. The workers help,
+	// and keep going after Quit until there's nothing left.
+	u32 idle = 0;
+	while(Atomic_Load(&Jobs.Queued) > 0) {
+		Job job;
+		if(Job_Take(&job)) {
+			Job_Execute(job);
+			idle = 0;
+		} else if(++idle < 256) {
+			Thread_Pause();
+		} else {
+			Thread_Yield();
+		}
+	}
+
+	Mutex_Lock(&Jobs.SleepLock);
+	Atomic_Store(&Jobs.Quit, 1);
+	Cond_Broadcast(&Jobs.WorkReady);
+	Mutex_Unlock(&Jobs.SleepLock);
+
+	for(u32 i = 1; i < Jobs.NumThreads; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(Jobs.Workers[i], INFINITE);
+		CloseHandle(Jobs.Workers[i]);
+#else
+		pthread_join(Jobs.Workers[i], NULL);
+#endif
+	}
+
+	Cond_Destroy(&Jobs.WorkReady);
+	Mutex_Destroy(&Jobs.WaitingLock);
+	Mutex_Destroy(&Jobs.SleepLock);
+
+	Free(Jobs.Queues);
+	Jobs.Queues      = NULL;
+	Jobs.NumThreads  = 0;
+	Jobs.Initialized = 0;
+	Job_ThreadIndex  = -1;
+}
+
+u32 Job_NumThreads() { return Jobs.Initialized ? Jobs.NumThreads : 1; }
+
+void Job_Run(Job_Func func, void* data, Job_Counter* counter) {
+	if(counter) Atomic_Add(&counter->Value, 1);
+
+	Job job = { .Func = func, .Data = data, .Counter = counter };
+	Job_Push(&job);
+}
+
+void Job_RunAfter(Job_Counter* dependency, Job_Func func, void* data, Job_Counter* counter) {
+	if(counter) Atomic_Add(&counter->Value, 1);
+
+	Job job = { .Func = func, .Data = data, .Counter = counter };
+
+	// Job_Finish() takes the list and zeroes the counter while holding the lock,
+	// so the job either goes on the list in time or sees zero here.
+	if(Jobs.Initialized) {
+		Mutex_Lock(&Jobs.WaitingLock);
+
+		if(Atomic_Load(&dependency->Value) > 0) {
+			Job* waiting        = Allocate(sizeof(Job));
+			*waiting            = job;
+			waiting->Next       = dependency->Waiting;
+			dependency->Waiting = waiting;
+
+			Mutex_Unlock(&Jobs.WaitingLock);
+			return;
+		}
+
+		Mutex_Unlock(&Jobs.WaitingLock);
+	}
+
+	Job_Push(&job);
+}
+
+void Job_Wait(Job_Counter* counter) {
+	u32 idle = 0;
+	while(Atomic_Load(&counter->Value) > 0) {
+		Job job;
+		if(Jobs.Initialized && Job_Take(&job)) {
+			Job_Execute(job);
+			idle = 0;
+		} else if(++idle < 256) {
+			Thread_Pause();
+		} else {
+			Thread_Yield();
+		}
+	}
+}
+
+bool8 Job_IsDone(Job_Counter* counter) { return Atomic_Load(&counter->Value) <= 0; }
+
+// 0 hasn't run, 1 is running and 2 is done.
+void Job_RunOnce(Job_Once* once, Job_Func func, void* data) {
+	if(Atomic_Load(once) == 2) return;
+
+	if(Atomic_CAS(once, 0, 1)) {
+		func(data);
+		Atomic_Store(once, 2);
+		return;
+	}
+
+	while(Atomic_Load(once) != 2) Thread_Yield();
+}
+
+void Job_Lock(Job_Mutex* mutex) {
+	while(!Atomic_CAS(mutex, 0, 1)) Thread_Yield();
+}
+
+void Job_Unlock(Job_Mutex* mutex) { Atomic_Store(mutex, 0); }
+
+void Job_ParallelFor(u32 count, u32 batch, Job_ForFunc func, void* data) {
+	if(!count) return;
+	if(!batch) batch = MAX(count / (Job_NumThreads() * 4), 1);
+
+	if(count <= batch || Job_ThreadIndex < 0) {
+		func(data, 0, count);
+		return;
+	}
+
+	Job_Counter counter = { .Value = 1 };
+	Job_Execute((Job) {
+		.ForFunc = func,
+		.Data    = data,
+		.Begin   = 0,
+		.End     = count,
+		.Batch   = batch,
+		.Counter = &counter,
+	});
+
+	Job_Wait(&counter);
+}
+
 typedef struct Allocation Allocation;
 typedef struct Array_Allocation Array_Allocation;
 
@@ -347,8 +987,11 @@ void Array_Allocation_Remove(Array_Allocation* a, u32 idx) {
 
 #ifdef ALLOC_DEBUG
 
+// Job workers allocate too, so the bookkeeping is behind a lock. It's set up
+// statically, so it works before Job_Init() as well.
 static Array_Allocation Allocs = {0};
 static u32 SizesSum            = 0;
+static Mutex AllocsLock        = MUTEX_INITIALIZER;
 
 static i32 Allocation_FindPtr(void* f) {
 	if(!f) return -1;
@@ -375,9 +1018,15 @@ static i32 Allocation_FindPtr(void* f) {
 #	else
 #		define CHECK_ALLOC_LIMIT(sz)
 #	endif
-u32 Alloc_GetTotalSize() { return SizesSum; }
+u32 Alloc_GetTotalSize() {
+	Mutex_Lock(&AllocsLock);
+	u32 sum = SizesSum;
+	Mutex_Unlock(&AllocsLock);
+	return sum;
+}
 
 void Alloc_PrintInfo() {
+	Mutex_Lock(&AllocsLock);
 	Log(INFO, "Allocated memory: %.2f kiB (%d bytes)", SizesSum / 1024.0, SizesSum);
 
 	for(u32 i = 0; i < Allocs.Size; i++) {
@@ -388,6 +1037,7 @@ void Alloc_PrintInfo() {
 		    Allocs.Data[i].Line,
 		    Allocs.Data[i].Function);
 	}
+	Mutex_Unlock(&AllocsLock);
 }
 
 void* Allocate(u32 size, const char* __func, const char* __file, u32 __line) {
@@ -415,8 +1065,10 @@ void* Allocate(u32 size, const char* __func, const char* __file, u32 __line) {
 		return NULL;
 	}
 
+	Mutex_Lock(&AllocsLock);
 	Array_Allocation_Push(&Allocs, &a);
 	SizesSum += a.Size;
+	Mutex_Unlock(&AllocsLock);
 	return a.Ptr;
 }
 
@@ -430,8 +1082,12 @@ void* Reallocate(void* ptr, u32 newSize, const char* __func, const char* __file,
 
 	CHECK_ALLOC_LIMIT(newSize);
 
+	// Held until the entry is updated, another thread could move it meanwhile.
+	Mutex_Lock(&AllocsLock);
+
 	i32 i = Allocation_FindPtr(ptr);
 	if(i < 0 && ptr) {
+		Mutex_Unlock(&AllocsLock);
 		Log(ERROR, "Attempted to reallocate invalid pointer 0x%x.", ptr);
 		Log(ERROR, "  (Called from [%s:%d %s()])", __file, __line, __func);
 		return NULL;
@@ -439,6 +1095,7 @@ void* Reallocate(void* ptr, u32 newSize, const char* __func, const char* __file,
 
 	void* newPtr = realloc(ptr, newSize);
 	if(!newPtr) {
+		Mutex_Unlock(&AllocsLock);
 		Log(ERROR, "Reallocation of pointer 0x%x with new size %d bytes failed.",
 		    newSize);
 
@@ -463,15 +1120,18 @@ void* Reallocate(void* ptr, u32 newSize, const char* __func, const char* __file,
 	strcpy(Allocs.Data[i].File, __file);
 	strcpy(Allocs.Data[i].Function, __func);
 
+	Mutex_Unlock(&AllocsLock);
 	return newPtr;
 }
 
 void Free(void* ptr, const char* __func, const char* __file, u32 __line) {
 	if(!ptr) return;
 
+	Mutex_Lock(&AllocsLock);
 	i32 i = Allocation_FindPtr(ptr);
 
 	if(i < 0) {
+		Mutex_Unlock(&AllocsLock);
 		Log(ERROR, "Attempt to free invalid pointer 0x%x.", ptr);
 		Log(ERROR, "  (Called from [%s:%d %s])", __file, __line, __func);
 		return;
@@ -479,10 +1139,12 @@ void Free(void* ptr, const char* __func, const char* __file, u32 __line) {
 
 	SizesSum -= Allocs.Data[i].Size;
 	Array_Allocation_Remove(&Allocs, i);
+	Mutex_Unlock(&AllocsLock);
 	free(ptr);
 }
 
 void Alloc_FreeAll() {
+	Mutex_Lock(&AllocsLock);
 	SizesSum = 0;
 	for(u32 i = 0; i < Allocs.Size; ++i) free(Allocs.Data[i].Ptr);
 	free(Allocs.Data);
@@ -490,8 +1152,9 @@ void Alloc_FreeAll() {
 	Allocs.Data     = NULL;
 	Allocs.Size     = 0;
 	Allocs.Capacity = 0;
+	Mutex_Unlock(&AllocsLock);
 }
-#endif
+#else
 
 void* Allocate(u32 size) { 
 	return malloc(size);
@@ -515,6 +1178,7 @@ void Alloc_PrintInfo() {
 void Alloc_FreeAll() {
 	Log(WARN, "Allocation debugging disabled.", "");
 }
+#endif
 
 // --- Logging --- //
 
@@ -3,48 +3,827 @@
 #include "../JSON.h"
 
 #include <stdlib.h>
-#include <assert.h>
+#include <string.h>
 
-GLTF_Asset* GLTF_LoadFile(const char* filename) {
-	JSON_Value v = JSON_FromFile(filename);
+#define GLB_MAGIC      0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A // "JSON"
+#define GLB_CHUNK_BIN  0x004E4942 // "BIN\0"
 
-	if (v.Type == JSON_Error) {
-		Log(ERROR, "[GLTF] Error reading %s.", filename);
-		return NULL;
+//
+// Helpers
+//
+
+static u32 ReadU32(const u8* p) {
+	// .glb files are little endian.
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32) p[3] << 24);
+}
+
+static char* String_Copy_N(const char* str, u32 len) {
+	char* res = Allocate(len + 1);
+	memcpy(res, str, len);
+	res[len] = '\0';
+	return res;
+}
+
+// Thank you, https://en.wikipedia.org/wiki/Base64
+static u8* Base64_Decode(const char* str, u32 len, u32* outSize) {
+	static i8 table[256];
+	if(!table['B']) {
+		memset(table, -1, sizeof(table));
+
+		const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		for(u32 i = 0; i < 64; i++) table[(u8) alphabet[i]] = i;
 	}
 
-	if(v.Type != JSON_Object) {
-		Log(ERROR, "[GLTF] %s doesn't seem to contain valid GLTF.", filename);
-		return NULL;
+	u8* res = Allocate(MAX(len / 4 * 3 + 3, 1));
+
+	u32 size = 0, bits = 0, numBits = 0;
+	for(u32 i = 0; i < len && str[i] != '='; i++) {
+		i8 v = table[(u8) str[i]];
+		if(v < 0) {
+			Free(res);
+			return NULL;
+		}
+
+		bits = (bits << 6) | v;
+		numBits += 6;
+
+		if(numBits >= 8) {
+			numBits -= 8;
+			res[size++] = (bits >> numBits) & 0xFF;
+		}
+	}
+
+	*outSize = size;
+	return res;
+}
+
+//
+// Accessors
+//
+
+u32 GLTF_Accessor_NumComponents(const GLTF_Accessor* a) {
+	static const u32 numComponents[] = {
+		[Type_Scalar] = 1,
+		[Type_Vec2] = 2, [Type_Vec3] = 3, [Type_Vec4] = 4,
+		[Type_Mat2] = 4, [Type_Mat3] = 9, [Type_Mat4] = 16,
+	};
+	return numComponents[a->type];
+}
+
+u32 GLTF_Accessor_ElementSize(const GLTF_Accessor* a) {
+	u32 componentSize = 0;
+	switch(a->componentType) {
+		case Component_Byte:
+		case Component_UnsignedByte: componentSize = 1; break;
+		case Component_Short:
+		case Component_UnsignedShort: componentSize = 2; break;
+		case Component_UnsignedInt:
+		case Component_Float: componentSize = 4; break;
+	}
+	return componentSize * GLTF_Accessor_NumComponents(a);
+}
+
+u32 GLTF_Accessor_Stride(const GLTF_Accessor* a) {
+	if(a->bufferView && a->bufferView->stride) return a->bufferView->stride;
+	return GLTF_Accessor_ElementSize(a);
+}
+
+const u8* GLTF_Accessor_Data(const GLTF_Accessor* a) {
+	if(!a->bufferView) return NULL;
+	return a->bufferView->buffer->data + a->bufferView->offset + a->byteOffset;
+}
+
+//
+// Reading
+//
+
+// The JSON is read with the streaming reader, so nothing is built up for the
+// parts of the file we don't care about (animations, materials, extensions...).
+//
+// Objects can point to things that haven't been read yet, so while reading
+// every pointer to another object holds its index + 1 instead (0 being NULL).
+// Once everything's been read they get turned into real pointers and checked.
+
+typedef struct {
+	JSON_Reader Reader;
+	GLTF_Asset* Asset;
+
+	const char* Filename;
+	const u8* Bin;
+	u32 BinSize;
+
+	bool8 HasVersion;
+} GLTF_Loader;
+
+typedef bool8 (*GLTF_ReadFunc)(GLTF_Loader* l, void* item, u32 index);
+
+static bool8 GLTF_Expect(JSON_Reader* r, enum JSON_Event e) { return JSON_Reader_Next(r) == e; }
+
+// Returns 1 for a key, 0 at the end of the object and -1 on errors.
+static i32 GLTF_NextKey(JSON_Reader* r) {
+	enum JSON_Event e = JSON_Reader_Next(r);
+	if(e == JSON_Event_Key) return 1;
+	return (e == JSON_Event_EndObject ? 0 : -1);
+}
+
+static bool8 GLTF_ReadNumber(JSON_Reader* r, r64* out) {
+	if(!GLTF_Expect(r, JSON_Event_Number)) return 0;
+	*out = r->Number;
+	return 1;
+}
+
+static bool8 GLTF_ReadU32(JSON_Reader* r, u32* out) {
+	r64 n;
+	if(!GLTF_ReadNumber(r, &n) || n < 0 || n > UINT32_MAX || n != (u32) n) return 0;
+	*out = n;
+	return 1;
+}
+
+static bool8 GLTF_ReadIndex(JSON_Reader* r, void* out) {
+	u32 n;
+	if(!GLTF_ReadU32(r, &n) || n >= INT32_MAX) return 0;
+	*(uintptr_t*) out = n + 1;
+	return 1;
+}
+
+static bool8 GLTF_ReadBool(JSON_Reader* r, bool8* out) {
+	if(!GLTF_Expect(r, JSON_Event_Boolean)) return 0;
+	*out = r->Boolean;
+	return 1;
+}
+
+static bool8 GLTF_ReadName(JSON_Reader* r, const char** out) {
+	if(!GLTF_Expect(r, JSON_Event_String)) return 0;
+	Free((void*) *out);
+	*out = String_Copy_N(r->String, r->StringLength);
+	return 1;
+}
+
+// Read up to `max` numbers from an array into `out`, returns how many were read or -1.
+static i32 GLTF_ReadNumbers(JSON_Reader* r, r32* out, u32 max) {
+	if(!GLTF_Expect(r, JSON_Event_BeginArray)) return -1;
+
+	u32 n = 0;
+	enum JSON_Event e;
+	while((e = JSON_Reader_Next(r)) == JSON_Event_Number) {
+		if(n < max) out[n] = r->Number;
+		n++;
+	}
+
+	return (e == JSON_Event_EndArray ? (i32) MIN(n, max) : -1);
+}
+
+// Read an array of things into a growing array.
+static bool8 GLTF_ReadArray(GLTF_Loader* l, void** items, u32* count, u32 itemSize, GLTF_ReadFunc read) {
+	JSON_Reader* r = &l->Reader;
+	if(*items || !GLTF_Expect(r, JSON_Event_BeginArray)) return 0;
+
+	u32 capacity = 4;
+	*items       = Allocate(itemSize * capacity);
+
+	while(1) {
+		// The read functions pick up from the item's first event.
+		enum JSON_Event e = JSON_Reader_Next(r);
+		if(e == JSON_Event_EndArray) return 1;
+		if(e < JSON_Event_BeginObject) return 0;
+
+		if(*count == capacity) {
+			capacity *= 2;
+			*items = Reallocate(*items, itemSize * capacity);
+		}
+
+		// Count it before reading, so GLTF_Free() cleans up half-read items too.
+		u8* item = (u8*) *items + itemSize * *count;
+		memset(item, 0, itemSize);
+		(*count)++;
+
+		if(!read(l, item, *count - 1)) return 0;
+	}
+}
+
+static bool8 GLTF_ReadIndexItem(GLTF_Loader* l, void* item, u32 index) {
+	(void) index;
+	JSON_Reader* r = &l->Reader;
+	if(r->LastEvent != JSON_Event_Number || r->Number < 0 || r->Number >= INT32_MAX
+	   || r->Number != (u32) r->Number)
+		return 0;
+
+	*(uintptr_t*) item = (u32) r->Number + 1;
+	return 1;
+}
+
+static bool8 GLTF_ReadBuffer(GLTF_Loader* l, void* item, u32 index) {
+	JSON_Reader* r   = &l->Reader;
+	GLTF_Buffer* buf = item;
+	u32 byteLength   = 0;
+	bool8 hasURI     = 0;
+	i32 k;
+
+	if(r->LastEvent != JSON_Event_BeginObject) return 0;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "name")) {
+			ok = GLTF_ReadName(r, &buf->name);
+		} else if(JSON_Reader_StringIs(r, "byteLength")) {
+			ok = GLTF_ReadU32(r, &byteLength);
+		} else if(JSON_Reader_StringIs(r, "uri")) {
+			if(hasURI || !GLTF_Expect(r, JSON_Event_String)) return 0;
+			hasURI = 1;
+
+			const char* uri = r->String;
+			u32 uriLen      = r->StringLength;
+
+			if(uriLen >= 5 && memcmp(uri, "data:", 5) == 0) {
+				const char* data = NULL;
+				for(u32 i = 5; i + 8 <= uriLen && !data; i++)
+					if(memcmp(uri + i, ";base64,", 8) == 0) data = uri + i + 8;
+
+				if(!data) {
+					Log(ERROR, "[GLTF] Buffer %d has a data URI that isn't base64.", index);
+					return 0;
+				}
+
+				buf->storage = Storage_Allocated;
+				buf->data    = Base64_Decode(data, uri + uriLen - data, &buf->size);
+			} else {
+				// External files are relative to the .gltf.
+				const char* slash = strrchr(l->Filename, '/');
+				u32 dirLen        = (slash ? slash - l->Filename + 1 : 0);
+
+				char* path = Allocate(dirLen + uriLen + 1);
+				memcpy(path, l->Filename, dirLen);
+				memcpy(path + dirLen, uri, uriLen);
+				path[dirLen + uriLen] = '\0';
+
+				buf->storage = Storage_Mapped;
+				buf->data    = File_Map(path, &buf->size);
+
+				if(!buf->data) Log(ERROR, "[GLTF] Couldn't open buffer \"%s\".", path);
+				Free(path);
+			}
+
+			ok = (buf->data != NULL);
+		} else {
+			JSON_Reader_Skip(r);
+		}
+
+		if(!ok) return 0;
+	}
+
+	if(k < 0) return 0;
+
+	if(!hasURI) {
+		// Only the first buffer of a .glb may point to the BIN chunk.
+		if(index != 0 || !l->Bin) {
+			Log(ERROR, "[GLTF] Buffer %d has no URI and there's no BIN chunk.", index);
+			return 0;
+		}
+
+		buf->storage = Storage_GLB;
+		buf->data    = l->Bin;
+		buf->size    = l->BinSize;
+	}
+
+	if(buf->size < byteLength) {
+		Log(ERROR, "[GLTF] Buffer %d is %d bytes, expected %d.", index, buf->size, byteLength);
+		return 0;
+	}
+
+	return 1;
+}
+
+static bool8 GLTF_ReadBufferView(GLTF_Loader* l, void* item, u32 index) {
+	(void) index;
+	JSON_Reader* r      = &l->Reader;
+	GLTF_BufferView* bv = item;
+	i32 k;
+
+	if(r->LastEvent != JSON_Event_BeginObject) return 0;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "buffer"))
+			ok = GLTF_ReadIndex(r, &bv->buffer);
+		else if(JSON_Reader_StringIs(r, "byteOffset"))
+			ok = GLTF_ReadU32(r, &bv->offset);
+		else if(JSON_Reader_StringIs(r, "byteLength"))
+			ok = GLTF_ReadU32(r, &bv->length);
+		else if(JSON_Reader_StringIs(r, "byteStride"))
+			ok = GLTF_ReadU32(r, &bv->stride);
+		else if(JSON_Reader_StringIs(r, "target"))
+			ok = GLTF_ReadU32(r, &bv->target);
+		else
+			JSON_Reader_Skip(r);
+
+		if(!ok) return 0;
+	}
+
+	return k == 0;
+}
+
+static bool8 GLTF_ReadAccessor(GLTF_Loader* l, void* item, u32 index) {
+	static const char* typeNames[] = {
+		[Type_Scalar] = "SCALAR",
+		[Type_Vec2] = "VEC2", [Type_Vec3] = "VEC3", [Type_Vec4] = "VEC4",
+		[Type_Mat2] = "MAT2", [Type_Mat3] = "MAT3", [Type_Mat4] = "MAT4",
+	};
+
+	JSON_Reader* r   = &l->Reader;
+	GLTF_Accessor* a = item;
+	i32 numMin = 0, numMax = 0, k;
+
+	if(r->LastEvent != JSON_Event_BeginObject) return 0;
+
+	a->type = -1;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "name")) {
+			ok = GLTF_ReadName(r, &a->name);
+		} else if(JSON_Reader_StringIs(r, "bufferView")) {
+			ok = GLTF_ReadIndex(r, &a->bufferView);
+		} else if(JSON_Reader_StringIs(r, "byteOffset")) {
+			ok = GLTF_ReadU32(r, &a->byteOffset);
+		} else if(JSON_Reader_StringIs(r, "componentType")) {
+			u32 componentType = 0;
+			ok                = GLTF_ReadU32(r, &componentType);
+			a->componentType  = componentType;
+		} else if(JSON_Reader_StringIs(r, "count")) {
+			ok = GLTF_ReadU32(r, &a->count);
+		} else if(JSON_Reader_StringIs(r, "normalized")) {
+			ok = GLTF_ReadBool(r, &a->normalized);
+		} else if(JSON_Reader_StringIs(r, "type")) {
+			ok = GLTF_Expect(r, JSON_Event_String);
+			for(u32 t = 0; ok && t < sizeof(typeNames) / sizeof(typeNames[0]); t++)
+				if(JSON_Reader_StringIs(r, typeNames[t])) a->type = t;
+		} else if(JSON_Reader_StringIs(r, "min")) {
+			ok = (numMin = GLTF_ReadNumbers(r, (r32*) &a->min, 16)) >= 0;
+		} else if(JSON_Reader_StringIs(r, "max")) {
+			ok = (numMax = GLTF_ReadNumbers(r, (r32*) &a->max, 16)) >= 0;
+		} else {
+			JSON_Reader_Skip(r);
+		}
+
+		if(!ok) return 0;
+	}
+
+	if(k < 0) return 0;
+
+	if((i32) a->type < 0 || !GLTF_Accessor_ElementSize(a)) {
+		Log(ERROR, "[GLTF] Accessor %d has an unknown type or component type.", index);
+		return 0;
+	}
+
+	i32 numComponents = GLTF_Accessor_NumComponents(a);
+	a->hasMinMax      = (numMin == numComponents && numMax == numComponents);
+	return 1;
+}
+
+static bool8 GLTF_ReadPrimitive(GLTF_Loader* l, void* item, u32 index) {
+	(void) index;
+	JSON_Reader* r       = &l->Reader;
+	GLTF_Primitive* prim = item;
+	i32 k;
+
+	if(r->LastEvent != JSON_Event_BeginObject) return 0;
+
+	prim->mode     = 4; // Triangles
+	prim->material = -1;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "attributes")) {
+			if(!GLTF_Expect(r, JSON_Event_BeginObject)) return 0;
+
+			while((k = GLTF_NextKey(r)) > 0) {
+				if(JSON_Reader_StringIs(r, "POSITION"))
+					ok = GLTF_ReadIndex(r, &prim->position);
+				else if(JSON_Reader_StringIs(r, "NORMAL"))
+					ok = GLTF_ReadIndex(r, &prim->normal);
+				else if(JSON_Reader_StringIs(r, "TEXCOORD_0"))
+					ok = GLTF_ReadIndex(r, &prim->texCoord);
+				else
+					JSON_Reader_Skip(r);
+
+				if(!ok) return 0;
+			}
+
+			ok = (k == 0);
+		} else if(JSON_Reader_StringIs(r, "indices")) {
+			ok = GLTF_ReadIndex(r, &prim->indices);
+		} else if(JSON_Reader_StringIs(r, "mode")) {
+			ok = GLTF_ReadU32(r, &prim->mode);
+		} else if(JSON_Reader_StringIs(r, "material")) {
+			u32 material   = 0;
+			ok             = GLTF_ReadU32(r, &material) && material < INT32_MAX;
+			prim->material = material;
+		} else {
+			JSON_Reader_Skip(r);
+		}
+
+		if(!ok) return 0;
+	}
+
+	return k == 0;
+}
+
+static bool8 GLTF_ReadMesh(GLTF_Loader* l, void* item, u32 index) {
+	(void) index;
+	JSON_Reader* r  = &l->Reader;
+	GLTF_Mesh* mesh = item;
+	i32 k;
+
+	if(r->LastEvent != JSON_Event_BeginObject) return 0;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "name"))
+			ok = GLTF_ReadName(r, &mesh->name);
+		else if(JSON_Reader_StringIs(r, "primitives"))
+			ok = GLTF_ReadArray(l, (void**) &mesh->primitives, &mesh->numPrimitives,
+			                    sizeof(GLTF_Primitive), GLTF_ReadPrimitive);
+		else
+			JSON_Reader_Skip(r);
+
+		if(!ok) return 0;
+	}
+
+	return k == 0;
+}
+
+static bool8 GLTF_ReadNode(GLTF_Loader* l, void* item, u32 index) {
+	(void) index;
+	JSON_Reader* r  = &l->Reader;
+	GLTF_Node* node = item;
+	i32 numMatrix = 0, k;
+	r32 m[16];
+
+	if(r->LastEvent != JSON_Event_BeginObject) return 0;
+
+	node->trs = Transform3D_Default;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "name"))
+			ok = GLTF_ReadName(r, &node->name);
+		else if(JSON_Reader_StringIs(r, "mesh"))
+			ok = GLTF_ReadIndex(r, &node->mesh);
+		else if(JSON_Reader_StringIs(r, "children"))
+			ok = GLTF_ReadArray(l, (void**) &node->children, &node->numChildren,
+			                    sizeof(GLTF_Node*), GLTF_ReadIndexItem);
+		else if(JSON_Reader_StringIs(r, "matrix"))
+			ok = (numMatrix = GLTF_ReadNumbers(r, m, 16)) >= 0;
+		else if(JSON_Reader_StringIs(r, "translation"))
+			ok = GLTF_ReadNumbers(r, (r32*) &node->trs.Position, 3) >= 0;
+		else if(JSON_Reader_StringIs(r, "rotation"))
+			ok = GLTF_ReadNumbers(r, (r32*) &node->trs.Rotation, 4) >= 0;
+		else if(JSON_Reader_StringIs(r, "scale"))
+			ok = GLTF_ReadNumbers(r, (r32*) &node->trs.Scale, 3) >= 0;
+		else
+			JSON_Reader_Skip(r);
+
+		if(!ok) return 0;
+	}
+
+	if(k < 0) return 0;
+
+	if(numMatrix == 16) {
+		// glTF matrices are column major.
+		node->transformType = Transform_Mat4;
+		for(u32 r = 0; r < 4; r++)
+			for(u32 c = 0; c < 4; c++) node->matrix[r * 4 + c] = m[c * 4 + r];
+	} else {
+		node->transformType = Transform_TRS;
+	}
+
+	return 1;
+}
+
+static bool8 GLTF_ReadScene(GLTF_Loader* l, void* item, u32 index) {
+	(void) index;
+	JSON_Reader* r    = &l->Reader;
+	GLTF_Scene* scene = item;
+	i32 k;
+
+	if(r->LastEvent != JSON_Event_BeginObject) return 0;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "name"))
+			ok = GLTF_ReadName(r, &scene->name);
+		else if(JSON_Reader_StringIs(r, "nodes"))
+			ok = GLTF_ReadArray(l, (void**) &scene->rootNodes, &scene->numRootNodes,
+			                    sizeof(GLTF_Node*), GLTF_ReadIndexItem);
+		else
+			JSON_Reader_Skip(r);
+
+		if(!ok) return 0;
+	}
+
+	return k == 0;
+}
+
+static bool8 GLTF_ReadRoot(GLTF_Loader* l) {
+	JSON_Reader* r  = &l->Reader;
+	GLTF_Asset* res = l->Asset;
+	i32 k;
+
+	if(!GLTF_Expect(r, JSON_Event_BeginObject)) return 0;
+
+	while((k = GLTF_NextKey(r)) > 0) {
+		bool8 ok = 1;
+
+		if(JSON_Reader_StringIs(r, "asset")) {
+			if(!GLTF_Expect(r, JSON_Event_BeginObject)) return 0;
+
+			while((k = GLTF_NextKey(r)) > 0) {
+				if(!JSON_Reader_StringIs(r, "version")) {
+					JSON_Reader_Skip(r);
+					continue;
+				}
+
+				if(!GLTF_Expect(r, JSON_Event_String)) return 0;
+				l->HasVersion = (r->StringLength && r->String[0] == '2');
+			}
+
+			ok = (k == 0);
+		} else if(JSON_Reader_StringIs(r, "scene")) {
+				ok = GLTF_ReadIndex(r, &res->firstScene);
+		} else if(JSON_Reader_StringIs(r, "buffers")) {
+			ok = GLTF_ReadArray(l, (void**) &res->buffers, &res->numBuffers, sizeof(GLTF_Buffer),
+			                    GLTF_ReadBuffer);
+		} else if(JSON_Reader_StringIs(r, "bufferViews")) {
+			ok = GLTF_ReadArray(l, (void**) &res->bufferViews, &res->numBufferViews,
+			                    sizeof(GLTF_BufferView), GLTF_ReadBufferView);
+		} else if(JSON_Reader_StringIs(r, "accessors")) {
+			ok = GLTF_ReadArray(l, (void**) &res->accessors, &res->numAccessors, sizeof(GLTF_Accessor),
+			                    GLTF_ReadAccessor);
+		} else if(JSON_Reader_StringIs(r, "meshes")) {
+			ok = GLTF_ReadArray(l, (void**) &res->meshes, &res->numMeshes, sizeof(GLTF_Mesh),
+			                    GLTF_ReadMesh);
+		} else if(JSON_Reader_StringIs(r, "nodes")) {
+			ok = GLTF_ReadArray(l, (void**) &res->nodes, &res->numNodes, sizeof(GLTF_Node),
+			                    GLTF_ReadNode);
+		} else if(JSON_Reader_StringIs(r, "scenes")) {
+			ok = GLTF_ReadArray(l, (void**) &res->scenes, &res->numScenes, sizeof(GLTF_Scene),
+			                    GLTF_ReadScene);
+		} else {
+			JSON_Reader_Skip(r);
+		}
+
+		if(!ok) return 0;
 	}
 
-	GLTF_Asset* res = malloc(sizeof(GLTF_Asset));
+	return k == 0 && JSON_Reader_Next(r) == JSON_Event_End;
+}
+
+//
+// Resolving
+//
 
-	for(u32 i = 0; i < v.Object.StringKeys.Size; i++) {
-		const char* key = v.Object.StringKeys.Data[i];
-		const JSON_Value* val = &v.Object.Map.Values[i];
+// Turn an index + 1 into a pointer into `base`, returns 0 if it's out of range.
+static bool8 GLTF_Resolve(void* field, void* base, u32 count, u32 size) {
+	void** ptr = field;
+	uintptr_t i = (uintptr_t) *ptr;
 
-		if(strcmp(key, "asset"))
-		{
-			assert(val->Type == JSON_Object);
+	if(!i) return 1;
+	if(i > count) return 0;
+
+	*ptr = (u8*) base + (i - 1) * size;
+	return 1;
+}
+
+static bool8 GLTF_ResolveAll(GLTF_Loader* l) {
+	GLTF_Asset* res = l->Asset;
+
+	for(u32 i = 0; i < res->numBufferViews; i++) {
+		GLTF_BufferView* bv = &res->bufferViews[i];
+
+		if(!bv->buffer || !GLTF_Resolve(&bv->buffer, res->buffers, res->numBuffers, sizeof(GLTF_Buffer))) {
+			Log(ERROR, "[GLTF] Buffer view %d has an invalid buffer.", i);
+			return 0;
+		}
+
+		if((u64) bv->offset + bv->length > bv->buffer->size) {
+			Log(ERROR, "[GLTF] Buffer view %d goes past the end of its buffer.", i);
+			return 0;
 		}
-		else if(strcmp(key, "scene"))
-		{
-			assert(val->Type == JSON_Number);
-			res->firstScene = &res->scenes[(i32) val->Number];
+	}
+
+	for(u32 i = 0; i < res->numAccessors; i++) {
+		GLTF_Accessor* a = &res->accessors[i];
+
+		if(!GLTF_Resolve(&a->bufferView, res->bufferViews, res->numBufferViews, sizeof(GLTF_BufferView))) {
+			Log(ERROR, "[GLTF] Accessor %d has an invalid buffer view.", i);
+			return 0;
 		}
-		else if(strcmp(key, "scenes"))
-		{
-			assert(val->Type == JSON_Array);
-			
-			for (u32 j = 0; j < val->Array.Size; j++)
-			{
-				//JSON_Value* scene = &val->Array.Data[j];
+
+		// Make sure every element is inside the buffer view.
+		if(a->bufferView && a->count) {
+			u64 end = a->byteOffset + (u64) (a->count - 1) * GLTF_Accessor_Stride(a)
+			        + GLTF_Accessor_ElementSize(a);
+			if(end > a->bufferView->length) {
+				Log(ERROR, "[GLTF] Accessor %d goes past the end of its buffer view.", i);
+				return 0;
+			}
+		}
+	}
+
+	for(u32 i = 0; i < res->numMeshes; i++) {
+		GLTF_Mesh* mesh = &res->meshes[i];
+
+		for(u32 j = 0; j < mesh->numPrimitives; j++) {
+			GLTF_Primitive* prim = &mesh->primitives[j];
+			u32 n                = res->numAccessors;
+
+			if(!GLTF_Resolve(&prim->position, res->accessors, n, sizeof(GLTF_Accessor))
+			   || !GLTF_Resolve(&prim->normal, res->accessors, n, sizeof(GLTF_Accessor))
+			   || !GLTF_Resolve(&prim->texCoord, res->accessors, n, sizeof(GLTF_Accessor))
+			   || !GLTF_Resolve(&prim->indices, res->accessors, n, sizeof(GLTF_Accessor))) {
+				Log(ERROR, "[GLTF] Mesh %d, primitive %d uses an invalid accessor.", i, j);
+				return 0;
 			}
 		}
 	}
 
+	// Nodes can only have one parent, which also rules out cycles through scene roots.
+	bool8* hasParent = Allocate(MAX(res->numNodes, 1));
+	memset(hasParent, 0, res->numNodes);
 
-	JSON_Free(&v);
+	for(u32 i = 0; i < res->numNodes; i++) {
+		GLTF_Node* node = &res->nodes[i];
+
+		if(!GLTF_Resolve(&node->mesh, res->meshes, res->numMeshes, sizeof(GLTF_Mesh))) {
+			Log(ERROR, "[GLTF] Node %d has an invalid mesh.", i);
+			goto ResolveAll_error;
+		}
+
+		for(u32 j = 0; j < node->numChildren; j++) {
+			uintptr_t child = (uintptr_t) node->children[j] - 1;
+
+			if(child >= res->numNodes || child == i || hasParent[child]) {
+				Log(ERROR, "[GLTF] Node %d has an invalid child.", i);
+				goto ResolveAll_error;
+			}
+
+			hasParent[child]  = 1;
+			node->children[j] = &res->nodes[child];
+		}
+	}
+
+	for(u32 i = 0; i < res->numScenes; i++) {
+		GLTF_Scene* scene = &res->scenes[i];
+
+		for(u32 j = 0; j < scene->numRootNodes; j++) {
+			uintptr_t node = (uintptr_t) scene->rootNodes[j] - 1;
+
+			if(node >= res->numNodes || hasParent[node]) {
+				Log(ERROR, "[GLTF] Scene %d has an invalid root node.", i);
+				goto ResolveAll_error;
+			}
+
+			scene->rootNodes[j] = &res->nodes[node];
+		}
+	}
+
+	Free(hasParent);
+
+	if(!GLTF_Resolve(&res->firstScene, res->scenes, res->numScenes, sizeof(GLTF_Scene))) {
+		Log(ERROR, "[GLTF] %s has an invalid default scene.", l->Filename);
+		return 0;
+	}
+
+	return 1;
+
+ResolveAll_error:
+	Free(hasParent);
+	return 0;
+}
+
+//
+// Loading
+//
+
+GLTF_Asset* GLTF_LoadFile(const char* filename) {
+	u32 fileSize;
+	const u8* file = File_Map(filename, &fileSize);
+
+	if(!file) {
+		Log(ERROR, "[GLTF] Error reading %s.", filename);
+		return NULL;
+	}
+
+	GLTF_Asset* res = Allocate(sizeof(GLTF_Asset));
+	memset(res, 0, sizeof(GLTF_Asset));
+	res->file     = file;
+	res->fileSize = fileSize;
+
+	// A .glb is a small header followed by a JSON chunk and an optional BIN chunk,
+	// otherwise the whole file is JSON.
+	const char* json = (const char*) file;
+	u32 jsonSize     = fileSize;
+	const u8* bin    = NULL;
+	u32 binSize      = 0;
+
+	if(fileSize >= 12 && ReadU32(file) == GLB_MAGIC) {
+		u32 version = ReadU32(file + 4);
+		u32 length  = MIN(ReadU32(file + 8), fileSize);
+
+		if(version != 2 || length < 20 || ReadU32(file + 16) != GLB_CHUNK_JSON
+		   || ReadU32(file + 12) > length - 20) {
+			Log(ERROR, "[GLTF] %s is not a valid glTF 2.0 binary.", filename);
+			GLTF_Free(res);
+			return NULL;
+		}
+
+		jsonSize = ReadU32(file + 12);
+		json     = (const char*) file + 20;
+
+		u32 binChunk = 20 + ((jsonSize + 3) & ~3u);
+		if(binChunk + 8 <= length && ReadU32(file + binChunk + 4) == GLB_CHUNK_BIN) {
+			binSize = MIN(ReadU32(file + binChunk), length - binChunk - 8);
+			bin     = file + binChunk + 8;
+		}
+	}
+
+	// The reader's big, keep it off the stack.
+	GLTF_Loader* l = Allocate(sizeof(GLTF_Loader));
+	l->Asset       = res;
+	l->Filename    = filename;
+	l->Bin         = bin;
+	l->BinSize     = binSize;
+	l->HasVersion  = 0;
+	JSON_Reader_Init(&l->Reader, json, jsonSize);
+
+	if(!GLTF_ReadRoot(l)) {
+		Log(ERROR, "[GLTF] %s doesn't seem to contain valid GLTF.", filename);
+		goto error;
+	}
+
+	if(!l->HasVersion) {
+		Log(ERROR, "[GLTF] %s is not glTF 2.0.", filename);
+		goto error;
+	}
+
+	if(!GLTF_ResolveAll(l)) goto error;
+
+	Free(l);
 	return res;
+
+error:
+	Free(l);
+	GLTF_Free(res);
+	return NULL;
+}
+
+void GLTF_Free(GLTF_Asset* asset) {
+	if(!asset) return;
+
+	for(u32 i = 0; i < asset->numBuffers; i++) {
+		GLTF_Buffer* b = &asset->buffers[i];
+		Free((void*) b->name);
+
+		if(!b->data) continue;
+
+		if(b->storage == Storage_Mapped)
+			File_Unmap(b->data, b->size);
+		else if(b->storage == Storage_Allocated)
+			Free((void*) b->data);
+	}
+
+	for(u32 i = 0; i < asset->numAccessors; i++) Free((void*) asset->accessors[i].name);
+
+	for(u32 i = 0; i < asset->numMeshes; i++) {
+		Free((void*) asset->meshes[i].name);
+		Free(asset->meshes[i].primitives);
+	}
+
+	for(u32 i = 0; i < asset->numNodes; i++) {
+		Free((void*) asset->nodes[i].name);
+		Free(asset->nodes[i].children);
+	}
+
+	for(u32 i = 0; i < asset->numScenes; i++) {
+		Free((void*) asset->scenes[i].name);
+		Free(asset->scenes[i].rootNodes);
+	}
+
+	Free(asset->buffers);
+	Free(asset->bufferViews);
+	Free(asset->accessors);
+	Free(asset->meshes);
+	Free(asset->nodes);
+	Free(asset->scenes);
+
+	File_Unmap(asset->file, asset->fileSize);
+	Free(asset);
 }
@@ -0,0 +1,893 @@
+#include "../Image.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static const u32 Image_PixelBytes[ImageFormat_Count] = {1, 2, 4, 0, 0, 0, 0};
+static const u32 Image_BlockBytes[ImageFormat_Count] = {0, 0, 0, 8, 16, 8, 16};
+
+u32 Image_Size(enum Image_Format format, u32 width, u32 height) {
+	if(Image_BlockBytes[format]) return ((width + 3) / 4) * ((height + 3) / 4) * Image_BlockBytes[format];
+	return width * height * Image_PixelBytes[format];
+}
+
+//
+// Block compression
+//
+
+// Blocks that hang off the edge repeat the last row and column.
+static void Image_LoadBlock(const u8* rgba, u32 w, u32 h, u32 bx, u32 by, u8 out[16][4]) {
+	for(u32 y = 0; y < 4; y++) {
+		u32 sy = MIN(by * 4 + y, h - 1);
+		for(u32 x = 0; x < 4; x++) {
+			u32 sx = MIN(bx * 4 + x, w - 1);
+			memcpy(out[y * 4 + x], rgba + (sy * w + sx) * 4, 4);
+		}
+	}
+}
+
+// One channel: the highest and lowest values, and six evenly spaced ones between them.
+// Index 0 is the highest, 1 the lowest, and 2 to 7 go from high to low.
+static void Image_BC4Block(const u8 block[16][4], u32 channel, u8 out[8]) {
+	u8 hi = 0, lo = 255;
+	for(u32 i = 0; i < 16; i++) {
+		hi = MAX(hi, block[i][channel]);
+		lo = MIN(lo, block[i][channel]);
+	}
+
+	out[0] = hi;
+	out[1] = lo;
+
+	u64 bits = 0;
+	if(hi != lo) {
+		u32 range = hi - lo;
+		for(u32 i = 0; i < 16; i++) {
+			// How many sevenths of the way up it is, rounded.
+			u32 t   = ((block[i][channel] - lo) * 14 + range) / (2 * range);
+			u64 idx = t == 7 ? 0 : t == 0 ? 1 : 8 - t;
+			bits |= idx << (3 * i);
+		}
+	}
+
+	for(u32 i = 0; i < 6; i++) out[2 + i] = (bits >> (8 * i)) & 0xFF;
+}
+
+static u16 Image_To565(const r32 c[3]) {
+	u32 r = (u32) (CLAMP(c[0], 0, 255) * 31 / 255 + 0.5f);
+	u32 g = (u32) (CLAMP(c[1], 0, 255) * 63 / 255 + 0.5f);
+	u32 b = (u32) (CLAMP(c[2], 0, 255) * 31 / 255 + 0.5f);
+	return (r << 11) | (g << 5) | b;
+}
+
+static void Image_From565(u16 c, r32 out[3]) {
+	u32 r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+// How far along from the second endpoint to the first each index is.
+// With three colours, index 3 is transparent black and isn't on the line at all.
+static const r32 Image_BC1Weights[2][4] = {{1, 0, 2 / 3.0f, 1 / 3.0f}, {1, 0, 0.5f, 0}};
+
+// Pick the closest colour for every pixel, returns the total squared error.
+static r32 Image_BC1Indices(const r32 px[16][3], const bool8 opaque[16], u16 c0, u16 c1, bool8 three, u8 idx[16]) {
+	r32 e0[3], e1[3], pal[4][3];
+	Image_From565(c0, e0);
+	Image_From565(c1, e1);
+
+	u32 numColors = three ? 3 : 4;
+	for(u32 i = 0; i < numColors; i++) {
+		r32 w = Image_BC1Weights[three][i];
+		for(u32 c = 0; c < 3; c++) pal[i][c] = e0[c] * w + e1[c] * (1 - w);
+	}
+
+	r32 total = 0;
+	for(u32 i = 0; i < 16; i++) {
+		if(!opaque[i]) {
+			idx[i] = 3;
+			continue;
+		}
+
+		r32 best = INFINITY;
+		for(u32 j = 0; j < numColors; j++) {
+			r32 dr = px[i][0] - pal[j][0], dg = px[i][1] - pal[j][1], db = px[i][2] - pal[j][2];
+			r32 d  = dr * dr + dg * dg + db * db;
+			if(d < best) {
+				best   = d;
+				idx[i] = j;
+			}
+		}
+		total += best;
+	}
+
+	return total;
+}
+
+// Endpoints that fit the pixels best for the indices they've got, with least squares.
+// Returns 0 if every pixel went to the same end and there's nothing to solve.
+static bool8 Image_BC1Fit(const r32 px[16][3], const bool8 opaque[16], const u8 idx[16], bool8 three, r32 e0[3], r32 e1[3]) {
+	r32 a = 0, b = 0, c = 0, x0[3] = {0}, x1[3] = {0};
+	for(u32 i = 0; i < 16; i++) {
+		if(!opaque[i]) continue;
+
+		r32 w = Image_BC1Weights[three][idx[i]];
+		a += w * w;
+		b += w * (1 - w);
+		c += (1 - w) * (1 - w);
+		for(u32 k = 0; k < 3; k++) {
+			x0[k] += w * px[i][k];
+			x1[k] += (1 - w) * px[i][k];
+		}
+	}
+
+	r32 det = a * c - b * b;
+	if(fabsf(det) < 1e-6f) return 0;
+
+	for(u32 k = 0; k < 3; k++) {
+		e0[k] = (c * x0[k] - b * x1[k]) / det;
+		e1[k] = (a * x1[k] - b * x0[k]) / det;
+	}
+	return 1;
+}
+
+// Colours: two endpoints in RGB565 and two more between them, 2 bits per pixel to pick one.
+// Endpoints start at the ends of the line the colours spread out along the most,
+// then get moved to fit the pixels better. With `punchThrough`, pixels with alpha under
+// half become transparent, which takes one of the in between colours away.
+static void Image_BC1Block(const u8 block[16][4], bool8 punchThrough, u8 out[8]) {
+	r32 px[16][3], mean[3] = {0};
+	bool8 opaque[16], three = 0;
+	u32 n = 0;
+
+	for(u32 i = 0; i < 16; i++) {
+		opaque[i] = !punchThrough || block[i][3] >= 128;
+		three |= !opaque[i];
+		for(u32 c = 0; c < 3; c++) px[i][c] = block[i][c];
+
+		if(!opaque[i]) continue;
+		n++;
+		for(u32 c = 0; c < 3; c++) mean[c] += px[i][c];
+	}
+
+	// Both endpoints black and every index transparent.
+	if(!n) {
+		memset(out, 0, 4);
+		memset(out + 4, 0xFF, 4);
+		return;
+	}
+
+	for(u32 c = 0; c < 3; c++) mean[c] /= n;
+
+	r32 cov[6] = {0}, lo[3] = {255, 255, 255}, hi[3] = {0};
+	for(u32 i = 0; i < 16; i++) {
+		if(!opaque[i]) continue;
+
+		r32 d[3] = {px[i][0] - mean[0], px[i][1] - mean[1], px[i][2] - mean[2]};
+		cov[0] += d[0] * d[0];
+		cov[1] += d[0] * d[1];
+		cov[2] += d[0] * d[2];
+		cov[3] += d[1] * d[1];
+		cov[4] += d[1] * d[2];
+		cov[5] += d[2] * d[2];
+
+		for(u32 c = 0; c < 3; c++) {
+			lo[c] = MIN(lo[c], px[i][c]);
+			hi[c] = MAX(hi[c], px[i][c]);
+		}
+	}
+
+	// Power iteration for the covariance's biggest eigenvector.
+	r32 axis[3] = {hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]};
+	for(u32 it = 0; it < 8; it++) {
+		r32 v[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+		            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+		            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+
+		r32 len = MAX3(fabsf(v[0]), fabsf(v[1]), fabsf(v[2]));
+		if(len <= 0) break;
+		for(u32 c = 0; c < 3; c++) axis[c] = v[c] / len;
+	}
+
+	r32 minT = INFINITY, maxT = -INFINITY, e0[3], e1[3];
+	for(u32 i = 0; i < 16; i++) {
+		if(!opaque[i]) continue;
+
+		r32 t = px[i][0] * axis[0] + px[i][1] * axis[1] + px[i][2] * axis[2];
+		if(t > maxT) {
+			maxT = t;
+			memcpy(e0, px[i], sizeof(e0));
+		}
+		if(t < minT) {
+			minT = t;
+			memcpy(e1, px[i], sizeof(e1));
+		}
+	}
+
+	u16 c0 = 0, c1 = 0;
+	u8 idx[16];
+	r32 bestErr = INFINITY;
+
+	for(u32 it = 0; it < 3; it++) {
+		u16 t0 = Image_To565(e0), t1 = Image_To565(e1);
+		u8 tIdx[16];
+		r32 err = Image_BC1Indices(px, opaque, t0, t1, three, tIdx);
+
+		if(err < bestErr) {
+			bestErr = err;
+			c0      = t0;
+			c1      = t1;
+			memcpy(idx, tIdx, sizeof(idx));
+		}
+
+		if(bestErr <= 0 || !Image_BC1Fit(px, opaque, tIdx, three, e0, e1)) break;
+	}
+
+	// Which mode the block is in goes by the endpoints' order:
+	// c0 > c1 for four colours, c0 <= c1 for three and transparent.
+	if(three ? c0 > c1 : c0 < c1) {
+		u16 tmp = c0;
+		c0      = c1;
+		c1      = tmp;
+		for(u32 i = 0; i < 16; i++) {
+			if(idx[i] < 2) idx[i] ^= 1;
+			else if(!three) idx[i] ^= 1;
+		}
+	} else if(!three && c0 == c1) {
+		// Equal endpoints mean three colours, where index 3 is transparent.
+		memset(idx, 0, sizeof(idx));
+	}
+
+	u32 bits = 0;
+	for(u32 i = 0; i < 16; i++) bits |= (u32) idx[i] << (2 * i);
+
+	out[0] = c0 & 0xFF;
+	out[1] = c0 >> 8;
+	out[2] = c1 & 0xFF;
+	out[3] = c1 >> 8;
+	for(u32 i = 0; i < 4; i++) out[4 + i] = (bits >> (8 * i)) & 0xFF;
+}
+
+typedef struct {
+	enum Image_Format Format;
+	const u8* RGBA;
+	u32 Width, Height;
+	u8* Out;
+} Image_EncodeJob;
+
+// A run of rows of blocks.
+static void Image_EncodeBlockRows(void* data, u32 begin, u32 end) {
+	Image_EncodeJob* job = data;
+	u32 blocksWide       = (job->Width + 3) / 4;
+	u32 blockBytes       = Image_BlockBytes[job->Format];
+
+	for(u32 by = begin; by < end; by++) {
+		for(u32 bx = 0; bx < blocksWide; bx++) {
+			u8 block[16][4];
+			u8* out = job->Out + (by * blocksWide + bx) * blockBytes;
+			Image_LoadBlock(job->RGBA, job->Width, job->Height, bx, by, block);
+
+			switch(job->Format) {
+				case ImageFormat_BC1: Image_BC1Block(block, 1, out); break;
+				case ImageFormat_BC3:
+					Image_BC4Block(block, 3, out);
+					Image_BC1Block(block, 0, out + 8);
+					break;
+				case ImageFormat_BC4: Image_BC4Block(block, 0, out); break;
+				case ImageFormat_BC5:
+					Image_BC4Block(block, 0, out);
+					Image_BC4Block(block, 1, out + 8);
+					break;
+				default: break;
+			}
+		}
+	}
+}
+
+void Image_Encode(enum Image_Format format, const u8* rgba, u32 width, u32 height, u8* out) {
+	if(!width || !height) return;
+
+	if(!Image_BlockBytes[format]) {
+		u32 n = Image_PixelBytes[format];
+		for(u32 i = 0; i < width * height; i++) memcpy(out + i * n, rgba + i * 4, n);
+		return;
+	}
+
+	Image_EncodeJob job = {format, rgba, width, height, out};
+	Job_ParallelFor((height + 3) / 4, 0, Image_EncodeBlockRows, &job);
+}
+
+//
+// Mipmaps
+//
+
+// While they're filtered, pixels are 4 floats in linear light, so one fits in an SSE register
+// and the filters can work on all of its channels at once. SSE2 is always there on x86-64.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+#define IMAGE_HAS_SSE 1
+#endif
+
+#define IMAGE_KAISER_WIDTH 3   // How far the sinc goes out on each side, in pixels of the smaller level.
+#define IMAGE_KAISER_ALPHA 4.0 // Higher rings less but blurs more.
+
+#define IMAGE_SRGB_STEPS 16384 // Small enough steps that looking up sRGB is never more than a rounding off.
+
+static r32 Image_ByteToFloat[256];
+static r32 Image_SRGBToLinear[256];
+static u8 Image_LinearToSRGB[IMAGE_SRGB_STEPS];
+static r64 Image_KaiserScale;
+static Job_Once Image_TablesOnce;
+
+static r64 Image_BesselI0(r64 x) {
+	r64 sum = 1, term = 1;
+	for(u32 k = 1; k < 32; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+// Mipmaps get made on job workers, so whichever gets there first fills these in.
+static void Image_InitTables(void* data) {
+	(void) data;
+
+	for(u32 i = 0; i < 256; i++) {
+		r64 c                 = i / 255.0;
+		Image_ByteToFloat[i]  = c;
+		Image_SRGBToLinear[i] = c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+	}
+
+	for(u32 i = 0; i < IMAGE_SRGB_STEPS; i++) {
+		r64 l                 = i / (r64) (IMAGE_SRGB_STEPS - 1);
+		r64 c                 = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1 / 2.4) - 0.055;
+		Image_LinearToSRGB[i] = (u8) (c * 255 + 0.5);
+	}
+
+	Image_KaiserScale = 1 / Image_BesselI0(IMAGE_KAISER_ALPHA);
+}
+
+// Which source pixels make up each pixel of the smaller level, and how much of each.
+// Every pixel has the same number of taps, the ones past the edge repeat the edge pixel.
+typedef struct {
+	u32 Taps;
+	u32* Index;
+	r32* Weight;
+} Image_Kernel;
+
+// How much a source pixel's centre at `at` counts towards a smaller level pixel centred on `centre`.
+static r64 Image_FilterWeight(enum Image_MipFilter filter, r64 at, r64 centre, r64 scale) {
+	if(filter == ImageMipFilter_Box) {
+		// How much of the source pixel the box covers.
+		r64 left = MAX(at - 0.5, centre - scale / 2), right = MIN(at + 0.5, centre + scale / 2);
+		return MAX(right - left, 0);
+	}
+
+	r64 t = (at - centre) / scale;
+	if(fabs(t) >= IMAGE_KAISER_WIDTH) return 0;
+
+	r64 r    = t / IMAGE_KAISER_WIDTH;
+	r64 sinc = t == 0 ? 1 : sin(Pi * t) / (Pi * t);
+	return sinc * Image_BesselI0(IMAGE_KAISER_ALPHA * sqrt(1 - r * r)) * Image_KaiserScale;
+}
+
+static Image_Kernel Image_MakeKernel(enum Image_MipFilter filter, u32 src, u32 dst) {
+	r64 scale = (r64) src / dst;
+	r64 reach = (filter == ImageMipFilter_Box ? 0.5 : IMAGE_KAISER_WIDTH) * scale + 1;
+
+	// The first and last source pixel that count for anything.
+	Image_Kernel k = {0};
+	for(u32 i = 0; i < dst; i++) {
+		r64 centre = (i + 0.5) * scale;
+		i32 first = (i32) floor(centre - reach), last = (i32) ceil(centre + reach);
+
+		while(first < last && Image_FilterWeight(filter, first + 0.5, centre, scale) == 0) first++;
+		while(last > first && Image_FilterWeight(filter, last + 0.5, centre, scale) == 0) last--;
+		k.Taps = MAX(k.Taps, (u32) (last - first + 1));
+	}
+
+	k.Index  = Allocate(sizeof(u32) * k.Taps * dst);
+	k.Weight = Allocate(sizeof(r32) * k.Taps * dst);
+
+	for(u32 i = 0; i < dst; i++) {
+		r64 centre = (i + 0.5) * scale;
+		i32 first  = (i32) floor(centre - reach);
+		while(Image_FilterWeight(filter, first + 0.5, centre, scale) == 0) first++;
+
+		// Levels are never less than a third the size, so that's at most 19 taps.
+		r64 weights[32], sum = 0;
+		for(u32 t = 0; t < k.Taps; t++) {
+			weights[t] = Image_FilterWeight(filter, first + t + 0.5, centre, scale);
+			sum += weights[t];
+
+			k.Index[i * k.Taps + t] = CLAMP(first + (i32) t, 0, (i32) src - 1);
+		}
+
+		for(u32 t = 0; t < k.Taps; t++) k.Weight[i * k.Taps + t] = weights[t] / sum;
+	}
+
+	return k;
+}
+
+typedef struct {
+	const Image_MipOptions* Options;
+	u32 Channels;
+
+	// The level being made from, and the one being made.
+	const r32* Src;
+	r32* Dst;
+	u32 SrcWidth, DstWidth;
+	const Image_Kernel* Kernel;
+
+	// Bytes going in or out.
+	const u8* In;
+	u8* Out;
+	r32 AlphaScale;
+} Image_MipJob;
+
+// Bytes to linear floats. Missing colour channels are 0 and missing alpha is 1.
+static void Image_ToLinearRows(void* data, u32 begin, u32 end) {
+	Image_MipJob* job = data;
+	u32 n             = job->Channels;
+
+	const r32* colour = job->Options->SRGB ? Image_SRGBToLinear : Image_ByteToFloat;
+
+	for(u32 i = begin * job->SrcWidth; i < end * job->SrcWidth; i++) {
+		const u8* in = job->In + i * n;
+		r32* px      = job->Dst + i * 4;
+
+		px[0] = colour[in[0]];
+		px[1] = n > 1 ? colour[in[1]] : 0;
+		px[2] = n > 2 ? colour[in[2]] : 0;
+		px[3] = n > 3 ? Image_ByteToFloat[in[3]] : 1;
+	}
+}
+
+// Shrink rows across, each one stays on its own row.
+static void Image_FilterRows(void* data, u32 begin, u32 end) {
+	Image_MipJob* job      = data;
+	const Image_Kernel* k = job->Kernel;
+
+	for(u32 y = begin; y < end; y++) {
+		const r32* src = job->Src + (u64) y * job->SrcWidth * 4;
+		r32* dst       = job->Dst + (u64) y * job->DstWidth * 4;
+
+		for(u32 x = 0; x < job->DstWidth; x++) {
+			const u32* index  = k->Index + x * k->Taps;
+			const r32* weight = k->Weight + x * k->Taps;
+
+#ifdef IMAGE_HAS_SSE
+			__m128 sum = _mm_setzero_ps();
+			for(u32 t = 0; t < k->Taps; t++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[t]), _mm_loadu_ps(src + index[t] * 4)));
+			_mm_storeu_ps(dst + x * 4, sum);
+#else
+			r32 sum[4] = {0};
+			for(u32 t = 0; t < k->Taps; t++)
+				for(u32 c = 0; c < 4; c++) sum[c] += weight[t] * src[index[t] * 4 + c];
+			memcpy(dst + x * 4, sum, sizeof(sum));
+#endif
+		}
+	}
+}
+
+// Shrink columns down, after the rows. Whole rows get added up, so they're read in order.
+static void Image_FilterColumns(void* data, u32 begin, u32 end) {
+	Image_MipJob* job      = data;
+	const Image_Kernel* k = job->Kernel;
+	u32 w                  = job->DstWidth;
+
+	for(u32 y = begin; y < end; y++) {
+		const u32* index  = k->Index + y * k->Taps;
+		const r32* weight = k->Weight + y * k->Taps;
+		r32* dst          = job->Dst + (u64) y * w * 4;
+
+		for(u32 x = 0; x < w; x++) {
+			const r32* src = job->Src + (u64) x * 4;
+
+#ifdef IMAGE_HAS_SSE
+			__m128 sum = _mm_setzero_ps();
+			for(u32 t = 0; t < k->Taps; t++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[t]), _mm_loadu_ps(src + (u64) index[t] * w * 4)));
+			_mm_storeu_ps(dst + x * 4, sum);
+#else
+			r32 sum[4] = {0};
+			for(u32 t = 0; t < k->Taps; t++)
+				for(u32 c = 0; c < 4; c++) sum[c] += weight[t] * src[(u64) index[t] * w * 4 + c];
+			memcpy(dst + x * 4, sum, sizeof(sum));
+#endif
+		}
+	}
+}
+
+// Linear floats back to bytes. The Kaiser filter can overshoot, so everything gets clamped.
+static void Image_ToBytesRows(void* data, u32 begin, u32 end) {
+	Image_MipJob* job = data;
+	u32 n             = job->Channels;
+
+	for(u32 i = begin * job->SrcWidth; i < end * job->SrcWidth; i++) {
+		r32 px[4];
+
+#ifdef IMAGE_HAS_SSE
+		__m128 v = _mm_loadu_ps(job->Src + i * 4);
+		v        = _mm_mul_ps(v, _mm_set_ps(job->AlphaScale, 1, 1, 1));
+		v        = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1));
+		_mm_storeu_ps(px, v);
+#else
+		memcpy(px, job->Src + i * 4, sizeof(px));
+		px[3] *= job->AlphaScale;
+		for(u32 c = 0; c < 4; c++) px[c] = CLAMP(px[c], 0, 1);
+#endif
+
+		for(u32 c = 0; c < n; c++) {
+			job->Out[i * n + c] = (c < 3 && job->Options->SRGB)
+			                        ? Image_LinearToSRGB[(u32) (px[c] * (IMAGE_SRGB_STEPS - 1) + 0.5f)]
+			                        : (u8) (px[c] * 255 + 0.5f);
+		}
+	}
+}
+
+#define IMAGE_COVERAGE_STEPS 4096
+
+// What to multiply a level's alpha by, so that `coverage` of its pixels end up above the cutoff.
+static r32 Image_AlphaScale(const r32* pixels, u32 count, r32 cutoff, r64 coverage) {
+	// Nothing to keep above the cutoff, so there's nothing to scale for.
+	u32 want = (u32) (coverage * count + 0.5);
+	if(!want) return 1;
+
+	u32 histogram[IMAGE_COVERAGE_STEPS] = {0}, passing = 0;
+	for(u32 i = 0; i < count; i++) {
+		r32 a = CLAMP(pixels[i * 4 + 3], 0, 1);
+		histogram[(u32) (a * (IMAGE_COVERAGE_STEPS - 1))]++;
+		passing += a > cutoff;
+	}
+
+	// Already right, like when everything's opaque.
+	if(passing == want) return 1;
+
+	// Go down from the top until enough pixels are above, that's where the cutoff should be.
+	u32 above = 0, step = IMAGE_COVERAGE_STEPS;
+	while(step > 0 && above < want) above += histogram[--step];
+
+	// Only pixels with no alpha at all would make up the numbers, and no scale lifts those.
+	if(!step) return 1;
+
+	return cutoff / (step / (r32) (IMAGE_COVERAGE_STEPS - 1));
+}
+
+u32 Image_NumLevels(u32 width, u32 height) {
+	u32 n = 1;
+	while(n < IMAGE_MAX_LEVELS && (width >> n || height >> n)) n++;
+	return n;
+}
+
+bool8 Image_GenMips(u8** levels, u32 width, u32 height, u32 channels, u32 numLevels, const Image_MipOptions* options) {
+	if(numLevels < 2 || !width || !height) return 1;
+
+	// Allocate() takes a u32, and the floats take 16 bytes a pixel.
+	u32 maxSide = 1u << (IMAGE_MAX_LEVELS - 1);
+	if(width > maxSide || height > maxSide || (u64) width * height * 16 > 0xFFFFFFFFu) {
+		Log(ERROR, "[Image] %ux%u is too big to make mipmaps for.", width, height);
+		return 0;
+	}
+
+	Job_RunOnce(&Image_TablesOnce, Image_InitTables, NULL);
+
+	// Each level is made from the one before it in floats, so rounding errors don't pile up.
+	r32* src = Allocate(width * height * 16);
+	r32* tmp = Allocate(MAX(width / 2, 1) * height * 16);
+	r32* dst = Allocate(MAX(width / 2, 1) * MAX(height / 2, 1) * 16);
+	if(!src || !tmp || !dst) {
+		Log(ERROR, "[Image] Out of memory making mipmaps for %ux%u.", width, height);
+		Free(src);
+		Free(tmp);
+		Free(dst);
+		return 0;
+	}
+
+	Image_MipJob job = {.Options = options, .Channels = channels, .In = levels[0], .Dst = src, .SrcWidth = width};
+	Job_ParallelFor(height, 0, Image_ToLinearRows, &job);
+
+	bool8 cutout  = options->AlphaCutoff > 0 && channels == 4;
+	r64 coverage = 0;
+	if(cutout) {
+		u32 above = 0;
+		for(u32 i = 0; i < width * height; i++) above += levels[0][i * 4 + 3] > options->AlphaCutoff * 255;
+		coverage = above / (r64) (width * height);
+	}
+
+	u32 w = width, h = height;
+	bool8 ok = 1;
+	for(u32 i = 1; i < numLevels; i++) {
+		u32 dw = MAX(w / 2, 1), dh = MAX(h / 2, 1);
+
+		levels[i] = Allocate(dw * dh * channels);
+		if(!levels[i]) {
+			Log(ERROR, "[Image] Out of memory making mipmaps for %ux%u.", width, height);
+			for(u32 j = 1; j < i; j++) Free(levels[j]);
+			ok = 0;
+			break;
+		}
+
+		Image_Kernel across = Image_MakeKernel(options->Filter, w, dw);
+		Image_Kernel down   = Image_MakeKernel(options->Filter, h, dh);
+
+		job = (Image_MipJob){.Options = options, .Channels = channels, .Src = src, .Dst = tmp, .SrcWidth = w, .DstWidth = dw, .Kernel = &across};
+		Job_ParallelFor(h, 0, Image_FilterRows, &job);
+
+		job.Src    = tmp;
+		job.Dst    = dst;
+		job.Kernel = &down;
+		Job_ParallelFor(dh, 0, Image_FilterColumns, &job);
+
+		// Only what gets written out is scaled, the next level is made from the real alpha.
+		job.Src        = dst;
+		job.SrcWidth   = dw;
+		job.Out        = levels[i];
+		job.AlphaScale = cutout ? Image_AlphaScale(dst, dw * dh, options->AlphaCutoff, coverage) : 1;
+		Job_ParallelFor(dh, 0, Image_ToBytesRows, &job);
+
+		Free(across.Index);
+		Free(across.Weight);
+		Free(down.Index);
+		Free(down.Weight);
+
+		r32* t = src;
+		src    = dst;
+		dst    = t;
+		w      = dw;
+		h      = dh;
+	}
+
+	Free(src);
+	Free(tmp);
+	Free(dst);
+
+	return ok;
+}
+
+//
+// KTX
+//
+
+static const u8 Image_KTXIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// KTX2 calls it that, KTX 1 doesn't have a name for it.
+static const char Image_SwizzleKey[] = "KTXswizzle";
+
+// GL's enums for each format, written out so that this doesn't need GL's headers.
+static const struct {
+	u32 Type, TypeSize, Format, InternalFormat, InternalFormatSRGB, BaseInternalFormat;
+} Image_GL[ImageFormat_Count] = {
+	// GL_UNSIGNED_BYTE, GL_RED / GL_RG / GL_RGBA, GL_R8 / GL_RG8 / GL_RGBA8 and GL_SRGB8_ALPHA8.
+	[ImageFormat_R8]    = {0x1401, 1, 0x1903, 0x8229, 0x8229, 0x1903},
+	[ImageFormat_RG8]   = {0x1401, 1, 0x8227, 0x822B, 0x822B, 0x8227},
+	[ImageFormat_RGBA8] = {0x1401, 1, 0x1908, 0x8058, 0x8C43, 0x1908},
+
+	// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT / DXT5, with GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT / DXT5,
+	// and GL_COMPRESSED_RED_RGTC1 / GL_COMPRESSED_RG_RGTC2. Compressed formats have no type or format.
+	[ImageFormat_BC1] = {0, 1, 0, 0x83F1, 0x8C4D, 0x1908},
+	[ImageFormat_BC3] = {0, 1, 0, 0x83F3, 0x8C4F, 0x1908},
+	[ImageFormat_BC4] = {0, 1, 0, 0x8DBB, 0x8DBB, 0x1903},
+	[ImageFormat_BC5] = {0, 1, 0, 0x8DBD, 0x8DBD, 0x8227},
+};
+
+static inline u32 Image_Align4(u32 n) { return (n + 3) & ~3u; }
+
+bool8 Image_IsKTX(const u8* data, u32 size) {
+	return size >= sizeof(Image_KTXIdentifier) && memcmp(data, Image_KTXIdentifier, sizeof(Image_KTXIdentifier)) == 0;
+}
+
+bool8 Image_WriteKTX(const char* filename,
+                     enum Image_Format format,
+                     bool8 srgb,
+                     const char* swizzle,
+                     u32 width,
+                     u32 height,
+                     u32 numLevels,
+                     const u8* const* levels) {
+	if(!numLevels || numLevels > IMAGE_MAX_LEVELS) {
+		Log(ERROR, "[Image] Can't write %u levels into %s.", numLevels, filename);
+		return 0;
+	}
+
+	FILE* f = fopen(filename, "wb");
+	if(!f) {
+		Log(ERROR, "[Image] Couldn't open %s for writing.", filename);
+		return 0;
+	}
+
+	// Key, NULL, the four letters, NULL.
+	u32 swizzleSize = sizeof(Image_SwizzleKey) + 5;
+	u32 kvBytes     = swizzle ? 4 + Image_Align4(swizzleSize) : 0;
+
+	u32 header[13] = {
+		0x04030201,
+		Image_GL[format].Type,
+		Image_GL[format].TypeSize,
+		Image_GL[format].Format,
+		srgb ? Image_GL[format].InternalFormatSRGB : Image_GL[format].InternalFormat,
+		Image_GL[format].BaseInternalFormat,
+		width,
+		height,
+		0, // Depth, 0 for 2D textures.
+		0, // Array elements, 0 for a plain texture.
+		1, // Faces, 6 for cubemaps.
+		numLevels,
+		kvBytes,
+	};
+
+	fwrite(Image_KTXIdentifier, 1, sizeof(Image_KTXIdentifier), f);
+	fwrite(header, sizeof(u32), 13, f);
+
+	if(swizzle) {
+		u8 kv[32] = {0};
+		memcpy(kv, &swizzleSize, 4);
+		memcpy(kv + 4, Image_SwizzleKey, sizeof(Image_SwizzleKey));
+		memcpy(kv + 4 + sizeof(Image_SwizzleKey), swizzle, 4);
+		fwrite(kv, 1, kvBytes, f);
+	}
+
+	static const u8 padding[4] = {0};
+
+	for(u32 i = 0; i < numLevels; i++) {
+		u32 w = MAX(width >> i, 1), h = MAX(height >> i, 1);
+
+		if(Image_BlockBytes[format]) {
+			u32 size = Image_Size(format, w, h);
+			fwrite(&size, 4, 1, f);
+			fwrite(levels[i], 1, size, f);
+			continue;
+		}
+
+		// Rows of uncompressed pixels are padded to 4 bytes, like GL_UNPACK_ALIGNMENT's default.
+		u32 rowBytes = w * Image_PixelBytes[format];
+		u32 size     = Image_Align4(rowBytes) * h;
+		fwrite(&size, 4, 1, f);
+		for(u32 y = 0; y < h; y++) {
+			fwrite(levels[i] + y * rowBytes, 1, rowBytes, f);
+			fwrite(padding, 1, Image_Align4(rowBytes) - rowBytes, f);
+		}
+	}
+
+	bool8 ok = !ferror(f);
+	fclose(f);
+
+	if(!ok) Log(ERROR, "[Image] Couldn't write %s.", filename);
+	return ok;
+}
+
+// How many bytes one channel of a GL type takes up. Packed types like GL_UNSIGNED_SHORT_5_6_5
+// aren't supported, they're 0 like anything unknown.
+static u32 Image_GLTypeSize(u32 type) {
+	switch(type) {
+		case 0x1400:           // GL_BYTE
+		case 0x1401: return 1; // GL_UNSIGNED_BYTE
+		case 0x1402:           // GL_SHORT
+		case 0x1403:           // GL_UNSIGNED_SHORT
+		case 0x140B: return 2; // GL_HALF_FLOAT
+		case 0x1404:           // GL_INT
+		case 0x1405:           // GL_UNSIGNED_INT
+		case 0x1406: return 4; // GL_FLOAT
+		default: return 0;
+	}
+}
+
+// How many bytes a pixel takes up, for the plain formats GL has.
+static u32 Image_GLPixelBytes(u32 format, u32 typeSize) {
+	switch(format) {
+		case 0x1903: return typeSize;     // GL_RED
+		case 0x8227: return typeSize * 2; // GL_RG
+		case 0x1907:                      // GL_RGB
+		case 0x80E0: return typeSize * 3; // GL_BGR
+		case 0x1908:                      // GL_RGBA
+		case 0x80E1: return typeSize * 4; // GL_BGRA
+		default: return 0;
+	}
+}
+
+// How many bytes a 4x4 block takes up, 0 for formats that aren't compressed or aren't known.
+static u32 Image_GLBlockBytes(u32 internalFormat) {
+	for(u32 i = 0; i < ImageFormat_Count; i++) {
+		if(Image_GL[i].Type) continue;
+		if(Image_GL[i].InternalFormat == internalFormat || Image_GL[i].InternalFormatSRGB == internalFormat)
+			return Image_BlockBytes[i];
+	}
+	return 0;
+}
+
+bool8 Image_ParseKTX(const u8* data, u32 size, Image_KTX* out) {
+	if(!Image_IsKTX(data, size) || size < 64) return 0;
+
+	u32 header[13];
+	memcpy(header, data + 12, sizeof(header));
+
+	if(header[0] != 0x04030201) {
+		Log(ERROR, "[Image] KTX file has the other byte order, it isn't supported.", "");
+		return 0;
+	}
+
+	memset(out, 0, sizeof(Image_KTX));
+	out->GLType               = header[1];
+	out->GLFormat             = header[3];
+	out->GLInternalFormat     = header[4];
+	out->GLBaseInternalFormat = header[5];
+	out->Width                = header[6];
+	out->Height               = header[7];
+	out->NumLevels            = header[11];
+	memcpy(out->Swizzle, "rgba", 4);
+
+	u32 typeSize = header[2], depth = header[8], arrayElements = header[9], faces = header[10], kvBytes = header[12];
+
+	if(!out->Width || !out->Height || depth > 1 || arrayElements || faces != 1 || out->NumLevels > IMAGE_MAX_LEVELS) {
+		Log(ERROR, "[Image] KTX file isn't a plain 2D texture.", "");
+		return 0;
+	}
+
+	// GL reads as many bytes as the type takes up, so that's what has to be in the file,
+	// whatever the file says its type size is.
+	u32 pixelBytes = 0;
+	if(out->GLType) {
+		u32 glTypeSize = Image_GLTypeSize(out->GLType);
+		if(!glTypeSize || glTypeSize != typeSize) {
+			Log(ERROR, "[Image] KTX file has an unsupported type 0x%x (size %u).", out->GLType, typeSize);
+			return 0;
+		}
+
+		pixelBytes = Image_GLPixelBytes(out->GLFormat, glTypeSize);
+		if(!pixelBytes) {
+			Log(ERROR, "[Image] KTX file has an unsupported pixel format 0x%x.", out->GLFormat);
+			return 0;
+		}
+	}
+
+	if(kvBytes > size - 64) return 0;
+
+	u32 pos = 64, end = 64 + kvBytes;
+	while(end - pos >= 4) {
+		u32 len;
+		memcpy(&len, data + pos, 4);
+		if(len > end - pos - 4) break;
+
+		const u8* kv = data + pos + 4;
+		if(len >= sizeof(Image_SwizzleKey) + 4 && memcmp(kv, Image_SwizzleKey, sizeof(Image_SwizzleKey)) == 0)
+			memcpy(out->Swizzle, kv + sizeof(Image_SwizzleKey), 4);
+
+		pos += 4 + Image_Align4(len);
+		if(pos > end) break;
+	}
+
+	u32 blockBytes = out->GLType ? 0 : Image_GLBlockBytes(out->GLInternalFormat);
+
+	pos = end;
+	for(u32 i = 0; i < MAX(out->NumLevels, 1); i++) {
+		u32 levelSize;
+		if(size - pos < 4) return 0;
+		memcpy(&levelSize, data + pos, 4);
+		pos += 4;
+
+		if(levelSize > size - pos) return 0;
+
+		// GL reads however much the size says, so make sure that's really there.
+		u32 w = MAX(out->Width >> i, 1), h = MAX(out->Height >> i, 1);
+		u64 rowBytes = 0;
+		if(out->GLType) {
+			rowBytes = ((u64) w * pixelBytes + 3) & ~3ull;
+		} else {
+			rowBytes = (u64) ((w + 3) / 4) * blockBytes;
+			h        = (h + 3) / 4;
+		}
+		if(rowBytes * h > levelSize) return 0;
+		out->RowBytes[i] = rowBytes;
+
+		out->Levels[i]     = data + pos;
+		out->LevelSizes[i] = levelSize;
+		pos += Image_Align4(levelSize);
+		if(pos > size) pos = size;
+	}
+
+	return 1;
+}
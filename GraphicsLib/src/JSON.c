@@ -1,431 +1,722 @@
 #include "../JSON.h"
 #include "../Common.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <stdio.h>
 
-DECL_ARRAY(Hash, u128);
-DECL_ARRAY(String, char*);
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define open  _open
+#define close _close
+#define write _write
+#define JSON_FILE_FLAGS (O_WRONLY | O_CREAT | O_TRUNC | O_BINARY)
+#define JSON_FILE_MODE  (_S_IREAD | _S_IWRITE)
+#else
+#include <unistd.h>
+#define JSON_FILE_FLAGS (O_WRONLY | O_CREAT | O_TRUNC)
+#define JSON_FILE_MODE  0644
+#endif
+
+// Deeper nesting than this is treated as an error instead of blowing the stack.
+#define JSON_MAX_DEPTH 512
+
+DEF_ARRAY(JSON_Value, JSON_Value);
 DECL_ARRAY(JSON_Value, JSON_Value);
-DECL_HASHMAP(JSON_Value, JSON_Value);
+DEF_ARRAY(JSON_Member, JSON_Member);
+DECL_ARRAY(JSON_Member, JSON_Member);
 
-JSON_Value JSON_FromFile(const char* filename) {
-	//Log(INFO, "Reading JSON file \"%s\".", filename);
-	u32 size;
-	u8* buf        = File_ReadToBuffer_Alloc(filename, &size);
-	JSON_Value res = JSON_FromString_N((char*) buf, size);
-	Free(buf);
+const JSON_Value Error = {.Type = JSON_Error};
+
+typedef struct JSON_Parser JSON_Parser;
+struct JSON_Parser {
+	char* Start;
+	char* Curr;
+	char* End;
+
+	Arena* Arena;
+
+	// Offsets of every structural, see JSON_FindStructurals().
+	u32* Structurals;
+	u32 NumStructurals;
+	u32 Next;
+
+	bool8 HasEscapes, HasControl; // Whether any string at all has them.
+
+	// Children of every container that's still open, in one stack each.
+	// A container's children get copied into the arena once it closes.
+	Array_JSON_Value Values;
+	Array_JSON_Member Members;
+
+	u32 Depth;
+};
+
+static bool8 JSON_Fail(JSON_Parser* p, const char* msg) {
+	u32 line = 1;
+	for(const char* c = p->Start; c < p->Curr; c++) line += (*c == '\n');
+
+	i32 context = MIN(p->End - p->Curr, 16);
+	Log(ERROR, "[JSON] Line %d: %s (near \"%.*s\").", line, msg, context, p->Curr);
+	return 0;
+}
+
+// Move to the next structural, returns 0 at the end.
+static char JSON_Advance(JSON_Parser* p) {
+	if(p->Next == p->NumStructurals) {
+		p->Curr = p->End;
+		return 0;
+	}
+
+	p->Curr = p->Start + p->Structurals[p->Next++];
+	return *p->Curr;
+}
+
+static bool8 Char_IsDelimiter(char c) {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ',' || c == ']' || c == '}'
+	    || c == ':';
+}
+
+static i32 Hex_Digit(char c) {
+	if('0' <= c && c <= '9') return c - '0';
+	if('a' <= c && c <= 'f') return c - 'a' + 10;
+	if('A' <= c && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+static i32 JSON_ReadHex4(const char* s) {
+	i32 res = 0;
+	for(u32 i = 0; i < 4; i++) {
+		i32 d = Hex_Digit(s[i]);
+		if(d < 0) return -1;
+		res = (res << 4) | d;
+	}
 	return res;
 }
 
-JSON_Value JSON_FromString(const char* str) { return JSON_FromString_N(str, strlen(str)); }
+#define STRING_HAS_ESCAPES 1
+#define STRING_HAS_CONTROL 2
+
+// Find the closing quote of a string, starting after the opening one.
+// `escaped` carries a trailing backslash over when a string is split into chunks,
+// and `flags` collects STRING_HAS_ESCAPES/STRING_HAS_CONTROL.
+// Returns NULL if the string doesn't end before `end`.
+static const char* JSON_StringEnd(const char* c, const char* end, bool8* escaped, u32* flags) {
+	if(*escaped && c < end) {
+		*escaped = 0;
+		c++;
+	}
 
-static bool8 Char_OneOf(char c, const char* chars) {
-	if(!chars) return 0;
+	while(c < end) {
+		u8 ch = *c;
 
-	while(*chars) {
-		if(c == *chars) return 1;
-		++chars;
+		if(ch == '\"') return c;
+
+		if(ch == '\\') {
+			*flags |= STRING_HAS_ESCAPES;
+			if(++c == end) {
+				*escaped = 1;
+				return NULL;
+			}
+		} else if(ch < 0x20) {
+			*flags |= STRING_HAS_CONTROL;
+		}
+
+		c++;
 	}
-	return 0;
+
+	return NULL;
 }
 
-enum TokenType {
-	Token_EOF = 0,
+// Unescape the inside of a string, `dst` may be the same as `src`.
+// Returns the unescaped length, or -1 if there's an invalid escape.
+static i32 JSON_Unescape(char* dst, const char* src, u32 len) {
+	const char* end = src + len;
+	char* start     = dst;
 
-	Token_Comma, // ,
-	Token_Colon, // :
+	while(src < end) {
+		if(*src != '\\') {
+			*dst++ = *src++;
+			continue;
+		}
 
-	Token_BeginObject, // {
-	Token_EndObject,   // }
+		if(src + 1 >= end) return -1;
+
+		switch(src[1]) {
+			case '\"': *dst++ = '\"'; break;
+			case '\\': *dst++ = '\\'; break;
+			case '/': *dst++ = '/'; break;
+			case 'b': *dst++ = '\b'; break;
+			case 'f': *dst++ = '\f'; break;
+			case 'n': *dst++ = '\n'; break;
+			case 'r': *dst++ = '\r'; break;
+			case 't': *dst++ = '\t'; break;
+
+			case 'u': {
+				i32 cp = (end - src >= 6 ? JSON_ReadHex4(src + 2) : -1);
+				if(cp < 0) return -1;
+
+				// Join up UTF-16 surrogate pairs.
+				if(cp >= 0xD800 && cp <= 0xDBFF && end - src >= 12 && src[6] == '\\' && src[7] == 'u') {
+					i32 low = JSON_ReadHex4(src + 8);
+					if(low >= 0xDC00 && low <= 0xDFFF) {
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+						src += 6;
+					}
+				}
 
-	Token_BeginArray, // [
-	Token_EndArray,   // ]
+				// Encode as UTF-8, which is never longer than the escape.
+				if(cp < 0x80) {
+					*dst++ = cp;
+				} else if(cp < 0x800) {
+					*dst++ = 0xC0 | (cp >> 6);
+					*dst++ = 0x80 | (cp & 0x3F);
+				} else if(cp < 0x10000) {
+					*dst++ = 0xE0 | (cp >> 12);
+					*dst++ = 0x80 | ((cp >> 6) & 0x3F);
+					*dst++ = 0x80 | (cp & 0x3F);
+				} else {
+					*dst++ = 0xF0 | (cp >> 18);
+					*dst++ = 0x80 | ((cp >> 12) & 0x3F);
+					*dst++ = 0x80 | ((cp >> 6) & 0x3F);
+					*dst++ = 0x80 | (cp & 0x3F);
+				}
 
-	Token_Null,       // null
-	Token_Number,     // 0 || 1.0012
-	Token_String,     // "asdf"
-	Token_Bool_True,  // true
-	Token_Bool_False, // false
+				src += 4;
+			} break;
 
-	Token_TotalTypes,
-};
+			default: return -1;
+		}
 
-const char* TokenType_Strings[Token_TotalTypes + 1] = {
-	"Token_EOF",
+		src += 2;
+	}
 
-	"Token_Comma",
-	"Token_Colon",
+	return dst - start;
+}
 
-	"Token_BeginObject",
-	"Token_EndObject",
+// Check a number's syntax and find where it ends, NULL if it's not valid.
+// The value is only worked out if `out` isn't NULL.
+static const char* JSON_ScanNumber(const char* c, const char* end, r64* out) {
+	const char* start = c;
 
-	"Token_BeginArray",
-	"Token_EndArray",
+	bool8 neg = (c < end && *c == '-');
+	c += neg;
 
-	"Token_Null",
-	"Token_Number",
-	"Token_String",
-	"Token_Bool_True",
-	"Token_Bool_False",
+	// Integers small enough to be exact are put together right here...
+	u64 mantissa       = 0;
+	const char* digits = c;
+	while(c < end && '0' <= *c && *c <= '9') mantissa = mantissa * 10 + (*c++ - '0');
 
-	"Token_TotalTypes"
-};
+	u32 numDigits = c - digits;
+	if(!numDigits || (numDigits > 1 && *digits == '0')) return NULL;
 
-typedef struct Token Token;
-struct Token {
-	enum TokenType Type;
-	const char* Start;
-	const char* End;
-	u32 LineNumber;
-};
+	bool8 simple = numDigits <= 15;
 
-DEF_ARRAY(Token, Token);
-DECL_ARRAY(Token, Token);
+	if(c < end && *c == '.') {
+		simple = 0;
+		if(++c == end || *c < '0' || *c > '9') return NULL;
+		while(c < end && '0' <= *c && *c <= '9') c++;
+	}
 
-static void PrintToken(const Token* t) {
-	printf("%s", TokenType_Strings[t->Type]);
-	switch(t->Type) {
-		case Token_String:
-			printf("(\"%.*s\")", (i32) (t->End - t->Start), t->Start);
-			break;
-		case Token_Number:
-			printf("(%.2f)", String_ToR32_N(t->Start, t->End - t->Start));
-			break;
-		default:
-			break;
+	if(c < end && (*c == 'e' || *c == 'E')) {
+		simple = 0;
+		c++;
+		if(c < end && (*c == '+' || *c == '-')) c++;
+		if(c == end || *c < '0' || *c > '9') return NULL;
+		while(c < end && '0' <= *c && *c <= '9') c++;
 	}
-	printf(" ");
-}
-
-static Array_Token JSON_ToTokens(const char* str, u32 len) {
-	const char* p      = str;
-	Array_Token tokens = {0};
-	Array_Token_Prealloc(&tokens, 256);
-
-	while(p != str + len) {
-		enum TokenType type = Token_EOF;
-		const char *start = 0, *end = 0;
-
-		// Eat whitespace
-		while(p < str + len && Char_OneOf(*p, " \t\n\r")) ++p;
-
-		if(*p == '{') {
-			type = Token_BeginObject;
-			++p;
-		} else if(*p == '}') {
-			type = Token_EndObject;
-			++p;
-		} else if(*p == '[') {
-			type = Token_BeginArray;
-			++p;
-		} else if(*p == ']') {
-			type = Token_EndArray;
-			++p;
-		} else if(*p == ':') {
-			type = Token_Colon;
-			++p;
-		} else if(*p == ',') {
-			type = Token_Comma;
-			++p;
-		} else if(*p == '\"') {
-			++p;
-			const char* q = p;
-			while(q < str + len && *q != '\"')
-				q += (*q == '\\' ? 2 : 1);
-
-			if(q == str + len) {
-				Log(ERROR, "[JSON] Unclosed string.", "");
-			}
 
-			type  = Token_String;
-			start = p;
-			end   = q;
-
-			p = q + 1;
-		} else if(*p == '-' || ('0' <= *p && *p <= '9')) {
-			const char* q = p;
-			bool8 gotDot  = 0;
-
-			while(q < str + len && !Char_OneOf(*q, " \t\n\r{}[]:,\"")) {
-				if(*q == '.') {
-					if(gotDot) {
-						Log(ERROR, "[JSON] Number with too many decimal points.", "");
-						Array_Token_Free(&tokens);
-						return (Array_Token){0};
-					} else
-						gotDot = 1;
-				}
-				++q;
-			}
-			type  = Token_Number;
-			start = p;
-			end   = q;
-
-			p = q;
-		} else if(strncmp(p, "null", 4) == 0) {
-			type = Token_Null;
-			p += 4;
-		} else if(strncmp(p, "true", 4) == 0) {
-			type = Token_Bool_True;
-			p += 4;
-		} else if(strncmp(p, "false", 5) == 0) {
-			type = Token_Bool_False;
-			p += 5;
-		} else {
-			while(p != str + len && !Char_OneOf(*p, " \t\n\r{}[]:,\""))
-				++p;
+	// ... everything else goes through strtod().
+	if(out) *out = (simple ? (neg ? -(r64) mantissa : (r64) mantissa) : String_ToR64_N(start, c - start));
+	return c;
+}
+
+//
+// Structural index
+//
+
+// Before parsing, the whole text is scanned 64 bytes at a time for the positions of
+// every structural character ({}[]:,), both quotes of every string and the start of
+// every number and literal. The parser then jumps from one to the next instead of
+// looking at every byte.
+// (https://arxiv.org/abs/1902.08318, "Parsing Gigabytes of JSON per Second")
+
+// Bits set for one 64 byte block, bit i is byte i.
+typedef struct {
+	u64 Quote, Backslash, Op, Whitespace, Control;
+} JSON_Block;
+
+// State carried from one block to the next.
+typedef struct {
+	u64 PrevEscaped;  // The first byte of the block is escaped.
+	u64 PrevInString; // All ones if the block starts inside a string.
+	u64 PrevScalar;   // The last byte of the previous block was part of a number/literal.
+
+	// Set if any string has an escape or a control character in it,
+	// most documents have neither and their strings don't have to be looked at again.
+	u64 StringBackslash, StringControl;
+} JSON_Scanner;
+
+static void JSON_ClassifyBlock(const u8* c, JSON_Block* b) {
+	*b = (JSON_Block){0};
+	for(u32 i = 0; i < 64; i++) {
+		u64 bit = (u64) 1 << i;
+
+		switch(c[i]) {
+			case '\"': b->Quote |= bit; break;
+			case '\\': b->Backslash |= bit; break;
+
+			case '{':
+			case '}':
+			case '[':
+			case ']':
+			case ':':
+			case ',': b->Op |= bit; break;
+
+			case ' ':
+			case '\t':
+			case '\n':
+			case '\r': b->Whitespace |= bit; break;
 		}
 
-		Token t = {.Type = type, .Start = start, .End = end};
-		//PrintToken(&t);
-		Array_Token_Push(&tokens, &t);
+		if(c[i] < 0x20) b->Control |= bit;
 	}
+}
 
-	// Push final Token_EOF
-	Token t = {.Type = Token_EOF};
-	Array_Token_Push(&tokens, &t);
-	Array_Token_SizeToFit(&tokens);
-	return tokens;
+// Bit i becomes the XOR of bits 0 to i, which turns quote positions into string ranges.
+static inline u64 PrefixXOR(u64 x) {
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
 }
 
-const JSON_Value Error = {.Type = JSON_Error};
+// Work out the structurals of one block from its character classes.
+static inline u64 JSON_BlockStructurals(JSON_Scanner* s, JSON_Block* b, u64 (*prefixXOR)(u64)) {
+	// Escaped characters are the ones after an odd-length run of backslashes.
+	// Adding the run starts to the runs carries each start to the end of its run,
+	// which tells odd and even lengths apart without a loop (see the paper above).
+	const u64 evenBits = 0x5555555555555555ull;
+
+	u64 backslash     = b->Backslash & ~s->PrevEscaped;
+	u64 followsEscape = backslash << 1 | s->PrevEscaped;
+	u64 oddStarts     = backslash & ~evenBits & ~followsEscape;
+
+	u64 evenSequences = oddStarts + backslash;
+	s->PrevEscaped    = evenSequences < oddStarts;
+
+	u64 escaped = ((evenBits ^ (evenSequences << 1)) & followsEscape);
+
+	// Everything from an opening quote up to (not including) the closing one.
+	u64 quotes      = b->Quote & ~escaped;
+	u64 inString    = prefixXOR(quotes) ^ s->PrevInString;
+	s->PrevInString = (u64) ((i64) inString >> 63);
+
+	// Numbers and literals start at any byte that isn't whitespace or an operator
+	// and doesn't come right after another such byte. A closing quote doesn't count
+	// as one, so the x in "a"x shows up too.
+	u64 scalar         = ~(b->Op | b->Whitespace);
+	u64 nonQuoteScalar = scalar & ~quotes;
+	u64 followsScalar  = nonQuoteScalar << 1 | s->PrevScalar;
+	s->PrevScalar      = nonQuoteScalar >> 63;
+	u64 scalarStarts   = scalar & ~followsScalar;
+
+	s->StringBackslash |= b->Backslash & inString;
+	s->StringControl |= b->Control & inString;
+
+	// Drop everything inside strings, but keep the quotes.
+	u64 stringTail  = inString ^ quotes;
+	u64 closeQuotes = quotes & ~inString;
+	return ((b->Op | scalarStarts) & ~stringTail) | closeQuotes;
+}
 
-static JSON_Value JSON_ParsePrimitive(const Token** curr);
-static JSON_Value JSON_ParseArray(const Token** curr);
-static JSON_Value JSON_ParseObject(const Token** curr);
+static inline u32 CountTrailingZeros(u64 x) {
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward64(&i, x);
+	return i;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
 
-static JSON_Value JSON_ParsePrimitive(const Token** curr) {
-	JSON_Value res = {.Type = JSON_Error};
+static inline u32 JSON_Flatten(u32* out, u32 offset, u64 bits) {
+	u32 n = 0;
+	while(bits) {
+		out[n++] = offset + CountTrailingZeros(bits);
+		bits &= bits - 1;
+	}
+	return n;
+}
 
-	switch((*curr)->Type) {
-		case Token_String: {
-			res.Type = JSON_String;
+// Grow the index so another block always fits.
+static inline void JSON_ReserveBlock(u32** index, u32* capacity, u32 size) {
+	if(size + 64 <= *capacity) return;
 
-			u32 len = (*curr)->End - (*curr)->Start;
+	*capacity = *capacity * 2 + 64;
+	*index    = Reallocate(*index, sizeof(u32) * *capacity);
+}
 
-			res.String = Allocate(len + 1);
-			strncpy(res.String, (*curr)->Start, len);
-			res.String[len] = '\0';
+static u32* JSON_FindStructurals_Scalar(const u8* str, u32 len, u32* outCount, JSON_Scanner* outScanner) {
+	JSON_Scanner s = {0};
+	JSON_Block b;
 
-		} break;
+	u32 capacity = len / 8 + 64, size = 0;
+	u32* index   = Allocate(sizeof(u32) * capacity);
 
-		case Token_Number: {
-			res.Type   = JSON_Number;
-			res.Number = String_ToR32_N((*curr)->Start, (*curr)->End - (*curr)->Start);
-		} break;
+	for(u32 i = 0; i < len; i += 64) {
+		const u8* block = str + i;
 
-		case Token_Null:
-			res.Type = JSON_Null;
-			break;
-		case Token_Bool_True:
-			res.Type    = JSON_Boolean;
-			res.Boolean = 1;
-			break;
-		case Token_Bool_False:
-			res.Type    = JSON_Boolean;
-			res.Boolean = 0;
-			break;
+		// The last block is padded with spaces.
+		u8 tail[64];
+		if(len - i < 64) {
+			memset(tail, ' ', 64);
+			memcpy(tail, block, len - i);
+			block = tail;
+		}
 
-		default:
-			Log(ERROR, "[JSON] Token %s is not a primitive.",
-				TokenType_Strings[(*curr)->Type]);
-			break;
+		JSON_ClassifyBlock(block, &b);
+		JSON_ReserveBlock(&index, &capacity, size);
+		size += JSON_Flatten(index + size, i, JSON_BlockStructurals(&s, &b, PrefixXOR));
 	}
 
-	(*curr)++;
-	return res;
+	*outCount   = size;
+	*outScanner = s;
+	return index;
 }
 
-static JSON_Value JSON_ParseArray(const Token** curr) {
-	(*curr)++;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
 
-	JSON_Value array;
-	array.Type  = JSON_Array;
-	array.Array = (Array_JSON_Value){0};
+#define JSON_HAS_AVX2 1
 
-	while((*curr)->Type != Token_EndArray && (*curr)->Type != Token_EOF) {
-		JSON_Value v;
-		switch((*curr)->Type) {
-			case Token_BeginArray:
-				v = JSON_ParseArray(curr);
-				break;
+__attribute__((target("avx2,pclmul"))) static inline u64 PrefixXOR_CLMUL(u64 x) {
+	// Carry-less multiplication by all ones is exactly a prefix XOR.
+	__m128i v = _mm_clmulepi64_si128(_mm_set_epi64x(0, x), _mm_set1_epi8(-1), 0);
+	return _mm_cvtsi128_si64(v);
+}
 
-			case Token_BeginObject:
-				v = JSON_ParseObject(curr);
-				break;
+__attribute__((target("avx2"))) static inline u32 Mask_Eq(__m256i v, char c) {
+	return _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+}
 
-			case Token_Bool_True:
-			case Token_Bool_False:
-			case Token_Null:
-			case Token_Number:
-			case Token_String:
-				v = JSON_ParsePrimitive(curr);
-				break;
+__attribute__((target("avx2"))) static inline void JSON_ClassifyHalf(const u8* c, u32 shift, JSON_Block* b) {
+	__m256i v = _mm256_loadu_si256((const __m256i*) c);
 
-			default:
-				v = Error;
-				break;
-		}
-		if(v.Type == JSON_Error) 
-			goto ParseArray_error;
-
-		Array_JSON_Value_Push(&array.Array, &v);
-
-		if((*curr)->Type != Token_Comma && (*curr)->Type != Token_EndArray) {
-			Log(ERROR, "[JSON] Array: expected ',' or ']', got these instead: ", "");
-			PrintToken(*curr - 2);
-			PrintToken(*curr - 1);
-			PrintToken(*curr);
-			PrintToken(*curr + 1);
-			PrintToken(*curr + 2);
-			printf("\n");
-			goto ParseArray_error;
+	b->Quote |= (u64) Mask_Eq(v, '\"') << shift;
+	b->Backslash |= (u64) Mask_Eq(v, '\\') << shift;
+
+	// [ and ] are just { and } without the 0x20 bit, so each compare finds a pair.
+	__m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	u32 op = Mask_Eq(folded, '{') | Mask_Eq(folded, '}') | Mask_Eq(v, ':') | Mask_Eq(v, ',');
+	b->Op |= (u64) op << shift;
+
+	u32 ws = Mask_Eq(v, ' ') | Mask_Eq(v, '\t') | Mask_Eq(v, '\n') | Mask_Eq(v, '\r');
+	b->Whitespace |= (u64) ws << shift;
+
+	// Bytes up to 0x1F, unsigned.
+	b->Control |= (u64) Mask_Eq(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), 0x1F) << shift;
+}
+
+__attribute__((target("avx2,pclmul,bmi"))) static u32* JSON_FindStructurals_AVX2(const u8* str,
+                                                                                 u32 len,
+                                                                                 u32* outCount,
+                                                                                 JSON_Scanner* outScanner) {
+	JSON_Scanner s = {0};
+	JSON_Block b;
+
+	u32 capacity = len / 8 + 64, size = 0;
+	u32* index   = Allocate(sizeof(u32) * capacity);
+
+	for(u32 i = 0; i < len; i += 64) {
+		const u8* block = str + i;
+
+		u8 tail[64];
+		if(len - i < 64) {
+			memset(tail, ' ', 64);
+			memcpy(tail, block, len - i);
+			block = tail;
 		}
 
-		if((*curr)->Type == Token_Comma) (*curr)++;
-	}
+		b = (JSON_Block){0};
+		JSON_ClassifyHalf(block, 0, &b);
+		JSON_ClassifyHalf(block + 32, 32, &b);
 
-	if((*curr)->Type == Token_EOF) {
-		Log(ERROR, "[JSON] Array: reached EOF without closing the array.", "");
-		PrintToken(*curr - 4);
-		PrintToken(*curr - 3);
-		PrintToken(*curr - 2);
-		PrintToken(*curr - 1);
-		PrintToken(*curr);
-		printf("\n");
-		goto ParseArray_error;
+		JSON_ReserveBlock(&index, &capacity, size);
+		size += JSON_Flatten(index + size, i, JSON_BlockStructurals(&s, &b, PrefixXOR_CLMUL));
 	}
 
-	(*curr)++;
-	return array;
+	*outCount   = size;
+	*outScanner = s;
+	return index;
+}
+#endif
+
+// Returns the offsets of all structurals in order, free with Free().
+static u32* JSON_FindStructurals(const char* str, u32 len, u32* outCount, JSON_Scanner* outScanner) {
+#ifdef JSON_HAS_AVX2
+	static i8 hasAVX2 = -1;
+	if(hasAVX2 < 0)
+		hasAVX2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")
+		       && __builtin_cpu_supports("bmi");
+
+	if(hasAVX2) return JSON_FindStructurals_AVX2((const u8*) str, len, outCount, outScanner);
+#endif
 
-ParseArray_error:
-	JSON_Free(&array);
-	return Error;
+	return JSON_FindStructurals_Scalar((const u8*) str, len, outCount, outScanner);
 }
 
-static JSON_Value JSON_ParseObject(const Token** curr) {
-	(*curr)++;
+// Unescape a string in place. p->Curr is on the opening quote.
+// The closing quote gets replaced with a NULL.
+static bool8 JSON_ParseString(JSON_Parser* p, char** outStr, u32* outLen) {
+	char* start = ++p->Curr;
 
-	JSON_Value object;
-	object.Type              = JSON_Object;
-	object.Object.Map        = (HashMap_JSON_Value){0};
-	object.Object.StringKeys = (Array_String){0};
+	// The closing quote is always the next structural, unless the string never ends.
+	if(p->Next == p->NumStructurals || p->Start[p->Structurals[p->Next]] != '\"') {
+		p->Curr = p->End;
+		return JSON_Fail(p, "Unclosed string");
+	}
 
-	while((*curr)->Type != Token_EndObject && (*curr)->Type != Token_EOF) {
-		char* Key;
-		u32 KeyLen;
+	char* close = p->Start + p->Structurals[p->Next++];
 
-		if((*curr)->Type == Token_String) {
-			KeyLen = (*curr)->End - (*curr)->Start;
+	// Only look inside the string if there's a chance it needs it.
+	u32 flags = 0;
+	if(p->HasEscapes || p->HasControl) {
+		bool8 escaped = 0;
+		JSON_StringEnd(start, close, &escaped, &flags);
+	}
 
-			Key = Allocate(KeyLen + 1);
-			Key[KeyLen] = '\0';
+	if(flags & STRING_HAS_CONTROL) return JSON_Fail(p, "Control character inside a string");
 
-			strncpy(Key, (*curr)->Start, KeyLen);
+	i32 len = close - start;
+	if(flags & STRING_HAS_ESCAPES) {
+		len = JSON_Unescape(start, start, len);
+		if(len < 0) return JSON_Fail(p, "Invalid escape sequence");
+	}
 
-			(*curr)++;
-		} else {
-			Log(ERROR, "[JSON] Object, expected string, got %s.",
-			    TokenType_Strings[(*curr)->Type]);
+	start[len] = '\0';
+	*outStr    = start;
+	*outLen    = len;
+	p->Curr    = close + 1;
+	return 1;
+}
 
-			PrintToken(*curr - 2);
-			PrintToken(*curr - 1);
-			PrintToken(*curr);
-			PrintToken(*curr + 1);
-			PrintToken(*curr + 2);
+static bool8 JSON_ParseNumber(JSON_Parser* p, r64* out) {
+	const char* end = JSON_ScanNumber(p->Curr, p->End, out);
+	if(!end) return JSON_Fail(p, "Invalid number");
 
-			printf("\n");
-			goto ParseObject_error;
-		}
+	p->Curr = (char*) end;
+	return 1;
+}
 
-		if((*curr)->Type == Token_Colon) {
-			(*curr)++;
-		} else {
-			Free(Key);
-			Log(ERROR, "[JSON] Object, expected ':', got %s.",
-			    TokenType_Strings[(*curr)->Type]);
-
-			PrintToken(*curr - 2);
-			PrintToken(*curr - 1);
-			PrintToken(*curr);
-			PrintToken(*curr + 1);
-			PrintToken(*curr + 2);
-
-			printf("\n");
-			goto ParseObject_error;
+static bool8 JSON_ParseValue(JSON_Parser* p, JSON_Value* out);
+
+static bool8 JSON_ParseArray(JSON_Parser* p, JSON_Value* out) {
+	p->Curr++;
+
+	u32 first = p->Values.Size;
+
+	if(JSON_Advance(p) != ']') {
+		while(1) {
+			JSON_Value v;
+			if(!JSON_ParseValue(p, &v)) return 0;
+			Array_JSON_Value_Push(&p->Values, &v);
+
+			char c = JSON_Advance(p);
+			if(c == ']') break;
+			if(!c) return JSON_Fail(p, "Reached the end without closing the array");
+			if(c != ',') return JSON_Fail(p, "Array: expected ',' or ']'");
+
+			JSON_Advance(p);
 		}
+	}
 
-		JSON_Value v;
-		switch((*curr)->Type) {
-			case Token_BeginArray:
-				v = JSON_ParseArray(curr);
-				break;
+	u32 size        = p->Values.Size - first;
+	out->Type       = JSON_Array;
+	out->Array.Size = size;
+	out->Array.Data = NULL;
 
-			case Token_BeginObject: 
-				v = JSON_ParseObject(curr);
-				break;
+	if(size) {
+		out->Array.Data = Arena_Alloc(p->Arena, sizeof(JSON_Value) * size);
+		memcpy(out->Array.Data, p->Values.Data + first, sizeof(JSON_Value) * size);
+	}
 
-			case Token_Bool_True:
-			case Token_Bool_False:
-			case Token_Null:
-			case Token_Number:
-			case Token_String:
-				v = JSON_ParsePrimitive(curr);
-				break;
+	p->Values.Size = first;
+	return 1;
+}
+
+static void JSON_BuildIndex(JSON_Value* obj, Arena* arena) {
+	u32 capacity = 1;
+	while(capacity < obj->Object.Size * 2) capacity *= 2;
+
+	obj->Object.IndexMask = capacity - 1;
+	obj->Object.Index     = Arena_Alloc(arena, sizeof(u32) * capacity);
+	memset(obj->Object.Index, 0, sizeof(u32) * capacity);
+
+	for(u32 i = 0; i < obj->Object.Size; i++) {
+		const JSON_Member* m = &obj->Object.Members[i];
+		u32 slot = Hash_FNV1a((const u8*) m->Key, m->KeyLength) & obj->Object.IndexMask;
 
-			default:
-				v = Error;
+		// Linear probing, later duplicates of a key win.
+		while(obj->Object.Index[slot]) {
+			const JSON_Member* other = &obj->Object.Members[obj->Object.Index[slot] - 1];
+			if(other->KeyLength == m->KeyLength && memcmp(other->Key, m->Key, m->KeyLength) == 0)
 				break;
-		}
-		if(v.Type == JSON_Error) {
-			Free(Key);
-			goto ParseObject_error;
+
+			slot = (slot + 1) & obj->Object.IndexMask;
 		}
 
-		i32 i = HashMap_JSON_Value_FindIdx(&object.Object.Map, (u8*) Key, KeyLen);
+		obj->Object.Index[slot] = i + 1;
+	}
+}
 
-		if(i >= 0) {
-			Log(WARN, "[JSON] Object, key \"%s\" already exists, overwriting value.", Key);
-			object.Object.Map.Values[i] = v;
-		} else {
-			HashMap_JSON_Value_Add(&object.Object.Map, (u8*) Key, KeyLen, &v);
-			Array_String_PushVal(&object.Object.StringKeys, Key);
-		}
+static bool8 JSON_ParseObject(JSON_Parser* p, JSON_Value* out) {
+	p->Curr++;
 
-		if((*curr)->Type != Token_Comma && (*curr)->Type != Token_EndObject) {
-			Free(Key);
+	u32 first = p->Members.Size;
 
-			Log(ERROR, "[JSON] Object, expected ',' or '}', got %s",
-			    TokenType_Strings[(*curr)->Type]);
+	char c = JSON_Advance(p);
+	if(c != '}') {
+		while(1) {
+			JSON_Member m;
 
-			PrintToken(*curr - 2);
-			PrintToken(*curr - 1);
-			PrintToken(*curr);
-			PrintToken(*curr + 1);
-			PrintToken(*curr + 2);
+			if(c != '\"') return JSON_Fail(p, "Object: expected a string key");
+			if(!JSON_ParseString(p, (char**) &m.Key, &m.KeyLength)) return 0;
 
-			printf("\n");
-			goto ParseObject_error;
+			if(JSON_Advance(p) != ':') return JSON_Fail(p, "Object: expected ':'");
+
+			JSON_Advance(p);
+			if(!JSON_ParseValue(p, &m.Value)) return 0;
+			Array_JSON_Member_Push(&p->Members, &m);
+
+			c = JSON_Advance(p);
+			if(c == '}') break;
+			if(!c) return JSON_Fail(p, "Reached the end without closing the object");
+			if(c != ',') return JSON_Fail(p, "Object: expected ',' or '}'");
+
+			c = JSON_Advance(p);
 		}
+	}
 
-		if((*curr)->Type == Token_Comma)
-			(*curr)++;
+	u32 size = p->Members.Size - first;
+	*out     = (JSON_Value){.Type = JSON_Object};
+
+	if(size) {
+		out->Object.Size    = size;
+		out->Object.Members = Arena_Alloc(p->Arena, sizeof(JSON_Member) * size);
+		memcpy(out->Object.Members, p->Members.Data + first, sizeof(JSON_Member) * size);
+
+		if(size > JSON_INDEX_THRESHOLD) JSON_BuildIndex(out, p->Arena);
 	}
 
-	if((*curr)->Type == Token_EOF) {
-		Log(ERROR, "[JSON] Object, reached EOF without closing the object.", "");
-		goto ParseObject_error;
+	p->Members.Size = first;
+	return 1;
+}
+
+// p->Curr is on the value's first character.
+static bool8 JSON_ParseValue(JSON_Parser* p, JSON_Value* out) {
+	*out = (JSON_Value){.Type = JSON_Null};
+
+	if(p->Curr == p->End) return JSON_Fail(p, "Expected a value, reached the end");
+
+	bool8 ok = 1;
+	switch(*p->Curr) {
+		case '{':
+		case '[':
+			if(++p->Depth > JSON_MAX_DEPTH) return JSON_Fail(p, "Nested too deeply");
+
+			ok = (*p->Curr == '{' ? JSON_ParseObject(p, out) : JSON_ParseArray(p, out));
+			p->Depth--;
+			return ok;
+
+		case '\"':
+			out->Type = JSON_String;
+			return JSON_ParseString(p, &out->String, &out->StringLength);
+
+		case 't':
+		case 'f':
+		case 'n': {
+			static const char* words[] = {"true", "false", "null"};
+
+			u32 w   = (*p->Curr == 't' ? 0 : *p->Curr == 'f' ? 1 : 2);
+			u32 len = strlen(words[w]);
+			if(p->End - p->Curr < len || memcmp(p->Curr, words[w], len) != 0)
+				return JSON_Fail(p, "Unknown literal");
+
+			out->Type    = (w == 2 ? JSON_Null : JSON_Boolean);
+			out->Boolean = (w == 0);
+			p->Curr += len;
+		} break;
+
+		default:
+			if(*p->Curr != '-' && (*p->Curr < '0' || *p->Curr > '9'))
+				return JSON_Fail(p, "Unexpected character");
+
+			out->Type = JSON_Number;
+			ok        = JSON_ParseNumber(p, &out->Number);
+			break;
 	}
 
-	(*curr)++;
-	return object;
+	// The structural index skips over whatever's left of a bad number or literal, like "truex".
+	if(ok && p->Curr < p->End && !Char_IsDelimiter(*p->Curr))
+		return JSON_Fail(p, "Unexpected character after value");
+
+	return ok;
+}
+
+static JSON_Value JSON_Parse(char* str, u32 len, Arena* arena) {
+	JSON_Parser p = {.Start = str, .Curr = str, .End = str + len, .Arena = arena};
+	JSON_Scanner scan;
+	p.Structurals = JSON_FindStructurals(str, len, &p.NumStructurals, &scan);
+	p.HasEscapes  = (scan.StringBackslash != 0);
+	p.HasControl  = (scan.StringControl != 0);
+
+	JSON_Value res;
+	JSON_Advance(&p);
+	bool8 ok = JSON_ParseValue(&p, &res);
+
+	Free(p.Structurals);
+	Array_JSON_Value_Free(&p.Values);
+	Array_JSON_Member_Free(&p.Members);
+
+	if(!ok) {
+		Log(ERROR, "[JSON] Parsing error.", "");
+		Arena_Free(arena);
+		Free(arena);
+		return Error;
+	}
+
+	if(p.Next != p.NumStructurals) Log(WARN, "[JSON] There are still unparsed characters.", "");
+
+	res.Arena = arena;
+	return res;
+}
+
+static Arena* JSON_NewArena(u32 len) {
+	// The DOM is usually about as big as the text.
+	Arena* arena = Allocate(sizeof(Arena));
+	Arena_Init(arena, Clamp_I32(len, Kilobytes(4), Megabytes(4)));
+	return arena;
+}
+
+JSON_Value JSON_ParseInSitu(char* str, u32 len) {
+	if(!str || !len) {
+		Log(ERROR, "[JSON] Null string or zero length.", "");
+		return Error;
+	}
 
-ParseObject_error:
-	JSON_Free(&object);
-	return Error;
+	return JSON_Parse(str, len, JSON_NewArena(len));
 }
 
 JSON_Value JSON_FromString_N(const char* str, u32 len) {
@@ -434,86 +725,949 @@ JSON_Value JSON_FromString_N(const char* str, u32 len) {
 		return Error;
 	}
 
-	Array_Token tokens = JSON_ToTokens(str, len);
+	// Strings get unescaped in place, so work on a copy in the arena.
+	Arena* arena = JSON_NewArena(len);
+	char* copy   = Arena_Alloc(arena, len + 1);
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+
+	return JSON_Parse(copy, len, arena);
+}
 
-	if(!tokens.Data) {
-		Log(ERROR, "[JSON] No tokens parsed.", "");
+JSON_Value JSON_FromString(const char* str) { return JSON_FromString_N(str, strlen(str)); }
+
+JSON_Value JSON_FromFile(const char* filename) {
+	u32 size;
+	const u8* file = File_Map(filename, &size);
+	if(!file) {
+		Log(ERROR, "[JSON] Couldn't read \"%s\".", filename);
 		return Error;
 	}
 
-	const Token* currToken = tokens.Data;
-	JSON_Value res;
+	JSON_Value res = JSON_FromString_N((const char*) file, size);
+	File_Unmap(file, size);
+	return res;
+}
 
-	switch(currToken->Type) {
-		case Token_BeginArray:
-			res = JSON_ParseArray(&currToken);
-			break;
+void JSON_Free(JSON_Value* v) {
+	// Only the root owns any memory, and all of it is in one arena.
+	if(v->Arena) {
+		Arena_Free(v->Arena);
+		Free(v->Arena);
+	}
 
-		case Token_BeginObject:
-			res = JSON_ParseObject(&currToken);
-			break;
+	*v = (JSON_Value){.Type = JSON_Null};
+}
 
-		case Token_Null:
-		case Token_String:
-		case Token_Number:
-		case Token_Bool_True:
-		case Token_Bool_False:
-			res = JSON_ParsePrimitive(&currToken);
-			goto end;
+JSON_Value* JSON_ObjectFind(const JSON_Value* v, const char* str) {
+	if(!v || !str || v->Type != JSON_Object)
+		return NULL;
 
-		default:
-			goto error;
+	u32 len = strlen(str);
+
+	if(v->Object.Index) {
+		u32 slot = Hash_FNV1a((const u8*) str, len) & v->Object.IndexMask;
+
+		while(v->Object.Index[slot]) {
+			JSON_Member* m = &v->Object.Members[v->Object.Index[slot] - 1];
+			if(m->KeyLength == len && memcmp(m->Key, str, len) == 0) return &m->Value;
+
+			slot = (slot + 1) & v->Object.IndexMask;
+		}
+
+		return NULL;
 	}
 
-	if(res.Type == JSON_Error)
-		goto error;
+	// Small objects are quicker to just go through, last duplicate wins.
+	for(u32 i = v->Object.Size; i-- > 0;) {
+		JSON_Member* m = &v->Object.Members[i];
+		if(m->KeyLength == len && memcmp(m->Key, str, len) == 0) return &m->Value;
+	}
 
-end:
-	if(currToken->Type != Token_EOF)
-		Log(WARN, "[JSON] There are still unparsed JSON tokens.", "");
+	return NULL;
+}
 
-	Array_Token_Free(&tokens);
-	return res;
+//
+// Streaming reader
+//
+
+enum {
+	Reader_Value,
+	Reader_ValueOrEnd,
+	Reader_Key,
+	Reader_KeyOrEnd,
+	Reader_Colon,
+	Reader_CommaOrEnd,
+	Reader_Done,
+	Reader_Error,
+};
 
-error:
-	Log(ERROR, "[JSON] Parsing error.", "");
-	Array_Token_Free(&tokens);
-	return Error;
+static enum JSON_Event JSON_Reader_Fail(JSON_Reader* r, const char* msg) {
+	Log(ERROR, "[JSON] Reader: %s.", msg);
+	r->State = Reader_Error;
+	return JSON_Event_Error;
 }
 
-void JSON_Free(JSON_Value* v) {
-	switch(v->Type) {
-		case JSON_Array:
-			for(u32 i = 0; i < v->Array.Size; ++i)
-				JSON_Free(v->Array.Data + i);
+static bool8 JSON_Reader_InObject(const JSON_Reader* r) {
+	u32 level = r->Depth - 1;
+	return (r->Stack[level / 8] >> (level % 8)) & 1;
+}
 
-			Array_JSON_Value_Free(&v->Array);
+static void JSON_Reader_AfterValue(JSON_Reader* r) {
+	r->State = (r->Depth ? Reader_CommaOrEnd : Reader_Done);
+}
 
-			break;
+// Where a number or literal ends, NULL if it might go on in the next chunk.
+static const char* JSON_LiteralEnd(const char* c, const char* end) {
+	while(c < end && !Char_IsDelimiter(*c)) c++;
+	return (c < end ? c : NULL);
+}
 
-		case JSON_Object:
-			for(u32 i = 0; i < v->Object.Map.Size; ++i) {
-				Free(v->Object.StringKeys.Data[i]);
-				JSON_Free(v->Object.Map.Values + i);
+void JSON_Reader_Init(JSON_Reader* r, const char* str, u32 len) {
+	JSON_Reader_InitStream(r);
+	JSON_Reader_Feed(r, str, len, 1);
+}
+
+void JSON_Reader_InitStream(JSON_Reader* r) {
+	// Skip zeroing the buffers, they're big and never read before being written.
+	memset(r, 0, offsetof(JSON_Reader, Carry));
+	r->CarrySize    = 0;
+	r->CarryEscaped = 0;
+	r->CarryReady   = 0;
+	r->State        = Reader_Value;
+	r->LastEvent    = JSON_Event_NeedInput;
+}
+
+static bool8 JSON_Reader_CarryAppend(JSON_Reader* r, const char* s, u32 len) {
+	if(r->CarrySize + len > JSON_READER_CARRY_SIZE) {
+		JSON_Reader_Fail(r, "Token split between chunks is too long");
+		return 0;
+	}
+
+	memcpy(r->Carry + r->CarrySize, s, len);
+	r->CarrySize += len;
+	return 1;
+}
+
+void JSON_Reader_Feed(JSON_Reader* r, const char* chunk, u32 len, bool8 last) {
+	r->Curr      = chunk;
+	r->End       = chunk + len;
+	r->LastChunk = last;
+
+	if(!r->CarrySize || r->State == Reader_Error) return;
+
+	// Finish the token that got cut off at the end of the last chunk.
+	const char* end;
+	if(r->Carry[0] == '\"') {
+		u32 flags = 0;
+		end       = JSON_StringEnd(chunk, r->End, &r->CarryEscaped, &flags);
+		if(end) end++;
+	} else {
+		end = JSON_LiteralEnd(chunk, r->End);
+		if(!end && last) end = r->End;
+	}
+
+	if(!JSON_Reader_CarryAppend(r, chunk, (end ? end : r->End) - chunk)) return;
+	if(!end && last) {
+		JSON_Reader_Fail(r, "Unclosed string");
+		return;
+	}
+
+	r->Curr       = (end ? end : r->End);
+	r->CarryReady = (end != NULL);
+}
+
+// Turn a whole string, number or literal into an event.
+static enum JSON_Event JSON_Reader_Token(JSON_Reader* r, const char* s, const char* e, u32 flags) {
+	bool8 wantKey   = (r->State == Reader_Key || r->State == Reader_KeyOrEnd);
+	bool8 wantValue = (r->State == Reader_Value || r->State == Reader_ValueOrEnd);
+
+	if(*s == '\"') {
+		if(!wantKey && !wantValue) return JSON_Reader_Fail(r, "Unexpected string");
+
+		r->String       = s + 1;
+		r->StringLength = e - s - 2;
+
+		if(flags & STRING_HAS_CONTROL) return JSON_Reader_Fail(r, "Control character inside a string");
+
+		if(!r->Skipping && (flags & STRING_HAS_ESCAPES)) {
+			if(r->StringLength > JSON_READER_CARRY_SIZE)
+				return JSON_Reader_Fail(r, "String with escapes is too long");
+
+			i32 len = JSON_Unescape(r->Scratch, r->String, r->StringLength);
+			if(len < 0) return JSON_Reader_Fail(r, "Invalid escape sequence");
+
+			r->String       = r->Scratch;
+			r->StringLength = len;
+		}
+
+		if(wantKey) {
+			r->State = Reader_Colon;
+			return JSON_Event_Key;
+		}
+
+		JSON_Reader_AfterValue(r);
+		return JSON_Event_String;
+	}
+
+	if(!wantValue) return JSON_Reader_Fail(r, "Expected a key");
+
+	enum JSON_Event res;
+	u32 len = e - s;
+
+	if(len == 4 && memcmp(s, "true", 4) == 0) {
+		res        = JSON_Event_Boolean;
+		r->Boolean = 1;
+	} else if(len == 5 && memcmp(s, "false", 5) == 0) {
+		res        = JSON_Event_Boolean;
+		r->Boolean = 0;
+	} else if(len == 4 && memcmp(s, "null", 4) == 0) {
+		res = JSON_Event_Null;
+	} else if(JSON_ScanNumber(s, e, (r->Skipping ? NULL : &r->Number)) == e) {
+		res = JSON_Event_Number;
+	} else {
+		return JSON_Reader_Fail(r, "Invalid number or literal");
+	}
+
+	JSON_Reader_AfterValue(r);
+	return res;
+}
+
+static enum JSON_Event JSON_Reader_Step(JSON_Reader* r) {
+	if(r->State == Reader_Error) return JSON_Event_Error;
+
+	// A token that was split between chunks is whole again.
+	if(r->CarryReady) {
+		u32 flags = 0;
+		if(r->Carry[0] == '\"') {
+			bool8 escaped = 0;
+			JSON_StringEnd(r->Carry + 1, r->Carry + r->CarrySize, &escaped, &flags);
+		}
+
+		r->CarryReady     = 0;
+		enum JSON_Event e = JSON_Reader_Token(r, r->Carry, r->Carry + r->CarrySize, flags);
+		r->CarrySize      = 0;
+		return e;
+	}
+
+	while(1) {
+		while(r->Curr < r->End
+		      && (*r->Curr == ' ' || *r->Curr == '\n' || *r->Curr == '\r' || *r->Curr == '\t'))
+			r->Curr++;
+
+		if(r->Curr == r->End) {
+			if(!r->LastChunk || r->CarrySize) return JSON_Event_NeedInput;
+			if(r->State == Reader_Done) return JSON_Event_End;
+			return JSON_Reader_Fail(r, "Document ended too early");
+		}
+
+		char c = *r->Curr;
+		switch(c) {
+			case '{':
+			case '[':
+				if(r->State != Reader_Value && r->State != Reader_ValueOrEnd)
+					return JSON_Reader_Fail(r, "Unexpected object or array");
+				if(r->Depth == JSON_READER_MAX_DEPTH) return JSON_Reader_Fail(r, "Nested too deeply");
+
+				if(c == '{')
+					r->Stack[r->Depth / 8] |= 1 << (r->Depth % 8);
+				else
+					r->Stack[r->Depth / 8] &= ~(1 << (r->Depth % 8));
+
+				r->Depth++;
+				r->Curr++;
+				r->State = (c == '{' ? Reader_KeyOrEnd : Reader_ValueOrEnd);
+				return (c == '{' ? JSON_Event_BeginObject : JSON_Event_BeginArray);
+
+			case '}':
+			case ']': {
+				bool8 obj = (c == '}');
+				bool8 ok  = r->Depth && JSON_Reader_InObject(r) == obj
+				         && (r->State == Reader_CommaOrEnd
+				             || r->State == (obj ? Reader_KeyOrEnd : Reader_ValueOrEnd));
+				if(!ok) return JSON_Reader_Fail(r, "Unexpected end of object or array");
+
+				r->Depth--;
+				r->Curr++;
+				JSON_Reader_AfterValue(r);
+				return (obj ? JSON_Event_EndObject : JSON_Event_EndArray);
 			}
 
-			Array_String_Free(&v->Object.StringKeys);
-			HashMap_JSON_Value_Free(&v->Object.Map);
+			case ':':
+				if(r->State != Reader_Colon) return JSON_Reader_Fail(r, "Unexpected ':'");
+				r->State = Reader_Value;
+				r->Curr++;
+				continue;
+
+			case ',':
+				if(r->State != Reader_CommaOrEnd) return JSON_Reader_Fail(r, "Unexpected ','");
+				r->State = (JSON_Reader_InObject(r) ? Reader_Key : Reader_Value);
+				r->Curr++;
+				continue;
+
+			default: break;
+		}
+
+		if(r->State == Reader_Done) return JSON_Reader_Fail(r, "Trailing characters after the document");
+
+		// Strings, numbers and literals have to be whole before they can be turned into events.
+		const char* start = r->Curr;
+		const char* end;
+		u32 flags = 0;
+		if(c == '\"') {
+			bool8 escaped = 0;
+			end           = JSON_StringEnd(start + 1, r->End, &escaped, &flags);
+			if(end) end++;
+
+			if(!end && !r->LastChunk) r->CarryEscaped = escaped;
+		} else {
+			end = JSON_LiteralEnd(start, r->End);
+			if(!end && r->LastChunk) end = r->End;
+		}
+
+		if(!end) {
+			if(r->LastChunk) return JSON_Reader_Fail(r, "Unclosed string");
+
+			r->CarrySize = 0;
+			if(!JSON_Reader_CarryAppend(r, start, r->End - start)) return JSON_Event_Error;
+
+			r->Curr = r->End;
+			return JSON_Event_NeedInput;
+		}
+
+		r->Curr = end;
+		return JSON_Reader_Token(r, start, end, flags);
+	}
+}
+
+enum JSON_Event JSON_Reader_Next(JSON_Reader* r) {
+	while(1) {
+		enum JSON_Event e = JSON_Reader_Step(r);
+		if(e <= JSON_Event_End) return e;
+
+		r->LastEvent = e;
+		if(!r->Skipping) return e;
+
+		// Drop everything until the value being skipped is over.
+		if(r->Depth == r->SkipDepth && e != JSON_Event_BeginObject && e != JSON_Event_BeginArray
+		   && e != JSON_Event_Key)
+			r->Skipping = 0;
+	}
+}
+
+void JSON_Reader_Skip(JSON_Reader* r) {
+	if(r->LastEvent == JSON_Event_Key)
+		r->SkipDepth = r->Depth;
+	else if(r->LastEvent == JSON_Event_BeginObject || r->LastEvent == JSON_Event_BeginArray)
+		r->SkipDepth = r->Depth - 1;
+	else
+		return;
+
+	r->Skipping = 1;
+}
+
+bool8 JSON_Reader_StringIs(const JSON_Reader* r, const char* str) {
+	u32 len = strlen(str);
+	return r->StringLength == len && memcmp(r->String, str, len) == 0;
+}
+
+//
+// Writing
+//
+
+#define JSON_WRITER_BUFFER_SIZE Kilobytes(16)
+
+// Writers give their buffers back here and take them from here first.
+// Buffers that grew past JSON_POOL_MAX_BUFFER are freed instead of being kept around.
+// Not thread safe.
+#define JSON_POOL_SIZE       8
+#define JSON_POOL_MAX_BUFFER Megabytes(1)
+
+static struct {
+	char* Data;
+	u32 Capacity;
+} JSON_Pool[JSON_POOL_SIZE];
+static u32 JSON_PoolSize = 0;
+
+static void JSON_Writer_Setup(JSON_Writer* w, i32 fd, u32 indent) {
+	memset(w, 0, sizeof(JSON_Writer));
+	w->FD     = fd;
+	w->Indent = indent;
+
+	if(JSON_PoolSize) {
+		JSON_PoolSize--;
+		w->Data     = JSON_Pool[JSON_PoolSize].Data;
+		w->Capacity = JSON_Pool[JSON_PoolSize].Capacity;
+	} else {
+		w->Data     = Allocate(JSON_WRITER_BUFFER_SIZE);
+		w->Capacity = JSON_WRITER_BUFFER_SIZE;
+	}
+}
+
+void JSON_Writer_Init(JSON_Writer* w, u32 indent) { JSON_Writer_Setup(w, -1, indent); }
+void JSON_Writer_InitFD(JSON_Writer* w, i32 fd, u32 indent) { JSON_Writer_Setup(w, fd, indent); }
+
+void JSON_Writer_Free(JSON_Writer* w) {
+	if(w->Data && w->Capacity <= JSON_POOL_MAX_BUFFER && JSON_PoolSize < JSON_POOL_SIZE) {
+		JSON_Pool[JSON_PoolSize].Data     = w->Data;
+		JSON_Pool[JSON_PoolSize].Capacity = w->Capacity;
+		JSON_PoolSize++;
+	} else {
+		Free(w->Data);
+	}
+
+	w->Data     = NULL;
+	w->Size     = 0;
+	w->Capacity = 0;
+}
 
+static void JSON_Writer_Write(JSON_Writer* w, const char* data, u32 len) {
+	while(len && !w->Failed) {
+		i32 n = write(w->FD, data, len);
+		if(n <= 0) {
+			Log(ERROR, "[JSON] Couldn't write to file descriptor %d.", w->FD);
+			w->Failed = 1;
 			break;
+		}
+
+		data += n;
+		len -= n;
+	}
+}
+
+static void JSON_Writer_Flush(JSON_Writer* w) {
+	if(w->FD < 0) return;
+
+	JSON_Writer_Write(w, w->Data, w->Size);
+	w->Size = 0;
+}
+
+// Make room for `n` more bytes (and a NULL) and return where they go.
+static char* JSON_Writer_Reserve(JSON_Writer* w, u32 n) {
+	if(w->Size + n + 1 > w->Capacity) {
+		JSON_Writer_Flush(w);
+
+		if(w->Size + n + 1 > w->Capacity) {
+			while(w->Capacity < w->Size + n + 1) w->Capacity *= 2;
+			w->Data = Reallocate(w->Data, w->Capacity);
+		}
+	}
+
+	return w->Data + w->Size;
+}
+
+static void JSON_Writer_Append(JSON_Writer* w, const char* data, u32 len) {
+	// Big pieces go straight to the file descriptor instead of through the buffer.
+	if(w->FD >= 0 && len >= w->Capacity) {
+		JSON_Writer_Flush(w);
+		JSON_Writer_Write(w, data, len);
+		return;
+	}
+
+	memcpy(JSON_Writer_Reserve(w, len), data, len);
+	w->Size += len;
+}
+
+static char* JSON_Writer_Newline(JSON_Writer* w, char* c, u32 depth) {
+	*c++ = '\n';
+	memset(c, ' ', w->Indent * depth);
+	return c + w->Indent * depth;
+}
+
+static bool8 JSON_Writer_LevelHasItems(const JSON_Writer* w, u32 level) {
+	level = MIN(level, JSON_WRITER_MAX_DEPTH - 1);
+	return (w->HasItems[level / 8] >> (level % 8)) & 1;
+}
+
+// Put a comma and a line break in front of the next value, if it needs them.
+static void JSON_Writer_Separate(JSON_Writer* w) {
+	if(w->AfterKey) {
+		w->AfterKey = 0;
+		return;
+	}
+
+	if(!w->Depth) return;
+
+	u32 level      = MIN(w->Depth, JSON_WRITER_MAX_DEPTH) - 1;
+	bool8 hasItems = JSON_Writer_LevelHasItems(w, level);
+	w->HasItems[level / 8] |= 1 << (level % 8);
+
+	char* c = JSON_Writer_Reserve(w, 2 + w->Indent * w->Depth);
+	if(hasItems) *c++ = ',';
+	if(w->Indent) c = JSON_Writer_Newline(w, c, w->Depth);
+	w->Size = c - w->Data;
+}
+
+static void JSON_Writer_Begin(JSON_Writer* w, char open) {
+	JSON_Writer_Separate(w);
+
+	if(w->Depth == JSON_WRITER_MAX_DEPTH) {
+		Log(ERROR, "[JSON] Writer: nested too deeply.", "");
+		w->Failed = 1;
+	}
+
+	*JSON_Writer_Reserve(w, 1) = open;
+	w->Size++;
+
+	u32 level = MIN(w->Depth, JSON_WRITER_MAX_DEPTH - 1);
+	w->HasItems[level / 8] &= ~(1 << (level % 8));
+	w->Depth++;
+}
+
+static void JSON_Writer_End(JSON_Writer* w, char close) {
+	if(!w->Depth) {
+		Log(ERROR, "[JSON] Writer: closing more than was opened.", "");
+		w->Failed = 1;
+		return;
+	}
+
+	bool8 hasItems = JSON_Writer_LevelHasItems(w, w->Depth - 1);
+	w->Depth--;
+
+	char* c = JSON_Writer_Reserve(w, 2 + w->Indent * w->Depth);
+	if(hasItems && w->Indent) c = JSON_Writer_Newline(w, c, w->Depth);
+	*c++    = close;
+	w->Size = c - w->Data;
+}
+
+void JSON_Writer_BeginObject(JSON_Writer* w) { JSON_Writer_Begin(w, '{'); }
+void JSON_Writer_EndObject(JSON_Writer* w) { JSON_Writer_End(w, '}'); }
+void JSON_Writer_BeginArray(JSON_Writer* w) { JSON_Writer_Begin(w, '['); }
+void JSON_Writer_EndArray(JSON_Writer* w) { JSON_Writer_End(w, ']'); }
+
+// What each byte turns into inside a string, 0 means it stays as it is.
+static const char JSON_EscapeChars[256] = {
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+	['\"'] = '\"', ['\\'] = '\\',
+};
+
+static void JSON_Writer_Quoted(JSON_Writer* w, const char* str, u32 len) {
+	static const char hex[] = "0123456789abcdef";
+
+	*JSON_Writer_Reserve(w, 1) = '\"';
+	w->Size++;
+
+	// Copy everything between escapes in one go.
+	const char* run = str;
+	const char* end = str + len;
+	for(const char* s = str; s < end; s++) {
+		char e = JSON_EscapeChars[(u8) *s];
+		if(!e) continue;
+
+		JSON_Writer_Append(w, run, s - run);
+		run = s + 1;
+
+		char* c = JSON_Writer_Reserve(w, 6);
+		*c++    = '\\';
+		*c++    = e;
+		if(e == 'u') {
+			*c++ = '0';
+			*c++ = '0';
+			*c++ = hex[(u8) *s >> 4];
+			*c++ = hex[*s & 0xF];
+		}
+		w->Size = c - w->Data;
+	}
 
-		case JSON_String:
-			Free(v->String);
+	JSON_Writer_Append(w, run, end - run);
+
+	*JSON_Writer_Reserve(w, 1) = '\"';
+	w->Size++;
+}
+
+void JSON_Writer_Key_N(JSON_Writer* w, const char* key, u32 len) {
+	JSON_Writer_Separate(w);
+	JSON_Writer_Quoted(w, key, len);
+
+	char* c = JSON_Writer_Reserve(w, 2);
+	*c++    = ':';
+	if(w->Indent) *c++ = ' ';
+	w->Size = c - w->Data;
+
+	w->AfterKey = 1;
+}
+
+void JSON_Writer_Key(JSON_Writer* w, const char* key) { JSON_Writer_Key_N(w, key, strlen(key)); }
+
+void JSON_Writer_String_N(JSON_Writer* w, const char* str, u32 len) {
+	JSON_Writer_Separate(w);
+	JSON_Writer_Quoted(w, str, len);
+}
+
+void JSON_Writer_String(JSON_Writer* w, const char* str) { JSON_Writer_String_N(w, str, strlen(str)); }
+
+void JSON_Writer_Integer(JSON_Writer* w, i64 n) {
+	JSON_Writer_Separate(w);
+
+	// Digits come out backwards.
+	char buf[20];
+	u32 len = 0;
+	u64 u   = (n < 0 ? -(u64) n : (u64) n);
+	do {
+		buf[len++] = '0' + u % 10;
+		u /= 10;
+	} while(u);
+
+	char* c = JSON_Writer_Reserve(w, len + 1);
+	if(n < 0) *c++ = '-';
+	while(len) *c++ = buf[--len];
+	w->Size = c - w->Data;
+}
+
+// Shortest number formatting, with Grisu2.
+// The digits always read back as the same number, and are the shortest possible
+// for nearly every input (the rest are one digit longer).
+// Thank you, https://github.com/Tencent/rapidjson/blob/master/include/rapidjson/internal/dtoa.h
+// and https://www.cs.tufts.edu/~nr/cs257/archive/florian-loitsch/printf.pdf
+
+typedef struct {
+	u64 F;
+	i32 E;
+} DiyFP;
+
+// 10^-348, 10^-340, ..., 10^340, normalized.
+static const DiyFP Grisu_CachedPowers[87] = {
+	{0xFA8FD5A0081C0288ull, -1220}, {0xBAAEE17FA23EBF76ull, -1193}, {0x8B16FB203055AC76ull, -1166},
+	{0xCF42894A5DCE35EAull, -1140}, {0x9A6BB0AA55653B2Dull, -1113}, {0xE61ACF033D1A45DFull, -1087},
+	{0xAB70FE17C79AC6CAull, -1060}, {0xFF77B1FCBEBCDC4Full, -1034}, {0xBE5691EF416BD60Cull, -1007},
+	{0x8DD01FAD907FFC3Cull, -980}, {0xD3515C2831559A83ull, -954}, {0x9D71AC8FADA6C9B5ull, -927},
+	{0xEA9C227723EE8BCBull, -901}, {0xAECC49914078536Dull, -874}, {0x823C12795DB6CE57ull, -847},
+	{0xC21094364DFB5637ull, -821}, {0x9096EA6F3848984Full, -794}, {0xD77485CB25823AC7ull, -768},
+	{0xA086CFCD97BF97F4ull, -741}, {0xEF340A98172AACE5ull, -715}, {0xB23867FB2A35B28Eull, -688},
+	{0x84C8D4DFD2C63F3Bull, -661}, {0xC5DD44271AD3CDBAull, -635}, {0x936B9FCEBB25C996ull, -608},
+	{0xDBAC6C247D62A584ull, -582}, {0xA3AB66580D5FDAF6ull, -555}, {0xF3E2F893DEC3F126ull, -529},
+	{0xB5B5ADA8AAFF80B8ull, -502}, {0x87625F056C7C4A8Bull, -475}, {0xC9BCFF6034C13053ull, -449},
+	{0x964E858C91BA2655ull, -422}, {0xDFF9772470297EBDull, -396}, {0xA6DFBD9FB8E5B88Full, -369},
+	{0xF8A95FCF88747D94ull, -343}, {0xB94470938FA89BCFull, -316}, {0x8A08F0F8BF0F156Bull, -289},
+	{0xCDB02555653131B6ull, -263}, {0x993FE2C6D07B7FACull, -236}, {0xE45C10C42A2B3B06ull, -210},
+	{0xAA242499697392D3ull, -183}, {0xFD87B5F28300CA0Eull, -157}, {0xBCE5086492111AEBull, -130},
+	{0x8CBCCC096F5088CCull, -103}, {0xD1B71758E219652Cull, -77}, {0x9C40000000000000ull, -50},
+	{0xE8D4A51000000000ull, -24}, {0xAD78EBC5AC620000ull, 3}, {0x813F3978F8940984ull, 30},
+	{0xC097CE7BC90715B3ull, 56}, {0x8F7E32CE7BEA5C70ull, 83}, {0xD5D238A4ABE98068ull, 109},
+	{0x9F4F2726179A2245ull, 136}, {0xED63A231D4C4FB27ull, 162}, {0xB0DE65388CC8ADA8ull, 189},
+	{0x83C7088E1AAB65DBull, 216}, {0xC45D1DF942711D9Aull, 242}, {0x924D692CA61BE758ull, 269},
+	{0xDA01EE641A708DEAull, 295}, {0xA26DA3999AEF774Aull, 322}, {0xF209787BB47D6B85ull, 348},
+	{0xB454E4A179DD1877ull, 375}, {0x865B86925B9BC5C2ull, 402}, {0xC83553C5C8965D3Dull, 428},
+	{0x952AB45CFA97A0B3ull, 455}, {0xDE469FBD99A05FE3ull, 481}, {0xA59BC234DB398C25ull, 508},
+	{0xF6C69A72A3989F5Cull, 534}, {0xB7DCBF5354E9BECEull, 561}, {0x88FCF317F22241E2ull, 588},
+	{0xCC20CE9BD35C78A5ull, 614}, {0x98165AF37B2153DFull, 641}, {0xE2A0B5DC971F303Aull, 667},
+	{0xA8D9D1535CE3B396ull, 694}, {0xFB9B7CD9A4A7443Cull, 720}, {0xBB764C4CA7A44410ull, 747},
+	{0x8BAB8EEFB6409C1Aull, 774}, {0xD01FEF10A657842Cull, 800}, {0x9B10A4E5E9913129ull, 827},
+	{0xE7109BFBA19C0C9Dull, 853}, {0xAC2820D9623BF429ull, 880}, {0x80444B5E7AA7CF85ull, 907},
+	{0xBF21E44003ACDD2Dull, 933}, {0x8E679C2F5E44FF8Full, 960}, {0xD433179D9C8CB841ull, 986},
+	{0x9E19DB92B4E31BA9ull, 1013}, {0xEB96BF6EBADF77D9ull, 1039}, {0xAF87023B9BF0EE6Bull, 1066},
+};
+
+static DiyFP DiyFP_Mult(DiyFP x, DiyFP y) {
+	// The top 64 bits of the 128 bit product, rounded.
+	const u64 mask = 0xFFFFFFFF;
+
+	u64 a = x.F >> 32, b = x.F & mask;
+	u64 c = y.F >> 32, d = y.F & mask;
+
+	u64 ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	u64 mid = (bd >> 32) + (ad & mask) + (bc & mask) + (1u << 31);
+
+	return (DiyFP){ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.E + y.E + 64};
+}
+
+static DiyFP DiyFP_Normalize(DiyFP x) {
+	while(!(x.F & ((u64) 1 << 63))) {
+		x.F <<= 1;
+		x.E--;
+	}
+	return x;
+}
+
+static void Grisu_Round(char* buf, u32 len, u64 delta, u64 rest, u64 tenKappa, u64 distance) {
+	while(rest < distance && delta - rest >= tenKappa
+	      && (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance)) {
+		buf[len - 1]--;
+		rest += tenKappa;
+	}
+}
+
+// Generate digits of `w` until they're inside the range [high - delta, high].
+static u32 Grisu_DigitGen(DiyFP w, DiyFP high, u64 delta, char* buf, i32* K) {
+	static const u64 pow10[20] = {
+		1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+		1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+		100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+		1000000000000000000ull, 10000000000000000000ull,
+	};
+
+	DiyFP one    = {(u64) 1 << -high.E, high.E};
+	u64 distance = high.F - w.F;
+
+	// Integer and fractional parts.
+	u32 p1 = high.F >> -one.E;
+	u64 p2 = high.F & (one.F - 1);
+
+	i32 kappa = 1;
+	while(kappa < 10 && p1 >= pow10[kappa]) kappa++;
+
+	u32 len = 0;
+	while(kappa > 0) {
+		u32 d = p1 / pow10[kappa - 1];
+		p1 %= pow10[kappa - 1];
+
+		if(d || len) buf[len++] = '0' + d;
+		kappa--;
+
+		u64 rest = ((u64) p1 << -one.E) + p2;
+		if(rest <= delta) {
+			*K += kappa;
+			Grisu_Round(buf, len, delta, rest, pow10[kappa] << -one.E, distance);
+			return len;
+		}
+	}
+
+	while(1) {
+		p2 *= 10;
+		delta *= 10;
+
+		char d = p2 >> -one.E;
+		if(d || len) buf[len++] = '0' + d;
+
+		p2 &= one.F - 1;
+		kappa--;
+
+		if(p2 < delta) {
+			*K += kappa;
+			Grisu_Round(buf, len, delta, p2, one.F, distance * (-kappa < 20 ? pow10[-kappa] : 0));
+			return len;
+		}
+	}
+}
+
+// Digits of the number f * 2^e, where anything between the boundaries rounds back to it.
+// The number is digits * 10^K.
+static u32 Grisu2(u64 f, i32 e, bool8 lowerCloser, char* buf, i32* K) {
+	// The boundaries, halfway to the next number either way.
+	DiyFP high = DiyFP_Normalize((DiyFP){(f << 1) + 1, e - 1});
+	DiyFP low  = (lowerCloser ? (DiyFP){(f << 2) - 1, e - 2} : (DiyFP){(f << 1) - 1, e - 1});
+	low.F <<= low.E - high.E;
+	low.E = high.E;
+
+	// Scale everything by a power of 10, so the exponent ends up in [-60, -32].
+	r64 dk = (-61 - high.E) * 0.30102999566398114 + 347;
+	i32 k  = (i32) dk;
+	if(dk - k > 0.0) k++;
+
+	u32 index = (k >> 3) + 1;
+	*K        = -(-348 + (i32) (index << 3));
+
+	DiyFP c = Grisu_CachedPowers[index];
+	DiyFP w = DiyFP_Mult(DiyFP_Normalize((DiyFP){f, e}), c);
+	high    = DiyFP_Mult(high, c);
+	low     = DiyFP_Mult(low, c);
+
+	// Stay clear of the boundaries, the multiplications aren't exact.
+	low.F++;
+	high.F--;
+
+	return Grisu_DigitGen(w, high, high.F - low.F, buf, K);
+}
+
+// Turn digits * 10^k into regular notation, returns the new length.
+static u32 Grisu_Format(char* buf, u32 len, i32 k) {
+	i32 kk = len + k; // 10^(kk - 1) <= number < 10^kk
+
+	if(k >= 0 && kk <= 21) {
+		// 1234e7 -> 12340000000
+		for(i32 i = len; i < kk; i++) buf[i] = '0';
+		return kk;
+	}
+
+	if(kk > 0 && kk <= 21) {
+		// 1234e-2 -> 12.34
+		memmove(buf + kk + 1, buf + kk, len - kk);
+		buf[kk] = '.';
+		return len + 1;
+	}
+
+	if(kk > -6 && kk <= 0) {
+		// 1234e-6 -> 0.001234
+		u32 offset = 2 - kk;
+		memmove(buf + offset, buf, len);
+		buf[0] = '0';
+		buf[1] = '.';
+		for(u32 i = 2; i < offset; i++) buf[i] = '0';
+		return len + offset;
+	}
+
+	// 1234e30 -> 1.234e33
+	u32 pos = 1;
+	if(len > 1) {
+		memmove(buf + 2, buf + 1, len - 1);
+		buf[1] = '.';
+		pos    = len + 1;
+	}
+
+	i32 exp    = kk - 1;
+	buf[pos++] = 'e';
+	if(exp < 0) {
+		buf[pos++] = '-';
+		exp        = -exp;
+	}
+
+	if(exp >= 100) buf[pos++] = '0' + exp / 100;
+	if(exp >= 10) buf[pos++] = '0' + exp / 10 % 10;
+	buf[pos++] = '0' + exp % 10;
+	return pos;
+}
+
+void JSON_Writer_Number(JSON_Writer* w, r64 n) {
+	// JSON doesn't have infinities or NaNs.
+	if(isnan(n) || isinf(n)) {
+		JSON_Writer_Null(w);
+		return;
+	}
+
+	// Whole numbers that a double holds exactly.
+	if(fabs(n) < 9007199254740992.0 && n == (r64)(i64) n) {
+		JSON_Writer_Integer(w, (i64) n);
+		return;
+	}
+
+	JSON_Writer_Separate(w);
+
+	u64 bits;
+	memcpy(&bits, &n, sizeof(bits));
+
+	u32 exp  = (bits >> 52) & 0x7FF;
+	u64 frac = bits & (((u64) 1 << 52) - 1);
+
+	char* c = JSON_Writer_Reserve(w, 32);
+	if(bits >> 63) *c++ = '-';
+
+	i32 k;
+	u32 len;
+	if(exp)
+		len = Grisu2(frac | ((u64) 1 << 52), exp - 1075, frac == 0 && exp > 1, c, &k);
+	else
+		len = Grisu2(frac, -1074, 0, c, &k);
+
+	c += Grisu_Format(c, len, k);
+	w->Size = c - w->Data;
+}
+
+void JSON_Writer_Float(JSON_Writer* w, r32 n) {
+	if(isnan(n) || isinf(n)) {
+		JSON_Writer_Null(w);
+		return;
+	}
+
+	if(fabsf(n) < 16777216.0f && n == (r32)(i32) n) {
+		JSON_Writer_Integer(w, (i32) n);
+		return;
+	}
+
+	JSON_Writer_Separate(w);
+
+	u32 bits;
+	memcpy(&bits, &n, sizeof(bits));
+
+	u32 exp  = (bits >> 23) & 0xFF;
+	u32 frac = bits & ((1 << 23) - 1);
+
+	char* c = JSON_Writer_Reserve(w, 32);
+	if(bits >> 31) *c++ = '-';
+
+	// Same thing as doubles, just with the float's own boundaries.
+	i32 k;
+	u32 len;
+	if(exp)
+		len = Grisu2(frac | (1 << 23), (i32) exp - 150, frac == 0 && exp > 1, c, &k);
+	else
+		len = Grisu2(frac, -149, 0, c, &k);
+
+	c += Grisu_Format(c, len, k);
+	w->Size = c - w->Data;
+}
+
+void JSON_Writer_Boolean(JSON_Writer* w, bool8 b) {
+	JSON_Writer_Separate(w);
+	JSON_Writer_Append(w, (b ? "true" : "false"), (b ? 4 : 5));
+}
+
+void JSON_Writer_Null(JSON_Writer* w) {
+	JSON_Writer_Separate(w);
+	JSON_Writer_Append(w, "null", 4);
+}
+
+void JSON_Writer_Value(JSON_Writer* w, const JSON_Value* v) {
+	switch(v->Type) {
+		case JSON_Object:
+			JSON_Writer_BeginObject(w);
+			for(u32 i = 0; i < v->Object.Size; i++) {
+				const JSON_Member* m = &v->Object.Members[i];
+				JSON_Writer_Key_N(w, m->Key, m->KeyLength);
+				JSON_Writer_Value(w, &m->Value);
+			}
+			JSON_Writer_EndObject(w);
 			break;
 
-		default:
+		case JSON_Array:
+			JSON_Writer_BeginArray(w);
+			for(u32 i = 0; i < v->Array.Size; i++) JSON_Writer_Value(w, &v->Array.Data[i]);
+			JSON_Writer_EndArray(w);
 			break;
+
+		case JSON_String: JSON_Writer_String_N(w, v->String, v->StringLength); break;
+		case JSON_Number: JSON_Writer_Number(w, v->Number); break;
+		case JSON_Boolean: JSON_Writer_Boolean(w, v->Boolean); break;
+
+		case JSON_Null:
+		case JSON_Error: JSON_Writer_Null(w); break;
 	}
 }
 
-JSON_Value* JSON_ObjectFind(const JSON_Value* v, const char* str) {
-	if(!v || !str)
-		return NULL;
+bool8 JSON_Writer_Finish(JSON_Writer* w) {
+	JSON_Writer_Flush(w);
+	w->Data[w->Size] = '\0';
+
+	if(w->Depth) {
+		Log(ERROR, "[JSON] Writer: %d objects/arrays were left open.", w->Depth);
+		return 0;
+	}
+
+	return !w->Failed;
+}
+
+char* JSON_Writer_Detach(JSON_Writer* w, u32* outSize) {
+	char* res    = w->Data;
+	res[w->Size] = '\0';
+	if(outSize) *outSize = w->Size;
+
+	w->Data     = NULL;
+	w->Size     = 0;
+	w->Capacity = 0;
+	return res;
+}
+
+char* JSON_ToString(const JSON_Value* v, u32 indent, u32* outSize) {
+	JSON_Writer w;
+	JSON_Writer_Init(&w, indent);
+	JSON_Writer_Value(&w, v);
+	JSON_Writer_Finish(&w);
+	return JSON_Writer_Detach(&w, outSize);
+}
+
+bool8 JSON_ToFile(const JSON_Value* v, const char* filename, u32 indent) {
+	i32 fd = open(filename, JSON_FILE_FLAGS, JSON_FILE_MODE);
+	if(fd < 0) {
+		Log(ERROR, "[JSON] Couldn't open \"%s\" for writing.", filename);
+		return 0;
+	}
+
+	JSON_Writer w;
+	JSON_Writer_InitFD(&w, fd, indent);
+	JSON_Writer_Value(&w, v);
 
-	return HashMap_JSON_Value_Find(&v->Object.Map, (u8*) str, strlen(str));
+	bool8 ok = JSON_Writer_Finish(&w);
+	JSON_Writer_Free(&w);
+	close(fd);
+	return ok;
 }
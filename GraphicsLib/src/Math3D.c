@@ -826,30 +826,32 @@ Transform3D Mat4_Decompose(Mat4 mat) {
 
 	// Thank you,
 	// https://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/
-	float trace = mat[0] + mat[5] + mat[10];
+	float trace = copy[0] + copy[5] + copy[10];
 	if(trace > 0) {
 		float s = 0.5f / sqrtf(trace + 1.0f);
-		res.Rotation =
-		    V4((mat[9] - mat[6]) * s, (mat[2] - mat[8]) * s, (mat[4] - mat[1]) * s, 0.25f / s);
+		res.Rotation = V4((copy[9] - copy[6]) * s,
+		                  (copy[2] - copy[8]) * s,
+		                  (copy[4] - copy[1]) * s,
+		                  0.25f / s);
 	} else {
-		if(mat[0] > mat[5] && mat[0] > mat[10]) {
-			float s      = 2.0f * sqrtf(1.0f + mat[0] - mat[5] - mat[10]);
+		if(copy[0] > copy[5] && copy[0] > copy[10]) {
+			float s      = 2.0f * sqrtf(1.0f + copy[0] - copy[5] - copy[10]);
 			res.Rotation = V4(0.25f * s,
-			                  (mat[1] + mat[4]) / s,
-			                  (mat[2] + mat[8]) / s,
-			                  (mat[9] - mat[6]) / s);
-		} else if(mat[5] > mat[10]) {
-			float s      = 2.0f * sqrtf(1.0f + mat[5] - mat[0] - mat[10]);
-			res.Rotation = V4((mat[1] + mat[4]) / s,
+			                  (copy[1] + copy[4]) / s,
+			                  (copy[2] + copy[8]) / s,
+			                  (copy[9] - copy[6]) / s);
+		} else if(copy[5] > copy[10]) {
+			float s      = 2.0f * sqrtf(1.0f + copy[5] - copy[0] - copy[10]);
+			res.Rotation = V4((copy[1] + copy[4]) / s,
 			                  0.25f * s,
-			                  (mat[6] + mat[9]) / s,
-			                  (mat[2] - mat[8]) / s);
+			                  (copy[6] + copy[9]) / s,
+			                  (copy[2] - copy[8]) / s);
 		} else {
-			float s      = 2.0f * sqrtf(1.0f + mat[10] - mat[0] - mat[5]);
-			res.Rotation = V4((mat[2] + mat[8]) / s,
-			                  (mat[6] + mat[9]) / s,
+			float s      = 2.0f * sqrtf(1.0f + copy[10] - copy[0] - copy[5]);
+			res.Rotation = V4((copy[2] + copy[8]) / s,
+			                  (copy[6] + copy[9]) / s,
 			                  0.25f * s,
-			                  (mat[4] - mat[1]) / s);
+			                  (copy[4] - copy[1]) / s);
 		}
 	}
 
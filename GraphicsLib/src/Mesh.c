@@ -0,0 +1,711 @@
+#include "../Mesh.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../Common.h"
+
+#define VTX_POS(i)  (*(const Vec3*) ((const u8*) positions + (i) * stride))
+#define VTX_NORM(i) (*(const Vec3*) ((const u8*) normals + (i) * stride))
+#define VTX_UV(i)   (*(const Vec2*) ((const u8*) uvs + (i) * stride))
+
+//
+// Quadrics
+//
+
+// Symmetric 4x4 matrix (upper triangle) plus the total area that went into it.
+typedef struct Quadric Quadric;
+struct Quadric {
+	r64 a2, ab, ac, ad;
+	r64     b2, bc, bd;
+	r64         c2, cd;
+	r64             d2;
+	r64 Weight;
+};
+
+static void Quadric_FromTriangle(Quadric* q, Vec3 p0, Vec3 p1, Vec3 p2) {
+	Vec3 n   = Vec3_Cross(Vec3_Sub(p1, p0), Vec3_Sub(p2, p0));
+	r64 len  = Vec3_Len(n);
+	r64 area = len * 0.5;
+
+	memset(q, 0, sizeof(Quadric));
+	if(len <= 0) return;
+
+	r64 a = n.x / len, b = n.y / len, c = n.z / len;
+	r64 d = -(a * p0.x + b * p0.y + c * p0.z);
+
+	q->a2 = a * a * area, q->ab = a * b * area, q->ac = a * c * area, q->ad = a * d * area;
+	q->b2 = b * b * area, q->bc = b * c * area, q->bd = b * d * area;
+	q->c2 = c * c * area, q->cd = c * d * area;
+	q->d2 = d * d * area;
+
+	q->Weight = area;
+}
+
+static void Quadric_Add(Quadric* q, const Quadric* o) {
+	q->a2 += o->a2, q->ab += o->ab, q->ac += o->ac, q->ad += o->ad;
+	q->b2 += o->b2, q->bc += o->bc, q->bd += o->bd;
+	q->c2 += o->c2, q->cd += o->cd;
+	q->d2 += o->d2;
+
+	q->Weight += o->Weight;
+}
+
+// Area-weighted mean squared distance from `p` to the planes in the quadric.
+static r64 Quadric_Error(const Quadric* q, Vec3 p) {
+	r64 x = p.x, y = p.y, z = p.z;
+
+	r64 e = q->a2 * x * x + 2 * q->ab * x * y + 2 * q->ac * x * z + 2 * q->ad * x
+	      + q->b2 * y * y + 2 * q->bc * y * z + 2 * q->bd * y
+	      + q->c2 * z * z + 2 * q->cd * z
+	      + q->d2;
+
+	return q->Weight > 0 ? fabs(e) / q->Weight : 0;
+}
+
+//
+// Simplification
+//
+
+typedef struct Collapse Collapse;
+struct Collapse {
+	u32 From;   // Welded vertex that goes away
+	u32 To;     // Welded vertex it's merged into
+	u32 ToVert; // Actual vertex that replaces From in triangles
+	r32 Cost;
+};
+
+static i32 Collapse_Compare(const void* a, const void* b) {
+	r32 ca = ((const Collapse*) a)->Cost;
+	r32 cb = ((const Collapse*) b)->Cost;
+	return (ca > cb) - (ca < cb);
+}
+
+static u32 HashPosition(Vec3 p) {
+	u32 h[3];
+	memcpy(h, &p, sizeof(h));
+	return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+}
+
+// Map every vertex to the first vertex with the exact same position.
+static void WeldPositions(u32* weld,
+                          const Vec3* positions,
+                          u32 numVertices,
+                          u32 stride) {
+	u32 tableSize = 1;
+	while(tableSize < numVertices * 2) tableSize *= 2;
+
+	u32* table = Allocate(sizeof(u32) * tableSize);
+	memset(table, 0xFF, sizeof(u32) * tableSize);
+
+	for(u32 i = 0; i < numVertices; i++) {
+		Vec3 p = VTX_POS(i);
+		u32 h  = HashPosition(p) & (tableSize - 1);
+
+		while(table[h] != ~0u && memcmp(&VTX_POS(table[h]), &p, sizeof(Vec3)) != 0)
+			h = (h + 1) & (tableSize - 1);
+
+		if(table[h] == ~0u) table[h] = i;
+		weld[i] = table[h];
+	}
+
+	Free(table);
+}
+
+// Follow the chain of collapses until we reach a vertex that's still alive.
+static u32 ResolveVertex(u32 v, const u32* weld, const u32* collapsedTo) {
+	while(collapsedTo[weld[v]] != ~0u) v = collapsedTo[weld[v]];
+	return v;
+}
+
+// Would moving `from` onto `to` flip (or flatten) any of the triangles around it?
+static bool8 CollapseFlips(u32 from,
+                           Vec3 to,
+                           u32 toWeld,
+                           const u32* tris,
+                           const u32* adjOffsets,
+                           const u32* adjTris,
+                           const u32* weld,
+                           const Vec3* positions,
+                           u32 stride) {
+	for(u32 i = adjOffsets[from]; i < adjOffsets[from + 1]; i++) {
+		const u32* t = tris + adjTris[i] * 3;
+		u32 w[3]     = {weld[t[0]], weld[t[1]], weld[t[2]]};
+
+		// These triangles disappear with the collapse.
+		if(w[0] == toWeld || w[1] == toWeld || w[2] == toWeld) continue;
+
+		Vec3 p[3] = {VTX_POS(t[0]), VTX_POS(t[1]), VTX_POS(t[2])};
+		Vec3 before = Triangle_GetNormal(p[0], p[1], p[2]);
+
+		for(u32 k = 0; k < 3; k++)
+			if(w[k] == from) p[k] = to;
+
+		Vec3 after = Vec3_Cross(Vec3_Sub(p[1], p[0]), Vec3_Sub(p[2], p[0]));
+		r32 len    = Vec3_Len(after);
+
+		if(len <= FLT_EPSILON || Vec3_Dot(before, after) < 0.25f * len) return 1;
+	}
+
+	return 0;
+}
+
+u32 Mesh_Simplify(u32* outIndices,
+                  const u32* indices,
+                  u32 numIndices,
+                  const Vec3* positions,
+                  const Vec3* normals,
+                  const Vec2* uvs,
+                  u32 numVertices,
+                  u32 stride,
+                  u32 targetIndices,
+                  r32 maxError,
+                  r32* outError) {
+	r64 resultError = 0;
+	memcpy(outIndices, indices, sizeof(u32) * numIndices);
+
+	if(numIndices <= targetIndices || !numVertices) {
+		if(outError) *outError = 0;
+		return numIndices;
+	}
+
+	u32* weld        = Allocate(sizeof(u32) * numVertices);
+	u32* collapsedTo = Allocate(sizeof(u32) * numVertices);
+	bool8* locked    = Allocate(sizeof(bool8) * numVertices);
+	bool8* touched   = Allocate(sizeof(bool8) * numVertices);
+	Quadric* quadrics = Allocate(sizeof(Quadric) * numVertices);
+
+	WeldPositions(weld, positions, numVertices, stride);
+	memset(collapsedTo, 0xFF, sizeof(u32) * numVertices);
+	memset(locked, 0, sizeof(bool8) * numVertices);
+	memset(quadrics, 0, sizeof(Quadric) * numVertices);
+
+	// Lock seams: welded vertices whose copies disagree on normals or UVs.
+	for(u32 i = 0; i < numVertices; i++) {
+		u32 w = weld[i];
+		if(w == i) continue;
+
+		if((normals && memcmp(&VTX_NORM(i), &VTX_NORM(w), sizeof(Vec3)) != 0) ||
+		   (uvs && memcmp(&VTX_UV(i), &VTX_UV(w), sizeof(Vec2)) != 0))
+			locked[w] = 1;
+	}
+
+	for(u32 i = 0; i < numIndices; i += 3) {
+		Quadric q;
+		Quadric_FromTriangle(&q,
+		                     VTX_POS(indices[i]),
+		                     VTX_POS(indices[i + 1]),
+		                     VTX_POS(indices[i + 2]));
+
+		for(u32 k = 0; k < 3; k++) Quadric_Add(&quadrics[weld[indices[i + k]]], &q);
+	}
+
+	u32 numTris          = numIndices / 3;
+	u32* adjOffsets      = Allocate(sizeof(u32) * (numVertices + 1));
+	u32* adjTris         = Allocate(sizeof(u32) * numIndices);
+	Collapse* candidates = Allocate(sizeof(Collapse) * numIndices * 2);
+	r64 maxErrorSq       = (r64) maxError * maxError;
+
+	while(numTris * 3 > targetIndices) {
+		// Vertex -> triangle adjacency, in terms of welded vertices.
+		memset(adjOffsets, 0, sizeof(u32) * (numVertices + 1));
+		for(u32 i = 0; i < numTris * 3; i++) adjOffsets[weld[outIndices[i]] + 1]++;
+		for(u32 i = 0; i < numVertices; i++) adjOffsets[i + 1] += adjOffsets[i];
+		for(u32 i = 0; i < numTris * 3; i++) adjTris[adjOffsets[weld[outIndices[i]]]++] = i / 3;
+		for(u32 i = numVertices; i > 0; i--) adjOffsets[i] = adjOffsets[i - 1];
+		adjOffsets[0] = 0;
+
+		// Every edge can be collapsed in both directions.
+		u32 numCandidates = 0;
+		for(u32 i = 0; i < numTris * 3; i++) {
+			u32 a = outIndices[i];
+			u32 b = outIndices[(i % 3 == 2) ? i - 2 : i + 1];
+
+			u32 wa = weld[a], wb = weld[b];
+			if(wa == wb) continue;
+
+			for(u32 dir = 0; dir < 2; dir++) {
+				u32 from = dir ? wb : wa;
+				u32 to   = dir ? wa : wb;
+				u32 vert = dir ? a : b;
+
+				if(locked[from]) continue;
+
+				Quadric q = quadrics[from];
+				Quadric_Add(&q, &quadrics[to]);
+
+				candidates[numCandidates++] = (Collapse){
+				    .From   = from,
+				    .To     = to,
+				    .ToVert = vert,
+				    .Cost   = Quadric_Error(&q, VTX_POS(to)),
+				};
+			}
+		}
+
+		if(!numCandidates) break;
+
+		qsort(candidates, numCandidates, sizeof(Collapse), Collapse_Compare);
+		memset(touched, 0, sizeof(bool8) * numVertices);
+
+		u32 remaining = numTris;
+		u32 collapses = 0;
+
+		for(u32 i = 0; i < numCandidates && remaining * 3 > targetIndices; i++) {
+			Collapse c = candidates[i];
+
+			if(c.Cost > maxErrorSq) break;
+			if(touched[c.From] || touched[c.To]) continue;
+			if(CollapseFlips(c.From, VTX_POS(c.To), c.To, outIndices, adjOffsets, adjTris,
+			                 weld, positions, stride))
+				continue;
+
+			collapsedTo[c.From] = c.ToVert;
+			Quadric_Add(&quadrics[c.To], &quadrics[c.From]);
+			resultError = MAX(resultError, c.Cost);
+			collapses++;
+
+			// Nothing around this collapse can be touched until the next pass,
+			// since the adjacency and flip checks are now out of date.
+			for(u32 j = adjOffsets[c.From]; j < adjOffsets[c.From + 1]; j++) {
+				const u32* t = outIndices + adjTris[j] * 3;
+				u32 w[3]     = {weld[t[0]], weld[t[1]], weld[t[2]]};
+
+				touched[w[0]] = touched[w[1]] = touched[w[2]] = 1;
+				if(w[0] == c.To || w[1] == c.To || w[2] == c.To) remaining--;
+			}
+		}
+
+		if(!collapses) break;
+
+		// Apply the collapses and drop the triangles that became degenerate.
+		u32 newTris = 0;
+		for(u32 i = 0; i < numTris; i++) {
+			u32 t[3];
+			for(u32 k = 0; k < 3; k++)
+				t[k] = ResolveVertex(outIndices[i * 3 + k], weld, collapsedTo);
+
+			if(!TRINEQ(weld[t[0]], weld[t[1]], weld[t[2]])) continue;
+
+			memcpy(outIndices + newTris * 3, t, sizeof(t));
+			newTris++;
+		}
+		numTris = newTris;
+	}
+
+	Free(weld);
+	Free(collapsedTo);
+	Free(locked);
+	Free(touched);
+	Free(quadrics);
+	Free(adjOffsets);
+	Free(adjTris);
+	Free(candidates);
+
+	if(outError) *outError = sqrt(resultError);
+	return numTris * 3;
+}
+
+//
+// Levels of detail
+//
+
+void WObj_BuildLODs(WObj_Object* obj, u32 numLevels, r32 reduction) {
+	if(!obj || !obj->NumIndices) return;
+
+	WObj_FreeLODs(obj);
+	numLevels = MIN(numLevels, WOBJ_MAX_LODS);
+
+	const u32* prevIndices = obj->Indices;
+	u32 prevCount          = obj->NumIndices;
+	r32 prevError          = 0;
+
+	u32* scratch = Allocate(sizeof(u32) * obj->NumIndices);
+
+	for(u32 i = 0; i < numLevels; i++) {
+		u32 target = (u32) (prevCount / 3 * reduction) * 3;
+		r32 error  = 0;
+
+		u32 count = Mesh_Simplify(scratch,
+		                          prevIndices,
+		                          prevCount,
+		                          &obj->Vertices[0].Position,
+		                          &obj->Vertices[0].Normal,
+		                          &obj->Vertices[0].UV,
+		                          obj->NumVertices,
+		                          sizeof(WObj_Vertex),
+		                          target,
+		                          FLT_MAX,
+		                          &error);
+
+		// Not worth keeping a level that's almost the same as the last one.
+		if(!count || count > prevCount * 0.95f) break;
+
+		WObj_LOD* lod   = &obj->LODs[obj->NumLODs++];
+		lod->NumIndices = count;
+		lod->Indices    = Allocate(sizeof(u32) * count);
+		lod->Error      = prevError + error;
+		memcpy(lod->Indices, scratch, sizeof(u32) * count);
+
+		Log(INFO, "[Mesh] \"%s\" LOD %d: %d -> %d triangles, error %.4f.",
+		    obj->Name, obj->NumLODs, prevCount / 3, count / 3, lod->Error);
+
+		prevIndices = lod->Indices;
+		prevCount   = count;
+		prevError   = lod->Error;
+	}
+
+	Free(scratch);
+}
+
+void WObj_FreeLODs(WObj_Object* obj) {
+	for(u32 i = 0; i < obj->NumLODs; i++) {
+		Free(obj->LODs[i].Indices);
+		obj->LODs[i] = (WObj_LOD){0};
+	}
+	obj->NumLODs = 0;
+}
+
+r32 Mesh_ScreenSpaceError(r32 error, Camera cam, Vec3 position, r32 screenHeight) {
+	if(cam.Mode == CameraMode_Orthographic) {
+		// The orthographic projection maps one unit to one pixel.
+		return error * screenHeight / MAX(cam.ScreenHeight, 1);
+	}
+
+	r32 dist = MAX(Vec3_Len(Vec3_Sub(position, cam.Position)), cam.ZNear);
+	return error * screenHeight / (2 * dist * tanf(cam.VerticalFoV / 2));
+}
+
+u32 Mesh_SelectLOD(const r32* errors,
+                   u32 numLevels,
+                   Camera cam,
+                   Transform3D transform,
+                   r32 screenHeight,
+                   r32 maxPixelError) {
+	r32 scale = MAX3(fabsf(transform.Scale.x), fabsf(transform.Scale.y), fabsf(transform.Scale.z));
+
+	// Errors only grow with each level, so stop at the first one that's too big.
+	u32 lod = 0;
+	for(u32 i = 1; i < numLevels; i++) {
+		r32 px = Mesh_ScreenSpaceError(errors[i] * scale, cam, transform.Position, screenHeight);
+		if(px > maxPixelError) break;
+		lod = i;
+	}
+
+	return lod;
+}
+
+//
+// Meshlets
+//
+
+// Bounding sphere and normal cone of a finished meshlet.
+// Thank you, https://github.com/zeux/meshoptimizer/blob/master/src/clusterizer.cpp
+static void Meshlet_ComputeBounds(Meshlet* m,
+                                  const u32* vertices,
+                                  const u8* triangles,
+                                  const Vec3* positions,
+                                  u32 stride) {
+	Vec3 min = VTX_POS(vertices[0]), max = min;
+	for(u32 i = 1; i < m->NumVertices; i++) {
+		Vec3 p = VTX_POS(vertices[i]);
+		min    = V3(MIN(min.x, p.x), MIN(min.y, p.y), MIN(min.z, p.z));
+		max    = V3(MAX(max.x, p.x), MAX(max.y, p.y), MAX(max.z, p.z));
+	}
+
+	m->Center = Vec3_Center(min, max);
+	m->Radius = 0;
+	for(u32 i = 0; i < m->NumVertices; i++)
+		m->Radius = MAX(m->Radius, Vec3_Len(Vec3_Sub(VTX_POS(vertices[i]), m->Center)));
+
+	// Average the face normals to get the cone's axis...
+	Vec3 normals[MESHLET_MAX_TRIANGLES];
+	Vec3 axis = {0};
+	u32 numNormals = 0;
+
+	for(u32 t = 0; t < m->NumTriangles; t++) {
+		const u8* tri = triangles + t * 3;
+		Vec3 p0 = VTX_POS(vertices[tri[0]]);
+		Vec3 p1 = VTX_POS(vertices[tri[1]]);
+		Vec3 p2 = VTX_POS(vertices[tri[2]]);
+
+		Vec3 n  = Vec3_Cross(Vec3_Sub(p1, p0), Vec3_Sub(p2, p0));
+		r32 len = Vec3_Len(n);
+		if(len == 0) continue;
+
+		normals[numNormals++] = Vec3_DivScal(n, len);
+		axis = Vec3_Add(axis, Vec3_DivScal(n, len));
+	}
+
+	m->ConeApex   = m->Center;
+	m->ConeAxis   = V3(0, 0, 1);
+	m->ConeCutoff = 1;
+
+	r32 axisLen = Vec3_Len(axis);
+	if(!numNormals || axisLen == 0) return;
+	axis = Vec3_DivScal(axis, axisLen);
+
+	// ... then see how far off the worst normal is.
+	r32 minDot = 1;
+	for(u32 i = 0; i < numNormals; i++)
+		minDot = MIN(minDot, Vec3_Dot(normals[i], axis));
+
+	// Normals spread over (nearly) a hemisphere, this can't ever be backfacing.
+	if(minDot <= 0.1f) return;
+
+	// Move the apex back so that every triangle's plane is in front of it.
+	r32 maxT = 0;
+	for(u32 t = 0, n = 0; t < m->NumTriangles; t++) {
+		const u8* tri = triangles + t * 3;
+		Vec3 p0 = VTX_POS(vertices[tri[0]]);
+		Vec3 p1 = VTX_POS(vertices[tri[1]]);
+		Vec3 p2 = VTX_POS(vertices[tri[2]]);
+
+		if(Vec3_Len2(Vec3_Cross(Vec3_Sub(p1, p0), Vec3_Sub(p2, p0))) == 0) continue;
+
+		Vec3 normal = normals[n++];
+		r32 dc      = Vec3_Dot(Vec3_Sub(m->Center, p0), normal);
+		r32 dn      = Vec3_Dot(axis, normal);
+		maxT        = MAX(maxT, dc / dn);
+	}
+
+	m->ConeApex   = Vec3_Sub(m->Center, Vec3_MultScal(axis, maxT));
+	m->ConeAxis   = axis;
+	m->ConeCutoff = sqrtf(1 - minDot * minDot);
+}
+
+Mesh_Meshlets Mesh_BuildMeshlets(const u32* indices,
+                                 u32 numIndices,
+                                 const Vec3* positions,
+                                 u32 numVertices,
+                                 u32 stride) {
+	if(!stride) stride = sizeof(Vec3);
+
+	u32 numTris = numIndices / 3;
+
+	// Worst case: every triangle brings 3 new vertices.
+	u32 maxMeshlets = (numTris + MESHLET_MAX_TRIANGLES - 1) / MESHLET_MAX_TRIANGLES
+	                + (numTris * 3 + MESHLET_MAX_VERTICES - 1) / MESHLET_MAX_VERTICES;
+
+	Mesh_Meshlets res = {0};
+	res.Meshlets  = Allocate(sizeof(Meshlet) * MAX(maxMeshlets, 1));
+	res.Vertices  = Allocate(sizeof(u32) * MAX(numIndices, 1));
+	res.Triangles = Allocate(MAX(numIndices, 1));
+
+	// Vertex -> triangle adjacency, as offsets into one array.
+	u32* adjOffsets = Allocate(sizeof(u32) * (numVertices + 1));
+	u32* adjTris    = Allocate(sizeof(u32) * MAX(numIndices, 1));
+	memset(adjOffsets, 0, sizeof(u32) * (numVertices + 1));
+
+	for(u32 i = 0; i < numIndices; i++) adjOffsets[indices[i] + 1]++;
+	for(u32 v = 0; v < numVertices; v++) adjOffsets[v + 1] += adjOffsets[v];
+
+	u32* fill = Allocate(sizeof(u32) * MAX(numVertices, 1));
+	memcpy(fill, adjOffsets, sizeof(u32) * numVertices);
+	for(u32 i = 0; i < numIndices; i++) adjTris[fill[indices[i]]++] = i / 3;
+	Free(fill);
+
+	// Where each vertex sits inside the meshlet being built, 0xFF if it's not in it.
+	u8* local = Allocate(MAX(numVertices, 1));
+	memset(local, 0xFF, numVertices);
+
+	bool8* used = Allocate(MAX(numTris, 1));
+	memset(used, 0, numTris);
+
+	Meshlet* cur   = &res.Meshlets[0];
+	*cur           = (Meshlet){0};
+	u32 nextSeed   = 0;
+	u32 numEmitted = 0;
+
+	while(numEmitted < numTris) {
+		// Find the neighbouring triangle that needs the fewest new vertices.
+		u32 best = UINT32_MAX, bestNew = 4;
+		for(u32 i = 0; i < cur->NumVertices && bestNew; i++) {
+			u32 v = res.Vertices[cur->VertexOffset + i];
+
+			for(u32 a = adjOffsets[v]; a < adjOffsets[v + 1]; a++) {
+				u32 t = adjTris[a];
+				if(used[t]) continue;
+
+				u32 extra = (local[indices[t * 3 + 0]] == 0xFF) + (local[indices[t * 3 + 1]] == 0xFF)
+				          + (local[indices[t * 3 + 2]] == 0xFF);
+
+				if(extra < bestNew) {
+					best    = t;
+					bestNew = extra;
+					if(!extra) break;
+				}
+			}
+		}
+
+		bool8 full = cur->NumTriangles == MESHLET_MAX_TRIANGLES;
+
+		if(best == UINT32_MAX) {
+			// Ran out of neighbours. Start over somewhere else, but don't
+			// leave the meshlet mostly empty just because the mesh is split up.
+			while(used[nextSeed]) nextSeed++;
+			best    = nextSeed;
+			bestNew = 3;
+
+			if(cur->NumTriangles >= MESHLET_MAX_TRIANGLES / 2) full = true;
+		}
+
+		if(cur->NumVertices + bestNew > MESHLET_MAX_VERTICES) full = true;
+
+		if(full) {
+			Meshlet_ComputeBounds(cur,
+			                      res.Vertices + cur->VertexOffset,
+			                      res.Triangles + cur->TriangleOffset * 3,
+			                      positions,
+			                      stride);
+
+			for(u32 i = 0; i < cur->NumVertices; i++) local[res.Vertices[cur->VertexOffset + i]] = 0xFF;
+
+			res.NumMeshlets++;
+			cur  = &res.Meshlets[res.NumMeshlets];
+			*cur = (Meshlet){.VertexOffset = res.NumVertices, .TriangleOffset = res.NumTriangles};
+		}
+
+		u8* tri = res.Triangles + res.NumTriangles * 3;
+		for(u32 k = 0; k < 3; k++) {
+			u32 v = indices[best * 3 + k];
+			if(local[v] == 0xFF) {
+				local[v]                          = cur->NumVertices++;
+				res.Vertices[res.NumVertices++] = v;
+			}
+			tri[k] = local[v];
+		}
+
+		used[best] = true;
+		cur->NumTriangles++;
+		res.NumTriangles++;
+		numEmitted++;
+	}
+
+	if(cur->NumTriangles) {
+		Meshlet_ComputeBounds(cur,
+		                      res.Vertices + cur->VertexOffset,
+		                      res.Triangles + cur->TriangleOffset * 3,
+		                      positions,
+		                      stride);
+		res.NumMeshlets++;
+	}
+
+	Free(used);
+	Free(local);
+	Free(adjTris);
+	Free(adjOffsets);
+
+	// Give back what the worst case estimate didn't need.
+	res.Meshlets  = Reallocate(res.Meshlets, sizeof(Meshlet) * MAX(res.NumMeshlets, 1));
+	res.Vertices  = Reallocate(res.Vertices, sizeof(u32) * MAX(res.NumVertices, 1));
+	res.Triangles = Reallocate(res.Triangles, MAX(res.NumTriangles * 3, 1));
+
+	return res;
+}
+
+Mesh_Meshlets WObj_BuildMeshlets(const WObj_Object* obj) {
+	Mesh_Meshlets res = Mesh_BuildMeshlets(
+	    obj->Indices, obj->NumIndices, &obj->Vertices[0].Position, obj->NumVertices, sizeof(WObj_Vertex));
+
+	Log(INFO, "[Mesh] \"%s\": %d triangles in %d meshlets (%.1f vertices, %.1f triangles each).",
+	    obj->Name,
+	    res.NumTriangles,
+	    res.NumMeshlets,
+	    res.NumMeshlets ? (r32) res.NumVertices / res.NumMeshlets : 0.0f,
+	    res.NumMeshlets ? (r32) res.NumTriangles / res.NumMeshlets : 0.0f);
+
+	return res;
+}
+
+void Mesh_Meshlets_Free(Mesh_Meshlets* m) {
+	Free(m->Meshlets);
+	Free(m->Vertices);
+	Free(m->Triangles);
+	*m = (Mesh_Meshlets){0};
+}
+
+void Mesh_Meshlets_Unpack(const Mesh_Meshlets* m, u32* outIndices) {
+	for(u32 i = 0; i < m->NumMeshlets; i++) {
+		const Meshlet* ml = &m->Meshlets[i];
+		const u32* verts  = m->Vertices + ml->VertexOffset;
+		const u8* tris    = m->Triangles + ml->TriangleOffset * 3;
+
+		for(u32 j = 0; j < ml->NumTriangles * 3; j++)
+			outIndices[ml->TriangleOffset * 3 + j] = verts[tris[j]];
+	}
+}
+
+u32 Mesh_Meshlets_Cull(const Mesh_Meshlets* m,
+                       Camera cam,
+                       Transform3D transform,
+                       u32* outFirstIndex,
+                       u32* outCount) {
+	Mat4 mvp, view, model;
+	Camera_Mat4(cam, view, mvp);
+	Transform3D_Mat4(transform, model);
+	Mat4_MultMat(mvp, view);
+	Mat4_MultMat(mvp, model);
+
+	// Pull the frustum planes straight out of the MVP matrix, which puts them in model space.
+	// Thank you, https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+	Vec4 planes[6];
+	for(u32 i = 0; i < 3; i++) {
+		for(u32 s = 0; s < 2; s++) {
+			r32 sign = s ? -1 : 1;
+			Vec4 p   = V4(mvp[12] + sign * mvp[i * 4 + 0],
+                        mvp[13] + sign * mvp[i * 4 + 1],
+                        mvp[14] + sign * mvp[i * 4 + 2],
+                        mvp[15] + sign * mvp[i * 4 + 3]);
+
+			r32 len = Vec3_Len(V3(p.x, p.y, p.z));
+			if(len > 0) p = V4(p.x / len, p.y / len, p.z / len, p.w / len);
+			planes[i * 2 + s] = p;
+		}
+	}
+
+	// The camera in model space, for the cones.
+	// Orthographic cameras look along one direction instead of from one point.
+	Mat4 invRot;
+	Mat4_RotateQuat(invRot, Quat_Conjugate(transform.Rotation));
+
+	Vec3 camPos = Vec3_Sub(cam.Position, transform.Position);
+	Vec4 pos4   = Mat4_MultVec4(invRot, V4_V3(camPos, 1));
+	camPos      = Vec3_DivVec(V3(pos4.x, pos4.y, pos4.z), transform.Scale);
+
+	bool8 ortho  = cam.Mode == CameraMode_Orthographic;
+	Vec3 viewDir = Vec3_Sub(cam.Target, cam.Position);
+	Vec4 dir4    = Mat4_MultVec4(invRot, V4_V3(viewDir, 0));
+	viewDir      = Vec3_Norm(Vec3_DivVec(V3(dir4.x, dir4.y, dir4.z), transform.Scale));
+
+	u32 numRanges = 0;
+	for(u32 i = 0; i < m->NumMeshlets; i++) {
+		const Meshlet* ml = &m->Meshlets[i];
+
+		bool8 visible = true;
+		for(u32 p = 0; p < 6 && visible; p++) {
+			r32 d   = planes[p].x * ml->Center.x + planes[p].y * ml->Center.y + planes[p].z * ml->Center.z + planes[p].w;
+			visible = d >= -ml->Radius;
+		}
+		if(!visible) continue;
+
+		if(ml->ConeCutoff < 1) {
+			Vec3 dir = ortho ? viewDir : Vec3_Norm(Vec3_Sub(ml->ConeApex, camPos));
+			if(Vec3_Dot(dir, ml->ConeAxis) >= ml->ConeCutoff) continue;
+		}
+
+		u32 first = ml->TriangleOffset * 3, count = ml->NumTriangles * 3;
+		if(numRanges && outFirstIndex[numRanges - 1] + outCount[numRanges - 1] == first) {
+			outCount[numRanges - 1] += count;
+		} else {
+			outFirstIndex[numRanges] = first;
+			outCount[numRanges]      = count;
+			numRanges++;
+		}
+	}
+
+	return numRanges;
+}
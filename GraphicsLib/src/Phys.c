@@ -9,244 +9,661 @@
 
 static const r32 epsilon = 1e-8;
 
-/// Function for debugging.
-static bool8 GetSign_R32(r32 s) { return signbit(s); }
+// Corners of a triangle closer than this to the other one's plane count as on it.
+static const r32 planeEpsilon = 1e-7;
 
-/*
-static bool8
-Triangle_PointInside(const Vec3 tri[3], Vec3 point) {
-	Vec3 normal = Vec3_Cross(Vec3_Sub(tri[1], tri[0]), Vec3_Sub(tri[2], tri[0]));
-	r32 dist = Vec3_Dot(Vec3_Neg(normal), tri[0]);
+// Everything below is worked out from one corner and two edges of each triangle,
+// in the same order as the SIMD versions further down, so they always agree.
+static inline r32 TriTri_Dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
 
-	normal = Vec3_Norm(normal);
+static inline Vec3 TriTri_Cross(Vec3 a, Vec3 b)
+{
+	return V3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+// Distances to a plane come out multiplied by the length of its normal, so
+// `tolerance` is planeEpsilon times that too.
+static inline r32 TriTri_Snap(r32 d, r32 tolerance) { return (fabsf(d) < tolerance ? 0 : d); }
+
+// Thank you,
+// https://www.cs.cmu.edu/~quake/robust.html
+//
+// Sign of the 2D orientation of a, b and c, and never the wrong one. Usually the
+// determinant in doubles is far enough from 0 to be sure, otherwise it gets
+// summed up again exactly, as a list of doubles that don't overlap.
+static inline void TwoSum(r64 a, r64 b, r64* s, r64* e)
+{
+	*s = a + b;
+	r64 bv = *s - a;
+	*e = (a - (*s - bv)) + (b - bv);
+}
+
+static i32 Orient2D(Vec2 a, Vec2 b, Vec2 c)
+{
+	r64 acx = (r64) a.x - c.x, bcy = (r64) b.y - c.y;
+	r64 acy = (r64) a.y - c.y, bcx = (r64) b.x - c.x;
+
+	r64 l = acx * bcy, r = acy * bcx, det = l - r;
+	if(fabs(det) > 3.3306690738754716e-16 * (fabs(l) + fabs(r)))
+		return (det > 0) - (det < 0);
+
+	// Differences of floats, each split into a double and what it lost to rounding.
+	r64 x[2][2], y[2][2];
+	TwoSum(a.x, -(r64) c.x, &x[0][0], &x[0][1]);
+	TwoSum(b.y, -(r64) c.y, &y[0][0], &y[0][1]);
+	TwoSum(a.y, -(r64) c.y, &x[1][0], &x[1][1]);
+	TwoSum(b.x, -(r64) c.x, &y[1][0], &y[1][1]);
+
+	r64 terms[16];
+	u32 numTerms = 0;
+	for(u32 k = 0; k < 2; k++) {
+		for(u32 i = 0; i < 2; i++) {
+			for(u32 j = 0; j < 2; j++) {
+				r64 p = x[k][i] * y[k][j];
+				r64 e = fma(x[k][i], y[k][j], -p);
+
+				terms[numTerms++] = (k ? -p : p);
+				terms[numTerms++] = (k ? -e : e);
+			}
+		}
+	}
+
+	// Add every term into the expansion, its last non-zero part has the sign of the total.
+	r64 sum[16];
+	u32 size = 0;
+	for(u32 i = 0; i < numTerms; i++) {
+		r64 q = terms[i];
+		for(u32 j = 0; j < size; j++)
+			TwoSum(q, sum[j], &q, &sum[j]);
+		sum[size++] = q;
+	}
+
+	for(u32 i = size; i > 0; i--)
+		if(sum[i - 1] != 0)
+			return (sum[i - 1] > 0) - (sum[i - 1] < 0);
+	return 0;
+}
+
+static inline bool8 Segment_Contains(Vec2 a, Vec2 b, Vec2 p)
+{
+	return MIN(a.x, b.x) <= p.x && p.x <= MAX(a.x, b.x) && MIN(a.y, b.y) <= p.y && p.y <= MAX(a.y, b.y);
+}
+
+// Closed segments, touching counts.
+static bool8 Segments_Intersect(Vec2 a1, Vec2 a2, Vec2 b1, Vec2 b2)
+{
+	i32 o1 = Orient2D(a1, a2, b1), o2 = Orient2D(a1, a2, b2);
+	i32 o3 = Orient2D(b1, b2, a1), o4 = Orient2D(b1, b2, a2);
+
+	if(o1 * o2 < 0 && o3 * o4 < 0)
+		return 1;
+
+	return (!o1 && Segment_Contains(a1, a2, b1)) || (!o2 && Segment_Contains(a1, a2, b2))
+	    || (!o3 && Segment_Contains(b1, b2, a1)) || (!o4 && Segment_Contains(b1, b2, a2));
+}
+
+// Inside or on the edge. Flat triangles are left to the edge tests.
+static bool8 Triangle_Contains2D(const Vec2 t[3], Vec2 p)
+{
+	i32 o  = Orient2D(t[0], t[1], t[2]);
+	i32 o0 = Orient2D(t[0], t[1], p), o1 = Orient2D(t[1], t[2], p), o2 = Orient2D(t[2], t[0], p);
+	return o && o0 * o >= 0 && o1 * o >= 0 && o2 * o >= 0;
+}
+
+static inline Vec3 Triangle_LongestEdge(const Vec3 t[3])
+{
+	Vec3 e[3] = { Vec3_Sub(t[1], t[0]), Vec3_Sub(t[2], t[1]), Vec3_Sub(t[0], t[2]) };
+	u32 i = (Vec3_Len2(e[0]) >= Vec3_Len2(e[1]) ? 0 : 1);
+	return (Vec3_Len2(e[i]) >= Vec3_Len2(e[2]) ? e[i] : e[2]);
+}
+
+// Both triangles in one plane: drop the axis the plane faces the most and test in 2D.
+static Intersection TriTri_Coplanar(const Vec3 a[3], const Vec3 b[3], Vec3 normal)
+{
+	if(normal.x == 0 && normal.y == 0 && normal.z == 0) {
+		// Both triangles are flat, so they're line segments (or points). Find a plane with both in it.
+		Vec3 ea = Triangle_LongestEdge(a), eb = Triangle_LongestEdge(b), w = Vec3_Sub(b[0], a[0]);
+		Vec3 dir = (Vec3_Len2(ea) >= Vec3_Len2(eb) ? ea : eb);
+
+		normal = TriTri_Cross(ea, eb);
+		if(normal.x != 0 || normal.y != 0 || normal.z != 0) {
+			// Segments that aren't parallel and aren't in one plane never touch.
+			r64 vol = (r64) w.x * ((r64) ea.y * eb.z - (r64) ea.z * eb.y)
+			        + (r64) w.y * ((r64) ea.z * eb.x - (r64) ea.x * eb.z)
+			        + (r64) w.z * ((r64) ea.x * eb.y - (r64) ea.y * eb.x);
+			if(vol != 0)
+				return (Intersection) { .Occurred = 0 };
+		} else {
+			normal = TriTri_Cross(dir, w);
+		}
+
+		// Everything on one line, any plane the line doesn't face works.
+		if(normal.x == 0 && normal.y == 0 && normal.z == 0) {
+			Vec3 d = V3(fabsf(dir.x), fabsf(dir.y), fabsf(dir.z));
+			normal = V3(d.x <= d.y && d.x <= d.z, d.y < d.x && d.y <= d.z, d.z < d.x && d.z < d.y);
+		}
+	}
+
+	Vec3 n   = V3(fabsf(normal.x), fabsf(normal.y), fabsf(normal.z));
+	u32 axis = (n.x >= n.y && n.x >= n.z ? 0 : (n.y >= n.z ? 1 : 2));
+	u32 u    = (axis + 1) % 3, v = (axis + 2) % 3;
+
+	Vec2 ta[3], tb[3];
+	for(u32 i = 0; i < 3; i++) {
+		ta[i] = V2(a[i].d[u], a[i].d[v]);
+		tb[i] = V2(b[i].d[u], b[i].d[v]);
+	}
+
+	for(u32 i = 0; i < 3; i++) {
+		for(u32 j = 0; j < 3; j++) {
+			Vec2 a1 = ta[i], a2 = ta[(i + 1) % 3], b1 = tb[j], b2 = tb[(j + 1) % 3];
+			if(!Segments_Intersect(a1, a2, b1, b2))
+				continue;
+
+			// The crossing point itself only needs to be close.
+			r32 den = Vec2_Cross(Vec2_Sub(a2, a1), Vec2_Sub(b2, b1));
+			r32 t   = (den != 0 ? Clamp_R32(Vec2_Cross(Vec2_Sub(b1, a1), Vec2_Sub(b2, b1)) / den, 0, 1) : 0);
+			return (Intersection) {
+				.Occurred = 1,
+				.Point    = Vec3_Add(a[i], Vec3_MultScal(Vec3_Sub(a[(i + 1) % 3], a[i]), t))
+			};
+		}
+	}
+
+	// No edges cross, so either one triangle is inside the other or they don't touch.
+	if(Triangle_Contains2D(tb, ta[0]))
+		return (Intersection) { .Occurred = 1, .Point = Vec3_TriCenter(a[0], a[1], a[2]) };
+	if(Triangle_Contains2D(ta, tb[0]))
+		return (Intersection) { .Occurred = 1, .Point = Vec3_TriCenter(b[0], b[1], b[2]) };
+
+	return (Intersection) { .Occurred = 0 };
+}
+
+// Where a triangle crosses the line both planes share, as an interval of positions
+// along the line. `d` is how far each corner is from the other triangle's plane
+// and `p` is where it lands on the line. An edge crosses if its ends are on
+// different sides, or one of them is on the plane.
+typedef struct {
+	r32 Lo, Hi;
+	Vec3 LoPoint, HiPoint;
+} TriTri_Span;
+
+static TriTri_Span TriTri_Interval(const Vec3 v[3], const r32 d[3], const r32 p[3])
+{
+	TriTri_Span s = { .Lo = FLT_MAX, .Hi = -FLT_MAX };
+
+	for(u32 i = 0; i < 3; i++) {
+		u32 j = (i + 1) % 3;
+		if(!(d[i] * d[j] <= 0 && d[i] != d[j]))
+			continue;
+
+		r32 f = d[i] / (d[i] - d[j]);
+		r32 t = p[i] + (p[j] - p[i]) * f;
+
+		Vec3 point = Vec3_Add(v[i], Vec3_MultScal(Vec3_Sub(v[j], v[i]), f));
+		if(t < s.Lo) {
+			s.Lo      = t;
+			s.LoPoint = point;
+		}
+		if(t > s.Hi) {
+			s.Hi      = t;
+			s.HiPoint = point;
+		}
+	}
+
+	return s;
+}
+
+// The segment where a triangle crosses a plane, as a flat triangle. Same `d` as above.
+static void TriTri_Crossing(const Vec3 v[3], const r32 d[3], Vec3 out[3])
+{
+	u32 n = 0;
+	for(u32 i = 0; i < 3 && n < 2; i++) {
+		u32 j = (i + 1) % 3;
+		if(d[i] * d[j] <= 0 && d[i] != d[j])
+			out[n++] = Vec3_Add(v[i], Vec3_MultScal(Vec3_Sub(v[j], v[i]), d[i] / (d[i] - d[j])));
+	}
 
-	Vec3 pointOnPlane = Vec3_MultScal(normal, dist);
-	return fabs(Vec3_Dot(normal, Vec3_Sub(point, pointOnPlane))) <= epsilon;
+	if(n == 1)
+		out[1] = out[0];
+	out[2] = out[1];
 }
-*/
 
 // Thank you,
 // https://web.stanford.edu/class/cs277/resources/papers/Moller1997b.pdf
 Intersection TriTri_Intersect(const Vec3 a[3], const Vec3 b[3]) {
-	// Compute the normal and the distance for the plane equation of the plane triangle B sits on.
-	Vec3 N2 = Vec3_Cross(Vec3_Sub(b[1], b[0]), Vec3_Sub(b[2], b[0]));
-	r32 d2 = Vec3_Dot(Vec3_Neg(N2), b[0]);
+	Vec3 ea1 = Vec3_Sub(a[1], a[0]), ea2 = Vec3_Sub(a[2], a[0]);
+	Vec3 eb1 = Vec3_Sub(b[1], b[0]), eb2 = Vec3_Sub(b[2], b[0]);
+	Vec3 w   = Vec3_Sub(b[0], a[0]);
 
-	// Calculate the distances of the points of triangle A to the plane of triangle B.
-	r32 dist1[3] = {0};
-	for(u32 i = 0; i < 3; i++) {
-		dist1[i] = Vec3_Dot(N2, a[i]) + d2;
+	Vec3 N1 = TriTri_Cross(ea1, ea2);
+	Vec3 N2 = TriTri_Cross(eb1, eb2);
+
+	// How far the corners of each triangle are from the other one's plane.
+	r32 tolA = planeEpsilon * sqrtf(TriTri_Dot(N1, N1));
+	r32 tolB = planeEpsilon * sqrtf(TriTri_Dot(N2, N2));
+
+	r32 da[3], db[3];
+	for(u32 i = 0; i < 3; i++)
+		da[i] = TriTri_Snap(TriTri_Dot(N2, Vec3_Sub(a[i], b[0])), tolB);
+
+	db[0] = TriTri_Dot(N1, w);
+	db[1] = TriTri_Snap(db[0] + TriTri_Dot(N1, eb1), tolA);
+	db[2] = TriTri_Snap(db[0] + TriTri_Dot(N1, eb2), tolA);
+	db[0] = TriTri_Snap(db[0], tolA);
+
+	// All of one triangle on one side of the other's plane.
+	if(da[0] * da[1] > 0 && da[0] * da[2] > 0)
+		return (Intersection) { .Occurred = 0 };
+	if(db[0] * db[1] > 0 && db[0] * db[2] > 0)
+		return (Intersection) { .Occurred = 0 };
+
+	bool8 aInPlaneB = (da[0] == 0 && da[1] == 0 && da[2] == 0);
+	bool8 bInPlaneA = (db[0] == 0 && db[1] == 0 && db[2] == 0);
 
-		if(fabs(dist1[i]) < epsilon)
-			dist1[i] = 0;
+	if(aInPlaneB && bInPlaneA)
+		return TriTri_Coplanar(a, b, (Vec3_Len2(N1) >= Vec3_Len2(N2) ? N1 : N2));
+
+	// Only one lies in the other's plane, which happens when the other one has (next to)
+	// no area and no real plane of its own. All of it that can touch is where it crosses.
+	if(aInPlaneB) {
+		Vec3 cut[3];
+		TriTri_Crossing(b, db, cut);
+		return TriTri_Coplanar(a, cut, N1);
+	}
+	if(bInPlaneA) {
+		Vec3 cut[3];
+		TriTri_Crossing(a, da, cut);
+		return TriTri_Coplanar(cut, b, N2);
 	}
 
-	// If they're all non-zero and they all have the same sign, the triangles
-	// don't intersect (since the points are on only 1 side of the plane).
-	if(dist1[0] != 0 && dist1[1] != 0 && dist1[2] != 0 &&
-	   TRIEQ(GetSign_R32(dist1[0]), GetSign_R32(dist1[1]), GetSign_R32(dist1[2])))
-	{
-		Log(DEBUG, "Early reject 1. dist1[%.2f, %.2f, %.2f]", dist1[0], dist1[1], dist1[2]);
+	// Both triangles cut the line the planes meet on, they touch if the cuts overlap.
+	Vec3 D  = TriTri_Cross(N1, N2);
+	r32 q0  = TriTri_Dot(D, w);
+	r32 p[3] = { 0, TriTri_Dot(D, ea1), TriTri_Dot(D, ea2) };
+	r32 q[3] = { q0, q0 + TriTri_Dot(D, eb1), q0 + TriTri_Dot(D, eb2) };
+
+	TriTri_Span sa = TriTri_Interval(a, da, p);
+	TriTri_Span sb = TriTri_Interval(b, db, q);
+
+	if(MAX(sa.Lo, sb.Lo) > MIN(sa.Hi, sb.Hi))
 		return (Intersection) { .Occurred = 0 };
+
+	// Middle of the overlap.
+	Vec3 lo = (sa.Lo >= sb.Lo ? sa.LoPoint : sb.LoPoint);
+	Vec3 hi = (sa.Hi <= sb.Hi ? sa.HiPoint : sb.HiPoint);
+	return (Intersection) { .Occurred = 1, .Point = Vec3_Center(lo, hi) };
+}
+
+// AABB_Add() lives in another file and doesn't get inlined, the trees call this a lot.
+static inline AABB AABB_Union(AABB a, AABB b)
+{
+	for(u32 i = 0; i < 3; i++) {
+		a.Min.d[i] = MIN(a.Min.d[i], b.Min.d[i]);
+		a.Max.d[i] = MAX(a.Max.d[i], b.Max.d[i]);
 	}
+	return a;
+}
+
+static inline r32 AABB_Area(AABB a)
+{
+	r32 dx = a.Max.x - a.Min.x, dy = a.Max.y - a.Min.y, dz = a.Max.z - a.Min.z;
+	return 2 * (dx * dy + dy * dz + dz * dx);
+}
+
+static inline bool8 AABB_Contains(AABB outer, AABB inner)
+{
+	return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y && outer.Min.z <= inner.Min.z
+	    && inner.Max.x <= outer.Max.x && inner.Max.y <= outer.Max.y && inner.Max.z <= outer.Max.z;
+}
 
-	Vec3 N1 = Vec3_Cross(Vec3_Sub(a[1], a[0]), Vec3_Sub(a[2], a[0]));
-	r32 d1 = Vec3_Dot(Vec3_Neg(N1), a[0]);
-	r32	dist2[3] = {0};
+static inline bool8 Boxes_Overlap(const AABB* a, const AABB* b)
+{
+	return a->Min.x <= b->Max.x && b->Min.x <= a->Max.x
+	    && a->Min.y <= b->Max.y && b->Min.y <= a->Max.y
+	    && a->Min.z <= b->Max.z && b->Min.z <= a->Max.z;
+}
+
+// Thank you,
+// https://tavianator.com/2011/ray_box.html
+// Where the ray enters the box, if it does before maxT.
+static inline bool8 Ray_HitsBox(Vec3 start, Vec3 invDir, const AABB* box, r32 maxT, r32* outT)
+{
+	r32 tMin = 0, tMax = maxT;
 
 	for(u32 i = 0; i < 3; i++) {
-		dist2[i] = Vec3_Dot(N1, b[i]) + d1;
-		if(fabs(dist2[i]) < epsilon)
-			dist2[i] = 0;
+		r32 t1 = (box->Min.d[i] - start.d[i]) * invDir.d[i];
+		r32 t2 = (box->Max.d[i] - start.d[i]) * invDir.d[i];
+
+		// fminf/fmaxf drop the NaN that comes from a ray lying on the box's side.
+		tMin = fmaxf(tMin, fminf(t1, t2));
+		tMax = fminf(tMax, fmaxf(t1, t2));
 	}
-#define NONE_ARE_ZERO(arr) arr[0] != 0 && arr[1] != 0 && arr[2] != 0
 
-	if(NONE_ARE_ZERO(dist2) && TRIEQ(GetSign_R32(dist2[0]), GetSign_R32(dist2[1]), GetSign_R32(dist2[2])))
-	{
-		Log(DEBUG, "[Phys] Early reject 2. dist2[%.2f, %.2f, %.2f]", dist2[0], dist2[1], dist2[2]);
-		return (Intersection) { .Occurred = 0 };
+	*outT = tMin;
+	return tMin <= tMax;
+}
+
+//
+// TriHull BVH
+//
+
+// Triangles are tested in the hull's local space, so the ray or the other hull
+// gets moved there once, instead of every triangle getting moved into the world.
+
+// Row-major affine matrices, like the ones from Transform3D_Mat4().
+static inline Vec3 Affine_Point(const Mat4 m, Vec3 p)
+{
+	return V3(m[0] * p.x + m[1] * p.y + m[2]  * p.z + m[3],
+	          m[4] * p.x + m[5] * p.y + m[6]  * p.z + m[7],
+	          m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11]);
+}
+
+static inline Vec3 Affine_Dir(const Mat4 m, Vec3 d)
+{
+	return V3(m[0] * d.x + m[1] * d.y + m[2]  * d.z,
+	          m[4] * d.x + m[5] * d.y + m[6]  * d.z,
+	          m[8] * d.x + m[9] * d.y + m[10] * d.z);
+}
+
+// Same matrix as Transform3D_Mat4(), without building and multiplying three of them.
+static void Affine_FromTransform(const Transform3D* t, Mat4 out)
+{
+	Quat q = t->Rotation;
+	Vec3 s = t->Scale;
+
+	out[0]  = (1 - 2 * q.y * q.y - 2 * q.z * q.z) * s.x;
+	out[1]  = (2 * q.x * q.y - 2 * q.z * q.w) * s.y;
+	out[2]  = (2 * q.x * q.z + 2 * q.y * q.w) * s.z;
+	out[3]  = t->Position.x;
+
+	out[4]  = (2 * q.x * q.y + 2 * q.z * q.w) * s.x;
+	out[5]  = (1 - 2 * q.x * q.x - 2 * q.z * q.z) * s.y;
+	out[6]  = (2 * q.y * q.z - 2 * q.x * q.w) * s.z;
+	out[7]  = t->Position.y;
+
+	out[8]  = (2 * q.x * q.z - 2 * q.y * q.w) * s.x;
+	out[9]  = (2 * q.y * q.z + 2 * q.x * q.w) * s.y;
+	out[10] = (1 - 2 * q.x * q.x - 2 * q.y * q.y) * s.z;
+	out[11] = t->Position.z;
+
+	out[12] = out[13] = out[14] = 0;
+	out[15] = 1;
+}
+
+// Mat4_Inverse() doesn't work, and an affine matrix only needs its 3x3 part inverted anyway.
+static void Affine_Inverse(const Mat4 m, Mat4 out)
+{
+	r32 c00 = m[5] * m[10] - m[6] * m[9];
+	r32 c01 = m[6] * m[8]  - m[4] * m[10];
+	r32 c02 = m[4] * m[9]  - m[5] * m[8];
+
+	r32 det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+	r32 inv = (det != 0 ? 1.0f / det : 0);
+
+	out[0]  = c00 * inv;
+	out[1]  = (m[2] * m[9]  - m[1] * m[10]) * inv;
+	out[2]  = (m[1] * m[6]  - m[2] * m[5])  * inv;
+	out[4]  = c01 * inv;
+	out[5]  = (m[0] * m[10] - m[2] * m[8])  * inv;
+	out[6]  = (m[2] * m[4]  - m[0] * m[6])  * inv;
+	out[8]  = c02 * inv;
+	out[9]  = (m[1] * m[8]  - m[0] * m[9])  * inv;
+	out[10] = (m[0] * m[5]  - m[1] * m[4])  * inv;
+
+	Vec3 t  = Affine_Dir(out, V3(m[3], m[7], m[11]));
+	out[3]  = -t.x;
+	out[7]  = -t.y;
+	out[11] = -t.z;
+
+	out[12] = out[13] = out[14] = 0;
+	out[15] = 1;
+}
+
+// Thank you,
+// https://github.com/erich666/GraphicsGems/blob/master/gems/TransBox.c
+// The box around a transformed box, without transforming all 8 corners.
+static AABB Affine_Box(const Mat4 m, AABB box)
+{
+	Vec3 center = Vec3_MultScal(Vec3_Add(box.Min, box.Max), 0.5f);
+	Vec3 extent = Vec3_MultScal(Vec3_Sub(box.Max, box.Min), 0.5f);
+
+	Vec3 c = Affine_Point(m, center);
+	Vec3 e = V3(fabsf(m[0]) * extent.x + fabsf(m[1]) * extent.y + fabsf(m[2])  * extent.z,
+	            fabsf(m[4]) * extent.x + fabsf(m[5]) * extent.y + fabsf(m[6])  * extent.z,
+	            fabsf(m[8]) * extent.x + fabsf(m[9]) * extent.y + fabsf(m[10]) * extent.z);
+
+	return (AABB) { .Min = Vec3_Sub(c, e), .Max = Vec3_Add(c, e) };
+}
+
+// Matrices to and from the hull's local space.
+static void TriHull_Space(const TriHull* hull, Mat4 toWorld, Mat4 toLocal)
+{
+	if(hull->Transform) {
+		Affine_FromTransform(hull->Transform, toWorld);
+		Affine_Inverse(toWorld, toLocal);
+	} else {
+		Mat4_Identity(toWorld);
+		Mat4_Identity(toLocal);
+	}
+}
+
+static inline AABB Triangle_Box(const Vec3* tri)
+{
+	AABB box = { .Min = tri[0], .Max = tri[0] };
+	for(u32 i = 1; i < 3; i++) {
+		box.Min = V3(MIN(box.Min.x, tri[i].x), MIN(box.Min.y, tri[i].y), MIN(box.Min.z, tri[i].z));
+		box.Max = V3(MAX(box.Max.x, tri[i].x), MAX(box.Max.y, tri[i].y), MAX(box.Max.z, tri[i].z));
 	}
+	return box;
+}
 
-	if(dist2[0] == 0 && TRIEQ(dist2[0], dist2[1], dist2[2])) {
-		// The triangles are co-planar.
-		Log(DEBUG, "[Phys] Triangles are co-planar.", "");
-		
-		//
-		// TODO: This is most likely horrible code, but the document says that the triangles 
-		//       should be "projected onto the axis-aligned plane where the areas of the 
-		//       triangles are maximized" and I don't know maths well enough to do this better.
-		//
-		//       In theory, this should be very rare, so hopefully this can't have too much of
-		//       an effect on performance.
-		//
-		r32 areaXY = Triangle_AreaAxisAligned(a[0], a[1], a[2], Triangle_TargetAxis_XY)
-			       + Triangle_AreaAxisAligned(b[0], b[1], b[2], Triangle_TargetAxis_XY);
-		r32 areaXZ = Triangle_AreaAxisAligned(a[0], a[1], a[2], Triangle_TargetAxis_XZ)
-			       + Triangle_AreaAxisAligned(b[0], b[1], b[2], Triangle_TargetAxis_XZ);
-		r32 areaYZ = Triangle_AreaAxisAligned(a[0], a[1], a[2], Triangle_TargetAxis_YZ)
-			       + Triangle_AreaAxisAligned(b[0], b[1], b[2], Triangle_TargetAxis_YZ);
-
-		r32 max = MAX3(areaXY, areaXZ, areaYZ);
-
-		Vec2 tri1[3];
-		Vec2 tri2[3];
-
-		if(max == areaXY) {
-			tri1[0] = a[0].xy;
-			tri1[1] = a[1].xy;
-			tri1[2] = a[2].xy;
-
-			tri2[0] = b[0].xy;
-			tri2[1] = b[1].xy;
-			tri2[2] = b[2].xy;
-		} else if(max == areaXZ) {
-			tri1[0] = V2(a[0].x, a[0].z);
-			tri1[1] = V2(a[1].x, a[0].z);
-			tri1[2] = V2(a[2].x, a[0].z);
-
-			tri2[0] = V2(b[0].x, b[0].z);
-			tri2[1] = V2(b[1].x, b[0].z);
-			tri2[2] = V2(b[2].x, b[0].z);
-		} else if(max == areaYZ) {
-			tri1[0] = V2(a[0].y, a[0].z);
-			tri1[1] = V2(a[1].y, a[0].z);
-			tri1[2] = V2(a[2].y, a[0].z);
-
-			tri2[0] = V2(b[0].y, b[0].z);
-			tri2[1] = V2(b[1].y, b[0].z);
-			tri2[2] = V2(b[2].y, b[0].z);
-		}
-
-		// Thank you,
-		// https://en.wikipedia.org/wiki/Line%E2%80%93line_intersection#Given_two_Points_on_each_line
-		// Do line-line intersections for every edge of the two triangles.
-		for(u32 i = 0; i < 3; i++) {
-			Vec2 a1 = tri1[i];
-			Vec2 a2 = tri1[(i+1)%3];
+// Thank you,
+// https://www.sci.utah.edu/~wald/Publications/2007/ParallelBVHBuild/fastbuild.pdf
+// Binned SAH: centroids are dropped into bins along each axis, and the split
+// between bins with the lowest area * block count on both sides wins.
+// Leaves are tested a block of 4 triangles at a time, so 3 triangles cost as much as 4.
 
-			for(u32 j = 0; j < 3; j++) {
-				Vec2 b1 = tri2[j];
-				Vec2 b2 = tri2[(j+1)%3];
+#define TRIHULL_BVH_BINS      12
+#define TRIHULL_BVH_MAX_LEAF  16 // Leaves bigger than this get split even if SAH says not to.
+#define TRIHULL_BVH_MAX_DEPTH 64 // Keeps traversal stacks a fixed size.
 
-				r32 t = -((a1.x - b1.x)*(b1.y - b2.y) - (a1.y-b1.y)*(b1.x-b2.x))
-					   / ((a1.x - a2.x)*(b1.y - b2.y) - (a1.y-a2.y)*(b1.x-b2.x));
+#define TRIHULL_BLOCKS(count) (((count) + 3) / 4)
 
-				r32 u = -((a1.x - a2.x)*(a1.y - b1.y) - (a1.y-a2.y)*(a1.x-b1.x))
-					   / ((a1.x - a2.x)*(b1.y - b2.y) - (a1.y-a2.y)*(b1.x-b2.x));
+typedef struct {
+	TriHull_BVHNode* Nodes;
+	u32 NumNodes;
 
-				if(InRange_R32(t, 0, 1) && InRange_R32(u, 0, 1))
-					return (Intersection) { 
-						.Occurred = 1,
-						.Point = Vec3_Add(a[i], Vec3_MultScal(Vec3_Sub(a[(i+1)%3], a[i]), t)) 
-					};
-			}
+	AABB* Boxes;
+	Vec3* Centers;
+	u32* Order; // Triangle indices, sorted into leaves as the tree gets built.
+} TriHull_Builder;
+
+static void TriHull_BuildNode(TriHull_Builder* b, u32 first, u32 count, u32 depth)
+{
+	u32 node = b->NumNodes++;
+
+	AABB box     = b->Boxes[b->Order[first]];
+	AABB centers = { .Min = b->Centers[b->Order[first]], .Max = b->Centers[b->Order[first]] };
+
+	for(u32 i = first + 1; i < first + count; i++) {
+		Vec3 c  = b->Centers[b->Order[i]];
+		box     = AABB_Union(box, b->Boxes[b->Order[i]]);
+		centers = AABB_Union(centers, (AABB) { .Min = c, .Max = c });
+	}
+
+	b->Nodes[node].Box = box;
+
+	i32 bestAxis  = -1;
+	u32 bestSplit = 0;
+	r32 bestCost  = FLT_MAX;
+
+	// Up to one block's worth of triangles are never worth splitting.
+	for(u32 axis = 0; axis < 3 && count > 4; axis++) {
+		r32 lo = centers.Min.d[axis], extent = centers.Max.d[axis] - lo;
+		if(extent <= 0)
+			continue;
+
+		u32  binCount[TRIHULL_BVH_BINS] = {0};
+		AABB binBox[TRIHULL_BVH_BINS];
+		r32 scale = TRIHULL_BVH_BINS / extent;
+
+		for(u32 i = first; i < first + count; i++) {
+			u32 t   = b->Order[i];
+			u32 bin = MIN((u32) ((b->Centers[t].d[axis] - lo) * scale), TRIHULL_BVH_BINS - 1);
+			binBox[bin] = (binCount[bin]++ ? AABB_Union(binBox[bin], b->Boxes[t]) : b->Boxes[t]);
 		}
 
-		// If the line-line tests fail, check if one of the triangles is fully within the other.
-		bool8 triInside = 1;
-		for(u32 i = 0; i < 3; i++) {
-			//if(!Triangle_PointInside(tri1, tri2[i])) {
-				triInside = 0;
-				break;
-			//}
+		// Sweep from the right to get the area and count right of every split...
+		r32 rightArea[TRIHULL_BVH_BINS];
+		u32 rightCount[TRIHULL_BVH_BINS];
+		AABB acc;
+		u32 n = 0;
+
+		for(u32 i = TRIHULL_BVH_BINS - 1; i > 0; i--) {
+			if(binCount[i])
+				acc = (n ? AABB_Union(acc, binBox[i]) : binBox[i]);
+			n += binCount[i];
+
+			rightCount[i] = n;
+			rightArea[i]  = (n ? AABB_Area(acc) : 0);
 		}
-		if(triInside)
-			return (Intersection) {
-				.Occurred = 1,
-				.Point = Vec3_TriCenter(b[0], b[1], b[2])
-			};
 
-		triInside = 1;
-		for(u32 i = 0; i < 3; i++) {
-			//if(!Triangle_PointInside(tri2, tri1[i])) {
-				triInside = 0;
-				break;
-			//}
+		// ...then from the left to put them together.
+		n = 0;
+		for(u32 i = 0; i < TRIHULL_BVH_BINS - 1; i++) {
+			if(binCount[i])
+				acc = (n ? AABB_Union(acc, binBox[i]) : binBox[i]);
+			n += binCount[i];
+
+			if(!n || !rightCount[i + 1])
+				continue;
+
+			r32 cost = AABB_Area(acc) * TRIHULL_BLOCKS(n) + rightArea[i + 1] * TRIHULL_BLOCKS(rightCount[i + 1]);
+			if(cost < bestCost) {
+				bestCost  = cost;
+				bestAxis  = axis;
+				bestSplit = i;
+			}
 		}
+	}
 
-		return (Intersection) {
-			.Occurred = 1,
-			.Point = Vec3_TriCenter(a[0], a[1], a[2])
-		};
-	} else {
-		// The triangles are not co-planar.
-		Log(DEBUG, "[Phys] Triangles are NOT co-planar.", "");
-
-		// Thank you,
-		// https://stackoverflow.com/a/32410473
-		Vec3 D = Vec3_Cross(N1, N2);
-		r32 det = Vec3_Len2(D);
-
-		Vec3 O = Vec3_DivScal(Vec3_Add(
-					Vec3_MultScal(Vec3_Cross(D, N2), d1),
-					Vec3_MultScal(Vec3_Cross(N1, D), d2)), det);
-		r32 pv1[3] = {
-			Vec3_Dot(D, Vec3_Sub(a[0], O)),
-			Vec3_Dot(D, Vec3_Sub(a[1], O)),
-			Vec3_Dot(D, Vec3_Sub(a[2], O))
-		};
-		r32 t1 = pv1[0] + (pv1[1] - pv1[0]) * (dist1[0] / (dist1[0] - dist1[1]));
-		r32 t2 = pv1[1] + (pv1[2] - pv1[1]) * (dist1[1] / (dist1[1] - dist1[2]));
+	// A split costs one box test plus whatever's on both sides of it.
+	r32 area    = AABB_Area(box);
+	bool8 split = bestAxis >= 0 && (area + bestCost < area * TRIHULL_BLOCKS(count) || count > TRIHULL_BVH_MAX_LEAF);
 
-		r32 pv2[3] = {
-			Vec3_Dot(D, Vec3_Sub(b[0], O)),
-			Vec3_Dot(D, Vec3_Sub(b[1], O)),
-			Vec3_Dot(D, Vec3_Sub(b[2], O))
-		};
-		r32 t3 = pv2[0] + (pv2[1] - pv2[0]) * (dist2[0] / (dist2[0] - dist2[1]));
-		r32 t4 = pv2[1] + (pv2[2] - pv2[1]) * (dist2[1] / (dist2[1] - dist2[2]));
-		Log(DEBUG, "[Phys] Ranges: t1 = %12.2f | t3 = %12.2f", t1, t3);
-		Log(DEBUG, "               t2 = %12.2f | t4 = %12.2f", t2, t4);
+	u32 mid = first;
+	if(split) {
+		r32 lo    = centers.Min.d[bestAxis];
+		r32 scale = TRIHULL_BVH_BINS / (centers.Max.d[bestAxis] - lo);
 
-		bool8 Occurred = RangesOverlap_R32(t1, t2, t3, t4);
+		for(u32 i = first; i < first + count; i++) {
+			u32 t   = b->Order[i];
+			u32 bin = MIN((u32) ((b->Centers[t].d[bestAxis] - lo) * scale), TRIHULL_BVH_BINS - 1);
 
-		// TODO: Check the case where the collision Occurred again, it looks wrong...
-		if(!Occurred)
-			return (Intersection) { .Occurred = 0 };
-		else
-			return (Intersection) { .Occurred = 1, .Point = O };
+			if(bin <= bestSplit) {
+				b->Order[i]   = b->Order[mid];
+				b->Order[mid] = t;
+				mid++;
+			}
+		}
+	} else if(count > TRIHULL_BVH_MAX_LEAF) {
+		// All the centers are in the same spot, just cut the list in half.
+		mid = first + count / 2;
+	}
+
+	if(mid == first || depth >= TRIHULL_BVH_MAX_DEPTH) {
+		b->Nodes[node].Index = first;
+		b->Nodes[node].Count = count;
+		return;
 	}
+
+	TriHull_BuildNode(b, first, mid - first, depth + 1);
+	b->Nodes[node].Index = b->NumNodes;
+	b->Nodes[node].Count = 0;
+	TriHull_BuildNode(b, mid, first + count - mid, depth + 1);
 }
 
-Intersection 
-TriHull_Intersect(TriHull a, TriHull b)
+void TriHull_Build(TriHull* hull)
 {
-	// TODO: Optimizations go here.
-	
-	for(u32 i = 0; i < a.NumTris; i++) {
-		for(u32 j = 0; j < b.NumTris; j++) {
-			Vec3 triA[3] = { a.TriPoints[i*3], a.TriPoints[i*3+1], a.TriPoints[i*3+2] };
-			Vec3 triB[3] = { b.TriPoints[j*3], b.TriPoints[j*3+1], b.TriPoints[j*3+2] };
-
-			if(a.Transform)
-			{
-				Mat4 m; Transform3D_Mat4(*a.Transform, m);
-				for(u32 p = 0; p < 3; p++) triA[p] = Mat4_MultVec4(m, V4_V3(triA[p], 1)).xyz;
-			}
+	TriHull_Free(hull);
+	if(!hull->NumTris)
+		return;
 
-			if(b.Transform)
-			{
-				Mat4 m; Transform3D_Mat4(*b.Transform, m);
-				for(u32 p = 0; p < 3; p++) triB[p] = Mat4_MultVec4(m, V4_V3(triB[p], 1)).xyz;
-			}
+	u32 n = hull->NumTris;
+	TriHull_Builder b = {
+		.Nodes   = Allocate(sizeof(TriHull_BVHNode) * (2 * n - 1)),
+		.Boxes   = Allocate(sizeof(AABB) * n),
+		.Centers = Allocate(sizeof(Vec3) * n),
+		.Order   = Allocate(sizeof(u32) * n),
+	};
+
+	for(u32 i = 0; i < n; i++) {
+		b.Boxes[i]   = Triangle_Box(&hull->TriPoints[i * 3]);
+		b.Centers[i] = Vec3_MultScal(Vec3_Add(b.Boxes[i].Min, b.Boxes[i].Max), 0.5f);
+		b.Order[i]   = i;
+	}
 
-			Intersection res = TriTri_Intersect(triA, triB);
+	TriHull_BuildNode(&b, 0, n, 0);
 
-			if(res.Occurred) {
-				Log(INFO, "[Phys] Triangles #%d and #%d intersect at Point (%.2f, %.2f, %.2f)!", 
-					      i, j, res.Point.x, res.Point.y, res.Point.z);
-				return res;
+	u32 numBlocks = 0;
+	for(u32 i = 0; i < b.NumNodes; i++)
+		numBlocks += TRIHULL_BLOCKS(b.Nodes[i].Count);
+
+	TriHull_BVH* bvh = Allocate(sizeof(TriHull_BVH));
+	bvh->Nodes       = Reallocate(b.Nodes, sizeof(TriHull_BVHNode) * b.NumNodes);
+	bvh->NumNodes    = b.NumNodes;
+	bvh->Tris        = Allocate(sizeof(Vec3) * 3 * 4 * numBlocks);
+	bvh->Blocks      = Allocate(sizeof(TriHull_TriBlock) * numBlocks);
+
+	// Lay the leaves out again, each one starting on a fresh block.
+	u32 block = 0;
+	for(u32 i = 0; i < bvh->NumNodes; i++) {
+		TriHull_BVHNode* node = &bvh->Nodes[i];
+		if(!node->Count)
+			continue;
+
+		for(u32 j = 0; j < TRIHULL_BLOCKS(node->Count) * 4; j++) {
+			// The gaps are copies of the first triangle with no edges, which no ray can hit.
+			u32 k = (j < node->Count ? j : 0);
+			Vec3* tri = &bvh->Tris[(block * 4 + j) * 3];
+			memcpy(tri, &hull->TriPoints[b.Order[node->Index + k] * 3], sizeof(Vec3) * 3);
+
+			TriHull_TriBlock* dst = &bvh->Blocks[block + j / 4];
+			for(u32 c = 0; c < 3; c++) {
+				dst->V0[c][j % 4] = tri[0].d[c];
+				dst->E1[c][j % 4] = (j < node->Count ? tri[1].d[c] - tri[0].d[c] : 0);
+				dst->E2[c][j % 4] = (j < node->Count ? tri[2].d[c] - tri[0].d[c] : 0);
 			}
 		}
+
+		node->Index = block * 4;
+		block += TRIHULL_BLOCKS(node->Count);
 	}
 
-	return (Intersection) { .Occurred = 0 };
+	Free(b.Boxes);
+	Free(b.Centers);
+	Free(b.Order);
+
+	hull->BVH = bvh;
+}
+
+void TriHull_Free(TriHull* hull)
+{
+	if(!hull->BVH)
+		return;
+
+	Free(hull->BVH->Nodes);
+	Free(hull->BVH->Tris);
+	Free(hull->BVH->Blocks);
+	Free(hull->BVH);
+	hull->BVH = NULL;
 }
 
 // Thank you,
 // https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
 static Intersection
-TriRay_Intersect(Vec3 *tri, Ray ray)
+TriRay_Intersect(const Vec3 *tri, Ray ray)
 {
 	const r32 epsilon = 1e-8;
 
@@ -278,64 +695,4416 @@ TriRay_Intersect(Vec3 *tri, Ray ray)
 
 	return (Intersection) {
 		.Occurred = 1,
-		.Point = Vec3_Add(ray.Start, Vec3_MultScal(ray.Dir, t)) 
+		.Point = Vec3_Add(ray.Start, Vec3_MultScal(ray.Dir, t)),
+		.T = t
 	};
 }
 
-Intersection 
-TriHull_RayIntersect(TriHull hull, Ray ray)
+//
+// SIMD kernels
+//
+
+// The same ray test as above, on one ray and a block of 4 or 8 triangles, or on
+// one triangle and a packet of 4 or 8 rays. Same for TriTri_Intersect(), on one
+// triangle and a block. SSE2 is always there on x86-64, AVX gets checked for
+// when the program runs.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+#define PHYS_HAS_SSE 1
+
+#if defined(__GNUC__)
+#define PHYS_HAS_AVX 1
+
+static bool8 Phys_HasAVX(void)
 {
-	// TODO: Optimizations go here?
-	
-	for(u32 i = 0; i < hull.NumTris; i++) {
-		Vec3 tri[3] = { 
-			hull.TriPoints[i * 3],
-			hull.TriPoints[i * 3 + 1],
-			hull.TriPoints[i * 3 + 2]
-		};
+	static i8 hasAVX = -1;
+	if(hasAVX < 0)
+		hasAVX = (__builtin_cpu_supports("avx") ? 1 : 0);
+	return hasAVX;
+}
+#endif
 
-		if(hull.Transform)
-		{
-			Mat4 m;
-			Transform3D_Mat4(*hull.Transform, m);
+// Up to 8 rays that go through the BVH together, split up by component.
+typedef struct {
+	r32 Start[3][8];
+	r32 Dir[3][8];
+	r32 InvDir[3][8];
+	r32 Best[8]; // Closest hit so far, negative for lanes without a ray.
+	i32 Hit[8];
+} TriRay_Packet;
 
-			for(u32 p = 0; p < 3; p++)
-				tri[p] = Mat4_MultVec4(m, V4_V3(tri[p], 1)).xyz;
-		}
+static inline __m128 Dot_SSE(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
 
-		Intersection res = TriRay_Intersect(tri, ray);
+// Lanes where Möller-Trumbore hits, closer than `best`. T ends up in `outT`.
+static inline __m128 TriRay_Test_SSE(const __m128 start[3], const __m128 dir[3], const __m128 v0[3],
+                                     const __m128 e1[3], const __m128 e2[3], __m128 best, __m128* outT)
+{
+	__m128 hx = _mm_sub_ps(_mm_mul_ps(dir[1], e2[2]), _mm_mul_ps(dir[2], e2[1]));
+	__m128 hy = _mm_sub_ps(_mm_mul_ps(dir[2], e2[0]), _mm_mul_ps(dir[0], e2[2]));
+	__m128 hz = _mm_sub_ps(_mm_mul_ps(dir[0], e2[1]), _mm_mul_ps(dir[1], e2[0]));
+	__m128 a  = Dot_SSE(e1[0], e1[1], e1[2], hx, hy, hz);
+	__m128 f  = _mm_div_ps(_mm_set1_ps(1), a);
 
-		if(res.Occurred) {
-			Log(INFO, "[Phys] Triangle #%d and ray intersect at Point (%.2f, %.2f, %.2f)!", 
-				i, res.Point.x, res.Point.y, res.Point.z);
-			return res;
-		}
+	__m128 sx = _mm_sub_ps(start[0], v0[0]);
+	__m128 sy = _mm_sub_ps(start[1], v0[1]);
+	__m128 sz = _mm_sub_ps(start[2], v0[2]);
+	__m128 u  = _mm_mul_ps(f, Dot_SSE(sx, sy, sz, hx, hy, hz));
+
+	__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1[2]), _mm_mul_ps(sz, e1[1]));
+	__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1[0]), _mm_mul_ps(sx, e1[2]));
+	__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1[1]), _mm_mul_ps(sy, e1[0]));
+	__m128 v  = _mm_mul_ps(f, Dot_SSE(dir[0], dir[1], dir[2], qx, qy, qz));
+	__m128 t  = _mm_mul_ps(f, Dot_SSE(e2[0], e2[1], e2[2], qx, qy, qz));
+
+	__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1), eps = _mm_set1_ps(epsilon);
+
+	// Parallel rays come out with an infinite or NaN `f`, which fails every compare below anyway.
+	__m128 ok = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), a), eps);
+	ok = _mm_and_ps(ok, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+	ok = _mm_and_ps(ok, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(v, _mm_sub_ps(one, u))));
+	ok = _mm_and_ps(ok, _mm_and_ps(_mm_cmpge_ps(t, eps), _mm_cmplt_ps(t, best)));
+
+	*outT = t;
+	return ok;
+}
+
+// One ray against a block of 4 triangles. Returns the lane of the closest hit
+// that's closer than `best` and moves `best` there, or returns -1.
+static inline i32 TriRay_Block4(const TriHull_TriBlock* b, Ray ray, r32* best)
+{
+	// No loops filling these in, GCC keeps whole arrays in registers only if every index is a constant.
+	__m128 start[3] = { _mm_set1_ps(ray.Start.x), _mm_set1_ps(ray.Start.y), _mm_set1_ps(ray.Start.z) };
+	__m128 dir[3]   = { _mm_set1_ps(ray.Dir.x), _mm_set1_ps(ray.Dir.y), _mm_set1_ps(ray.Dir.z) };
+	__m128 v0[3]    = { _mm_loadu_ps(b->V0[0]), _mm_loadu_ps(b->V0[1]), _mm_loadu_ps(b->V0[2]) };
+	__m128 e1[3]    = { _mm_loadu_ps(b->E1[0]), _mm_loadu_ps(b->E1[1]), _mm_loadu_ps(b->E1[2]) };
+	__m128 e2[3]    = { _mm_loadu_ps(b->E2[0]), _mm_loadu_ps(b->E2[1]), _mm_loadu_ps(b->E2[2]) };
+
+	__m128 t;
+	__m128 ok = TriRay_Test_SSE(start, dir, v0, e1, e2, _mm_set1_ps(*best), &t);
+	if(!_mm_movemask_ps(ok))
+		return -1;
+
+	// Spread the smallest T over every lane, then look for where it came from.
+	t = _mm_or_ps(_mm_and_ps(ok, t), _mm_andnot_ps(ok, _mm_set1_ps(FLT_MAX)));
+	__m128 m = _mm_min_ps(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 3, 0, 1)));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+	u32 mask = _mm_movemask_ps(_mm_and_ps(ok, _mm_cmpeq_ps(t, m)));
+	i32 lane = 0;
+	while(!(mask & 1)) {
+		mask >>= 1;
+		lane++;
 	}
 
-	return (Intersection) { .Occurred = 0 };
+	*best = _mm_cvtss_f32(m);
+	return lane;
 }
 
-void PhysWorld_Init(PhysWorld* world)
+// Four rays of a packet (starting at `lane`) against one triangle of a block.
+static inline void TriRay_Packet4(TriRay_Packet* p, u32 lane, const TriHull_TriBlock* b, u32 j, i32 index)
+{
+	__m128 start[3] = { _mm_loadu_ps(&p->Start[0][lane]), _mm_loadu_ps(&p->Start[1][lane]), _mm_loadu_ps(&p->Start[2][lane]) };
+	__m128 dir[3]   = { _mm_loadu_ps(&p->Dir[0][lane]), _mm_loadu_ps(&p->Dir[1][lane]), _mm_loadu_ps(&p->Dir[2][lane]) };
+	__m128 v0[3]    = { _mm_set1_ps(b->V0[0][j]), _mm_set1_ps(b->V0[1][j]), _mm_set1_ps(b->V0[2][j]) };
+	__m128 e1[3]    = { _mm_set1_ps(b->E1[0][j]), _mm_set1_ps(b->E1[1][j]), _mm_set1_ps(b->E1[2][j]) };
+	__m128 e2[3]    = { _mm_set1_ps(b->E2[0][j]), _mm_set1_ps(b->E2[1][j]), _mm_set1_ps(b->E2[2][j]) };
+
+	__m128 t, best = _mm_loadu_ps(&p->Best[lane]);
+	__m128 ok = TriRay_Test_SSE(start, dir, v0, e1, e2, best, &t);
+	if(!_mm_movemask_ps(ok))
+		return;
+
+	__m128 hit = _mm_loadu_ps((const r32*) &p->Hit[lane]);
+	hit  = _mm_or_ps(_mm_and_ps(ok, _mm_castsi128_ps(_mm_set1_epi32(index))), _mm_andnot_ps(ok, hit));
+	best = _mm_or_ps(_mm_and_ps(ok, t), _mm_andnot_ps(ok, best));
+
+	_mm_storeu_ps(&p->Best[lane], best);
+	_mm_storeu_ps((r32*) &p->Hit[lane], hit);
+}
+
+// Thank you,
+// https://tavianator.com/2011/ray_box.html
+// Ray_HitsBox() for 4 rays of a packet. Returns which lanes hit and the closest entry point among them.
+static inline u32 TriRay_PacketHitsBox4(const TriRay_Packet* p, u32 lane, const AABB* box, r32* outT)
 {
-	world->Gravity = 9.8;
-	world->Objects = (Array_PhysObject) {0};
+	__m128 tMin = _mm_setzero_ps();
+	__m128 tMax = _mm_loadu_ps(&p->Best[lane]);
+
+	for(u32 c = 0; c < 3; c++) {
+		__m128 start  = _mm_loadu_ps(&p->Start[c][lane]);
+		__m128 invDir = _mm_loadu_ps(&p->InvDir[c][lane]);
+		__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box->Min.d[c]), start), invDir);
+		__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box->Max.d[c]), start), invDir);
+
+		// Like fminf() and fmaxf(), the NaN from a ray lying in a slab's plane gets dropped,
+		// since _mm_min_ps() and _mm_max_ps() return their second argument when there's one.
+		tMin = _mm_max_ps(_mm_min_ps(t1, t2), tMin);
+		tMax = _mm_min_ps(_mm_max_ps(t1, t2), tMax);
+	}
+
+	__m128 ok = _mm_cmple_ps(tMin, tMax);
+	u32 mask  = _mm_movemask_ps(ok);
+	if(mask) {
+		__m128 t = _mm_or_ps(_mm_and_ps(ok, tMin), _mm_andnot_ps(ok, _mm_set1_ps(FLT_MAX)));
+		t = _mm_min_ps(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 3, 0, 1)));
+		t = _mm_min_ps(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 0, 3, 2)));
+		*outT = MIN(*outT, _mm_cvtss_f32(t));
+	}
+	return mask;
 }
 
-// TODO: Implement.
-PhysObject*
-PhysWorld_RayCollide(const PhysWorld* world, Ray ray)
+#ifdef PHYS_HAS_AVX
+__attribute__((target("avx"))) static inline __m256 Dot_AVX(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
 {
-	// 2. 
-	return NULL;
+	return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
 }
 
-// TODO: Implement
-void PhysWorld_Update(PhysWorld* world, r32 dt)
+__attribute__((target("avx"))) static inline __m256
+TriRay_Test_AVX(const __m256 start[3], const __m256 dir[3], const __m256 v0[3],
+                const __m256 e1[3], const __m256 e2[3], __m256 best, __m256* outT)
+{
+	__m256 hx = _mm256_sub_ps(_mm256_mul_ps(dir[1], e2[2]), _mm256_mul_ps(dir[2], e2[1]));
+	__m256 hy = _mm256_sub_ps(_mm256_mul_ps(dir[2], e2[0]), _mm256_mul_ps(dir[0], e2[2]));
+	__m256 hz = _mm256_sub_ps(_mm256_mul_ps(dir[0], e2[1]), _mm256_mul_ps(dir[1], e2[0]));
+	__m256 a  = Dot_AVX(e1[0], e1[1], e1[2], hx, hy, hz);
+	__m256 f  = _mm256_div_ps(_mm256_set1_ps(1), a);
+
+	__m256 sx = _mm256_sub_ps(start[0], v0[0]);
+	__m256 sy = _mm256_sub_ps(start[1], v0[1]);
+	__m256 sz = _mm256_sub_ps(start[2], v0[2]);
+	__m256 u  = _mm256_mul_ps(f, Dot_AVX(sx, sy, sz, hx, hy, hz));
+
+	__m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1[2]), _mm256_mul_ps(sz, e1[1]));
+	__m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1[0]), _mm256_mul_ps(sx, e1[2]));
+	__m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1[1]), _mm256_mul_ps(sy, e1[0]));
+	__m256 v  = _mm256_mul_ps(f, Dot_AVX(dir[0], dir[1], dir[2], qx, qy, qz));
+	__m256 t  = _mm256_mul_ps(f, Dot_AVX(e2[0], e2[1], e2[2], qx, qy, qz));
+
+	__m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1), eps = _mm256_set1_ps(epsilon);
+
+	__m256 ok = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a), eps, _CMP_GT_OQ);
+	ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+	ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ),
+	                                     _mm256_cmp_ps(v, _mm256_sub_ps(one, u), _CMP_LE_OQ)));
+	ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(t, eps, _CMP_GE_OQ), _mm256_cmp_ps(t, best, _CMP_LT_OQ)));
+
+	*outT = t;
+	return ok;
+}
+
+// Two neighbouring blocks as one 8 wide vector.
+__attribute__((target("avx"))) static inline __m256 Load_Blocks(const r32* lo, const r32* hi)
 {
-	// 1. Split world into octree.
-	for(u32 i = 0; i < world->Objects.Size; i++) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+}
+
+// TriRay_Block4(), on two blocks at once.
+__attribute__((target("avx"))) static i32 TriRay_Block8(const TriHull_TriBlock* b, Ray ray, r32* best)
+{
+	__m256 start[3] = { _mm256_set1_ps(ray.Start.x), _mm256_set1_ps(ray.Start.y), _mm256_set1_ps(ray.Start.z) };
+	__m256 dir[3]   = { _mm256_set1_ps(ray.Dir.x), _mm256_set1_ps(ray.Dir.y), _mm256_set1_ps(ray.Dir.z) };
+	__m256 v0[3]    = { Load_Blocks(b[0].V0[0], b[1].V0[0]), Load_Blocks(b[0].V0[1], b[1].V0[1]), Load_Blocks(b[0].V0[2], b[1].V0[2]) };
+	__m256 e1[3]    = { Load_Blocks(b[0].E1[0], b[1].E1[0]), Load_Blocks(b[0].E1[1], b[1].E1[1]), Load_Blocks(b[0].E1[2], b[1].E1[2]) };
+	__m256 e2[3]    = { Load_Blocks(b[0].E2[0], b[1].E2[0]), Load_Blocks(b[0].E2[1], b[1].E2[1]), Load_Blocks(b[0].E2[2], b[1].E2[2]) };
+
+	__m256 t;
+	__m256 ok = TriRay_Test_AVX(start, dir, v0, e1, e2, _mm256_set1_ps(*best), &t);
+	if(!_mm256_movemask_ps(ok))
+		return -1;
+
+	t = _mm256_blendv_ps(_mm256_set1_ps(FLT_MAX), t, ok);
+	__m256 m = _mm256_min_ps(t, _mm256_permute2f128_ps(t, t, 1));
+	m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+	u32 mask = _mm256_movemask_ps(_mm256_and_ps(ok, _mm256_cmp_ps(t, m, _CMP_EQ_OQ)));
+	i32 lane = 0;
+	while(!(mask & 1)) {
+		mask >>= 1;
+		lane++;
 	}
-	// 2. Do broadphase collision, mark any potential hits for narrowphase.
-	// 3. Do narrowphase collision, actually see if objects collide.
-	// 4. Apply forces based on delta time
+
+	*best = _mm256_cvtss_f32(m);
+	return lane;
+}
+
+// TriRay_Packet4(), on the whole packet at once.
+__attribute__((target("avx"))) static void TriRay_Packet8(TriRay_Packet* p, const TriHull_TriBlock* b, u32 j, i32 index)
+{
+	__m256 start[3] = { _mm256_loadu_ps(p->Start[0]), _mm256_loadu_ps(p->Start[1]), _mm256_loadu_ps(p->Start[2]) };
+	__m256 dir[3]   = { _mm256_loadu_ps(p->Dir[0]), _mm256_loadu_ps(p->Dir[1]), _mm256_loadu_ps(p->Dir[2]) };
+	__m256 v0[3]    = { _mm256_set1_ps(b->V0[0][j]), _mm256_set1_ps(b->V0[1][j]), _mm256_set1_ps(b->V0[2][j]) };
+	__m256 e1[3]    = { _mm256_set1_ps(b->E1[0][j]), _mm256_set1_ps(b->E1[1][j]), _mm256_set1_ps(b->E1[2][j]) };
+	__m256 e2[3]    = { _mm256_set1_ps(b->E2[0][j]), _mm256_set1_ps(b->E2[1][j]), _mm256_set1_ps(b->E2[2][j]) };
+
+	__m256 t, best = _mm256_loadu_ps(p->Best);
+	__m256 ok = TriRay_Test_AVX(start, dir, v0, e1, e2, best, &t);
+	if(!_mm256_movemask_ps(ok))
+		return;
+
+	__m256 hit = _mm256_loadu_ps((const r32*) p->Hit);
+	_mm256_storeu_ps(p->Best, _mm256_blendv_ps(best, t, ok));
+	_mm256_storeu_ps((r32*) p->Hit, _mm256_blendv_ps(hit, _mm256_castsi256_ps(_mm256_set1_epi32(index)), ok));
+}
+#endif // PHYS_HAS_AVX
+
+// One triangle, ready to be tested against blocks of triangles by TriTri_Block4().
+typedef struct {
+	Vec3 V[3];
+	Vec3 E1, E2, N;
+	r32 Tolerance;
+} TriTri_Query;
+
+static inline TriTri_Query TriTri_Prepare(const Vec3 tri[3])
+{
+	TriTri_Query q = { .V = { tri[0], tri[1], tri[2] } };
+	q.E1 = Vec3_Sub(tri[1], tri[0]);
+	q.E2 = Vec3_Sub(tri[2], tri[0]);
+	q.N  = TriTri_Cross(q.E1, q.E2);
+
+	q.Tolerance = planeEpsilon * sqrtf(TriTri_Dot(q.N, q.N));
+	return q;
+}
+
+static inline __m128 Snap_SSE(__m128 d, __m128 tolerance)
+{
+	return _mm_andnot_ps(_mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), d), tolerance), d);
+}
+
+// One edge of TriTri_Interval() for 4 triangles, without the points.
+static inline void TriTri_Edge_SSE(__m128 di, __m128 dj, __m128 pi, __m128 pj, __m128* lo, __m128* hi)
+{
+	__m128 cross = _mm_and_ps(_mm_cmple_ps(_mm_mul_ps(di, dj), _mm_setzero_ps()), _mm_cmpneq_ps(di, dj));
+
+	__m128 f = _mm_div_ps(di, _mm_sub_ps(di, dj));
+	__m128 t = _mm_add_ps(pi, _mm_mul_ps(_mm_sub_ps(pj, pi), f));
+
+	*lo = _mm_min_ps(*lo, _mm_or_ps(_mm_and_ps(cross, t), _mm_andnot_ps(cross, _mm_set1_ps(FLT_MAX))));
+	*hi = _mm_max_ps(*hi, _mm_or_ps(_mm_and_ps(cross, t), _mm_andnot_ps(cross, _mm_set1_ps(-FLT_MAX))));
+}
+
+static inline __m128 TriTri_Overlap_SSE(__m128 da0, __m128 da1, __m128 da2, __m128 p1, __m128 p2,
+                                        __m128 db0, __m128 db1, __m128 db2, __m128 q0, __m128 q1, __m128 q2)
+{
+	__m128 zero = _mm_setzero_ps();
+	__m128 loA = _mm_set1_ps(FLT_MAX), hiA = _mm_set1_ps(-FLT_MAX);
+	__m128 loB = loA, hiB = hiA;
+
+	TriTri_Edge_SSE(da0, da1, zero, p1, &loA, &hiA);
+	TriTri_Edge_SSE(da1, da2, p1, p2, &loA, &hiA);
+	TriTri_Edge_SSE(da2, da0, p2, zero, &loA, &hiA);
+
+	TriTri_Edge_SSE(db0, db1, q0, q1, &loB, &hiB);
+	TriTri_Edge_SSE(db1, db2, q1, q2, &loB, &hiB);
+	TriTri_Edge_SSE(db2, db0, q2, q0, &loB, &hiB);
+
+	return _mm_cmple_ps(_mm_max_ps(loA, loB), _mm_min_ps(hiA, hiB));
+}
+
+// TriTri_Intersect() of one triangle against the first `count` triangles in a block.
+// Returns a bit for every one that's either hit or in the same plane, TriTri_Intersect()
+// gives the same answer for the hits and settles the coplanar ones exactly.
+static inline u32 TriTri_Block4(const TriTri_Query* a, const TriHull_TriBlock* b, u32 count)
+{
+	__m128 b0[3]  = { _mm_loadu_ps(b->V0[0]), _mm_loadu_ps(b->V0[1]), _mm_loadu_ps(b->V0[2]) };
+	__m128 eb1[3] = { _mm_loadu_ps(b->E1[0]), _mm_loadu_ps(b->E1[1]), _mm_loadu_ps(b->E1[2]) };
+	__m128 eb2[3] = { _mm_loadu_ps(b->E2[0]), _mm_loadu_ps(b->E2[1]), _mm_loadu_ps(b->E2[2]) };
+	__m128 n1[3]  = { _mm_set1_ps(a->N.x), _mm_set1_ps(a->N.y), _mm_set1_ps(a->N.z) };
+	__m128 w[3]   = {
+		_mm_sub_ps(b0[0], _mm_set1_ps(a->V[0].x)),
+		_mm_sub_ps(b0[1], _mm_set1_ps(a->V[0].y)),
+		_mm_sub_ps(b0[2], _mm_set1_ps(a->V[0].z)),
+	};
+
+	__m128 n2x = _mm_sub_ps(_mm_mul_ps(eb1[1], eb2[2]), _mm_mul_ps(eb1[2], eb2[1]));
+	__m128 n2y = _mm_sub_ps(_mm_mul_ps(eb1[2], eb2[0]), _mm_mul_ps(eb1[0], eb2[2]));
+	__m128 n2z = _mm_sub_ps(_mm_mul_ps(eb1[0], eb2[1]), _mm_mul_ps(eb1[1], eb2[0]));
+
+	__m128 tolA = _mm_set1_ps(a->Tolerance);
+	__m128 tolB = _mm_mul_ps(_mm_set1_ps(planeEpsilon), _mm_sqrt_ps(Dot_SSE(n2x, n2y, n2z, n2x, n2y, n2z)));
+
+#define DIST(v) Snap_SSE(Dot_SSE(n2x, n2y, n2z, _mm_sub_ps(_mm_set1_ps(v.x), b0[0]), \
+                                   _mm_sub_ps(_mm_set1_ps(v.y), b0[1]), _mm_sub_ps(_mm_set1_ps(v.z), b0[2])), tolB)
+	__m128 da[3] = { DIST(a->V[0]), DIST(a->V[1]), DIST(a->V[2]) }, db[3];
+#undef DIST
+
+	db[0] = Dot_SSE(n1[0], n1[1], n1[2], w[0], w[1], w[2]);
+	db[1] = Snap_SSE(_mm_add_ps(db[0], Dot_SSE(n1[0], n1[1], n1[2], eb1[0], eb1[1], eb1[2])), tolA);
+	db[2] = Snap_SSE(_mm_add_ps(db[0], Dot_SSE(n1[0], n1[1], n1[2], eb2[0], eb2[1], eb2[2])), tolA);
+	db[0] = Snap_SSE(db[0], tolA);
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 reject = _mm_or_ps(
+		_mm_and_ps(_mm_cmpgt_ps(_mm_mul_ps(da[0], da[1]), zero), _mm_cmpgt_ps(_mm_mul_ps(da[0], da[2]), zero)),
+		_mm_and_ps(_mm_cmpgt_ps(_mm_mul_ps(db[0], db[1]), zero), _mm_cmpgt_ps(_mm_mul_ps(db[0], db[2]), zero)));
+	__m128 coplanar = _mm_or_ps(
+		_mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(da[0], zero), _mm_cmpeq_ps(da[1], zero)), _mm_cmpeq_ps(da[2], zero)),
+		_mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(db[0], zero), _mm_cmpeq_ps(db[1], zero)), _mm_cmpeq_ps(db[2], zero)));
+
+	__m128 dx = _mm_sub_ps(_mm_mul_ps(n1[1], n2z), _mm_mul_ps(n1[2], n2y));
+	__m128 dy = _mm_sub_ps(_mm_mul_ps(n1[2], n2x), _mm_mul_ps(n1[0], n2z));
+	__m128 dz = _mm_sub_ps(_mm_mul_ps(n1[0], n2y), _mm_mul_ps(n1[1], n2x));
+
+	__m128 p1 = Dot_SSE(dx, dy, dz, _mm_set1_ps(a->E1.x), _mm_set1_ps(a->E1.y), _mm_set1_ps(a->E1.z));
+	__m128 p2 = Dot_SSE(dx, dy, dz, _mm_set1_ps(a->E2.x), _mm_set1_ps(a->E2.y), _mm_set1_ps(a->E2.z));
+	__m128 q0 = Dot_SSE(dx, dy, dz, w[0], w[1], w[2]);
+	__m128 q1 = _mm_add_ps(q0, Dot_SSE(dx, dy, dz, eb1[0], eb1[1], eb1[2]));
+	__m128 q2 = _mm_add_ps(q0, Dot_SSE(dx, dy, dz, eb2[0], eb2[1], eb2[2]));
+
+	__m128 overlap = TriTri_Overlap_SSE(da[0], da[1], da[2], p1, p2, db[0], db[1], db[2], q0, q1, q2);
+
+	u32 mask = _mm_movemask_ps(_mm_andnot_ps(reject, _mm_or_ps(coplanar, overlap)));
+	return mask & ((1u << count) - 1);
+}
+
+// Closest triangle for every ray of the packet, indices go into Hit and distances into Best.
+static void TriHull_PacketClosest(const TriHull_BVH* bvh, TriRay_Packet* p)
+{
+#ifdef PHYS_HAS_AVX
+	bool8 avx = Phys_HasAVX();
+#endif
+
+	u32 stack[TRIHULL_BVH_MAX_DEPTH + 2];
+	u32 size = 0;
+
+	r32 t = FLT_MAX;
+	if(TriRay_PacketHitsBox4(p, 0, &bvh->Nodes[0].Box, &t) | TriRay_PacketHitsBox4(p, 4, &bvh->Nodes[0].Box, &t))
+		stack[size++] = 0;
+
+	while(size) {
+		const TriHull_BVHNode* n = &bvh->Nodes[stack[--size]];
+
+		if(n->Count) {
+			for(u32 i = n->Index; i < n->Index + n->Count; i++) {
+				const TriHull_TriBlock* b = &bvh->Blocks[i / 4];
+#ifdef PHYS_HAS_AVX
+				if(avx) {
+					TriRay_Packet8(p, b, i % 4, i);
+					continue;
+				}
+#endif
+				TriRay_Packet4(p, 0, b, i % 4, i);
+				TriRay_Packet4(p, 4, b, i % 4, i);
+			}
+			continue;
+		}
+
+		u32 c1 = (u32) (n - bvh->Nodes) + 1, c2 = n->Index;
+		r32 t1 = FLT_MAX, t2 = FLT_MAX;
+		bool8 hit1 = (TriRay_PacketHitsBox4(p, 0, &bvh->Nodes[c1].Box, &t1) | TriRay_PacketHitsBox4(p, 4, &bvh->Nodes[c1].Box, &t1)) != 0;
+		bool8 hit2 = (TriRay_PacketHitsBox4(p, 0, &bvh->Nodes[c2].Box, &t2) | TriRay_PacketHitsBox4(p, 4, &bvh->Nodes[c2].Box, &t2)) != 0;
+
+		// Whichever child the packet gets to first goes on top.
+		if(hit1 && hit2) {
+			stack[size++] = (t1 <= t2 ? c2 : c1);
+			stack[size++] = (t1 <= t2 ? c1 : c2);
+		} else if(hit1) {
+			stack[size++] = c1;
+		} else if(hit2) {
+			stack[size++] = c2;
+		}
+	}
+}
+#endif // PHYS_HAS_SSE
+
+// Closest triangle in a leaf that's closer than `best`, or -1.
+static inline i32 TriHull_LeafClosest(const TriHull_BVH* bvh, const TriHull_BVHNode* n, Ray ray, r32* best)
+{
+	i32 hit = -1;
+
+#ifdef PHYS_HAS_SSE
+	const TriHull_TriBlock* b = &bvh->Blocks[n->Index / 4];
+	u32 numBlocks = TRIHULL_BLOCKS(n->Count), i = 0;
+
+#ifdef PHYS_HAS_AVX
+	if(numBlocks > 1 && Phys_HasAVX()) {
+		for(; i + 2 <= numBlocks; i += 2) {
+			i32 lane = TriRay_Block8(&b[i], ray, best);
+			if(lane >= 0)
+				hit = n->Index + i * 4 + lane;
+		}
+	}
+#endif
+
+	for(; i < numBlocks; i++) {
+		i32 lane = TriRay_Block4(&b[i], ray, best);
+		if(lane >= 0)
+			hit = n->Index + i * 4 + lane;
+	}
+#else
+	for(u32 i = n->Index; i < n->Index + n->Count; i++) {
+		Intersection res = TriRay_Intersect(&bvh->Tris[i * 3], ray);
+		if(res.Occurred && res.T < *best) {
+			*best = res.T;
+			hit   = i;
+		}
+	}
+#endif
+
+	return hit;
+}
+
+// Closest triangle along a ray in local space, before maxT. Returns its index or -1.
+static i32 TriHull_RayClosest(const TriHull* hull, Ray ray, r32 maxT, r32* outT)
+{
+	r32 best = maxT;
+	i32 hit  = -1;
+
+	const TriHull_BVH* bvh = hull->BVH;
+	if(!bvh) {
+		for(u32 i = 0; i < hull->NumTris; i++) {
+			Intersection res = TriRay_Intersect(&hull->TriPoints[i * 3], ray);
+			if(res.Occurred && res.T < best) {
+				best = res.T;
+				hit  = i;
+			}
+		}
+
+		*outT = best;
+		return hit;
+	}
+
+	Vec3 invDir = V3C(1.0f / ray.Dir.x, 1.0f / ray.Dir.y, 1.0f / ray.Dir.z);
+
+	// Each level pushes at most one node, the far child.
+	u32 stack[TRIHULL_BVH_MAX_DEPTH + 2];
+	u32 size = 0;
+
+	r32 t;
+	if(Ray_HitsBox(ray.Start, invDir, &bvh->Nodes[0].Box, best, &t))
+		stack[size++] = 0;
+
+	while(size) {
+		const TriHull_BVHNode* n = &bvh->Nodes[stack[--size]];
+
+		if(n->Count) {
+			i32 leafHit = TriHull_LeafClosest(bvh, n, ray, &best);
+			if(leafHit >= 0)
+				hit = leafHit;
+			continue;
+		}
+
+		u32 c1 = (u32) (n - bvh->Nodes) + 1, c2 = n->Index;
+		r32 t1, t2;
+		bool8 hit1 = Ray_HitsBox(ray.Start, invDir, &bvh->Nodes[c1].Box, best, &t1);
+		bool8 hit2 = Ray_HitsBox(ray.Start, invDir, &bvh->Nodes[c2].Box, best, &t2);
+
+		// Near child on top, so the far one usually gets skipped.
+		if(hit1 && hit2) {
+			stack[size++] = (t1 <= t2 ? c2 : c1);
+			stack[size++] = (t1 <= t2 ? c1 : c2);
+		} else if(hit1) {
+			stack[size++] = c1;
+		} else if(hit2) {
+			stack[size++] = c2;
+		}
+	}
+
+	*outT = best;
+	return hit;
+}
+
+// Turn a hit from TriHull_RayClosest() into one in world space.
+static Intersection TriHull_RayResult(const TriHull* hull, const Mat4 toLocal, Ray ray, i32 tri, r32 t)
+{
+	if(tri < 0)
+		return (Intersection) { .Occurred = 0 };
+
+	const Vec3* p = (hull->BVH ? hull->BVH->Tris : hull->TriPoints) + tri * 3;
+	Vec3 n = Vec3_Cross(Vec3_Sub(p[1], p[0]), Vec3_Sub(p[2], p[0]));
+
+	// Normals go through the inverse transpose.
+	n = V3(toLocal[0] * n.x + toLocal[4] * n.y + toLocal[8]  * n.z,
+	       toLocal[1] * n.x + toLocal[5] * n.y + toLocal[9]  * n.z,
+	       toLocal[2] * n.x + toLocal[6] * n.y + toLocal[10] * n.z);
+	n = Vec3_Norm(n);
+
+	if(Vec3_Dot(n, ray.Dir) > 0)
+		n = Vec3_Neg(n);
+
+	return (Intersection) {
+		.Occurred = 1,
+		.Point    = Vec3_Add(ray.Start, Vec3_MultScal(ray.Dir, t)),
+		.Normal   = n,
+		.T        = t
+	};
+}
+
+Intersection 
+TriHull_RayIntersect(TriHull hull, Ray ray)
+{
+	Mat4 toWorld, toLocal;
+	TriHull_Space(&hull, toWorld, toLocal);
+
+	// An affine transform doesn't change where along the ray things are,
+	// so T comes back out of local space as it is.
+	Ray local = { .Start = Affine_Point(toLocal, ray.Start), .Dir = Affine_Dir(toLocal, ray.Dir) };
+
+	r32 t;
+	i32 tri = TriHull_RayClosest(&hull, local, FLT_MAX, &t);
+	return TriHull_RayResult(&hull, toLocal, ray, tri, t);
+}
+
+void TriHull_RayIntersectMany(TriHull hull, const Ray* rays, u32 numRays, Intersection* out)
+{
+	Mat4 toWorld, toLocal;
+	TriHull_Space(&hull, toWorld, toLocal);
+
+#ifdef PHYS_HAS_SSE
+	if(hull.BVH) {
+		for(u32 first = 0; first < numRays; first += 8) {
+			u32 count = MIN(numRays - first, 8);
+
+			// Lanes past the last ray point nowhere and start out with a negative best,
+			// so they never hit a box or a triangle.
+			TriRay_Packet p;
+			for(u32 i = 0; i < 8; i++) {
+				Ray local = { .Start = V3(0, 0, 0), .Dir = V3(0, 0, 0) };
+				if(i < count) {
+					local.Start = Affine_Point(toLocal, rays[first + i].Start);
+					local.Dir   = Affine_Dir(toLocal, rays[first + i].Dir);
+				}
+
+				for(u32 c = 0; c < 3; c++) {
+					p.Start[c][i]  = local.Start.d[c];
+					p.Dir[c][i]    = local.Dir.d[c];
+					p.InvDir[c][i] = 1.0f / local.Dir.d[c];
+				}
+				p.Best[i] = (i < count ? FLT_MAX : -1);
+				p.Hit[i]  = -1;
+			}
+
+			TriHull_PacketClosest(hull.BVH, &p);
+
+			for(u32 i = 0; i < count; i++)
+				out[first + i] = TriHull_RayResult(&hull, toLocal, rays[first + i], p.Hit[i], p.Best[i]);
+		}
+		return;
+	}
+#endif
+
+	for(u32 i = 0; i < numRays; i++) {
+		Ray local = { .Start = Affine_Point(toLocal, rays[i].Start), .Dir = Affine_Dir(toLocal, rays[i].Dir) };
+
+		r32 t;
+		i32 tri = TriHull_RayClosest(&hull, local, FLT_MAX, &t);
+		out[i]  = TriHull_RayResult(&hull, toLocal, rays[i], tri, t);
+	}
+}
+
+u32 TriTri_CountHits(const Vec3 tri[3], const Vec3* tris, const TriHull_TriBlock* blocks, u32 count)
+{
+	u32 hits = 0;
+
+#ifdef PHYS_HAS_SSE
+	TriTri_Query q = TriTri_Prepare(tri);
+
+	for(u32 i = 0; i < TRIHULL_BLOCKS(count); i++) {
+		u32 first = i * 4;
+		u32 mask  = TriTri_Block4(&q, &blocks[i], MIN(count - first, 4));
+
+		for(u32 lane = 0; mask; lane++, mask >>= 1)
+			if(mask & 1)
+				hits += TriTri_Intersect(tri, &tris[(first + lane) * 3]).Occurred;
+	}
+#else
+	(void) blocks;
+	for(u32 i = 0; i < count; i++)
+		hits += TriTri_Intersect(tri, &tris[i * 3]).Occurred;
+#endif
+
+	return hits;
+}
+
+// Test one triangle (in the hull's local space) against the triangles of a leaf.
+static Intersection TriHull_LeafTri(const TriHull_BVH* bvh, const TriHull_BVHNode* n, const Vec3 tri[3])
+{
+#ifdef PHYS_HAS_SSE
+	TriTri_Query q = TriTri_Prepare(tri);
+	const TriHull_TriBlock* b = &bvh->Blocks[n->Index / 4];
+	u32 numBlocks = TRIHULL_BLOCKS(n->Count);
+
+	for(u32 i = 0; i < numBlocks; i++) {
+		u32 first = i * 4;
+		u32 mask  = TriTri_Block4(&q, &b[i], MIN(n->Count - first, 4));
+
+		for(u32 lane = 0; mask; lane++, mask >>= 1) {
+			if(!(mask & 1))
+				continue;
+
+			Intersection res = TriTri_Intersect(tri, &bvh->Tris[(n->Index + first + lane) * 3]);
+			if(res.Occurred)
+				return res;
+		}
+	}
+#else
+	for(u32 i = n->Index; i < n->Index + n->Count; i++) {
+		Intersection res = TriTri_Intersect(tri, &bvh->Tris[i * 3]);
+		if(res.Occurred)
+			return res;
+	}
+#endif
+
+	return (Intersection) { .Occurred = 0 };
+}
+
+// Test one triangle (already in X's local space) against the triangles of hull X near it.
+static Intersection TriHull_TriIntersect(const TriHull* x, const Vec3 tri[3])
+{
+	const TriHull_BVH* bvh = x->BVH;
+
+	if(!bvh) {
+		for(u32 i = 0; i < x->NumTris; i++) {
+			Intersection res = TriTri_Intersect(tri, &x->TriPoints[i * 3]);
+			if(res.Occurred)
+				return res;
+		}
+		return (Intersection) { .Occurred = 0 };
+	}
+
+	AABB box = Triangle_Box(tri);
+
+	u32 stack[TRIHULL_BVH_MAX_DEPTH + 2];
+	u32 size = 0;
+	stack[size++] = 0;
+
+	while(size) {
+		u32 id = stack[--size];
+		const TriHull_BVHNode* n = &bvh->Nodes[id];
+
+		if(!Boxes_Overlap(&n->Box, &box))
+			continue;
+
+		if(!n->Count) {
+			stack[size++] = n->Index;
+			stack[size++] = id + 1;
+			continue;
+		}
+
+		Intersection res = TriHull_LeafTri(bvh, n, tri);
+		if(res.Occurred)
+			return res;
+	}
+
+	return (Intersection) { .Occurred = 0 };
+}
+
+Intersection 
+TriHull_Intersect(TriHull a, TriHull b)
+{
+	// Work in the local space of a hull with a BVH, if there is one.
+	if(!a.BVH && b.BVH) {
+		TriHull tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	Mat4 toWorldA, toLocalA, toWorldB, toLocalB;
+	TriHull_Space(&a, toWorldA, toLocalA);
+	TriHull_Space(&b, toWorldB, toLocalB);
+
+	// B's local space -> A's local space.
+	Mat4 bToA;
+	Mat4_Copy(bToA, toLocalA);
+	Mat4_MultMat(bToA, toWorldB);
+
+	Intersection res = { .Occurred = 0 };
+
+	if(a.BVH && b.BVH) {
+		// Walk both trees at once, only going into pairs of nodes that overlap.
+		const TriHull_BVH* ba = a.BVH;
+		const TriHull_BVH* bb = b.BVH;
+
+		u32 stack[(TRIHULL_BVH_MAX_DEPTH + 2) * 2][2];
+		u32 size = 0;
+
+		stack[size][0] = 0;
+		stack[size][1] = 0;
+		size++;
+
+		while(size && !res.Occurred) {
+			size--;
+			u32 ia = stack[size][0], ib = stack[size][1];
+			const TriHull_BVHNode* na = &ba->Nodes[ia];
+			const TriHull_BVHNode* nb = &bb->Nodes[ib];
+
+			AABB boxB = Affine_Box(bToA, nb->Box);
+			if(!Boxes_Overlap(&na->Box, &boxB))
+				continue;
+
+			if(na->Count && nb->Count) {
+				for(u32 j = nb->Index; j < nb->Index + nb->Count && !res.Occurred; j++) {
+					Vec3 tri[3];
+					for(u32 p = 0; p < 3; p++)
+						tri[p] = Affine_Point(bToA, bb->Tris[j * 3 + p]);
+
+					res = TriHull_LeafTri(ba, na, tri);
+				}
+				continue;
+			}
+
+			// Go down the bigger one.
+			if(!na->Count && (nb->Count || AABB_Area(na->Box) >= AABB_Area(boxB))) {
+				stack[size][0] = na->Index; stack[size][1] = ib; size++;
+				stack[size][0] = ia + 1;    stack[size][1] = ib; size++;
+			} else {
+				stack[size][0] = ia; stack[size][1] = nb->Index; size++;
+				stack[size][0] = ia; stack[size][1] = ib + 1;    size++;
+			}
+		}
+	} else {
+		for(u32 j = 0; j < b.NumTris && !res.Occurred; j++) {
+			Vec3 tri[3];
+			for(u32 p = 0; p < 3; p++)
+				tri[p] = Affine_Point(bToA, b.TriPoints[j * 3 + p]);
+
+			res = TriHull_TriIntersect(&a, tri);
+		}
+	}
+
+	if(!res.Occurred)
+		return (Intersection) { .Occurred = 0 };
+
+	res.Point = Affine_Point(toWorldA, res.Point);
+	return res;
+}
+
+//
+// Convex shapes
+//
+
+// Thank you,
+// https://box2d.org/files/ErinCatto_GJK_GDC2010.pdf
+// https://github.com/erincatto/box2d/blob/v2.4.1/src/collision/b2_distance.cpp
+//
+// GJK only ever looks at the cores of the shapes: a sphere's center, a capsule's
+// segment, a box's corners and a hull's points. Those can all be numbered, so the
+// simplex can be kept between frames as a handful of indices, like Box2D does.
+// The radius of spheres and capsules is added on at the end.
+
+#define GJK_MAX_ITERATIONS 32
+#define EPA_MAX_VERTICES   64
+#define EPA_MAX_FACES      (EPA_MAX_VERTICES * 2)
+
+// GJK stops once a step gets it less than this much (relatively) closer.
+static const r32 gjkTolerance = 1e-5;
+
+// EPA stops once the polytope is this close to the real surface, relative to the depth.
+static const r32 epaTolerance = 1e-4;
+
+PhysShape PhysShape_Sphere(r32 radius)
+{
+	return (PhysShape) { .Type = PhysShapeType_Sphere, .Radius = radius };
+}
+
+PhysShape PhysShape_Box(Vec3 halfExtents)
+{
+	return (PhysShape) { .Type = PhysShapeType_Box, .HalfExtents = halfExtents };
+}
+
+PhysShape PhysShape_Capsule(r32 radius, r32 halfHeight)
+{
+	return (PhysShape) { .Type = PhysShapeType_Capsule, .Radius = radius, .HalfHeight = halfHeight };
+}
+
+typedef struct {
+	Vec3 P;
+	u32 Corner;
+} PhysShape_Corner;
+
+static i32 PhysShape_Corner_Compare(const void* a, const void* b)
+{
+	const PhysShape_Corner* ca = a;
+	const PhysShape_Corner* cb = b;
+
+	for(u32 i = 0; i < 3; i++) {
+		if(ca->P.d[i] != cb->P.d[i])
+			return ca->P.d[i] < cb->P.d[i] ? -1 : 1;
+	}
+	return 0;
+}
+
+static i32 u32_Compare(const void* a, const void* b)
+{
+	u32 ua = *(const u32*) a, ub = *(const u32*) b;
+	return (ua > ub) - (ua < ub);
+}
+
+// Every point has to be on the same side of every triangle for the mesh to be convex.
+static bool8 TriHull_IsConvex(const TriHull* hull, const Vec3* points, u32 numPoints)
+{
+	AABB box = PhysShape_AABB(&(PhysShape) { .Type = PhysShapeType_Convex, .Points = (Vec3*) points, .NumPoints = numPoints });
+	r32 size = Vec3_Len(Vec3_Sub(box.Max, box.Min));
+
+	for(u32 i = 0; i < hull->NumTris; i++) {
+		const Vec3* t = &hull->TriPoints[i * 3];
+		Vec3 n  = Vec3_Cross(Vec3_Sub(t[1], t[0]), Vec3_Sub(t[2], t[0]));
+		r32 len = Vec3_Len(n);
+
+		// Slivers don't have a plane worth checking against.
+		if(len <= 1e-6f * size * size)
+			continue;
+
+		r32 d         = Vec3_Dot(n, t[0]);
+		r32 tolerance = 1e-5f * len * size;
+		bool8 above = 0, below = 0;
+
+		for(u32 j = 0; j < numPoints && !(above && below); j++) {
+			r32 side = Vec3_Dot(n, points[j]) - d;
+			above |= (side > tolerance);
+			below |= (side < -tolerance);
+		}
+
+		if(above && below)
+			return 0;
+	}
+
+	return 1;
+}
+
+PhysShape PhysShape_FromTriHull(const TriHull* hull)
+{
+	if(!hull->NumTris)
+		return (PhysShape) { .Type = PhysShapeType_None };
+
+	// Only the points matter, the furthest one along any direction
+	// is always a corner of their convex hull anyway.
+	u32 n = hull->NumTris * 3;
+	PhysShape_Corner* corners = Allocate(sizeof(PhysShape_Corner) * n);
+	for(u32 i = 0; i < n; i++)
+		corners[i] = (PhysShape_Corner) { .P = hull->TriPoints[i], .Corner = i };
+	qsort(corners, n, sizeof(PhysShape_Corner), PhysShape_Corner_Compare);
+
+	Vec3* points = Allocate(sizeof(Vec3) * n);
+	u32* pointOf = Allocate(sizeof(u32) * n); // Triangle corner -> point
+	u32 numPoints = 0;
+
+	for(u32 i = 0; i < n; i++) {
+		if(!i || PhysShape_Corner_Compare(&corners[i], &corners[i - 1]))
+			points[numPoints++] = corners[i].P;
+		pointOf[corners[i].Corner] = numPoints - 1;
+	}
+	Free(corners);
+
+	PhysShape shape = {
+		.Type      = PhysShapeType_Convex,
+		.Points    = Reallocate(points, sizeof(Vec3) * numPoints),
+		.NumPoints = numPoints,
+	};
+
+	// On a closed convex mesh, walking along the edges towards whichever neighbour is further
+	// along a direction always ends up at the furthest point, without having to look at all of them.
+	if(TriHull_IsConvex(hull, shape.Points, numPoints)) {
+		u32* start = Allocate(sizeof(u32) * (numPoints + 1));
+		memset(start, 0, sizeof(u32) * (numPoints + 1));
+
+		for(u32 i = 0; i < n; i++)
+			start[pointOf[i] + 1] += 2;
+		for(u32 i = 0; i < numPoints; i++)
+			start[i + 1] += start[i];
+
+		u32* neighbours = Allocate(sizeof(u32) * n * 2);
+		u32* fill       = Allocate(sizeof(u32) * numPoints);
+		memcpy(fill, start, sizeof(u32) * numPoints);
+
+		for(u32 i = 0; i < n; i += 3) {
+			for(u32 j = 0; j < 3; j++) {
+				u32 p = pointOf[i + j];
+				neighbours[fill[p]++] = pointOf[i + (j + 1) % 3];
+				neighbours[fill[p]++] = pointOf[i + (j + 2) % 3];
+			}
+		}
+
+		// Every edge shows up once for each triangle next to it, and collapsed
+		// triangles point back at themselves. Pack what's left.
+		// An edge with an odd number of triangles is on a hole or a seam that wasn't
+		// welded, and walking could get stuck on one side of it.
+		u32 packed  = 0;
+		bool8 sealed = 1;
+
+		for(u32 i = 0; i < numPoints; i++) {
+			u32* list = &neighbours[start[i]];
+			u32 count = start[i + 1] - start[i];
+			qsort(list, count, sizeof(u32), u32_Compare);
+
+			start[i] = packed;
+			for(u32 j = 0; j < count;) {
+				u32 k = j + 1;
+				while(k < count && list[k] == list[j])
+					k++;
+
+				if(list[j] != i) {
+					sealed &= !((k - j) & 1);
+					neighbours[packed++] = list[j];
+				}
+				j = k;
+			}
+		}
+		start[numPoints] = packed;
+		Free(fill);
+
+		if(sealed) {
+			shape.Neighbours     = Reallocate(neighbours, sizeof(u32) * packed);
+			shape.NeighbourStart = start;
+		} else {
+			Free(neighbours);
+			Free(start);
+		}
+	}
+
+	Free(pointOf);
+	return shape;
+}
+
+void PhysShape_Free(PhysShape* shape)
+{
+	if(shape->Type == PhysShapeType_Convex) {
+		Free(shape->Points);
+		if(shape->Neighbours) {
+			Free(shape->Neighbours);
+			Free(shape->NeighbourStart);
+		}
+	}
+
+	*shape = (PhysShape) { .Type = PhysShapeType_None };
+}
+
+static u32 PhysShape_NumVertices(const PhysShape* s)
+{
+	switch(s->Type) {
+		case PhysShapeType_Sphere:  return 1;
+		case PhysShapeType_Capsule: return 2;
+		case PhysShapeType_Box:     return 8;
+		case PhysShapeType_Convex:  return s->NumPoints;
+		default:                return 0;
+	}
+}
+
+// A corner of the shape's core, in local space.
+static inline Vec3 PhysShape_Vertex(const PhysShape* s, u32 index)
+{
+	switch(s->Type) {
+		case PhysShapeType_Capsule:
+			return V3(0, index ? s->HalfHeight : -s->HalfHeight, 0);
+		case PhysShapeType_Box:
+			return V3((index & 1) ? s->HalfExtents.x : -s->HalfExtents.x,
+			          (index & 2) ? s->HalfExtents.y : -s->HalfExtents.y,
+			          (index & 4) ? s->HalfExtents.z : -s->HalfExtents.z);
+		case PhysShapeType_Convex:
+			return s->Points[index];
+		default:
+			return V3(0, 0, 0);
+	}
+}
+
+// Walk from `start` towards whichever neighbour is further along, until none of them are.
+static u32 PhysShape_Climb(const PhysShape* s, Vec3 dir, u32 start)
+{
+	u32 best    = start;
+	r32 bestDot = Vec3_Dot(s->Points[best], dir);
+
+	for(;;) {
+		u32 next = best;
+		for(u32 i = s->NeighbourStart[best]; i < s->NeighbourStart[best + 1]; i++) {
+			r32 d = Vec3_Dot(s->Points[s->Neighbours[i]], dir);
+			if(d > bestDot) {
+				bestDot = d;
+				next    = s->Neighbours[i];
+			}
+		}
+
+		if(next == best)
+			return best;
+		best = next;
+	}
+}
+
+// The corner of the core furthest along `dir`. Hulls with neighbours start looking from `hint`.
+static inline u32 PhysShape_SupportIndex(const PhysShape* s, Vec3 dir, u32 hint)
+{
+	switch(s->Type) {
+		case PhysShapeType_Capsule:
+			return dir.y >= 0;
+		case PhysShapeType_Box:
+			return (dir.x >= 0) | (dir.y >= 0) << 1 | (dir.z >= 0) << 2;
+		case PhysShapeType_Convex: {
+			if(s->Neighbours)
+				return PhysShape_Climb(s, dir, hint < s->NumPoints ? hint : 0);
+
+			u32 best    = 0;
+			r32 bestDot = -FLT_MAX;
+			for(u32 i = 0; i < s->NumPoints; i++) {
+				r32 d = Vec3_Dot(s->Points[i], dir);
+				if(d > bestDot) {
+					bestDot = d;
+					best    = i;
+				}
+			}
+			return best;
+		}
+		default:
+			return 0;
+	}
+}
+
+Vec3 PhysShape_Support(const PhysShape* shape, Vec3 dir)
+{
+	Vec3 p = PhysShape_Vertex(shape, PhysShape_SupportIndex(shape, dir, 0));
+
+	r32 len = Vec3_Len(dir);
+	if(shape->Radius > 0 && len > 0)
+		p = Vec3_Add(p, Vec3_MultScal(dir, shape->Radius / len));
+	return p;
+}
+
+AABB PhysShape_AABB(const PhysShape* shape)
+{
+	Vec3 r = V3(shape->Radius, shape->Radius, shape->Radius);
+
+	switch(shape->Type) {
+		case PhysShapeType_Capsule:
+			r.y += shape->HalfHeight;
+			break;
+		case PhysShapeType_Box:
+			r = shape->HalfExtents;
+			break;
+		case PhysShapeType_Convex: {
+			AABB box = { .Min = shape->Points[0], .Max = shape->Points[0] };
+			for(u32 i = 1; i < shape->NumPoints; i++)
+				box = AABB_Union(box, (AABB) { .Min = shape->Points[i], .Max = shape->Points[i] });
+			return box;
+		}
+		default:
+			break;
+	}
+
+	return (AABB) { .Min = Vec3_Neg(r), .Max = r };
+}
+
+// A shape placed in the world.
+typedef struct {
+	const PhysShape* Shape;
+	Mat4 ToWorld;
+	r32 Radius; // In world space, scaled by the biggest of the three scales.
+	u32 Hint;   // The last support point, where climbing starts from next time.
+} GJK_Proxy;
+
+static void GJK_Proxy_Init(GJK_Proxy* p, const PhysShape* shape, const Transform3D* t)
+{
+	p->Shape  = shape;
+	p->Radius = shape->Radius;
+	p->Hint   = 0;
+
+	if(t) {
+		Affine_FromTransform(t, p->ToWorld);
+		p->Radius *= MAX3(fabsf(t->Scale.x), fabsf(t->Scale.y), fabsf(t->Scale.z));
+	} else {
+		Mat4_Identity(p->ToWorld);
+	}
+}
+
+static inline u32 GJK_Proxy_Support(GJK_Proxy* p, Vec3 dir)
+{
+	// Into local space with the transposed 3x3 part, which gets scaling right too.
+	const r32* m = p->ToWorld;
+	Vec3 local = V3(m[0] * dir.x + m[4] * dir.y + m[8]  * dir.z,
+	                m[1] * dir.x + m[5] * dir.y + m[9]  * dir.z,
+	                m[2] * dir.x + m[6] * dir.y + m[10] * dir.z);
+
+	p->Hint = PhysShape_SupportIndex(p->Shape, local, p->Hint);
+	return p->Hint;
+}
+
+typedef struct {
+	Vec3 A, B; // Points on A's and B's cores, in world space.
+	Vec3 W;    // B - A, a point on the Minkowski difference.
+	r32 L;     // Weight of this vertex in the closest point.
+	u32 IndexA, IndexB;
+} GJK_Vertex;
+
+typedef struct {
+	GJK_Vertex V[4];
+	u32 Count;
+} GJK_Simplex;
+
+static inline GJK_Vertex GJK_MakeVertex(const GJK_Proxy* a, const GJK_Proxy* b, u32 ia, u32 ib)
+{
+	GJK_Vertex v = { .IndexA = ia, .IndexB = ib, .L = 1 };
+	v.A = Affine_Point(a->ToWorld, PhysShape_Vertex(a->Shape, ia));
+	v.B = Affine_Point(b->ToWorld, PhysShape_Vertex(b->Shape, ib));
+	v.W = Vec3_Sub(v.B, v.A);
+	return v;
+}
+
+// The point of the Minkowski difference furthest along `dir`.
+static inline GJK_Vertex GJK_Support(GJK_Proxy* a, GJK_Proxy* b, Vec3 dir)
+{
+	return GJK_MakeVertex(a, b, GJK_Proxy_Support(a, Vec3_Neg(dir)), GJK_Proxy_Support(b, dir));
+}
+
+// Which vertices of the simplex the closest point to the origin is made of, and how much of each.
+typedef struct {
+	u32 Count; // 4 means the origin is inside the tetrahedron.
+	u32 Keep[3];
+	r32 L[3];
+} GJK_Closest;
+
+static inline r32 GJK_Ratio(r64 n, r64 d) { return (d > 0 ? n / d : 0); }
+
+static GJK_Closest GJK_Segment(const GJK_Simplex* s, u32 ia, u32 ib)
+{
+	Vec3 a  = s->V[ia].W;
+	Vec3 ab = Vec3_Sub(s->V[ib].W, a);
+	r32 t   = GJK_Ratio(-Vec3_Dot(a, ab), Vec3_Dot(ab, ab));
+
+	if(t <= 0)
+		return (GJK_Closest) { 1, { ia }, { 1 } };
+	if(t >= 1)
+		return (GJK_Closest) { 1, { ib }, { 1 } };
+	return (GJK_Closest) { 2, { ia, ib }, { 1 - t, t } };
+}
+
+static inline Vec3 GJK_Point(const GJK_Simplex* s, const GJK_Closest* c)
+{
+	Vec3 p = V3(0, 0, 0);
+	for(u32 i = 0; i < c->Count; i++)
+		p = Vec3_Add(p, Vec3_MultScal(s->V[c->Keep[i]].W, c->L[i]));
+	return p;
+}
+
+// Thank you,
+// Real-Time Collision Detection (Christer Ericson), 5.1.5
+// Closest point on a triangle, found by checking which Voronoi region the origin is in.
+static inline r64 GJK_Dot64(const r64* a, const r64* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+static GJK_Closest GJK_Triangle(const GJK_Simplex* s, u32 ia, u32 ib, u32 ic)
+{
+	// In doubles, a big shape against a small one makes long thin triangles far from the
+	// origin, and the areas below are small differences between big products.
+	r64 a[3], b[3], c[3], ab[3], ac[3];
+	for(u32 k = 0; k < 3; k++) {
+		a[k]  = s->V[ia].W.d[k];
+		b[k]  = s->V[ib].W.d[k];
+		c[k]  = s->V[ic].W.d[k];
+		ab[k] = b[k] - a[k];
+		ac[k] = c[k] - a[k];
+	}
+
+	r64 d1 = -GJK_Dot64(ab, a), d2 = -GJK_Dot64(ac, a);
+	if(d1 <= 0 && d2 <= 0)
+		return (GJK_Closest) { 1, { ia }, { 1 } };
+
+	r64 d3 = -GJK_Dot64(ab, b), d4 = -GJK_Dot64(ac, b);
+	if(d3 >= 0 && d4 <= d3)
+		return (GJK_Closest) { 1, { ib }, { 1 } };
+
+	r64 vc = d1 * d4 - d3 * d2;
+	if(vc <= 0 && d1 >= 0 && d3 <= 0) {
+		r32 t = GJK_Ratio(d1, d1 - d3);
+		return (GJK_Closest) { 2, { ia, ib }, { 1 - t, t } };
+	}
+
+	r64 d5 = -GJK_Dot64(ab, c), d6 = -GJK_Dot64(ac, c);
+	if(d6 >= 0 && d5 <= d6)
+		return (GJK_Closest) { 1, { ic }, { 1 } };
+
+	r64 vb = d5 * d2 - d1 * d6;
+	if(vb <= 0 && d2 >= 0 && d6 <= 0) {
+		r32 t = GJK_Ratio(d2, d2 - d6);
+		return (GJK_Closest) { 2, { ia, ic }, { 1 - t, t } };
+	}
+
+	r64 va = d3 * d6 - d5 * d4;
+	if(va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+		r32 t = GJK_Ratio(d4 - d3, (d4 - d3) + (d5 - d6));
+		return (GJK_Closest) { 2, { ib, ic }, { 1 - t, t } };
+	}
+
+	r64 sum = va + vb + vc;
+	if(sum > 0)
+		return (GJK_Closest) { 3, { ia, ib, ic }, { va / sum, vb / sum, vc / sum } };
+
+	// Flat triangle, one of its edges will have to do.
+	GJK_Closest best = GJK_Segment(s, ia, ib);
+	GJK_Closest edges[2] = { GJK_Segment(s, ia, ic), GJK_Segment(s, ib, ic) };
+	for(u32 i = 0; i < 2; i++) {
+		if(Vec3_Len2(GJK_Point(s, &edges[i])) < Vec3_Len2(GJK_Point(s, &best)))
+			best = edges[i];
+	}
+	return best;
+}
+
+// Thank you,
+// Real-Time Collision Detection (Christer Ericson), 5.1.6
+// Only the faces with the origin in front of them can have the closest point.
+static GJK_Closest GJK_Tetrahedron(const GJK_Simplex* s)
+{
+	// Every face, followed by the vertex opposite to it.
+	static const u32 faces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+
+	// Doubles again, for the same reason as the triangle.
+	r64 w[4][3];
+	for(u32 i = 0; i < 4; i++) {
+		for(u32 k = 0; k < 3; k++)
+			w[i][k] = s->V[i].W.d[k];
+	}
+
+	r64 e[3][3];
+	for(u32 i = 0; i < 3; i++) {
+		for(u32 k = 0; k < 3; k++)
+			e[i][k] = w[i + 1][k] - w[0][k];
+	}
+
+	r64 cross[3] = { e[1][1] * e[2][2] - e[1][2] * e[2][1],
+	                 e[1][2] * e[2][0] - e[1][0] * e[2][2],
+	                 e[1][0] * e[2][1] - e[1][1] * e[2][0] };
+	r64 volume = GJK_Dot64(e[0], cross);
+
+	// Too flat to tell which side of a face anything is on, so try every face.
+	bool8 flat = volume * volume <= 1e-10 * GJK_Dot64(e[0], e[0]) * GJK_Dot64(e[1], e[1]) * GJK_Dot64(e[2], e[2]);
+
+	GJK_Closest best = { .Count = 4 };
+	r32 bestDist = FLT_MAX;
+
+	for(u32 i = 0; i < 4; i++) {
+		const r64* a = w[faces[i][0]];
+		r64 u[3], v[3], o[3];
+		for(u32 k = 0; k < 3; k++) {
+			u[k] = w[faces[i][1]][k] - a[k];
+			v[k] = w[faces[i][2]][k] - a[k];
+			o[k] = w[faces[i][3]][k] - a[k];
+		}
+
+		r64 n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+
+		r64 origin   = -GJK_Dot64(n, a);
+		r64 opposite = GJK_Dot64(n, o);
+		if(!flat && origin * opposite >= 0)
+			continue;
+
+		GJK_Closest c = GJK_Triangle(s, faces[i][0], faces[i][1], faces[i][2]);
+		r32 dist      = Vec3_Len2(GJK_Point(s, &c));
+		if(dist < bestDist) {
+			bestDist = dist;
+			best     = c;
+		}
+	}
+
+	return best;
+}
+
+// Find the closest point to the origin and throw away the vertices it doesn't need.
+// Returns 0 if the origin is inside the tetrahedron.
+static bool8 GJK_Solve(GJK_Simplex* s)
+{
+	GJK_Closest c;
+	switch(s->Count) {
+		case 1:  c = (GJK_Closest) { 1, { 0 }, { 1 } }; break;
+		case 2:  c = GJK_Segment(s, 0, 1);              break;
+		case 3:  c = GJK_Triangle(s, 0, 1, 2);          break;
+		default: c = GJK_Tetrahedron(s);                break;
+	}
+
+	if(c.Count == 4)
+		return 0;
+
+	GJK_Vertex v[3];
+	for(u32 i = 0; i < c.Count; i++) {
+		v[i]   = s->V[c.Keep[i]];
+		v[i].L = c.L[i];
+	}
+	memcpy(s->V, v, sizeof(GJK_Vertex) * c.Count);
+	s->Count = c.Count;
+	return 1;
+}
+
+// When the shapes nearly touch, the closest point is a tiny vector made out of much
+// bigger ones, and its direction is mostly rounding. The simplex's own shape says
+// which way it faces much more precisely. Returns the unit direction and how far along
+// it the simplex is, or 0 if there's no telling.
+static r32 GJK_Direction(const GJK_Simplex* s, Vec3 closest, Vec3* outDir)
+{
+	Vec3 w0 = s->V[0].W, n = closest;
+	if(s->Count == 2) {
+		Vec3 e = Vec3_Sub(s->V[1].W, w0);
+		n = Vec3_Cross(Vec3_Cross(e, w0), e);
+	} else if(s->Count == 3) {
+		n = Vec3_Cross(Vec3_Sub(s->V[1].W, w0), Vec3_Sub(s->V[2].W, w0));
+		if(Vec3_Dot(n, closest) < 0)
+			n = Vec3_Neg(n);
+	}
+
+	r32 len = Vec3_Len(n);
+	if(len > 0 && Vec3_Dot(n, closest) > 0) {
+		*outDir = Vec3_DivScal(n, len);
+		return Vec3_Dot(*outDir, w0);
+	}
+
+	len = Vec3_Len(closest);
+	if(len <= 0)
+		return 0;
+
+	*outDir = Vec3_DivScal(closest, len);
+	return len;
+}
+
+// Distance between the cores of two shapes. Returns 1 if the cores overlap, which leaves
+// the simplex around the origin for EPA, otherwise sets the closest points, the normal and the distance.
+static bool8 GJK_Distance(GJK_Proxy* a, GJK_Proxy* b, GJK_Cache* cache, GJK_Simplex* s,
+                          Vec3* outA, Vec3* outB, Vec3* outNormal, r32* outDist)
+{
+	s->Count = 0;
+
+	// Start from where the last frame ended, unless the shapes have changed under it.
+	if(cache && cache->Count <= 4) {
+		u32 numA = PhysShape_NumVertices(a->Shape), numB = PhysShape_NumVertices(b->Shape);
+		for(u32 i = 0; i < cache->Count; i++) {
+			if(cache->IndexA[i] >= numA || cache->IndexB[i] >= numB) {
+				s->Count = 0;
+				break;
+			}
+			s->V[s->Count++] = GJK_MakeVertex(a, b, cache->IndexA[i], cache->IndexB[i]);
+		}
+	}
+
+	if(!s->Count)
+		s->V[s->Count++] = GJK_MakeVertex(a, b, 0, 0);
+
+	a->Hint = s->V[0].IndexA;
+	b->Hint = s->V[0].IndexB;
+
+	bool8 overlap = 0;
+	Vec3 closest  = V3(0, 0, 0);
+
+	for(u32 iter = 0;; iter++) {
+		if(!GJK_Solve(s)) {
+			overlap = 1;
+			break;
+		}
+
+		GJK_Closest all = { .Count = s->Count };
+		r32 scale = 0;
+		for(u32 i = 0; i < s->Count; i++) {
+			all.Keep[i] = i;
+			all.L[i]    = s->V[i].L;
+			scale       = MAX(scale, Vec3_Len2(s->V[i].W));
+		}
+
+		closest  = GJK_Point(s, &all);
+		r32 dist2 = Vec3_Len2(closest);
+
+		// The origin's on the simplex, as far as floats can tell.
+		if(dist2 <= 1e-12f * scale) {
+			overlap = 1;
+			break;
+		}
+
+		if(iter == GJK_MAX_ITERATIONS)
+			break;
+
+		Vec3 dir;
+		r32 dist     = GJK_Direction(s, closest, &dir);
+		GJK_Vertex v = GJK_Support(a, b, Vec3_Neg(dir));
+
+		// A vertex it already has, or one that barely gets any closer, means this is as close as it gets.
+		bool8 repeat = 0;
+		for(u32 i = 0; i < s->Count; i++)
+			repeat |= (s->V[i].IndexA == v.IndexA && s->V[i].IndexB == v.IndexB);
+
+		if(repeat || dist - Vec3_Dot(v.W, dir) <= gjkTolerance * dist)
+			break;
+
+		s->V[s->Count++] = v;
+	}
+
+	if(cache) {
+		cache->Count = s->Count;
+		for(u32 i = 0; i < s->Count; i++) {
+			cache->IndexA[i] = s->V[i].IndexA;
+			cache->IndexB[i] = s->V[i].IndexB;
+		}
+	}
+
+	if(overlap)
+		return 1;
+
+	*outA = *outB = V3(0, 0, 0);
+	for(u32 i = 0; i < s->Count; i++) {
+		*outA = Vec3_Add(*outA, Vec3_MultScal(s->V[i].A, s->V[i].L));
+		*outB = Vec3_Add(*outB, Vec3_MultScal(s->V[i].B, s->V[i].L));
+	}
+
+	*outDist = GJK_Direction(s, closest, outNormal);
+	return 0;
+}
+
+// GJK stops with fewer than four points when the origin is right on the simplex.
+// EPA needs a tetrahedron, so keep adding points until it is one. Returns 0 if the
+// cores are too flat for one, a point for two spheres or a square for two crossing capsules.
+static bool8 EPA_Tetrahedron(GJK_Proxy* a, GJK_Proxy* b, GJK_Simplex* s)
+{
+	static const Vec3 axes[6] = {
+		V3C(1, 0, 0), V3C(-1, 0, 0), V3C(0, 1, 0), V3C(0, -1, 0), V3C(0, 0, 1), V3C(0, 0, -1),
+	};
+
+	for(u32 i = 0; i < 6 && s->Count == 1; i++) {
+		GJK_Vertex v = GJK_Support(a, b, axes[i]);
+		if(Vec3_Len2(Vec3_Sub(v.W, s->V[0].W)) > 1e-10f * (Vec3_Len2(v.W) + Vec3_Len2(s->V[0].W)))
+			s->V[s->Count++] = v;
+	}
+
+	if(s->Count == 2) {
+		// Go out sideways from the segment, along whichever axis it's least along.
+		Vec3 d = Vec3_Sub(s->V[1].W, s->V[0].W);
+		Vec3 e = (fabsf(d.x) < fabsf(d.y) && fabsf(d.x) < fabsf(d.z)) ? V3(1, 0, 0)
+		       : (fabsf(d.y) < fabsf(d.z)) ? V3(0, 1, 0) : V3(0, 0, 1);
+		Vec3 p = Vec3_Norm(Vec3_Cross(d, e));
+		Vec3 q = Vec3_Norm(Vec3_Cross(d, p));
+		Vec3 dirs[4] = { p, Vec3_Neg(p), q, Vec3_Neg(q) };
+
+		for(u32 i = 0; i < 4 && s->Count == 2; i++) {
+			GJK_Vertex v = GJK_Support(a, b, dirs[i]);
+			Vec3 off     = Vec3_Cross(d, Vec3_Sub(v.W, s->V[0].W));
+			if(Vec3_Len2(off) > 1e-10f * Vec3_Len2(d) * (Vec3_Len2(v.W) + Vec3_Len2(s->V[0].W)))
+				s->V[s->Count++] = v;
+		}
+	}
+
+	if(s->Count == 3) {
+		Vec3 n = Vec3_Norm(Vec3_Cross(Vec3_Sub(s->V[1].W, s->V[0].W), Vec3_Sub(s->V[2].W, s->V[0].W)));
+		Vec3 dirs[2] = { n, Vec3_Neg(n) };
+
+		for(u32 i = 0; i < 2 && s->Count == 3; i++) {
+			GJK_Vertex v = GJK_Support(a, b, dirs[i]);
+			r32 off      = Vec3_Dot(n, Vec3_Sub(v.W, s->V[0].W));
+			if(off * off > 1e-10f * (Vec3_Len2(v.W) + Vec3_Len2(s->V[0].W)))
+				s->V[s->Count++] = v;
+		}
+	}
+
+	return s->Count == 4;
+}
+
+typedef struct {
+	u8 V[3];
+	Vec3 Normal;  // Pointing out of the polytope.
+	r32 Distance; // From the origin to the face's plane.
+} EPA_Face;
+
+static bool8 EPA_MakeFace(const GJK_Vertex* verts, u8 a, u8 b, u8 c, EPA_Face* out)
+{
+	Vec3 n  = Vec3_Cross(Vec3_Sub(verts[b].W, verts[a].W), Vec3_Sub(verts[c].W, verts[a].W));
+	r32 len = Vec3_Len(n);
+	if(len <= 0)
+		return 0;
+
+	out->V[0]     = a;
+	out->V[1]     = b;
+	out->V[2]     = c;
+	out->Normal   = Vec3_DivScal(n, len);
+	out->Distance = Vec3_Dot(out->Normal, verts[a].W);
+	return 1;
+}
+
+// Thank you,
+// http://www.dtecta.com/papers/gdc2001depth.pdf
+// Blow the simplex up towards the surface of the Minkowski difference, one point at a time,
+// until the face closest to the origin is on the surface. That's how far the cores overlap,
+// and the radii just go on top of that, so round shapes don't need a round polytope.
+static void EPA_Penetration(GJK_Proxy* a, GJK_Proxy* b, GJK_Simplex* s, PhysContact* out)
+{
+	if(!EPA_Tetrahedron(a, b, s)) {
+		// The origin's on a flat simplex, so the cores only just touch. With only a point or a
+		// segment to go on, any direction that's flat against it is as good as any other.
+		Vec3 n = V3(0, 1, 0);
+		if(s->Count == 3)
+			n = Vec3_Cross(Vec3_Sub(s->V[1].W, s->V[0].W), Vec3_Sub(s->V[2].W, s->V[0].W));
+		else if(s->Count == 2)
+			n = Vec3_Cross(Vec3_Sub(s->V[1].W, s->V[0].W), V3(0, 1, 0));
+
+		if(Vec3_Len2(n) <= 0)
+			n = Vec3_Cross(Vec3_Sub(s->V[1].W, s->V[0].W), V3(1, 0, 0));
+		n = Vec3_Norm(n);
+
+		GJK_Closest c;
+		switch(s->Count) {
+			case 1:  c = (GJK_Closest) { 1, { 0 }, { 1 } }; break;
+			case 2:  c = GJK_Segment(s, 0, 1);              break;
+			default: c = GJK_Triangle(s, 0, 1, 2);          break;
+		}
+
+		Vec3 pa = V3(0, 0, 0), pb = V3(0, 0, 0);
+		for(u32 i = 0; i < c.Count; i++) {
+			pa = Vec3_Add(pa, Vec3_MultScal(s->V[c.Keep[i]].A, c.L[i]));
+			pb = Vec3_Add(pb, Vec3_MultScal(s->V[c.Keep[i]].B, c.L[i]));
+		}
+
+		*out = (PhysContact) {
+			.Touching = 1,
+			.Distance = -(a->Radius + b->Radius),
+			.Normal   = n,
+			.PointA   = Vec3_Add(pa, Vec3_MultScal(n, a->Radius)),
+			.PointB   = Vec3_Sub(pb, Vec3_MultScal(n, b->Radius)),
+		};
+		return;
+	}
+
+	GJK_Vertex verts[EPA_MAX_VERTICES];
+	EPA_Face faces[EPA_MAX_FACES];
+	u32 numVerts = 4, numFaces = 0;
+	memcpy(verts, s->V, sizeof(GJK_Vertex) * 4);
+
+	// Wind the tetrahedron so every face points away from the one vertex it doesn't have.
+	Vec3 e1 = Vec3_Sub(verts[1].W, verts[0].W);
+	Vec3 e2 = Vec3_Sub(verts[2].W, verts[0].W);
+	Vec3 e3 = Vec3_Sub(verts[3].W, verts[0].W);
+	if(Vec3_Dot(e1, Vec3_Cross(e2, e3)) > 0) {
+		GJK_Vertex tmp = verts[1];
+		verts[1] = verts[2];
+		verts[2] = tmp;
+	}
+
+	static const u8 tetra[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+	for(u32 i = 0; i < 4; i++)
+		numFaces += EPA_MakeFace(verts, tetra[i][0], tetra[i][1], tetra[i][2], &faces[numFaces]);
+
+	EPA_Face best = faces[0];
+
+	while(numFaces) {
+		u32 closest = 0;
+		for(u32 i = 1; i < numFaces; i++) {
+			if(faces[i].Distance < faces[closest].Distance)
+				closest = i;
+		}
+		best = faces[closest];
+
+		GJK_Vertex v = GJK_Support(a, b, best.Normal);
+		r32 gain     = Vec3_Dot(v.W, best.Normal) - best.Distance;
+		if(gain <= epaTolerance * fabsf(best.Distance) + 1e-6f || numVerts == EPA_MAX_VERTICES)
+			break;
+
+		// Take out the closest face and grow the hole across its edges into every face the new
+		// point can see. The edges on the border of the hole are the rim, which gets joined up
+		// with the new point. Boxes that are nearly lined up put lots of corners on the same
+		// plane, so faces the point is only just level with go too. Keeping one would leave a
+		// flat fold in the polytope, and growing from one face keeps the rim a single loop.
+		u8 edges[EPA_MAX_FACES * 3][2];
+		u32 numEdges = 0;
+
+		r32 level = -1e-5f * Vec3_Len(v.W);
+
+		for(u32 i = closest;;) {
+			EPA_Face* f = &faces[i];
+			for(u32 j = 0; j < 3; j++) {
+				u8 ea = f->V[j], eb = f->V[(j + 1) % 3];
+
+				u32 k = 0;
+				while(k < numEdges && !(edges[k][0] == eb && edges[k][1] == ea))
+					k++;
+
+				if(k < numEdges) {
+					edges[k][0] = edges[numEdges - 1][0];
+					edges[k][1] = edges[numEdges - 1][1];
+					numEdges--;
+				} else {
+					edges[numEdges][0] = ea;
+					edges[numEdges][1] = eb;
+					numEdges++;
+				}
+			}
+			*f = faces[--numFaces];
+
+			// Find the next face on the other side of the rim that the point can see.
+			for(i = 0; i < numFaces; i++) {
+				f = &faces[i];
+				if(Vec3_Dot(f->Normal, Vec3_Sub(v.W, verts[f->V[0]].W)) <= level)
+					continue;
+
+				bool8 borders = 0;
+				for(u32 j = 0; j < 3 && !borders; j++) {
+					u8 ea = f->V[j], eb = f->V[(j + 1) % 3];
+					for(u32 k = 0; k < numEdges && !borders; k++)
+						borders = (edges[k][0] == eb && edges[k][1] == ea);
+				}
+				if(borders)
+					break;
+			}
+
+			if(i == numFaces)
+				break;
+		}
+
+		if(numFaces + numEdges > EPA_MAX_FACES)
+			break;
+
+		u8 nv = numVerts++;
+		verts[nv] = v;
+		for(u32 i = 0; i < numEdges; i++)
+			numFaces += EPA_MakeFace(verts, edges[i][0], edges[i][1], nv, &faces[numFaces]);
+	}
+
+	// Thank you,
+	// Real-Time Collision Detection (Christer Ericson), 3.4
+	// Where the origin lands on the closest face, as weights of its corners.
+	Vec3 p  = Vec3_MultScal(best.Normal, best.Distance);
+	Vec3 w0 = verts[best.V[0]].W;
+	Vec3 v0 = Vec3_Sub(verts[best.V[1]].W, w0);
+	Vec3 v1 = Vec3_Sub(verts[best.V[2]].W, w0);
+	Vec3 v2 = Vec3_Sub(p, w0);
+
+	r32 d00 = Vec3_Dot(v0, v0), d01 = Vec3_Dot(v0, v1), d11 = Vec3_Dot(v1, v1);
+	r32 d20 = Vec3_Dot(v2, v0), d21 = Vec3_Dot(v2, v1);
+	r32 det = d00 * d11 - d01 * d01;
+
+	r32 l[3] = { 1, 0, 0 };
+	if(det > 0) {
+		l[1] = (d11 * d20 - d01 * d21) / det;
+		l[2] = (d00 * d21 - d01 * d20) / det;
+		l[0] = 1 - l[1] - l[2];
+	}
+
+	Vec3 pa = V3(0, 0, 0), pb = V3(0, 0, 0);
+	for(u32 i = 0; i < 3; i++) {
+		pa = Vec3_Add(pa, Vec3_MultScal(verts[best.V[i]].A, l[i]));
+		pb = Vec3_Add(pb, Vec3_MultScal(verts[best.V[i]].B, l[i]));
+	}
+
+	// The face faces out of B - A, so A has to go the other way to get out of B.
+	Vec3 n = Vec3_Neg(best.Normal);
+
+	*out = (PhysContact) {
+		.Touching = 1,
+		.Distance = -best.Distance - a->Radius - b->Radius,
+		.Normal   = n,
+		.PointA   = Vec3_Add(pa, Vec3_MultScal(n, a->Radius)),
+		.PointB   = Vec3_Sub(pb, Vec3_MultScal(n, b->Radius)),
+	};
+}
+
+bool8 PhysShape_Contact(const PhysShape* a, const Transform3D* ta, const PhysShape* b, const Transform3D* tb,
+                        GJK_Cache* cache, PhysContact* out)
+{
+	GJK_Proxy pa, pb;
+	GJK_Proxy_Init(&pa, a, ta);
+	GJK_Proxy_Init(&pb, b, tb);
+
+	GJK_Simplex s;
+	Vec3 pointA, pointB, n;
+	r32 dist;
+
+	// The cores overlap, so only EPA can say how deep it goes.
+	if(GJK_Distance(&pa, &pb, cache, &s, &pointA, &pointB, &n, &dist)) {
+		EPA_Penetration(&pa, &pb, &s, out);
+		return 1;
+	}
+
+	// Otherwise the rounded parts are just as far apart as the cores, minus the radii.
+	out->Normal   = n;
+	out->Distance = dist - pa.Radius - pb.Radius;
+	out->PointA   = Vec3_Add(pointA, Vec3_MultScal(n, pa.Radius));
+	out->PointB   = Vec3_Sub(pointB, Vec3_MultScal(n, pb.Radius));
+	out->Touching = (out->Distance <= 0);
+	return out->Touching;
+}
+
+// Where a transform ends up after moving with `v` and spinning with `w` for a while.
+static Transform3D Transform3D_Advance(Transform3D t, Vec3 v, Vec3 w, r32 time)
+{
+	t.Position = Vec3_Add(t.Position, Vec3_MultScal(v, time));
+
+	// The rotation changes by half of the spin times itself, every second.
+	Quat spin  = { .x = w.x, .y = w.y, .z = w.z, .w = 0 };
+	Quat dq    = Quat_Mult(t.Rotation, spin);
+	t.Rotation = Quat_Norm(Vec4_Add(t.Rotation, Vec4_MultScal(dq, 0.5f * time)));
+	return t;
+}
+
+// How far the shape reaches from its origin, so turning it by a small angle can't move
+// any of it further than angle * reach.
+static r32 PhysShape_Reach(const PhysShape* shape, const Transform3D* t)
+{
+	AABB box = PhysShape_AABB(shape);
+	Vec3 far = V3(MAX(fabsf(box.Min.x), fabsf(box.Max.x)),
+	              MAX(fabsf(box.Min.y), fabsf(box.Max.y)),
+	              MAX(fabsf(box.Min.z), fabsf(box.Max.z)));
+
+	r32 reach = Vec3_Len(far);
+	if(shape->Type == PhysShapeType_Convex)
+		reach += shape->Radius;
+
+	return t ? reach * MAX3(fabsf(t->Scale.x), fabsf(t->Scale.y), fabsf(t->Scale.z)) : reach;
+}
+
+// Thank you,
+// https://www.continuousphysics.com/BulletContinuousCollisionDetection.pdf
+//
+// Conservative advancement: nothing can close the gap faster than the speed along the normal plus
+// how fast the spin moves the furthest points, so it's always safe to move on by gap / that speed.
+// Takes a few steps when the shapes go straight at each other, more when they only just graze.
+r32 PhysShape_TimeOfImpact(const PhysShape* a, const Transform3D* ta, Vec3 va, Vec3 wa,
+                           const PhysShape* b, const Transform3D* tb, Vec3 vb, Vec3 wb,
+                           r32 dt, r32 distance, PhysContact* out)
+{
+	if(!ta) va = wa = V3(0, 0, 0);
+	if(!tb) vb = wb = V3(0, 0, 0);
+
+	Vec3 dv  = Vec3_Sub(va, vb);
+	r32 spin = Vec3_Len(wa) * PhysShape_Reach(a, ta) + Vec3_Len(wb) * PhysShape_Reach(b, tb);
+	r32 tolerance = 0.25f * fabsf(distance) + 1e-5f;
+
+	GJK_Cache cache = {0};
+	Transform3D at, bt;
+	r32 t = 0;
+
+	for(u32 iter = 0; iter < 32; iter++) {
+		if(ta) at = Transform3D_Advance(*ta, va, wa, t);
+		if(tb) bt = Transform3D_Advance(*tb, vb, wb, t);
+
+		PhysShape_Contact(a, ta ? &at : NULL, b, tb ? &bt : NULL, &cache, out);
+
+		r32 closing = Vec3_Dot(dv, out->Normal) + spin;
+		if(Vec3_Len2(out->Normal) > 0 && closing <= 0)
+			return 1;
+
+		if(out->Distance <= distance + tolerance || Vec3_Len2(out->Normal) <= 0)
+			return dt > 0 ? t / dt : 0;
+
+		t += (out->Distance - distance) / closing;
+		if(t >= dt)
+			return 1;
+	}
+
+	return t / dt;
+}
+
+// Thank you,
+// http://www.dtecta.com/papers/jgt04raycast.pdf
+// A point goes along the ray, each time by as far as it is from the shape. Nothing on the shape
+// is closer than that, so it can't go through, and it gets there in a few steps unless the ray only grazes it.
+Intersection PhysShape_RayIntersect(const PhysShape* shape, const Transform3D* t, Ray ray, r32 maxT)
+{
+	r32 speed = Vec3_Dot(ray.Dir, ray.Dir);
+	if(speed <= 0)
+		return (Intersection) { .Occurred = 0 };
+
+	PhysShape point = PhysShape_Sphere(0);
+	Transform3D at  = Transform3D_Default;
+	GJK_Cache cache = {0};
+	PhysContact c;
+	r32 along = 0;
+
+	for(u32 iter = 0; iter < 32; iter++) {
+		at.Position = Vec3_Add(ray.Start, Vec3_MultScal(ray.Dir, along));
+		PhysShape_Contact(&point, &at, shape, t, &cache, &c);
+
+		if(c.Distance <= 1e-4f) {
+			// Rays that start inside get a hit right away, facing back along the ray.
+			Vec3 n = (Vec3_Len2(c.Normal) > 0 ? Vec3_Neg(c.Normal) : Vec3_MultScal(ray.Dir, -1 / sqrtf(speed)));
+			return (Intersection) { .Occurred = 1, .Point = at.Position, .Normal = n, .T = along };
+		}
+
+		r32 closing = Vec3_Dot(ray.Dir, c.Normal);
+		if(closing <= 0)
+			break;
+
+		along += c.Distance / closing;
+		if(along > maxT)
+			break;
+	}
+
+	return (Intersection) { .Occurred = 0 };
+}
+
+DECL_ARRAY(PhysObject, PhysObject);
+DECL_ARRAY(PhysPair, PhysPair);
+
+//
+// Dynamic AABB tree
+//
+
+#define AABBTREE_NULL -1
+
+// Node stack for walking the tree, starts out on the C stack and moves to the heap if it has to.
+typedef struct {
+	i32 Node;
+	r32 T; // Where the ray enters the node, for ray casts.
+} AABBTree_StackEntry;
+
+typedef struct {
+	AABBTree_StackEntry* Data;
+	u32 Size, Capacity;
+	AABBTree_StackEntry Local[256];
+} AABBTree_Stack;
+
+static inline void AABBTree_Stack_Init(AABBTree_Stack* s)
+{
+	s->Data     = s->Local;
+	s->Size     = 0;
+	s->Capacity = 256;
+}
+
+static inline void AABBTree_Stack_Push(AABBTree_Stack* s, i32 node, r32 t)
+{
+	if(s->Size == s->Capacity) {
+		AABBTree_StackEntry* data = Allocate(sizeof(AABBTree_StackEntry) * s->Capacity * 2);
+		memcpy(data, s->Data, sizeof(AABBTree_StackEntry) * s->Size);
+		if(s->Data != s->Local)
+			Free(s->Data);
+
+		s->Data = data;
+		s->Capacity *= 2;
+	}
+
+	s->Data[s->Size++] = (AABBTree_StackEntry) { .Node = node, .T = t };
+}
+
+static inline void AABBTree_Stack_Free(AABBTree_Stack* s)
+{
+	if(s->Data != s->Local)
+		Free(s->Data);
+}
+
+void AABBTree_Init(AABBTree* tree)
+{
+	*tree = (AABBTree) {
+		.Nodes    = NULL,
+		.NumNodes = 0,
+		.Capacity = 0,
+		.Root     = AABBTREE_NULL,
+		.FreeList = AABBTREE_NULL,
+	};
+}
+
+void AABBTree_Free(AABBTree* tree)
+{
+	if(tree->Nodes)
+		Free(tree->Nodes);
+	AABBTree_Init(tree);
+}
+
+static i32 AABBTree_AllocNode(AABBTree* tree)
+{
+	if(tree->FreeList == AABBTREE_NULL) {
+		u32 capacity = MAX(tree->Capacity * 2, 16);
+		tree->Nodes  = Reallocate(tree->Nodes, sizeof(AABBTree_Node) * capacity);
+
+		// Chain all the new nodes onto the free list.
+		for(u32 i = tree->Capacity; i < capacity; i++) {
+			tree->Nodes[i].Parent = (i + 1 < capacity ? (i32) i + 1 : AABBTREE_NULL);
+			tree->Nodes[i].Height = -1;
+		}
+
+		tree->FreeList = tree->Capacity;
+		tree->Capacity = capacity;
+	}
+
+	i32 id         = tree->FreeList;
+	tree->FreeList = tree->Nodes[id].Parent;
+	tree->NumNodes++;
+
+	tree->Nodes[id] = (AABBTree_Node) {
+		.Parent = AABBTREE_NULL,
+		.Child1 = AABBTREE_NULL,
+		.Child2 = AABBTREE_NULL,
+		.Height = 0,
+	};
+	return id;
+}
+
+static void AABBTree_FreeNode(AABBTree* tree, i32 id)
+{
+	tree->Nodes[id].Parent = tree->FreeList;
+	tree->Nodes[id].Height = -1;
+	tree->FreeList         = id;
+	tree->NumNodes--;
+}
+
+static inline void AABBTree_Refit(AABBTree* tree, i32 id)
+{
+	AABBTree_Node* n = &tree->Nodes[id];
+	AABBTree_Node* a = &tree->Nodes[n->Child1];
+	AABBTree_Node* b = &tree->Nodes[n->Child2];
+
+	n->Box    = AABB_Union(a->Box, b->Box);
+	n->Height = 1 + MAX(a->Height, b->Height);
+}
+
+// Thank you,
+// https://github.com/erincatto/box2d/blob/main/src/dynamic_tree.c (b2RotateNodes)
+// https://www.cs.utah.edu/~thiago/papers/rotations.pdf
+//
+// Swap one of A's children with one of its grandchildren if that makes
+// the box of the child in between smaller. A's own box doesn't change.
+static void AABBTree_Rotate(AABBTree* tree, i32 a)
+{
+	AABBTree_Node* nodes = tree->Nodes;
+	i32 b = nodes[a].Child1;
+	i32 c = nodes[a].Child2;
+
+	if(nodes[b].Height == 0 && nodes[c].Height == 0)
+		return;
+
+	// Candidates: B <-> F, B <-> G (B moves under C) and C <-> D, C <-> E (C moves under B).
+	r32 bestGain = 0;
+	i32 bestFrom = AABBTREE_NULL, bestTo = AABBTREE_NULL, bestParent = AABBTREE_NULL;
+
+	if(nodes[c].Height > 0) {
+		i32 f = nodes[c].Child1, g = nodes[c].Child2;
+		r32 areaC = AABB_Area(nodes[c].Box);
+
+		r32 gainF = areaC - AABB_Area(AABB_Union(nodes[b].Box, nodes[g].Box));
+		r32 gainG = areaC - AABB_Area(AABB_Union(nodes[b].Box, nodes[f].Box));
+
+		if(gainF > bestGain) { bestGain = gainF; bestFrom = b; bestTo = f; bestParent = c; }
+		if(gainG > bestGain) { bestGain = gainG; bestFrom = b; bestTo = g; bestParent = c; }
+	}
+
+	if(nodes[b].Height > 0) {
+		i32 d = nodes[b].Child1, e = nodes[b].Child2;
+		r32 areaB = AABB_Area(nodes[b].Box);
+
+		r32 gainD = areaB - AABB_Area(AABB_Union(nodes[c].Box, nodes[e].Box));
+		r32 gainE = areaB - AABB_Area(AABB_Union(nodes[c].Box, nodes[d].Box));
+
+		if(gainD > bestGain) { bestGain = gainD; bestFrom = c; bestTo = d; bestParent = b; }
+		if(gainE > bestGain) { bestGain = gainE; bestFrom = c; bestTo = e; bestParent = b; }
+	}
+
+	if(bestFrom == AABBTREE_NULL)
+		return;
+
+	// `bestFrom` is a child of A, `bestTo` is a child of `bestParent`, the other child of A.
+	if(nodes[a].Child1 == bestFrom) nodes[a].Child1 = bestTo;
+	else                            nodes[a].Child2 = bestTo;
+
+	if(nodes[bestParent].Child1 == bestTo) nodes[bestParent].Child1 = bestFrom;
+	else                                   nodes[bestParent].Child2 = bestFrom;
+
+	nodes[bestTo].Parent   = a;
+	nodes[bestFrom].Parent = bestParent;
+
+	AABBTree_Refit(tree, bestParent);
+	AABBTree_Refit(tree, a);
+}
+
+// Walk up from `id` to the root, fixing boxes and heights and rotating along the way.
+static void AABBTree_FixUpwards(AABBTree* tree, i32 id)
+{
+	while(id != AABBTREE_NULL) {
+		AABBTree_Refit(tree, id);
+		AABBTree_Rotate(tree, id);
+		id = tree->Nodes[id].Parent;
+	}
+}
+
+// Thank you,
+// https://github.com/erincatto/box2d/blob/v2.4.1/src/collision/b2_dynamic_tree.cpp
+// Find the sibling that adds the least surface area to the tree.
+static void AABBTree_InsertLeaf(AABBTree* tree, i32 leaf)
+{
+	AABBTree_Node* nodes = tree->Nodes;
+
+	if(tree->Root == AABBTREE_NULL) {
+		tree->Root          = leaf;
+		nodes[leaf].Parent = AABBTREE_NULL;
+		return;
+	}
+
+	AABB box = nodes[leaf].Box;
+	i32 sibling = tree->Root;
+
+	while(nodes[sibling].Height > 0) {
+		i32 child1 = nodes[sibling].Child1;
+		i32 child2 = nodes[sibling].Child2;
+
+		r32 area         = AABB_Area(nodes[sibling].Box);
+		r32 combinedArea = AABB_Area(AABB_Union(nodes[sibling].Box, box));
+
+		// Cost of making a new parent for this node and the new leaf.
+		r32 cost = 2 * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree.
+		r32 inheritance = 2 * (combinedArea - area);
+
+		r32 cost1 = AABB_Area(AABB_Union(nodes[child1].Box, box)) + inheritance;
+		if(nodes[child1].Height > 0)
+			cost1 -= AABB_Area(nodes[child1].Box);
+
+		r32 cost2 = AABB_Area(AABB_Union(nodes[child2].Box, box)) + inheritance;
+		if(nodes[child2].Height > 0)
+			cost2 -= AABB_Area(nodes[child2].Box);
+
+		if(cost < cost1 && cost < cost2)
+			break;
+
+		sibling = (cost1 < cost2 ? child1 : child2);
+	}
+
+	i32 oldParent = nodes[sibling].Parent;
+	i32 newParent = AABBTree_AllocNode(tree);
+	nodes = tree->Nodes;
+
+	nodes[newParent].Parent = oldParent;
+	nodes[newParent].Child1 = sibling;
+	nodes[newParent].Child2 = leaf;
+	nodes[sibling].Parent   = newParent;
+	nodes[leaf].Parent      = newParent;
+
+	if(oldParent == AABBTREE_NULL) {
+		tree->Root = newParent;
+	} else if(nodes[oldParent].Child1 == sibling) {
+		nodes[oldParent].Child1 = newParent;
+	} else {
+		nodes[oldParent].Child2 = newParent;
+	}
+
+	AABBTree_FixUpwards(tree, newParent);
+}
+
+static void AABBTree_RemoveLeaf(AABBTree* tree, i32 leaf)
+{
+	AABBTree_Node* nodes = tree->Nodes;
+
+	if(leaf == tree->Root) {
+		tree->Root = AABBTREE_NULL;
+		return;
+	}
+
+	i32 parent      = nodes[leaf].Parent;
+	i32 grandParent = nodes[parent].Parent;
+	i32 sibling     = (nodes[parent].Child1 == leaf ? nodes[parent].Child2 : nodes[parent].Child1);
+
+	// The sibling takes the parent's place.
+	nodes[sibling].Parent = grandParent;
+	AABBTree_FreeNode(tree, parent);
+
+	if(grandParent == AABBTREE_NULL) {
+		tree->Root = sibling;
+		return;
+	}
+
+	if(nodes[grandParent].Child1 == parent)
+		nodes[grandParent].Child1 = sibling;
+	else
+		nodes[grandParent].Child2 = sibling;
+
+	AABBTree_FixUpwards(tree, grandParent);
+}
+
+static AABB AABBTree_Fatten(AABB box, Vec3 displacement)
+{
+	const Vec3 margin = V3C(AABBTREE_MARGIN, AABBTREE_MARGIN, AABBTREE_MARGIN);
+	box.Min = Vec3_Sub(box.Min, margin);
+	box.Max = Vec3_Add(box.Max, margin);
+
+	// Stretch it towards where the object's going.
+	for(u32 i = 0; i < 3; i++) {
+		if(displacement.d[i] < 0) box.Min.d[i] += displacement.d[i];
+		else                      box.Max.d[i] += displacement.d[i];
+	}
+
+	return box;
+}
+
+i32 AABBTree_Insert(AABBTree* tree, AABB box, u32 data)
+{
+	i32 leaf = AABBTree_AllocNode(tree);
+
+	tree->Nodes[leaf].Box   = AABBTree_Fatten(box, V3(0, 0, 0));
+	tree->Nodes[leaf].Data  = data;
+	tree->Nodes[leaf].Moved = 1;
+
+	AABBTree_InsertLeaf(tree, leaf);
+	return leaf;
+}
+
+void AABBTree_Remove(AABBTree* tree, i32 leaf)
+{
+	AABBTree_RemoveLeaf(tree, leaf);
+	AABBTree_FreeNode(tree, leaf);
+}
+
+bool8 AABBTree_Move(AABBTree* tree, i32 leaf, AABB box, Vec3 displacement)
+{
+	AABB treeBox = tree->Nodes[leaf].Box;
+
+	if(AABB_Contains(treeBox, box)) {
+		// Still inside, but a box that used to be stretched a long way for
+		// a fast object shouldn't stay that big once it slows down.
+		const Vec3 slack = V3C(AABBTREE_MARGIN * 4, AABBTREE_MARGIN * 4, AABBTREE_MARGIN * 4);
+		AABB huge = AABBTree_Fatten(box, Vec3_MultScal(displacement, 4));
+		huge.Min  = Vec3_Sub(huge.Min, slack);
+		huge.Max  = Vec3_Add(huge.Max, slack);
+
+		if(AABB_Contains(huge, treeBox))
+			return 0;
+	}
+
+	AABBTree_RemoveLeaf(tree, leaf);
+	tree->Nodes[leaf].Box   = AABBTree_Fatten(box, Vec3_MultScal(displacement, 2));
+	tree->Nodes[leaf].Moved = 1;
+	AABBTree_InsertLeaf(tree, leaf);
+	return 1;
+}
+
+void AABBTree_Query(const AABBTree* tree, AABB box, AABBTree_QueryFunc func, void* user)
+{
+	if(tree->Root == AABBTREE_NULL)
+		return;
+
+	AABBTree_Stack stack;
+	AABBTree_Stack_Init(&stack);
+	AABBTree_Stack_Push(&stack, tree->Root, 0);
+
+	while(stack.Size) {
+		const AABBTree_Node* n = &tree->Nodes[stack.Data[--stack.Size].Node];
+
+		if(!Boxes_Overlap(&n->Box, &box))
+			continue;
+
+		if(n->Height == 0) {
+			if(!func(user, n->Data))
+				break;
+		} else {
+			AABBTree_Stack_Push(&stack, n->Child1, 0);
+			AABBTree_Stack_Push(&stack, n->Child2, 0);
+		}
+	}
+
+	AABBTree_Stack_Free(&stack);
+}
+
+void AABBTree_RayCast(const AABBTree* tree, Ray ray, r32 maxT, AABBTree_RayFunc func, void* user)
+{
+	if(tree->Root == AABBTREE_NULL)
+		return;
+
+	Vec3 invDir = V3C(1.0f / ray.Dir.x, 1.0f / ray.Dir.y, 1.0f / ray.Dir.z);
+
+	r32 t;
+	if(!Ray_HitsBox(ray.Start, invDir, &tree->Nodes[tree->Root].Box, maxT, &t))
+		return;
+
+	AABBTree_Stack stack;
+	AABBTree_Stack_Init(&stack);
+	AABBTree_Stack_Push(&stack, tree->Root, t);
+
+	while(stack.Size) {
+		AABBTree_StackEntry top = stack.Data[--stack.Size];
+		const AABBTree_Node* n  = &tree->Nodes[top.Node];
+
+		// The ray got shorter since this was pushed.
+		if(top.T > maxT)
+			continue;
+
+		if(n->Height > 0) {
+			// Visit the closer child first, so the ray gets shortened sooner.
+			r32 t1, t2;
+			bool8 hit1 = Ray_HitsBox(ray.Start, invDir, &tree->Nodes[n->Child1].Box, maxT, &t1);
+			bool8 hit2 = Ray_HitsBox(ray.Start, invDir, &tree->Nodes[n->Child2].Box, maxT, &t2);
+
+			if(hit1 && hit2) {
+				if(t1 <= t2) {
+					AABBTree_Stack_Push(&stack, n->Child2, t2);
+					AABBTree_Stack_Push(&stack, n->Child1, t1);
+				} else {
+					AABBTree_Stack_Push(&stack, n->Child1, t1);
+					AABBTree_Stack_Push(&stack, n->Child2, t2);
+				}
+			} else if(hit1) {
+				AABBTree_Stack_Push(&stack, n->Child1, t1);
+			} else if(hit2) {
+				AABBTree_Stack_Push(&stack, n->Child2, t2);
+			}
+			continue;
+		}
+
+		r32 newMaxT = func(user, n->Data, ray, maxT);
+		if(newMaxT <= 0)
+			break;
+		maxT = MIN(maxT, newMaxT);
+	}
+
+	AABBTree_Stack_Free(&stack);
+}
+
+//
+// Broadphase
+//
+
+// Thank you,
+// https://en.wikipedia.org/wiki/Sweep_and_prune
+// http://www.codercorner.com/SAP.pdf
+//
+// Every box is projected onto the X, Y and Z axes as a min and a max endpoint,
+// and each axis is kept sorted. Objects don't move much between frames, so the
+// lists stay nearly sorted and insertion sort fixes them up in close to linear time.
+// Every swap it does is a change in overlap on that axis, which is when pairs
+// get added or removed, so the pair list is only ever touched where something moved.
+
+typedef struct {
+	r32 Value;
+	u32 Id; // Object index << 1, the low bit is set for max endpoints.
+} PhysEndpoint;
+
+// The solver's, further down.
+typedef struct PhysBody       PhysBody;
+typedef struct PhysIsland     PhysIsland;
+typedef struct PhysConstraint PhysConstraint;
+
+struct PhysWorld_Cache {
+	u32 NumObjects, Capacity;
+	enum PhysBroadphase Broadphase; // What the pair list was made with.
+
+	AABB* Boxes;   // World space boxes from the last update.
+	bool8* Static; // Kept next to the boxes so the sort doesn't have to touch the objects.
+	i32* Leaves;   // Every object's leaf in the tree.
+
+	AABBTree Tree;
+
+	// Sweep and prune
+	u32 NumSorted; // Objects that have endpoints on the axes.
+	PhysEndpoint* Axes[3];
+
+	// Spatial hash
+	u64* CellKeys[2];    // Morton code of every cell every box covers, and room to sort them.
+	u32* CellObjects[2]; // The box in each of them << 1, the low bit is set for static ones.
+	u32* Runs;           // Start and end of every cell with more than one box in it.
+	u32 CellCapacity;
+
+	u32* FirstCell; // Every box's lowest cell along X, Y and Z.
+	bool8* Big;     // Boxes too big for the grid, they get tested against everything.
+	r32* Extents;
+
+	Array_u64* ChunkPairs; // What each chunk found as A << 32 | B, the last one is for big boxes.
+	u32 NumChunks;         // How many of them there's room for.
+
+	u64* PairKeys[3]; // The pair list as A << 32 | B sorted, and room for the next one.
+	u32 NumPairKeys, PairKeyCapacity;
+
+	Array_PhysPair Pairs;
+
+	// Open addressing, holds pair index + 1, 0 means empty.
+	u32* PairIndex;
+	u32 PairMask;
+
+	// Solver, filled in from scratch every update.
+	PhysBody* Bodies;
+	u32* IslandOf;      // Union-find parents
+	u32* IslandIndex;   // For every island's root, its index in Islands.
+	bool8* IslandAwake; // For every island's root.
+	u32* IslandBodies;  // Every island's bodies, one after the other.
+
+	PhysIsland* Islands;
+	u32 NumIslands;
+
+	PhysConstraint* Constraints; // Sorted by island
+	u32 ConstraintCapacity;
+
+	PhysWorld_Stats Stats;
+};
+
+// Mins go before maxes at the same value, so "A's min is before B's max"
+// means the same thing as A.Min <= B.Max.
+static inline bool8 PhysEndpoint_Less(PhysEndpoint a, PhysEndpoint b)
+{
+	return a.Value < b.Value || (a.Value == b.Value && (a.Id & 1) < (b.Id & 1));
+}
+
+static i32 PhysEndpoint_Compare(const void* a, const void* b)
+{
+	PhysEndpoint ea = *(const PhysEndpoint*) a;
+	PhysEndpoint eb = *(const PhysEndpoint*) b;
+	return PhysEndpoint_Less(ea, eb) ? -1 : PhysEndpoint_Less(eb, ea);
+}
+
+static inline u32 PhysPair_Hash(u32 a, u32 b)
+{
+	return (a * 0x9E3779B1u) ^ (b * 0x85EBCA77u);
+}
+
+// Slot in the index holding the pair, or the empty slot where it would go.
+static u32 PhysPair_Slot(const PhysWorld_Cache* c, u32 a, u32 b)
+{
+	u32 slot = PhysPair_Hash(a, b) & c->PairMask;
+
+	while(c->PairIndex[slot]) {
+		const PhysPair* p = &c->Pairs.Data[c->PairIndex[slot] - 1];
+		if(p->A == a && p->B == b)
+			break;
+		slot = (slot + 1) & c->PairMask;
+	}
+
+	return slot;
+}
+
+static void PhysPair_Rehash(PhysWorld_Cache* c, u32 size)
+{
+	if(c->PairIndex)
+		Free(c->PairIndex);
+
+	c->PairMask  = size - 1;
+	c->PairIndex = Allocate(sizeof(u32) * size);
+	memset(c->PairIndex, 0, sizeof(u32) * size);
+
+	for(u32 i = 0; i < c->Pairs.Size; i++) {
+		const PhysPair* p = &c->Pairs.Data[i];
+		c->PairIndex[PhysPair_Slot(c, p->A, p->B)] = i + 1;
+	}
+}
+
+static void PhysPair_Add(PhysWorld_Cache* c, u32 a, u32 b)
+{
+	if(a > b) { u32 tmp = a; a = b; b = tmp; }
+
+	// Keep the index at most half full.
+	if((c->Pairs.Size + 1) * 2 > c->PairMask + 1)
+		PhysPair_Rehash(c, (c->PairMask + 1) * 2);
+
+	u32 slot = PhysPair_Slot(c, a, b);
+	if(c->PairIndex[slot])
+		return;
+
+	Array_PhysPair_PushVal(&c->Pairs, (PhysPair) { .A = a, .B = b });
+	c->PairIndex[slot] = c->Pairs.Size;
+}
+
+static void PhysPair_Remove(PhysWorld_Cache* c, u32 a, u32 b)
+{
+	if(a > b) { u32 tmp = a; a = b; b = tmp; }
+
+	u32 slot = PhysPair_Slot(c, a, b);
+	if(!c->PairIndex[slot])
+		return;
+
+	// Move the last pair into the hole so the list stays packed.
+	u32 idx  = c->PairIndex[slot] - 1;
+	u32 last = c->Pairs.Size - 1;
+	if(idx != last) {
+		PhysPair moved = c->Pairs.Data[last];
+		c->PairIndex[PhysPair_Slot(c, moved.A, moved.B)] = idx + 1;
+		c->Pairs.Data[idx] = moved;
+	}
+	c->Pairs.Size--;
+
+	// Thank you,
+	// https://en.wikipedia.org/wiki/Linear_probing#Deletion
+	// Shift the rest of the cluster back instead of leaving a tombstone.
+	u32 hole = slot;
+	for(u32 i = (slot + 1) & c->PairMask; c->PairIndex[i]; i = (i + 1) & c->PairMask) {
+		const PhysPair* p = &c->Pairs.Data[c->PairIndex[i] - 1];
+		u32 home = PhysPair_Hash(p->A, p->B) & c->PairMask;
+
+		// Can the entry at `i` move into the hole without ending up before its home slot?
+		bool8 canMove = (hole <= i) ? (home <= hole || home > i)
+		                            : (home <= hole && home > i);
+		if(canMove) {
+			c->PairIndex[hole] = c->PairIndex[i];
+			hole = i;
+		}
+	}
+	c->PairIndex[hole] = 0;
+}
+
+static inline bool8 Boxes_OverlapAxis(const AABB* a, const AABB* b, u32 axis)
+{
+	return a->Min.d[axis] <= b->Max.d[axis] && b->Min.d[axis] <= a->Max.d[axis];
+}
+
+static inline bool8 PhysObject_Sweeps(const PhysObject* o, Vec3 v)
+{
+	return o->Type == PhysObject_RigidBody && o->SweepSpeed > 0 && o->Shape.Type != PhysShapeType_None
+	    && Vec3_Len2(v) > o->SweepSpeed * o->SweepSpeed;
+}
+
+static void PhysWorld_UpdateBoxes(PhysWorld* world, r32 dt)
+{
+	PhysWorld_Cache* c = world->_cache;
+
+	const PhysObject* objects = world->Objects.Data;
+	AABB_ApplyTransform3D_N(&objects->AABB, sizeof(PhysObject), &objects->Transform, sizeof(PhysObject),
+	                        c->Boxes, c->NumObjects);
+
+	for(u32 i = 0; i < c->NumObjects; i++) {
+		const PhysObject* o = &world->Objects.Data[i];
+		c->Static[i] = (o->Type == PhysObject_Static);
+
+		// Fast bodies cover the whole way they're about to move, so whatever's in the way gets a pair.
+		if(PhysObject_Sweeps(o, o->Velocity)) {
+			Vec3 move   = V3(o->Velocity.x * dt, (o->Velocity.y - world->Gravity * dt) * dt, o->Velocity.z * dt);
+			c->Boxes[i] = AABB_Union(c->Boxes[i], (AABB) { .Min = Vec3_Add(c->Boxes[i].Min, move),
+			                                               .Max = Vec3_Add(c->Boxes[i].Max, move) });
+		}
+
+		if(c->Leaves[i] == AABBTREE_NULL)
+			c->Leaves[i] = AABBTree_Insert(&c->Tree, c->Boxes[i], i);
+		else
+			AABBTree_Move(&c->Tree, c->Leaves[i], c->Boxes[i], Vec3_MultScal(o->Velocity, dt));
+	}
+}
+
+// Forget everything, the next update starts from scratch.
+static void PhysWorld_Reset(PhysWorld* world)
+{
+	PhysWorld_Cache* c = world->_cache;
+
+	for(u32 axis = 0; axis < 3; axis++) {
+		if(c->Axes[axis])
+			Free(c->Axes[axis]);
+		c->Axes[axis] = NULL;
+	}
+
+	AABBTree_Free(&c->Tree);
+
+	c->NumObjects = 0;
+	c->NumSorted  = 0;
+	c->Broadphase = world->Broadphase;
+
+	c->Pairs.Size  = 0;
+	c->NumPairKeys = 0;
+	PhysPair_Rehash(c, MAX(c->PairMask + 1, 64));
+}
+
+static void PhysWorld_RefreshEndpoints(PhysWorld* world)
+{
+	PhysWorld_Cache* c = world->_cache;
+
+	for(u32 axis = 0; axis < 3; axis++) {
+		PhysEndpoint* ep = c->Axes[axis];
+
+		for(u32 i = 0; i < c->NumSorted * 2; i++) {
+			const AABB* box = &c->Boxes[ep[i].Id >> 1];
+			ep[i].Value = (ep[i].Id & 1) ? box->Max.d[axis] : box->Min.d[axis];
+		}
+	}
+}
+
+// Sort every axis from scratch and sweep the X axis for the starting pairs.
+static void PhysWorld_Rebuild(PhysWorld* world)
+{
+	PhysWorld_Cache* c = world->_cache;
+	u32 n = c->NumObjects;
+
+	c->NumSorted = n;
+	for(u32 axis = 0; axis < 3; axis++) {
+		c->Axes[axis] = Reallocate(c->Axes[axis], sizeof(PhysEndpoint) * MAX(n * 2, 1));
+		for(u32 i = 0; i < n * 2; i++)
+			c->Axes[axis][i].Id = i;
+	}
+
+	PhysWorld_RefreshEndpoints(world);
+
+	for(u32 axis = 0; axis < 3; axis++)
+		qsort(c->Axes[axis], n * 2, sizeof(PhysEndpoint), PhysEndpoint_Compare);
+
+	c->Pairs.Size = 0;
+	PhysPair_Rehash(c, c->PairMask + 1);
+
+	// Boxes that are open at the current point along X.
+	u32* active   = Allocate(sizeof(u32) * MAX(n, 1));
+	u32* position = Allocate(sizeof(u32) * MAX(n, 1));
+	u32 numActive = 0;
+
+	for(u32 i = 0; i < n * 2; i++) {
+		u32 id = c->Axes[0][i].Id >> 1;
+
+		if(c->Axes[0][i].Id & 1) {
+			u32 last = active[--numActive];
+			active[position[id]] = last;
+			position[last]       = position[id];
+			continue;
+		}
+
+		for(u32 j = 0; j < numActive; j++) {
+			u32 other = active[j];
+			if(Boxes_Overlap(&c->Boxes[id], &c->Boxes[other]) && !(c->Static[id] && c->Static[other]))
+				PhysPair_Add(c, id, other);
+		}
+
+		position[id]        = numActive;
+		active[numActive++] = id;
+	}
+
+	Free(active);
+	Free(position);
+}
+
+// Objects pushed onto the end keep everyone else's index, so their endpoints can
+// start out past the end of every axis and get sorted in like anything that moved.
+static void PhysWorld_Grow(PhysWorld* world)
+{
+	PhysWorld_Cache* c = world->_cache;
+	u32 n = c->NumObjects;
+
+	for(u32 axis = 0; axis < 3; axis++) {
+		c->Axes[axis] = Reallocate(c->Axes[axis], sizeof(PhysEndpoint) * n * 2);
+		for(u32 i = c->NumSorted * 2; i < n * 2; i++)
+			c->Axes[axis][i].Id = i;
+	}
+
+	c->NumSorted = n;
+}
+
+static void PhysWorld_SortAxis(PhysWorld* world, u32 axis)
+{
+	PhysWorld_Cache* c = world->_cache;
+	PhysEndpoint* ep   = c->Axes[axis];
+
+	for(u32 i = 1; i < c->NumSorted * 2; i++) {
+		PhysEndpoint e = ep[i];
+		u32 j = i;
+
+		for(; j > 0 && PhysEndpoint_Less(e, ep[j - 1]); j--) {
+			PhysEndpoint o = ep[j - 1];
+			u32 a = e.Id >> 1, b = o.Id >> 1;
+
+			// Most crossings are between boxes that are nowhere near each other on
+			// the other axes, so those get checked before the pair list is touched.
+			if(!(e.Id & 1) && (o.Id & 1)) {
+				// A min passed a max, the two now overlap on this axis.
+				if(Boxes_OverlapAxis(&c->Boxes[a], &c->Boxes[b], (axis + 1) % 3) &&
+				   Boxes_OverlapAxis(&c->Boxes[a], &c->Boxes[b], (axis + 2) % 3) &&
+				   !(c->Static[a] && c->Static[b]))
+					PhysPair_Add(c, a, b);
+			} else if((e.Id & 1) && !(o.Id & 1)) {
+				// A max passed a min, they don't overlap anymore. A pair overlapped on
+				// every axis before, so if a later axis doesn't overlap now, sorting
+				// that axis will come across them too and remove it there.
+				bool8 remove = 1;
+				for(u32 k = axis + 1; k < 3 && remove; k++)
+					remove = Boxes_OverlapAxis(&c->Boxes[a], &c->Boxes[b], k);
+
+				if(remove)
+					PhysPair_Remove(c, a, b);
+			}
+
+			ep[j] = o;
+		}
+
+		ep[j] = e;
+	}
+}
+
+static void PhysWorld_SweepAndPrune(PhysWorld* world)
+{
+	PhysWorld_Cache* c = world->_cache;
+	u32 old = c->NumSorted;
+
+	// A few new objects get sorted in, but lots of them are quicker to sort from scratch.
+	if(!c->Axes[0] || c->NumObjects - old > old / 4) {
+		PhysWorld_Rebuild(world);
+		return;
+	}
+
+	if(c->NumObjects > old)
+		PhysWorld_Grow(world);
+
+	PhysWorld_RefreshEndpoints(world);
+	for(u32 axis = 0; axis < 3; axis++)
+		PhysWorld_SortAxis(world, axis);
+}
+
+typedef struct {
+	PhysWorld_Cache* Cache;
+	u32 Object;
+} PhysWorld_PairQuery;
+
+static bool8 PhysWorld_PairQuery_Func(void* user, u32 other)
+{
+	PhysWorld_PairQuery* q = user;
+	PhysWorld_Cache* c     = q->Cache;
+
+	if(other == q->Object || (c->Static[other] && c->Static[q->Object]))
+		return 1;
+
+	// Both moved, the one with the lower index already found this pair.
+	if(other < q->Object && c->Tree.Nodes[c->Leaves[other]].Moved)
+		return 1;
+
+	PhysPair_Add(c, q->Object, other);
+	return 1;
+}
+
+// Thank you,
+// https://github.com/erincatto/box2d/blob/v2.4.1/src/collision/b2_broad_phase.cpp
+// Only leaves that were moved in the tree can have new neighbours, so only they look for them.
+static void PhysWorld_TreePairs(PhysWorld* world)
+{
+	PhysWorld_Cache* c    = world->_cache;
+	AABBTree_Node* nodes = c->Tree.Nodes;
+
+	// Drop the pairs that came apart. Going backwards, because removing
+	// a pair moves the last one into its place.
+	for(u32 i = c->Pairs.Size; i-- > 0;) {
+		PhysPair p = c->Pairs.Data[i];
+		if(!Boxes_Overlap(&nodes[c->Leaves[p.A]].Box, &nodes[c->Leaves[p.B]].Box))
+			PhysPair_Remove(c, p.A, p.B);
+	}
+
+	for(u32 i = 0; i < c->NumObjects; i++) {
+		if(!nodes[c->Leaves[i]].Moved)
+			continue;
+
+		PhysWorld_PairQuery q = { .Cache = c, .Object = i };
+		AABBTree_Query(&c->Tree, nodes[c->Leaves[i]].Box, PhysWorld_PairQuery_Func, &q);
+	}
+
+	for(u32 i = 0; i < c->NumObjects; i++)
+		nodes[c->Leaves[i]].Moved = 0;
+}
+
+// Thank you,
+// https://developer.nvidia.com/gpugems/gpugems3/part-v-physics-simulation/chapter-32-broad-phase-collision-detection-cuda
+// https://fgiesen.wordpress.com/2009/12/13/decoding-morton-codes/
+//
+// Space is cut into cubes a bit bigger than the median box, and every box is listed once for each
+// cell it covers, keyed by the cell's Morton code. Radix sorting the list puts everything in the
+// same cell next to each other, so pairs come out of one flat pass over short runs, which gets
+// split up between the job threads. The pairs that were found get sorted too, and merged with
+// the last update's, so only the ones that started or stopped overlapping touch the pair list.
+
+#define PHYSGRID_CELL_SCALE 2 // Cells are this many times bigger than the median box, so most boxes cover a few of them.
+#define PHYSGRID_MAX_SPAN   4 // Boxes this many cells across don't go in the grid, they're tested against everything.
+
+// Spread the low 21 bits of `x` out to every third bit.
+static inline u64 Morton_Spread(u64 x)
+{
+	x &= 0x1FFFFF;
+	x = (x | x << 32) & 0x1F00000000FFFFull;
+	x = (x | x << 16) & 0x1F0000FF0000FFull;
+	x = (x | x << 8)  & 0x100F00F00F00F00Full;
+	x = (x | x << 4)  & 0x10C30C30C30C30C3ull;
+	x = (x | x << 2)  & 0x1249249249249249ull;
+	return x;
+}
+
+// Gather every third bit back together.
+static inline u32 Morton_Compact(u64 x)
+{
+	x &= 0x1249249249249249ull;
+	x = (x | x >> 2)  & 0x10C30C30C30C30C3ull;
+	x = (x | x >> 4)  & 0x100F00F00F00F00Full;
+	x = (x | x >> 8)  & 0x1F0000FF0000FFull;
+	x = (x | x >> 16) & 0x1F00000000FFFFull;
+	x = (x | x >> 32) & 0x1FFFFF;
+	return (u32) x;
+}
+
+static inline u64 Morton_Encode(u32 x, u32 y, u32 z)
+{
+	return Morton_Spread(x) | Morton_Spread(y) << 1 | Morton_Spread(z) << 2;
+}
+
+// Least significant byte first, bytes that are the same in every key get skipped, so small
+// keys only take a few passes. `values` can be NULL. Both halves of `keys` and `values`
+// get used, returns the index of the sorted one.
+static u32 Radix_Sort(u64* keys[2], u32* values[2], u32 n, u64 maxKey)
+{
+	// Every byte gets counted in one go.
+	u32 numBytes = 0;
+	while(numBytes < 8 && (maxKey >> (numBytes * 8)))
+		numBytes++;
+
+	u32 histograms[8][256];
+	memset(histograms, 0, sizeof(u32) * 256 * numBytes);
+
+	for(u32 i = 0; i < n; i++) {
+		u64 key = keys[0][i];
+		for(u32 b = 0; b < numBytes; b++)
+			histograms[b][(key >> (b * 8)) & 0xFF]++;
+	}
+
+	u32 in = 0;
+	for(u32 byte = 0; byte < numBytes; byte++) {
+		const u64* src = keys[in];
+		u64* dst       = keys[in ^ 1];
+		u32* counts    = histograms[byte];
+		u32 shift      = byte * 8;
+
+		if(counts[(src[0] >> shift) & 0xFF] == n)
+			continue;
+
+		u32 offset = 0;
+		for(u32 b = 0; b < 256; b++) {
+			u32 count = counts[b];
+			counts[b] = offset;
+			offset   += count;
+		}
+
+		if(values) {
+			for(u32 i = 0; i < n; i++) {
+				u32 to             = counts[(src[i] >> shift) & 0xFF]++;
+				dst[to]            = src[i];
+				values[in ^ 1][to] = values[in][i];
+			}
+		} else {
+			for(u32 i = 0; i < n; i++)
+				dst[counts[(src[i] >> shift) & 0xFF]++] = src[i];
+		}
+
+		in ^= 1;
+	}
+
+	return in;
+}
+
+// Thank you,
+// https://en.wikipedia.org/wiki/Quickselect
+// Shuffles `values` around.
+static r32 PhysGrid_Median(r32* values, u32 n)
+{
+	i32 k = n / 2, lo = 0, hi = n - 1;
+
+	while(lo < hi) {
+		r32 pivot = values[lo + (hi - lo) / 2];
+		i32 i = lo, j = hi;
+
+		while(i <= j) {
+			while(values[i] < pivot) i++;
+			while(values[j] > pivot) j--;
+			if(i <= j) {
+				r32 tmp     = values[i];
+				values[i++] = values[j];
+				values[j--] = tmp;
+			}
+		}
+
+		if(k <= j)
+			hi = j;
+		else if(k >= i)
+			lo = i;
+		else
+			break;
+	}
+
+	return values[k];
+}
+
+typedef struct {
+	PhysWorld_Cache* Cache;
+	const u64* Keys;
+	const u32* Objects;
+	u32 NumRuns, NumChunks;
+
+	Vec3 Origin;
+	r32 InvSize;
+} PhysGrid;
+
+static inline u32 PhysGrid_Coord(const PhysGrid* g, r32 v, r32 origin)
+{
+	r32 cell = (v - origin) * g->InvSize;
+	return cell <= 0 ? 0 : cell >= 0x1FFFFF ? 0x1FFFFF : (u32) cell;
+}
+
+// Test everything that shares a cell. Two boxes can share a few cells, so a pair
+// only counts in the one where their overlap starts, the highest of their first cells.
+static void PhysGrid_Pairs(void* data, u32 begin, u32 end)
+{
+	const PhysGrid* g        = data;
+	const PhysWorld_Cache* c = g->Cache;
+
+	for(u32 chunk = begin; chunk < end; chunk++) {
+		Array_u64* out = &c->ChunkPairs[chunk];
+		out->Size = 0;
+
+		u32 first = (u64) chunk * g->NumRuns / g->NumChunks;
+		u32 last  = (u64) (chunk + 1) * g->NumRuns / g->NumChunks;
+
+		for(u32 r = first; r < last; r++) {
+			u32 runStart = c->Runs[r * 2], runEnd = c->Runs[r * 2 + 1];
+
+			u64 key = g->Keys[runStart];
+			u32 x = Morton_Compact(key), y = Morton_Compact(key >> 1), z = Morton_Compact(key >> 2);
+
+			for(u32 i = runStart; i < runEnd; i++) {
+				u32 a            = g->Objects[i] >> 1;
+				bool8 staticA    = g->Objects[i] & 1;
+				const AABB* boxA = &c->Boxes[a];
+				const u32* cellA = &c->FirstCell[a * 3];
+
+				for(u32 j = i + 1; j < runEnd; j++) {
+					u32 b            = g->Objects[j] >> 1;
+					const u32* cellB = &c->FirstCell[b * 3];
+
+					if((staticA && (g->Objects[j] & 1)) || !Boxes_Overlap(boxA, &c->Boxes[b]))
+						continue;
+					if(MAX(cellA[0], cellB[0]) != x || MAX(cellA[1], cellB[1]) != y || MAX(cellA[2], cellB[2]) != z)
+						continue;
+
+					Array_u64_PushVal(out, (u64) MIN(a, b) << 32 | MAX(a, b));
+				}
+			}
+		}
+	}
+}
+
+static void PhysWorld_GridPairs(PhysWorld* world)
+{
+	PhysWorld_Cache* c = world->_cache;
+	u32 n = c->NumObjects;
+
+	if(!n)
+		return;
+
+	// 1. Pick the cell size, and see which boxes are too big and where the grid starts.
+	for(u32 i = 0; i < n; i++) {
+		Vec3 size     = Vec3_Sub(c->Boxes[i].Max, c->Boxes[i].Min);
+		c->Extents[i] = MAX3(size.x, size.y, size.z);
+	}
+
+	r32 size = PhysGrid_Median(c->Extents, n) * PHYSGRID_CELL_SCALE;
+	PhysGrid g = {
+		.Cache   = c,
+		.InvSize = (size > 0 ? 1 / size : 1),
+		.Origin  = V3(INFINITY, INFINITY, INFINITY),
+	};
+
+	u32 numEntries = 0;
+	for(u32 i = 0; i < n; i++) {
+		const AABB* box = &c->Boxes[i];
+		Vec3 span       = Vec3_MultScal(Vec3_Sub(box->Max, box->Min), g.InvSize);
+
+		c->Big[i] = !(MAX3(span.x, span.y, span.z) < PHYSGRID_MAX_SPAN);
+		if(c->Big[i])
+			continue;
+
+		g.Origin = V3(MIN(g.Origin.x, box->Min.x), MIN(g.Origin.y, box->Min.y), MIN(g.Origin.z, box->Min.z));
+		numEntries += (u32) (span.x + 2) * (u32) (span.y + 2) * (u32) (span.z + 2);
+	}
+
+	if(numEntries > c->CellCapacity) {
+		c->CellCapacity = MAX(numEntries, c->CellCapacity * 2);
+		for(u32 i = 0; i < 2; i++) {
+			c->CellKeys[i]    = Reallocate(c->CellKeys[i], sizeof(u64) * c->CellCapacity);
+			c->CellObjects[i] = Reallocate(c->CellObjects[i], sizeof(u32) * c->CellCapacity);
+		}
+		c->Runs = Reallocate(c->Runs, sizeof(u32) * c->CellCapacity);
+	}
+
+	// 2. List the cells every box covers, and sort them.
+	u64 maxKey = 0;
+	numEntries = 0;
+
+	for(u32 i = 0; i < n; i++) {
+		if(c->Big[i])
+			continue;
+
+		const AABB* box = &c->Boxes[i];
+		u32* cell       = &c->FirstCell[i * 3];
+		cell[0] = PhysGrid_Coord(&g, box->Min.x, g.Origin.x);
+		cell[1] = PhysGrid_Coord(&g, box->Min.y, g.Origin.y);
+		cell[2] = PhysGrid_Coord(&g, box->Min.z, g.Origin.z);
+
+		u32 x1 = PhysGrid_Coord(&g, box->Max.x, g.Origin.x);
+		u32 y1 = PhysGrid_Coord(&g, box->Max.y, g.Origin.y);
+		u32 z1 = PhysGrid_Coord(&g, box->Max.z, g.Origin.z);
+
+		for(u32 z = cell[2]; z <= z1; z++)
+			for(u32 y = cell[1]; y <= y1; y++)
+				for(u32 x = cell[0]; x <= x1; x++) {
+					u64 key = Morton_Encode(x, y, z);
+					maxKey |= key;
+
+					c->CellKeys[0][numEntries]      = key;
+					c->CellObjects[0][numEntries++] = i << 1 | c->Static[i];
+				}
+	}
+
+	u32 sorted = numEntries ? Radix_Sort(c->CellKeys, c->CellObjects, numEntries, maxKey) : 0;
+	g.Keys     = c->CellKeys[sorted];
+	g.Objects  = c->CellObjects[sorted];
+
+	// 3. Find the cells with more than one box in them.
+	for(u32 i = 0; i < numEntries;) {
+		u32 j = i + 1;
+		while(j < numEntries && g.Keys[j] == g.Keys[i])
+			j++;
+
+		if(j - i > 1) {
+			c->Runs[g.NumRuns * 2]     = i;
+			c->Runs[g.NumRuns * 2 + 1] = j;
+			g.NumRuns++;
+		}
+		i = j;
+	}
+
+	// 4. Test the runs in chunks, a few for every thread, and big boxes against everything.
+	g.NumChunks = MIN(MAX(g.NumRuns / 64, 1), Job_NumThreads() * 4);
+	if(g.NumChunks + 1 > c->NumChunks) {
+		c->ChunkPairs = Reallocate(c->ChunkPairs, sizeof(Array_u64) * (g.NumChunks + 1));
+		memset(c->ChunkPairs + c->NumChunks, 0, sizeof(Array_u64) * (g.NumChunks + 1 - c->NumChunks));
+		c->NumChunks = g.NumChunks + 1;
+	}
+
+	Job_ParallelFor(g.NumChunks, 1, PhysGrid_Pairs, &g);
+
+	Array_u64* bigPairs = &c->ChunkPairs[g.NumChunks];
+	bigPairs->Size      = 0;
+
+	for(u32 i = 0; i < n; i++) {
+		if(!c->Big[i])
+			continue;
+
+		for(u32 j = 0; j < n; j++) {
+			if(j == i || (c->Big[j] && j < i) || (c->Static[i] && c->Static[j]))
+				continue;
+			if(Boxes_Overlap(&c->Boxes[i], &c->Boxes[j]))
+				Array_u64_PushVal(bigPairs, (u64) MIN(i, j) << 32 | MAX(i, j));
+		}
+	}
+
+	// 5. Sort what was found, and go through it next to the last update's pairs.
+	u32 numFound = 0;
+	for(u32 chunk = 0; chunk <= g.NumChunks; chunk++)
+		numFound += c->ChunkPairs[chunk].Size;
+
+	if(numFound > c->PairKeyCapacity) {
+		c->PairKeyCapacity = MAX(numFound, c->PairKeyCapacity * 2);
+		for(u32 i = 0; i < 3; i++)
+			c->PairKeys[i] = Reallocate(c->PairKeys[i], sizeof(u64) * c->PairKeyCapacity);
+	}
+
+	u64* found  = c->PairKeys[1];
+	u64 maxPair = (u64) n << 32;
+	numFound    = 0;
+
+	for(u32 chunk = 0; chunk <= g.NumChunks; chunk++) {
+		const Array_u64* pairs = &c->ChunkPairs[chunk];
+		if(pairs->Size)
+			memcpy(found + numFound, pairs->Data, sizeof(u64) * pairs->Size);
+		numFound += pairs->Size;
+	}
+
+	if(numFound)
+		found = c->PairKeys[1 + Radix_Sort(&c->PairKeys[1], NULL, numFound, maxPair)];
+
+	const u64* old = c->PairKeys[0];
+	u32 i = 0, j = 0;
+
+	while(i < c->NumPairKeys || j < numFound) {
+		if(j == numFound || (i < c->NumPairKeys && old[i] < found[j])) {
+			PhysPair_Remove(c, old[i] >> 32, (u32) old[i]);
+			i++;
+		} else if(i == c->NumPairKeys || found[j] < old[i]) {
+			PhysPair_Add(c, found[j] >> 32, (u32) found[j]);
+			j++;
+		} else {
+			i++, j++;
+		}
+	}
+
+	// The found pairs are the pair list now.
+	u32 result          = (found == c->PairKeys[1] ? 1 : 2);
+	c->PairKeys[result] = c->PairKeys[0];
+	c->PairKeys[0]      = found;
+	c->NumPairKeys      = numFound;
+}
+
+void PhysWorld_Init(PhysWorld* world)
+{
+	world->Gravity    = 9.8;
+	world->Iterations = 10;
+	world->Objects    = (Array_PhysObject) {0};
+	world->Broadphase = PhysBroadphase_SweepAndPrune;
+	world->_cache     = NULL;
+}
+
+void PhysWorld_Free(PhysWorld* world)
+{
+	PhysWorld_Cache* c = world->_cache;
+
+	if(c) {
+		PhysWorld_Reset(world);
+
+		if(c->Boxes) {
+			Free(c->Boxes);
+			Free(c->Static);
+			Free(c->Leaves);
+			Free(c->Big);
+			Free(c->Extents);
+			Free(c->FirstCell);
+
+			Free(c->Bodies);
+			Free(c->IslandOf);
+			Free(c->IslandIndex);
+			Free(c->IslandAwake);
+			Free(c->IslandBodies);
+			Free(c->Islands);
+		}
+		if(c->Constraints)
+			Free(c->Constraints);
+		if(c->Runs) {
+			Free(c->CellKeys[0]);
+			Free(c->CellKeys[1]);
+			Free(c->CellObjects[0]);
+			Free(c->CellObjects[1]);
+			Free(c->Runs);
+		}
+		if(c->PairKeys[0]) {
+			for(u32 i = 0; i < 3; i++)
+				Free(c->PairKeys[i]);
+		}
+		for(u32 i = 0; i < c->NumChunks; i++)
+			Array_u64_Free(&c->ChunkPairs[i]);
+		if(c->ChunkPairs)
+			Free(c->ChunkPairs);
+		Free(c->PairIndex);
+		Array_PhysPair_Free(&c->Pairs);
+		Free(c);
+	}
+
+	Array_PhysObject_Free(&world->Objects);
+	world->_cache = NULL;
+}
+
+const PhysPair* PhysWorld_GetPairs(const PhysWorld* world, u32* outNumPairs)
+{
+	if(!world->_cache) {
+		*outNumPairs = 0;
+		return NULL;
+	}
+
+	*outNumPairs = world->_cache->Pairs.Size;
+	return world->_cache->Pairs.Data;
+}
+
+PhysWorld_Stats PhysWorld_GetStats(const PhysWorld* world)
+{
+	return (world->_cache ? world->_cache->Stats : (PhysWorld_Stats) {0});
+}
+
+// Where the ray first hits an object: its hull, or its shape, or just its box.
+static Intersection PhysObject_RayIntersect(const PhysWorld* world, u32 object, Ray ray, r32 maxT)
+{
+	const PhysObject* o = &world->Objects.Data[object];
+
+	if(o->Hull.NumTris) {
+		Mat4 toWorld, toLocal;
+		TriHull_Space(&o->Hull, toWorld, toLocal);
+		Ray local = { .Start = Affine_Point(toLocal, ray.Start), .Dir = Affine_Dir(toLocal, ray.Dir) };
+
+		r32 t;
+		i32 tri = TriHull_RayClosest(&o->Hull, local, maxT, &t);
+		return TriHull_RayResult(&o->Hull, toLocal, ray, tri, t);
+	}
+
+	if(o->Shape.Type != PhysShapeType_None)
+		return PhysShape_RayIntersect(&o->Shape, &o->Transform, ray, maxT);
+
+	// No hull, the box will have to do. The normal is whichever side the point is closest to.
+	const AABB* box = &world->_cache->Boxes[object];
+	Vec3 invDir     = V3C(1.0f / ray.Dir.x, 1.0f / ray.Dir.y, 1.0f / ray.Dir.z);
+
+	r32 t;
+	if(!Ray_HitsBox(ray.Start, invDir, box, maxT, &t))
+		return (Intersection) { .Occurred = 0 };
+
+	Intersection res = { .Occurred = 1, .Point = Vec3_Add(ray.Start, Vec3_MultScal(ray.Dir, t)), .T = t };
+	r32 closest      = FLT_MAX;
+
+	for(u32 axis = 0; axis < 3; axis++) {
+		r32 toMin = fabsf(res.Point.d[axis] - box->Min.d[axis]);
+		r32 toMax = fabsf(res.Point.d[axis] - box->Max.d[axis]);
+
+		if(MIN(toMin, toMax) < closest) {
+			closest            = MIN(toMin, toMax);
+			res.Normal         = V3(0, 0, 0);
+			res.Normal.d[axis] = (toMin < toMax ? -1 : 1);
+		}
+	}
+
+	return res;
+}
+
+typedef struct {
+	const PhysWorld* World;
+	u32 Mask;
+	PhysRayHit* Hit;
+} PhysWorld_RayQuery;
+
+static r32 PhysWorld_RayQuery_Func(void* user, u32 object, Ray ray, r32 maxT)
+{
+	PhysWorld_RayQuery* q = user;
+	if(object >= q->World->Objects.Size)
+		return maxT;
+
+	u32 layers = q->World->Objects.Data[object].Layers;
+	if(q->Mask && !((layers ? layers : 1) & q->Mask))
+		return maxT;
+
+	Intersection res = PhysObject_RayIntersect(q->World, object, ray, maxT);
+	if(!res.Occurred || res.T > maxT)
+		return maxT;
+
+	*q->Hit = (PhysRayHit) { .Object = object, .Point = res.Point, .Normal = res.Normal, .T = res.T };
+	return res.T;
+}
+
+static void PhysWorld_RayCast(const PhysWorld* world, const PhysRay* ray, PhysRayHit* out)
+{
+	*out = (PhysRayHit) { .Object = -1 };
+
+	PhysWorld_RayQuery q = { .World = world, .Mask = ray->Mask, .Hit = out };
+	AABBTree_RayCast(&world->_cache->Tree, ray->Ray, (ray->MaxT > 0 ? ray->MaxT : FLT_MAX), PhysWorld_RayQuery_Func, &q);
+}
+
+PhysObject*
+PhysWorld_RayCollide(const PhysWorld* world, Ray ray)
+{
+	if(!world->_cache)
+		return NULL;
+
+	PhysRay r = { .Ray = ray };
+	PhysRayHit hit;
+	PhysWorld_RayCast(world, &r, &hit);
+	return (hit.Object >= 0 ? &world->Objects.Data[hit.Object] : NULL);
+}
+
+typedef struct {
+	const PhysWorld* World;
+	const PhysRay* Rays;
+	const u32* Order;
+	PhysRayHit* Out;
+} PhysWorld_RayBatch;
+
+static void PhysWorld_RayCastBatch(void* data, u32 begin, u32 end)
+{
+	const PhysWorld_RayBatch* b = data;
+
+	for(u32 i = begin; i < end; i++) {
+		u32 ray = b->Order[i];
+		PhysWorld_RayCast(b->World, &b->Rays[ray], &b->Out[ray]);
+	}
+}
+
+// Rays that point the same way from about the same place get sorted next to each other,
+// so they end up in the same batch, walk the same part of the tree and test the same
+// objects while those are still in the cache.
+void PhysWorld_RayCastMany(const PhysWorld* world, const PhysRay* rays, u32 numRays, PhysRayHit* out)
+{
+	if(!world->_cache) {
+		for(u32 i = 0; i < numRays; i++)
+			out[i] = (PhysRayHit) { .Object = -1 };
+		return;
+	}
+
+	if(numRays < PHYSRAY_BATCH) {
+		for(u32 i = 0; i < numRays; i++)
+			PhysWorld_RayCast(world, &rays[i], &out[i]);
+		return;
+	}
+
+	// Keyed on which way they point (the signs of Dir), then the Morton code of where they start.
+	Vec3 lo = rays[0].Ray.Start, hi = lo;
+	for(u32 i = 1; i < numRays; i++) {
+		Vec3 p = rays[i].Ray.Start;
+		lo = V3(MIN(lo.x, p.x), MIN(lo.y, p.y), MIN(lo.z, p.z));
+		hi = V3(MAX(hi.x, p.x), MAX(hi.y, p.y), MAX(hi.z, p.z));
+	}
+
+	Vec3 scale = V3(hi.x > lo.x ? 1023 / (hi.x - lo.x) : 0,
+	                hi.y > lo.y ? 1023 / (hi.y - lo.y) : 0,
+	                hi.z > lo.z ? 1023 / (hi.z - lo.z) : 0);
+
+	u64* keys[2]  = { Allocate(sizeof(u64) * numRays), Allocate(sizeof(u64) * numRays) };
+	u32* order[2] = { Allocate(sizeof(u32) * numRays), Allocate(sizeof(u32) * numRays) };
+	u64 maxKey    = 0;
+
+	for(u32 i = 0; i < numRays; i++) {
+		const Ray* r = &rays[i].Ray;
+		u64 octant   = (r->Dir.x < 0) | (r->Dir.y < 0) << 1 | (r->Dir.z < 0) << 2;
+
+		keys[0][i]  = octant << 30 | Morton_Encode((r->Start.x - lo.x) * scale.x,
+		                                           (r->Start.y - lo.y) * scale.y,
+		                                           (r->Start.z - lo.z) * scale.z);
+		order[0][i] = i;
+		maxKey     |= keys[0][i];
+	}
+
+	u32 sorted = Radix_Sort(keys, order, numRays, maxKey);
+
+	PhysWorld_RayBatch batch = { .World = world, .Rays = rays, .Order = order[sorted], .Out = out };
+	Job_ParallelFor(numRays, PHYSRAY_BATCH, PhysWorld_RayCastBatch, &batch);
+
+	for(u32 i = 0; i < 2; i++) {
+		Free(keys[i]);
+		Free(order[i]);
+	}
+}
+
+typedef struct {
+	const PhysWorld_Cache* Cache;
+	AABB Box;
+	Array_u32* Out;
+} PhysWorld_BoxQuery;
+
+static bool8 PhysWorld_BoxQuery_Func(void* user, u32 object)
+{
+	PhysWorld_BoxQuery* q = user;
+
+	// The tree only knows about the fattened boxes.
+	if(Boxes_Overlap(&q->Cache->Boxes[object], &q->Box))
+		Array_u32_Push(q->Out, &object);
+	return 1;
+}
+
+void PhysWorld_QueryAABB(const PhysWorld* world, AABB box, Array_u32* outObjects)
+{
+	if(!world->_cache)
+		return;
+
+	PhysWorld_BoxQuery q = { .Cache = world->_cache, .Box = AABB_Fix(box), .Out = outObjects };
+	AABBTree_Query(&world->_cache->Tree, q.Box, PhysWorld_BoxQuery_Func, &q);
+}
+
+//
+// Rigid bodies
+//
+
+// Points further apart than this, or that slid this far apart, aren't touching anymore.
+static const r32 contactMargin = 0.02f;
+
+// How much of the overlap gets pushed out each update, and how much of it is left alone
+// so resting objects keep touching instead of bouncing in and out of each other.
+static const r32 baumgarte        = 0.2f;
+static const r32 penetrationSlop  = 0.005f;
+static const r32 maxBiasVelocity  = 4.0f;
+static const r32 restitutionSpeed = 1.0f; // Slower hits than this don't bounce.
+
+// Swept bodies stop this far away from what they'd hit, close enough for a contact to pick it up.
+static const r32 sweepDistance = 0.5f * contactMargin;
+
+static const r32 sleepLinear  = 0.05f; // Meters per second
+static const r32 sleepAngular = 0.05f; // Radians per second
+static const r32 timeToSleep  = 0.5f;
+
+static inline Vec3 Rotate_Vec3(Quat q, Vec3 v)
+{
+	Vec3 u = q.xyz;
+	Vec3 t = Vec3_MultScal(Vec3_Cross(u, v), 2);
+	return Vec3_Add(Vec3_Add(v, Vec3_MultScal(t, q.w)), Vec3_Cross(u, t));
+}
+
+static inline Vec3 Unrotate_Vec3(Quat q, Vec3 v)
+{
+	q.xyz = Vec3_Neg(q.xyz);
+	return Rotate_Vec3(q, v);
+}
+
+// Thank you,
+// https://jcgt.org/published/0006/01/01/
+// Two directions perpendicular to the normal and each other, always the same ones for the same normal.
+static inline void Phys_Tangents(Vec3 n, Vec3* t1, Vec3* t2)
+{
+	r32 sign = copysignf(1, n.z);
+	r32 a    = -1 / (sign + n.z);
+	r32 b    = n.x * n.y * a;
+
+	*t1 = V3(1 + sign * n.x * n.x * a, sign * b, -sign * n.x);
+	*t2 = V3(b, sign + n.y * n.y * a, -n.y);
+}
+
+//
+// Manifolds
+//
+
+// Drop the points the objects moved away from, and update how far apart the rest are.
+static void PhysManifold_Refresh(PhysManifold* m, const Transform3D* ta, const Transform3D* tb)
+{
+	for(u32 i = m->NumPoints; i-- > 0;) {
+		PhysManifoldPoint* p = &m->Points[i];
+
+		Vec3 pa = Vec3_Add(ta->Position, Rotate_Vec3(ta->Rotation, p->LocalA));
+		Vec3 pb = Vec3_Add(tb->Position, Rotate_Vec3(tb->Rotation, p->LocalB));
+		Vec3 d  = Vec3_Sub(pb, pa);
+
+		p->Distance = Vec3_Dot(d, p->Normal);
+		Vec3 slide  = Vec3_Sub(d, Vec3_MultScal(p->Normal, p->Distance));
+
+		if(p->Distance > contactMargin || Vec3_Len2(slide) > contactMargin * contactMargin)
+			m->Points[i] = m->Points[--m->NumPoints];
+	}
+}
+
+// Thank you,
+// https://github.com/bulletphysics/bullet3/blob/master/src/BulletCollision/NarrowPhaseCollision/btPersistentManifold.cpp
+// The area of four points that can come in any order, going by whichever two of the
+// lines between them are the diagonals. That's the pair that crosses the most.
+static inline r32 Quad_Area2(Vec3 a, Vec3 b, Vec3 c, Vec3 d)
+{
+	r32 ac = Vec3_Len2(Vec3_Cross(Vec3_Sub(a, c), Vec3_Sub(b, d)));
+	r32 ab = Vec3_Len2(Vec3_Cross(Vec3_Sub(a, b), Vec3_Sub(c, d)));
+	r32 ad = Vec3_Len2(Vec3_Cross(Vec3_Sub(a, d), Vec3_Sub(b, c)));
+	return MAX3(ac, ab, ad);
+}
+
+// With a full manifold, the new point takes the place of whichever one leaves the biggest
+// area behind. The deepest point always stays, that's the one doing the most work.
+// Returns PHYSMANIFOLD_MAX_POINTS if the new point is better left out: objects resting
+// flat on each other keep coming up with points in the middle of the face, and trading
+// a corner for one of those would only make the patch smaller.
+static u32 PhysManifold_Replace(const PhysManifold* m, const PhysManifoldPoint* p)
+{
+	u32 deepest = 0;
+	for(u32 i = 1; i < PHYSMANIFOLD_MAX_POINTS; i++) {
+		if(m->Points[i].Distance < m->Points[deepest].Distance)
+			deepest = i;
+	}
+
+	// Depths closer together than the slop are as good as the same.
+	if(p->Distance < m->Points[deepest].Distance - penetrationSlop)
+		deepest = PHYSMANIFOLD_MAX_POINTS;
+
+	const PhysManifoldPoint* q = m->Points;
+	r32 area = Quad_Area2(q[0].LocalA, q[1].LocalA, q[2].LocalA, q[3].LocalA);
+
+	u32 best     = PHYSMANIFOLD_MAX_POINTS;
+	r32 bestArea = (deepest == PHYSMANIFOLD_MAX_POINTS ? -1 : area);
+	for(u32 i = 0; i < PHYSMANIFOLD_MAX_POINTS; i++) {
+		if(i == deepest)
+			continue;
+
+		Vec3 r[4];
+		for(u32 j = 0; j < PHYSMANIFOLD_MAX_POINTS; j++)
+			r[j] = (j == i ? p->LocalA : q[j].LocalA);
+
+		area = Quad_Area2(r[0], r[1], r[2], r[3]);
+		if(area > bestArea) {
+			bestArea = area;
+			best     = i;
+		}
+	}
+
+	return best;
+}
+
+// The point that's within the margin of `localA`, or -1 if there isn't one.
+static i32 PhysManifold_Find(const PhysManifold* m, Vec3 localA)
+{
+	for(u32 i = 0; i < m->NumPoints; i++) {
+		if(Vec3_Len2(Vec3_Sub(m->Points[i].LocalA, localA)) < contactMargin * contactMargin)
+			return i;
+	}
+	return -1;
+}
+
+static void PhysManifold_Add(PhysManifold* m, const Transform3D* ta, const Transform3D* tb,
+                             Vec3 pointA, Vec3 pointB, Vec3 normal, r32 distance)
+{
+	PhysManifoldPoint p = {
+		.LocalA   = Unrotate_Vec3(ta->Rotation, Vec3_Sub(pointA, ta->Position)),
+		.LocalB   = Unrotate_Vec3(tb->Rotation, Vec3_Sub(pointB, tb->Position)),
+		.Normal   = normal,
+		.Distance = distance,
+	};
+
+	// The same point as last time keeps its impulses, so the solver can start from them.
+	i32 same = PhysManifold_Find(m, p.LocalA);
+	if(same >= 0) {
+		PhysManifoldPoint* old = &m->Points[same];
+		p.NormalImpulse     = old->NormalImpulse;
+		p.TangentImpulse[0] = old->TangentImpulse[0];
+		p.TangentImpulse[1] = old->TangentImpulse[1];
+		*old = p;
+		return;
+	}
+
+	if(m->NumPoints < PHYSMANIFOLD_MAX_POINTS) {
+		m->Points[m->NumPoints++] = p;
+	} else {
+		u32 i = PhysManifold_Replace(m, &p);
+		if(i < PHYSMANIFOLD_MAX_POINTS)
+			m->Points[i] = p;
+	}
+}
+
+// Thank you,
+// https://github.com/bulletphysics/bullet3/blob/master/src/BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.cpp
+// Tilt the smaller object a little bit four ways around the normal and see which of its
+// corners would touch, so a box that lands flat gets all four corners right away.
+static void PhysWorld_Perturb(const PhysObject* a, const PhysObject* b, PhysPair* pair)
+{
+	const PhysContact* c = &pair->Contact;
+
+	r32 reachA  = PhysShape_Reach(&a->Shape, &a->Transform);
+	r32 reachB  = PhysShape_Reach(&b->Shape, &b->Transform);
+	bool8 tiltA = (reachA <= reachB);
+	r32 reach   = (tiltA ? reachA : reachB);
+	if(reach <= 0)
+		return;
+
+	r32 angle = MIN(contactMargin / reach, 0.3927f); // No more than 22.5 degrees
+
+	// Tilting around an axis that lines up with an edge lowers the whole edge, and all that
+	// comes back is a point in its middle. Objects tend to be lined up with the world, and so
+	// with the tangents, so the axes are turned 22.5 degrees away from them to land on corners.
+	Vec3 t1, t2;
+	Phys_Tangents(c->Normal, &t1, &t2);
+
+	Vec3 u1 = Vec3_Add(Vec3_MultScal(t1, 0.92388f), Vec3_MultScal(t2, 0.38268f));
+	Vec3 u2 = Vec3_Cross(c->Normal, u1);
+
+	for(u32 i = 0; i < 4; i++) {
+		Vec3 axis = (i & 1 ? u2 : u1);
+		Quat tilt = Quat_RotAxis(i & 2 ? Vec3_Neg(axis) : axis, angle);
+
+		Transform3D ta = a->Transform, tb = b->Transform;
+		Transform3D* tilted = (tiltA ? &ta : &tb);
+		tilted->Rotation    = Quat_Mult(tilted->Rotation, tilt); // Quat_Mult(a, b) turns by a, then by b.
+
+		GJK_Cache cache = pair->Cache;
+		PhysContact res;
+		PhysShape_Contact(&a->Shape, &ta, &b->Shape, &tb, &cache, &res);
+
+		// Untilt the tilted side's point, it's a corner that's there on the real object too.
+		Vec3 pa = res.PointA, pb = res.PointB;
+		Vec3* p = (tiltA ? &pa : &pb);
+		*p = Vec3_Add(tilted->Position, Unrotate_Vec3(tilt, Vec3_Sub(*p, tilted->Position)));
+
+		r32 distance = Vec3_Dot(Vec3_Sub(pb, pa), c->Normal);
+		if(distance <= contactMargin)
+			PhysManifold_Add(&pair->Manifold, &a->Transform, &b->Transform, pa, pb, c->Normal, distance);
+	}
+}
+
+//
+// Solver
+//
+
+struct PhysBody {
+	Vec3 V, W; // Linear and angular velocity
+	r32 InvMass;
+	r32 InvInertia[9]; // In world space, row major.
+
+	// Only these get pushed around, everything else is read only,
+	// so islands can share the static objects they stand on.
+	bool8 Dynamic;
+
+	// Swept bodies only move once everything else has, see PhysWorld_Sweep().
+	bool8 Swept;
+	r32 Impact;        // How far into the update it first hits something, 1 if it doesn't.
+	Vec3 ImpactNormal; // Away from a triangle hull it hit, zero for anything else.
+	r32 ImpactBounce;
+};
+
+// One direction a point gets pushed in. Everything that doesn't change while the
+// solver goes over it is worked out once, so each pass is just a few dot products.
+typedef struct {
+	Vec3 Dir;
+	Vec3 AngularA, AngularB; // How much the direction turns each object, RA x Dir and RB x Dir.
+	Vec3 TurnA, TurnB;       // How much spin a unit impulse gives them, InvInertia * Angular.
+	r32 Mass;
+	r32 Impulse; // The total so far
+} PhysConstraintRow;
+
+typedef struct {
+	PhysConstraintRow Rows[3]; // The normal, then the two tangents.
+	r32 Bias;                  // The normal speed the point should end up with.
+} PhysConstraintPoint;
+
+struct PhysConstraint {
+	u32 A, B;
+	u32 Pair;
+	r32 Friction;
+
+	u32 NumPoints;
+	PhysConstraintPoint Points[PHYSMANIFOLD_MAX_POINTS];
+};
+
+struct PhysIsland {
+	u32 FirstBody, NumBodies;            // In IslandBodies
+	u32 FirstConstraint, NumConstraints; // In Constraints
+};
+
+// The solver goes over every point many times per update, and Math3D's functions live in
+// another file where they can't be inlined, so it does its own arithmetic.
+static inline r32 Body_Dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+static inline Vec3 Body_Cross(Vec3 a, Vec3 b)
+{
+	return (Vec3) { .x = a.y * b.z - a.z * b.y, .y = a.z * b.x - a.x * b.z, .z = a.x * b.y - a.y * b.x };
+}
+
+
+// a + b * s
+static inline Vec3 Body_MultAdd(Vec3 a, Vec3 b, r32 s)
+{
+	return (Vec3) { .x = a.x + b.x * s, .y = a.y + b.y * s, .z = a.z + b.z * s };
+}
+
+static inline Vec3 Inertia_Apply(const r32* m, Vec3 v)
+{
+	return (Vec3) { .x = m[0] * v.x + m[1] * v.y + m[2] * v.z,
+	                .y = m[3] * v.x + m[4] * v.y + m[5] * v.z,
+	                .z = m[6] * v.x + m[7] * v.y + m[8] * v.z };
+}
+
+// The inertia of the box around the object (or the ball, for spheres), turned into world space.
+static void PhysBody_Init(PhysBody* body, const PhysObject* o)
+{
+	memset(body, 0, sizeof(PhysBody));
+	body->V = o->Velocity;
+	body->W = o->AngularVelocity;
+
+	body->Dynamic = (o->Type == PhysObject_RigidBody && o->Mass > 0);
+	if(!body->Dynamic) {
+		// Static objects stay put no matter what their velocity says.
+		if(o->Type == PhysObject_Static)
+			body->V = body->W = V3(0, 0, 0);
+		return;
+	}
+
+	const Transform3D* t = &o->Transform;
+	r32 m = o->Mass;
+	Vec3 inertia;
+
+	if(o->Shape.Type == PhysShapeType_Sphere) {
+		r32 r   = o->Shape.Radius * MAX3(fabsf(t->Scale.x), fabsf(t->Scale.y), fabsf(t->Scale.z));
+		r32 i   = 0.4f * m * r * r;
+		inertia = V3(i, i, i);
+	} else {
+		AABB box = (o->Shape.Type != PhysShapeType_None ? PhysShape_AABB(&o->Shape) : o->AABB);
+		Vec3 h   = Vec3_MultScal(Vec3_Sub(box.Max, box.Min), 0.5f);
+		h        = V3(h.x * fabsf(t->Scale.x), h.y * fabsf(t->Scale.y), h.z * fabsf(t->Scale.z));
+
+		inertia = V3(m / 3 * (h.y * h.y + h.z * h.z),
+		             m / 3 * (h.x * h.x + h.z * h.z),
+		             m / 3 * (h.x * h.x + h.y * h.y));
+	}
+
+	r32 inv[3] = { inertia.x > 0 ? 1 / inertia.x : 0,
+	               inertia.y > 0 ? 1 / inertia.y : 0,
+	               inertia.z > 0 ? 1 / inertia.z : 0 };
+
+	// R * diag(inv) * R^T
+	Vec3 r[3] = { Rotate_Vec3(t->Rotation, V3(1, 0, 0)),
+	              Rotate_Vec3(t->Rotation, V3(0, 1, 0)),
+	              Rotate_Vec3(t->Rotation, V3(0, 0, 1)) };
+
+	for(u32 i = 0; i < 3; i++) {
+		for(u32 j = 0; j < 3; j++) {
+			body->InvInertia[i * 3 + j] = r[0].d[i] * inv[0] * r[0].d[j]
+			                            + r[1].d[i] * inv[1] * r[1].d[j]
+			                            + r[2].d[i] * inv[2] * r[2].d[j];
+		}
+	}
+
+	body->InvMass = 1 / m;
+}
+
+static void PhysConstraintRow_Init(PhysConstraintRow* row, const PhysBody* a, Vec3 ra,
+                                   const PhysBody* b, Vec3 rb, Vec3 dir, r32 impulse)
+{
+	row->Dir      = dir;
+	row->AngularA = Body_Cross(ra, dir);
+	row->AngularB = Body_Cross(rb, dir);
+	row->TurnA    = Inertia_Apply(a->InvInertia, row->AngularA);
+	row->TurnB    = Inertia_Apply(b->InvInertia, row->AngularB);
+	row->Impulse  = impulse;
+
+	r32 k = a->InvMass + b->InvMass + Body_Dot(row->AngularA, row->TurnA) + Body_Dot(row->AngularB, row->TurnB);
+	row->Mass = (k > 0 ? 1 / k : 0);
+}
+
+// How fast B's point moves away from A's along the row.
+static inline r32 PhysConstraintRow_Speed(const PhysConstraintRow* row, const PhysBody* a, const PhysBody* b)
+{
+	return Body_Dot(b->V, row->Dir) + Body_Dot(b->W, row->AngularB)
+	     - Body_Dot(a->V, row->Dir) - Body_Dot(a->W, row->AngularA);
+}
+
+// Push B along the row and A the other way. Only dynamic bodies get written to,
+// the static ones are shared between islands.
+static inline void PhysConstraintRow_Apply(const PhysConstraintRow* row, PhysBody* a, PhysBody* b, r32 impulse)
+{
+	if(a->Dynamic) {
+		a->V = Body_MultAdd(a->V, row->Dir, -impulse * a->InvMass);
+		a->W = Body_MultAdd(a->W, row->TurnA, -impulse);
+	}
+	if(b->Dynamic) {
+		b->V = Body_MultAdd(b->V, row->Dir, impulse * b->InvMass);
+		b->W = Body_MultAdd(b->W, row->TurnB, impulse);
+	}
+}
+
+static void PhysConstraint_Init(PhysConstraint* c, const PhysWorld* world, const PhysBody* bodies, r32 dt)
+{
+	const PhysPair* pair  = &world->_cache->Pairs.Data[c->Pair];
+	const PhysObject* oa = &world->Objects.Data[c->A];
+	const PhysObject* ob = &world->Objects.Data[c->B];
+	const PhysBody* a    = &bodies[c->A];
+	const PhysBody* b    = &bodies[c->B];
+
+	r32 bounce = MAX(oa->Bounciness, ob->Bounciness);
+	c->Friction  = sqrtf(MAX(oa->Friction, 0) * MAX(ob->Friction, 0));
+	c->NumPoints = pair->Manifold.NumPoints;
+
+	for(u32 i = 0; i < c->NumPoints; i++) {
+		const PhysManifoldPoint* mp = &pair->Manifold.Points[i];
+		PhysConstraintPoint* p      = &c->Points[i];
+
+		// Push at the middle of the two points, so both sides feel it in the same place.
+		Vec3 pa = Vec3_Add(oa->Transform.Position, Rotate_Vec3(oa->Transform.Rotation, mp->LocalA));
+		Vec3 pb = Vec3_Add(ob->Transform.Position, Rotate_Vec3(ob->Transform.Rotation, mp->LocalB));
+		Vec3 at = Vec3_MultScal(Vec3_Add(pa, pb), 0.5f);
+		Vec3 ra = Vec3_Sub(at, oa->Transform.Position);
+		Vec3 rb = Vec3_Sub(at, ob->Transform.Position);
+
+		Vec3 t1, t2;
+		Phys_Tangents(mp->Normal, &t1, &t2);
+
+		PhysConstraintRow_Init(&p->Rows[0], a, ra, b, rb, mp->Normal, mp->NormalImpulse);
+		PhysConstraintRow_Init(&p->Rows[1], a, ra, b, rb, t1, mp->TangentImpulse[0]);
+		PhysConstraintRow_Init(&p->Rows[2], a, ra, b, rb, t2, mp->TangentImpulse[1]);
+
+		// Points that are still apart may close the gap this update but no more,
+		// and overlapping ones get pushed out a bit at a time.
+		r32 d = mp->Distance;
+		if(d > 0)
+			p->Bias = -d / dt;
+		else
+			p->Bias = MIN(baumgarte * MAX(-d - penetrationSlop, 0) / dt, maxBiasVelocity);
+
+		r32 vn = PhysConstraintRow_Speed(&p->Rows[0], a, b);
+		if(vn < -restitutionSpeed)
+			p->Bias = MAX(p->Bias, -bounce * vn);
+	}
+}
+
+static void PhysConstraint_WarmStart(const PhysConstraint* c, PhysBody* bodies)
+{
+	PhysBody* a = &bodies[c->A];
+	PhysBody* b = &bodies[c->B];
+
+	for(u32 i = 0; i < c->NumPoints; i++) {
+		for(u32 j = 0; j < 3; j++)
+			PhysConstraintRow_Apply(&c->Points[i].Rows[j], a, b, c->Points[i].Rows[j].Impulse);
+	}
+}
+
+static void PhysConstraint_Solve(PhysConstraint* c, PhysBody* bodies)
+{
+	PhysBody* a = &bodies[c->A];
+	PhysBody* b = &bodies[c->B];
+
+	for(u32 i = 0; i < c->NumPoints; i++) {
+		PhysConstraintPoint* p = &c->Points[i];
+		PhysConstraintRow* n   = &p->Rows[0];
+
+		// Friction can only push back as hard as the normal does.
+		r32 maxFriction = c->Friction * n->Impulse;
+		for(u32 j = 1; j < 3; j++) {
+			PhysConstraintRow* row = &p->Rows[j];
+
+			r32 old  = row->Impulse;
+			r32 want = old - row->Mass * PhysConstraintRow_Speed(row, a, b);
+			row->Impulse = CLAMP(want, -maxFriction, maxFriction);
+			PhysConstraintRow_Apply(row, a, b, row->Impulse - old);
+		}
+
+		// Contacts only push, so the total can't go below zero.
+		r32 old    = n->Impulse;
+		r32 want   = old - n->Mass * (PhysConstraintRow_Speed(n, a, b) - p->Bias);
+		n->Impulse = MAX(want, 0);
+		PhysConstraintRow_Apply(n, a, b, n->Impulse - old);
+	}
+}
+
+static void PhysObject_Integrate(PhysObject* o, Vec3 v, Vec3 w, r32 dt)
+{
+	o->Transform = Transform3D_Advance(o->Transform, v, w, dt);
+}
+
+// Everything an island needs is its own bodies and contacts, and the static objects it
+// only reads, so islands can be solved in any order, or all at once.
+static void PhysIsland_Solve(PhysWorld* world, const PhysIsland* island, r32 dt)
+{
+	PhysWorld_Cache* c         = world->_cache;
+	PhysBody* bodies           = c->Bodies;
+	PhysConstraint* constraints = &c->Constraints[island->FirstConstraint];
+	const u32* members          = &c->IslandBodies[island->FirstBody];
+
+	for(u32 i = 0; i < island->NumBodies; i++)
+		bodies[members[i]].V.y -= world->Gravity * dt;
+
+	for(u32 i = 0; i < island->NumConstraints; i++) {
+		PhysConstraint_Init(&constraints[i], world, bodies, dt);
+		PhysConstraint_WarmStart(&constraints[i], bodies);
+	}
+
+	for(u32 iter = 0; iter < world->Iterations; iter++) {
+		for(u32 i = 0; i < island->NumConstraints; i++)
+			PhysConstraint_Solve(&constraints[i], bodies);
+	}
+
+	// Keep the impulses for next time.
+	for(u32 i = 0; i < island->NumConstraints; i++) {
+		const PhysConstraint* con = &constraints[i];
+		PhysManifold* m           = &c->Pairs.Data[con->Pair].Manifold;
+
+		for(u32 j = 0; j < con->NumPoints; j++) {
+			m->Points[j].NormalImpulse     = con->Points[j].Rows[0].Impulse;
+			m->Points[j].TangentImpulse[0] = con->Points[j].Rows[1].Impulse;
+			m->Points[j].TangentImpulse[1] = con->Points[j].Rows[2].Impulse;
+		}
+	}
+
+	// Move everything, and see whether the whole island has been still long enough to sleep.
+	r32 stillFor = timeToSleep;
+	for(u32 i = 0; i < island->NumBodies; i++) {
+		PhysObject* o  = &world->Objects.Data[members[i]];
+		PhysBody* body = &bodies[members[i]];
+
+		if(PhysObject_Sweeps(o, body->V)) {
+			body->Swept  = 1;
+			body->Impact = 1;
+		} else {
+			PhysObject_Integrate(o, body->V, body->W, dt);
+		}
+		o->Velocity        = body->V;
+		o->AngularVelocity = body->W;
+
+		if(Vec3_Len2(body->V) > sleepLinear * sleepLinear || Vec3_Len2(body->W) > sleepAngular * sleepAngular)
+			o->SleepTime = 0;
+		else
+			o->SleepTime += dt;
+
+		stillFor = MIN(stillFor, o->SleepTime);
+	}
+
+	if(stillFor < timeToSleep)
+		return;
+
+	for(u32 i = 0; i < island->NumBodies; i++) {
+		PhysObject* o      = &world->Objects.Data[members[i]];
+		o->Asleep          = 1;
+		o->Velocity        = V3(0, 0, 0);
+		o->AngularVelocity = V3(0, 0, 0);
+	}
+}
+
+typedef struct {
+	PhysWorld* World;
+	r32 DT;
+} PhysIsland_Batch;
+
+static void PhysIsland_SolveMany(void* data, u32 begin, u32 end)
+{
+	PhysIsland_Batch* batch = data;
+	for(u32 i = begin; i < end; i++)
+		PhysIsland_Solve(batch->World, &batch->World->_cache->Islands[i], batch->DT);
+}
+
+// Objects that'll stay where they are until the swept bodies have moved.
+static inline bool8 PhysSweep_Obstacle(const PhysObject* o, const PhysBody* body)
+{
+	return !body->Dynamic || o->Asleep;
+}
+
+// Record a hit if it's the earliest one yet. The body stops just short of it either way, and
+// anything with a PhysShape gets a contact next update that pushes back properly. Nothing
+// pushes back from triangle hulls though, so for those the sweep has to stop the body itself.
+static inline void PhysSweep_Hit(PhysBody* body, r32 impact, const PhysContact* hit, bool8 hull, r32 bounce)
+{
+	if(impact >= body->Impact)
+		return;
+
+	body->Impact       = impact;
+	body->ImpactNormal = hull ? Vec3_Neg(hit->Normal) : V3(0, 0, 0);
+	body->ImpactBounce = bounce;
+}
+
+// The first hit, as a fraction of the whole update. A body that's already closer than sweepDistance
+// can still go sweepDistance further in each update, so it isn't stuck, but it can't go through
+// a thin wall on its own either.
+static r32 PhysSweep_Impact(const PhysObject* o, const PhysBody* body,
+                            const PhysShape* shape, const Transform3D* t, const PhysBody* obstacle,
+                            r32 dt, PhysContact* hit)
+{
+	r32 window = dt * body->Impact;
+	r32 impact = PhysShape_TimeOfImpact(&o->Shape, &o->Transform, body->V, body->W, shape, t, obstacle->V, obstacle->W,
+	                                    window, sweepDistance, hit);
+
+	if(impact <= 0)
+		impact = PhysShape_TimeOfImpact(&o->Shape, &o->Transform, body->V, body->W, shape, t, obstacle->V, obstacle->W,
+		                                window, hit->Distance - sweepDistance, hit);
+
+	return impact * body->Impact;
+}
+
+static void PhysSweep_Hull(PhysWorld* world, u32 mover, u32 obstacle, r32 dt)
+{
+	PhysWorld_Cache* c   = world->_cache;
+	PhysBody* body       = &c->Bodies[mover];
+	const PhysObject* o  = &world->Objects.Data[mover];
+	const PhysObject* ob = &world->Objects.Data[obstacle];
+	const TriHull* hull  = &ob->Hull;
+	const PhysBody* bb   = &c->Bodies[obstacle];
+
+	// Only the triangles near the way the body goes.
+	Mat4 toWorld, toLocal;
+	TriHull_Space(hull, toWorld, toLocal);
+	AABB box = AABB_ApplyMat4(c->Boxes[mover], toLocal);
+
+	const TriHull_BVH* bvh = hull->BVH;
+	const Vec3* tris       = (bvh ? bvh->Tris : hull->TriPoints);
+	r32 bounce             = MAX(o->Bounciness, ob->Bounciness);
+
+	u32 stack[TRIHULL_BVH_MAX_DEPTH + 2];
+	u32 size = 0;
+	stack[size++] = 0;
+
+	while(size) {
+		u32 first = 0, count = hull->NumTris;
+
+		if(bvh) {
+			u32 id                   = stack[--size];
+			const TriHull_BVHNode* n = &bvh->Nodes[id];
+
+			if(!Boxes_Overlap(&n->Box, &box))
+				continue;
+
+			if(!n->Count) {
+				stack[size++] = n->Index;
+				stack[size++] = id + 1;
+				continue;
+			}
+
+			first = n->Index;
+			count = n->Count;
+		} else {
+			size = 0;
+		}
+
+		for(u32 i = first; i < first + count; i++) {
+			AABB triBox = Triangle_Box(&tris[i * 3]);
+			if(!Boxes_Overlap(&triBox, &box))
+				continue;
+
+			PhysShape tri = { .Type = PhysShapeType_Convex, .Points = (Vec3*) &tris[i * 3], .NumPoints = 3 };
+			PhysContact hit;
+
+			r32 impact = PhysSweep_Impact(o, body, &tri, hull->Transform, bb, dt, &hit);
+			if(impact >= body->Impact)
+				continue;
+
+			PhysSweep_Hit(body, impact, &hit, 1, bounce);
+		}
+	}
+}
+
+static void PhysSweep_Pair(PhysWorld* world, u32 mover, u32 obstacle, r32 dt)
+{
+	PhysWorld_Cache* c   = world->_cache;
+	PhysBody* body       = &c->Bodies[mover];
+	const PhysObject* o  = &world->Objects.Data[mover];
+	const PhysObject* ob = &world->Objects.Data[obstacle];
+	const PhysBody* bb   = &c->Bodies[obstacle];
+
+	if(!body->Swept || !PhysSweep_Obstacle(ob, bb))
+		return;
+
+	if(ob->Shape.Type == PhysShapeType_None) {
+		if(ob->Hull.NumTris)
+			PhysSweep_Hull(world, mover, obstacle, dt);
+		return;
+	}
+
+	PhysContact hit;
+	r32 impact = PhysSweep_Impact(o, body, &ob->Shape, &ob->Transform, bb, dt, &hit);
+	PhysSweep_Hit(body, impact, &hit, 0, 0);
+}
+
+// Move the swept bodies as far as they get before they'd hit something.
+static void PhysWorld_Sweep(PhysWorld* world, r32 dt)
+{
+	PhysWorld_Cache* c  = world->_cache;
+	PhysObject* objects = world->Objects.Data;
+
+	bool8 any = 0;
+	for(u32 i = 0; i < c->NumObjects && !any; i++)
+		any = c->Bodies[i].Swept;
+
+	if(!any)
+		return;
+
+	for(u32 i = 0; i < c->Pairs.Size; i++) {
+		const PhysPair* p = &c->Pairs.Data[i];
+		PhysSweep_Pair(world, p->A, p->B, dt);
+		PhysSweep_Pair(world, p->B, p->A, dt);
+	}
+
+	for(u32 i = 0; i < c->NumObjects; i++) {
+		PhysBody* body = &c->Bodies[i];
+		if(!body->Swept)
+			continue;
+
+		PhysObject_Integrate(&objects[i], body->V, body->W, dt * body->Impact);
+
+		// Take out the speed going into the hull, and bounce back if it hit hard enough.
+		r32 into = Vec3_Dot(body->V, body->ImpactNormal);
+		if(into < 0) {
+			r32 bounce = (-into > restitutionSpeed ? body->ImpactBounce : 0);
+			objects[i].Velocity = Vec3_Sub(body->V, Vec3_MultScal(body->ImpactNormal, (1 + bounce) * into));
+		}
+	}
+}
+
+static inline u32 PhysIsland_Find(u32* parent, u32 i)
+{
+	while(parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i         = parent[i];
+	}
+	return i;
+}
+
+// The dynamic object a contact gets solved with, -1 if neither of them is.
+static inline i32 PhysConstraint_Owner(const PhysWorld_Cache* c, const PhysPair* p)
+{
+	if(!p->Manifold.NumPoints)
+		return -1;
+	if(c->Bodies[p->A].Dynamic)
+		return p->A;
+	if(c->Bodies[p->B].Dynamic)
+		return p->B;
+	return -1;
+}
+
+// Thank you,
+// https://en.wikipedia.org/wiki/Disjoint-set_data_structure
+static void PhysWorld_Solve(PhysWorld* world, r32 dt)
+{
+	PhysWorld_Cache* c = world->_cache;
+	PhysObject* objects = world->Objects.Data;
+	u32 n = c->NumObjects;
+
+	u32* parent = c->IslandOf;
+	u32* index  = c->IslandIndex;
+	bool8* awake = c->IslandAwake;
+
+	// 1. Every object as a body, setting a sleeping one's velocity wakes it up.
+	for(u32 i = 0; i < n; i++) {
+		PhysObject* o = &objects[i];
+		if(o->Asleep && (Vec3_Len2(o->Velocity) > 0 || Vec3_Len2(o->AngularVelocity) > 0))
+			o->Asleep = 0;
+
+		PhysBody_Init(&c->Bodies[i], o);
+		parent[i] = i;
+		index[i]  = ~0u;
+		awake[i]  = 0;
+	}
+
+	// 2. Bodies that touch end up in the same island. Static objects and moving platforms
+	// don't join anything, or everything standing on the ground would be one island.
+	for(u32 i = 0; i < c->Pairs.Size; i++) {
+		const PhysPair* p = &c->Pairs.Data[i];
+		if(p->Manifold.NumPoints && c->Bodies[p->A].Dynamic && c->Bodies[p->B].Dynamic)
+			parent[PhysIsland_Find(parent, p->A)] = PhysIsland_Find(parent, p->B);
+	}
+
+	// An island is awake if anything in it is, or a moving platform is carrying it.
+	for(u32 i = 0; i < n; i++) {
+		if(c->Bodies[i].Dynamic && !objects[i].Asleep)
+			awake[PhysIsland_Find(parent, i)] = 1;
+	}
+
+	for(u32 i = 0; i < c->Pairs.Size; i++) {
+		const PhysPair* p = &c->Pairs.Data[i];
+		i32 owner = PhysConstraint_Owner(c, p);
+		if(owner < 0)
+			continue;
+
+		const PhysBody* other = &c->Bodies[owner == (i32) p->A ? p->B : p->A];
+		if(!other->Dynamic && (Vec3_Len2(other->V) > 0 || Vec3_Len2(other->W) > 0))
+			awake[PhysIsland_Find(parent, owner)] = 1;
+	}
+
+	// 3. Gather the awake islands' bodies, sleeping islands get left out entirely.
+	c->NumIslands = 0;
+	for(u32 i = 0; i < n; i++) {
+		u32 root = (c->Bodies[i].Dynamic ? PhysIsland_Find(parent, i) : i);
+		if(!c->Bodies[i].Dynamic || !awake[root])
+			continue;
+
+		if(index[root] == ~0u) {
+			index[root] = c->NumIslands++;
+			c->Islands[index[root]] = (PhysIsland) {0};
+		}
+		c->Islands[index[root]].NumBodies++;
+
+		// Something it touched woke it up.
+		if(objects[i].Asleep) {
+			objects[i].Asleep    = 0;
+			objects[i].SleepTime = 0;
+		}
+	}
+
+	u32 numConstraints = 0;
+	for(u32 i = 0; i < c->Pairs.Size; i++) {
+		i32 owner = PhysConstraint_Owner(c, &c->Pairs.Data[i]);
+		if(owner >= 0 && awake[PhysIsland_Find(parent, owner)]) {
+			c->Islands[index[PhysIsland_Find(parent, owner)]].NumConstraints++;
+			numConstraints++;
+		}
+	}
+
+	if(numConstraints > c->ConstraintCapacity) {
+		c->ConstraintCapacity = MAX(numConstraints, c->ConstraintCapacity * 2);
+		c->Constraints        = Reallocate(c->Constraints, sizeof(PhysConstraint) * c->ConstraintCapacity);
+	}
+
+	// Where each island's bodies and contacts start, then fill them in.
+	u32 firstBody = 0, firstConstraint = 0;
+	for(u32 i = 0; i < c->NumIslands; i++) {
+		PhysIsland* island      = &c->Islands[i];
+		island->FirstBody       = firstBody;
+		island->FirstConstraint = firstConstraint;
+		firstBody       += island->NumBodies;
+		firstConstraint += island->NumConstraints;
+		island->NumBodies      = 0;
+		island->NumConstraints = 0;
+	}
+
+	for(u32 i = 0; i < n; i++) {
+		if(!c->Bodies[i].Dynamic || objects[i].Asleep)
+			continue;
+
+		PhysIsland* island = &c->Islands[index[PhysIsland_Find(parent, i)]];
+		c->IslandBodies[island->FirstBody + island->NumBodies++] = i;
+	}
+
+	for(u32 i = 0; i < c->Pairs.Size; i++) {
+		const PhysPair* p = &c->Pairs.Data[i];
+		i32 owner = PhysConstraint_Owner(c, p);
+		if(owner < 0 || !awake[PhysIsland_Find(parent, owner)])
+			continue;
+
+		PhysIsland* island = &c->Islands[index[PhysIsland_Find(parent, owner)]];
+		c->Constraints[island->FirstConstraint + island->NumConstraints++] = (PhysConstraint) {
+			.A = p->A, .B = p->B, .Pair = i,
+		};
+	}
+
+	// 4. Solve, every island on whichever thread gets to it first.
+	PhysIsland_Batch batch = { .World = world, .DT = dt };
+	Job_ParallelFor(c->NumIslands, 0, PhysIsland_SolveMany, &batch);
+	PhysWorld_Sweep(world, dt);
+
+	// Moving platforms go wherever their velocity takes them.
+	for(u32 i = 0; i < n; i++) {
+		if(objects[i].Type == PhysObject_MovingPlaftorm)
+			PhysObject_Integrate(&objects[i], objects[i].Velocity, objects[i].AngularVelocity, dt);
+	}
+}
+
+static inline bool8 PhysObject_Resting(const PhysObject* o)
+{
+	return o->Type == PhysObject_Static || o->Asleep;
+}
+
+// Where the object is as far as contacts go. Hulls have a transform of their own.
+static inline Transform3D PhysObject_Pose(const PhysObject* o)
+{
+	if(o->Shape.Type == PhysShapeType_None && o->Hull.NumTris)
+		return (o->Hull.Transform ? *o->Hull.Transform : Transform3D_Default);
+	return o->Transform;
+}
+
+// How far any part of an object could have got from where it was, going by how far it moved
+// and turned. A turn of `angle` moves a point `reach` away from the middle by 2 * reach * sin(angle / 2).
+static r32 PhysObject_Moved(const PhysObject* o, const Transform3D* then, const Transform3D* now)
+{
+	if(then->Scale.x != now->Scale.x || then->Scale.y != now->Scale.y || then->Scale.z != now->Scale.z)
+		return INFINITY;
+
+	Vec3 move   = Vec3_Sub(now->Position, then->Position);
+	r32 cosHalf = fabsf(Quat_Dot(then->Rotation, now->Rotation));
+	if(move.x == 0 && move.y == 0 && move.z == 0 && cosHalf >= 1)
+		return 0;
+
+	r32 reach;
+	if(o->Shape.Type != PhysShapeType_None) {
+		reach = PhysShape_Reach(&o->Shape, now);
+	} else {
+		Vec3 far = V3(MAX(fabsf(o->AABB.Min.x), fabsf(o->AABB.Max.x)),
+		              MAX(fabsf(o->AABB.Min.y), fabsf(o->AABB.Max.y)),
+		              MAX(fabsf(o->AABB.Min.z), fabsf(o->AABB.Max.z)));
+		reach = Vec3_Len(far) * MAX3(fabsf(now->Scale.x), fabsf(now->Scale.y), fabsf(now->Scale.z));
+	}
+
+	return Vec3_Len(move) + 2 * reach * sqrtf(MAX(0, 1 - cosHalf * cosHalf));
+}
+
+static void PhysWorld_Contact(PhysWorld* world, PhysPair* pair)
+{
+	const PhysObject* a = &world->Objects.Data[pair->A];
+	const PhysObject* b = &world->Objects.Data[pair->B];
+	PhysWorld_Stats* stats = &world->_cache->Stats;
+
+	Transform3D poseA = PhysObject_Pose(a), poseB = PhysObject_Pose(b);
+	if(pair->Known) {
+		r32 moved = PhysObject_Moved(a, &pair->PoseA, &poseA) + PhysObject_Moved(b, &pair->PoseB, &poseB);
+		if(moved == 0 || moved < pair->Separation - contactMargin) {
+			stats->Cached++;
+			return;
+		}
+	}
+
+	stats->Tested++;
+	pair->Known      = 1;
+	pair->Separation = 0;
+	pair->PoseA      = poseA;
+	pair->PoseB      = poseB;
+
+	if(a->Shape.Type != PhysShapeType_None && b->Shape.Type != PhysShapeType_None) {
+		const PhysContact* contact = &pair->Contact;
+		PhysManifold* m            = &pair->Manifold;
+
+		PhysShape_Contact(&a->Shape, &a->Transform, &b->Shape, &b->Transform, &pair->Cache, &pair->Contact);
+		PhysManifold_Refresh(m, &a->Transform, &b->Transform);
+
+		bool8 sphere = (a->Shape.Type == PhysShapeType_Sphere || b->Shape.Type == PhysShapeType_Sphere);
+
+		if(contact->Distance > contactMargin || Vec3_Len2(contact->Normal) <= 0) {
+			if(sphere)
+				m->NumPoints = 0;
+
+			// Nothing left from when they touched, so nothing can change until they get closer.
+			if(!m->NumPoints && Vec3_Len2(contact->Normal) > 0)
+				pair->Separation = contact->Distance;
+		} else if(sphere) {
+			// A sphere only ever touches in one place, and that place moves along when it rolls.
+			// Old points would be left behind, so there's only ever the new one, which carries on
+			// from the old one's impulses.
+			PhysManifoldPoint old = m->Points[0];
+			u32 had               = m->NumPoints;
+
+			m->NumPoints = 0;
+			PhysManifold_Add(m, &a->Transform, &b->Transform, contact->PointA, contact->PointB,
+			                 contact->Normal, contact->Distance);
+
+			if(had) {
+				m->Points[0].NormalImpulse     = old.NormalImpulse;
+				m->Points[0].TangentImpulse[0] = old.TangentImpulse[0];
+				m->Points[0].TangentImpulse[1] = old.TangentImpulse[1];
+			}
+		} else {
+			// Tilting only turns up anything new when the contact has moved somewhere new. The corners
+			// go in first, so a contact in the middle of a face doesn't take the place of one of them.
+			Vec3 localA = Unrotate_Vec3(a->Transform.Rotation, Vec3_Sub(contact->PointA, a->Transform.Position));
+			if(m->NumPoints < 3 && PhysManifold_Find(m, localA) < 0)
+				PhysWorld_Perturb(a, b, pair);
+
+			PhysManifold_Add(m, &a->Transform, &b->Transform, contact->PointA, contact->PointB,
+			                 contact->Normal, contact->Distance);
+		}
+		return;
+	}
+
+	pair->Manifold.NumPoints = 0;
+	if(a->Hull.NumTris && b->Hull.NumTris) {
+		// Triangles can only tell whether they touch, and where.
+		Intersection res = TriHull_Intersect(a->Hull, b->Hull);
+		pair->Contact    = (PhysContact) { .Touching = res.Occurred, .PointA = res.Point, .PointB = res.Point };
+	} else {
+		pair->Contact = (PhysContact) { .Touching = 0 };
+	}
+}
+
+void PhysWorld_Update(PhysWorld* world, r32 dt)
+{
+	// 1. Broadphase, keep the tree and the list of overlapping boxes up to date.
+	if(!world->_cache) {
+		world->_cache = Allocate(sizeof(PhysWorld_Cache));
+		memset(world->_cache, 0, sizeof(PhysWorld_Cache));
+		AABBTree_Init(&world->_cache->Tree);
+	}
+
+	PhysWorld_Cache* c = world->_cache;
+	u32 n = world->Objects.Size;
+
+	// Indices shift around when objects are removed, so start over.
+	if(!c->PairIndex || n < c->NumObjects || c->Broadphase != world->Broadphase)
+		PhysWorld_Reset(world);
+
+	if(n > c->Capacity) {
+		c->Capacity = MAX(n, c->Capacity * 2);
+		c->Boxes    = Reallocate(c->Boxes, sizeof(AABB) * c->Capacity);
+		c->Static   = Reallocate(c->Static, sizeof(bool8) * c->Capacity);
+		c->Leaves   = Reallocate(c->Leaves, sizeof(i32) * c->Capacity);
+		c->Big      = Reallocate(c->Big, sizeof(bool8) * c->Capacity);
+		c->Extents  = Reallocate(c->Extents, sizeof(r32) * c->Capacity);
+
+		c->FirstCell = Reallocate(c->FirstCell, sizeof(u32) * 3 * c->Capacity);
+
+		c->Bodies       = Reallocate(c->Bodies, sizeof(PhysBody) * c->Capacity);
+		c->IslandOf     = Reallocate(c->IslandOf, sizeof(u32) * c->Capacity);
+		c->IslandIndex  = Reallocate(c->IslandIndex, sizeof(u32) * c->Capacity);
+		c->IslandAwake  = Reallocate(c->IslandAwake, sizeof(bool8) * c->Capacity);
+		c->IslandBodies = Reallocate(c->IslandBodies, sizeof(u32) * c->Capacity);
+		c->Islands      = Reallocate(c->Islands, sizeof(PhysIsland) * c->Capacity);
+	}
+
+	for(u32 i = c->NumObjects; i < n; i++)
+		c->Leaves[i] = AABBTREE_NULL;
+	c->NumObjects = n;
+
+	PhysWorld_UpdateBoxes(world, dt);
+
+	if(world->Broadphase == PhysBroadphase_Tree)
+		PhysWorld_TreePairs(world);
+	else if(world->Broadphase == PhysBroadphase_Grid)
+		PhysWorld_GridPairs(world);
+	else
+		PhysWorld_SweepAndPrune(world);
+
+	// 2. Narrowphase, see which of the pairs actually touch. Nothing changes between
+	// sleeping objects and what they're resting on, so their contacts are left as they were.
+	c->Stats.Pairs   = c->Pairs.Size;
+	c->Stats.Resting = c->Stats.Cached = c->Stats.Tested = 0;
+
+	for(u32 i = 0; i < c->Pairs.Size; i++) {
+		PhysPair* p = &c->Pairs.Data[i];
+		if(PhysObject_Resting(&world->Objects.Data[p->A]) && PhysObject_Resting(&world->Objects.Data[p->B])) {
+			c->Stats.Resting++;
+			continue;
+		}
+		PhysWorld_Contact(world, p);
+	}
+
+	c->Stats.TotalCached += c->Stats.Cached;
+	c->Stats.TotalTested += c->Stats.Tested;
+
+	// 3. Push apart whatever touches, and move everything.
+	if(dt > 0)
+		PhysWorld_Solve(world, dt);
+}
+
+// --- Fixed steps --- //
+
+void PhysSim_Init(PhysSim* sim, PhysWorld* world, r32 step)
+{
+	*sim          = (PhysSim) {0};
+	sim->World    = world;
+	sim->Step     = (step > 0 ? step : 1.0f / 60);
+	sim->MaxSteps = 5;
+}
+
+void PhysSim_Free(PhysSim* sim)
+{
+	Job_Wait(&sim->_running);
+
+	Free(sim->Previous);
+	Free(sim->Current);
+	Free(sim->_next[0]);
+	Free(sim->_next[1]);
+	*sim = (PhysSim) {0};
+}
+
+static void PhysSim_Snapshot(const PhysWorld* world, Transform3D* out)
+{
+	for(u32 i = 0; i < world->Objects.Size; i++)
+		out[i] = world->Objects.Data[i].Transform;
+}
+
+static void PhysSim_Run(void* data)
+{
+	PhysSim* sim = data;
+
+	for(u32 i = 0; i < sim->_steps; i++) {
+		if(i == sim->_steps - 1)
+			PhysSim_Snapshot(sim->World, sim->_next[0]);
+
+		PhysWorld_Update(sim->World, sim->Step);
+	}
+
+	PhysSim_Snapshot(sim->World, sim->_next[1]);
+}
+
+void PhysSim_Start(PhysSim* sim, r32 frameTime)
+{
+	PhysWorld* world = sim->World;
+	u32 n            = world->Objects.Size;
+
+	if(sim->_steps)
+		PhysSim_Finish(sim);
+
+	if(n > sim->_capacity) {
+		sim->_capacity = MAX(n, sim->_capacity * 2);
+		sim->Previous  = Reallocate(sim->Previous, sizeof(Transform3D) * sim->_capacity);
+		sim->Current   = Reallocate(sim->Current, sizeof(Transform3D) * sim->_capacity);
+		sim->_next[0]  = Reallocate(sim->_next[0], sizeof(Transform3D) * sim->_capacity);
+		sim->_next[1]  = Reallocate(sim->_next[1], sizeof(Transform3D) * sim->_capacity);
+	}
+
+	// Objects added since the last step don't have anywhere to come from yet.
+	for(u32 i = sim->NumTransforms; i < n; i++)
+		sim->Previous[i] = sim->Current[i] = world->Objects.Data[i].Transform;
+	sim->NumTransforms = n;
+
+	sim->Accumulator += MAX(frameTime, 0);
+
+	u32 steps = (u32) (sim->Accumulator / sim->Step);
+	sim->Accumulator -= steps * sim->Step;
+
+	if(steps > sim->MaxSteps) {
+		steps            = sim->MaxSteps;
+		sim->Accumulator = 0;
+	}
+
+	sim->_steps = steps;
+	sim->_alpha = CLAMP(sim->Accumulator / sim->Step, 0, 1);
+
+	if(steps)
+		Job_Run(PhysSim_Run, sim, &sim->_running);
+}
+
+u32 PhysSim_Finish(PhysSim* sim)
+{
+	Job_Wait(&sim->_running);
+
+	if(sim->_steps) {
+		Transform3D* previous = sim->Previous;
+		Transform3D* current  = sim->Current;
+
+		sim->Previous = sim->_next[0];
+		sim->Current  = sim->_next[1];
+		sim->_next[0] = previous;
+		sim->_next[1] = current;
+	}
+
+	u32 steps   = sim->_steps;
+	sim->_steps = 0;
+	sim->Alpha  = sim->_alpha;
+	return steps;
+}
+
+u32 PhysSim_Advance(PhysSim* sim, r32 frameTime)
+{
+	PhysSim_Start(sim, frameTime);
+	return PhysSim_Finish(sim);
+}
+
+Transform3D PhysSim_Transform(const PhysSim* sim, u32 object)
+{
+	const Transform3D* a = &sim->Previous[object];
+	const Transform3D* b = &sim->Current[object];
+	r32 t                = sim->Alpha;
+
+	// Normalized lerp, the steps are short enough that it's as good as a slerp.
+	Quat qb = b->Rotation;
+	if(Quat_Dot(a->Rotation, qb) < 0)
+		qb = Vec4_Neg(qb);
+
+	return (Transform3D) {
+		.Position = Vec3_Add(a->Position, Vec3_MultScal(Vec3_Sub(b->Position, a->Position), t)),
+		.Rotation = Quat_Norm(Vec4_Add(a->Rotation, Vec4_MultScal(Vec4_Sub(qb, a->Rotation), t))),
+		.Scale    = Vec3_Add(a->Scale, Vec3_MultScal(Vec3_Sub(b->Scale, a->Scale), t)),
+	};
 }
@@ -3,7 +3,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../Image.h"
 #include "../Math3D.h"
+#include "../Res.h"
 #include "SDL_video.h"
 #include "../stb_image.h"
 
@@ -147,6 +149,10 @@ void RSys_Init(u32 Width, u32 Height) {
 	// Load OpenGL functions.
 	if(!gladLoadGL()) Log(FATAL, "%s", "gladLoadGL() failed, OpenGL couldn't be loaded.");
 
+	// Images come out top row first. stb_image keeps this in a global, so it's
+	// only set here and never while something might be decoding.
+	stbi_set_flip_vertically_on_load(0);
+
 	// Set a few default parameters.
 
 	// Set the clear color to black.
@@ -314,17 +320,27 @@ void RSys_FinishFrame() {
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
+	// Start on the next frame's share of texture uploads.
+	Texture_UpdateAsync();
+
 	// Record some info about the time it took to render.
 	RSys_State.LastFrameDT   = SDL_GetTicks() - RSys_State.LastFrameTime;
 	RSys_State.LastFrameTime = SDL_GetTicks();
 }
 
 void RSys_Quit() {
+	Texture_CancelAsync();
 	SDL_GL_DeleteContext(RSys_State.GLContext);
 	SDL_DestroyWindow(RSys_State.Window);
 	SDL_Quit();
 }
 
+// Shrinking goes through the mipmaps when there are any, otherwise they'd never get sampled.
+static GLint Texture_MinFilter(const Texture* t) {
+	if(!t->HasMipmaps) return t->Filter;
+	return t->Filter == Filter_Nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+}
+
 Texture Texture_Init(u32 w, u32 h, enum Texture_Format fmt, enum Texture_Filter filt, enum Texture_Wrap wrap) {
 	glGetError();
 
@@ -359,9 +375,28 @@ void Texture_SetData(Texture* t, const u8* data, u32 width, u32 height, bool8 mi
 
 	glBindTexture(GL_TEXTURE_2D, t->Id);
 
-	GLenum intFmt = t->Format == Format_Depth ? Format_Depth : Format_RGBA;
-	GLenum type   = t->Format == Format_Depth ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE;
+	// Only as many channels as there are, sampling the missing ones gives the same 0, 0, 1 as
+	// expanding them to RGBA would have, at a quarter of the memory for one channel.
+	GLenum intFmt, type = GL_UNSIGNED_BYTE;
+	switch(t->Format) {
+		case Format_Red: intFmt = GL_R8; break;
+		case Format_RG: intFmt = GL_RG8; break;
+		case Format_RGB:
+		case Format_BGR: intFmt = t->SRGB ? GL_SRGB8 : GL_RGB8; break;
+		default: intFmt = t->SRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8; break;
+
+		case Format_Depth:
+			intFmt = GL_DEPTH_COMPONENT;
+			type   = GL_UNSIGNED_INT;
+			break;
+		case Format_DepthStencil:
+			intFmt = GL_DEPTH24_STENCIL8;
+			type   = GL_UNSIGNED_INT_24_8;
+			break;
+	}
 
+	// stb_image doesn't pad rows to 4 bytes.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	glTexImage2D(
 		GL_TEXTURE_2D, // target:         Target texture
 		0,             // level:          LOD level, 0 because we don't have custom LOD
@@ -373,6 +408,7 @@ void Texture_SetData(Texture* t, const u8* data, u32 width, u32 height, bool8 mi
 		type,          // type:           How each pixel is encoded
 		data           // data:           Pointer to pixel data
 	);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
 	GLenum err = glGetError();
 	if(err != GL_NO_ERROR) {
@@ -382,36 +418,214 @@ void Texture_SetData(Texture* t, const u8* data, u32 width, u32 height, bool8 mi
 		return;
 	}
 
-	t->Width      = width;
-	t->Height     = height;
-	t->HasMipmaps = data && width && height && mips;
+	t->Width          = width;
+	t->Height         = height;
+	t->HasMipmaps     = data && width && height && mips;
+	t->InternalFormat = intFmt;
 
 	if(t->HasMipmaps) glGenerateMipmap(GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Texture_MinFilter(t));
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Make a texture out of decoded pixels, with as many channels as the image had.
+static Texture Texture_FromPixels(const u8* data, i32 w, i32 h, i32 nComp) {
+	enum Texture_Format fmt;
+	switch(nComp) {
+		case 1: fmt = Format_Red; break;
+		case 2: fmt = Format_RG; break;
+		case 3: fmt = Format_RGB; break;
+		case 4: fmt = Format_RGBA; break;
+	}
+
+	Texture t = Texture_Init(w, h, fmt, Filter_Linear, Wrap_Repeat);
+	Texture_SetData(&t, data, w, h, 1);
+
+	return t;
+}
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT        0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT        0x83F3
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT  0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT  0x8C4F
+#endif
+
+// BC1 and BC3 aren't in core GL, but every desktop driver has them.
+static bool8 Texture_HasS3TC() {
+	static i32 has = -1;
+	if(has >= 0) return has;
+
+	GLint n = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+
+	has = 0;
+	for(GLint i = 0; i < n && !has; i++) {
+		const char* ext = (const char*) glGetStringi(GL_EXTENSIONS, i);
+		has = ext && strcmp(ext, "GL_EXT_texture_compression_s3tc") == 0;
+	}
+
+	return has;
+}
+
+static GLint Texture_SwizzleChannel(char c) {
+	switch(c) {
+		case 'r': return GL_RED;
+		case 'g': return GL_GREEN;
+		case 'b': return GL_BLUE;
+		case '0': return GL_ZERO;
+		case '1': return GL_ONE;
+		default: return GL_ALPHA;
+	}
+}
+
+// A texture with room for every level of a KTX file. With `fill` the levels get filled in
+// from the file, otherwise they're left for Texture_UpdateAsync() to fill in bit by bit.
+static Texture Texture_InitKTX(const Image_KTX* ktx, bool8 fill) {
+	switch(ktx->GLInternalFormat) {
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+			if(!Texture_HasS3TC()) {
+				Log(ERROR, "[Render] Texture KTX load fail - no S3TC support for BC1/BC3.", "");
+				return (Texture){0};
+			}
+	}
+
+	Texture t = {.Width  = ktx->Width,
+	             .Height = ktx->Height,
+	             .Format = ktx->GLBaseInternalFormat,
+	             .Filter = Filter_Linear,
+	             .Wrap   = Wrap_Repeat};
+
+	u32 numLevels = MAX(ktx->NumLevels, 1);
+
+	glGetError();
+	glGenTextures(1, &t.Id);
+	glBindTexture(GL_TEXTURE_2D, t.Id);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, t.Wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, t.Wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, t.Filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, t.Filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+
+	for(u32 i = 0; i < numLevels; i++) {
+		u32 w = MAX(ktx->Width >> i, 1), h = MAX(ktx->Height >> i, 1);
+		const u8* level = fill ? ktx->Levels[i] : NULL;
+		if(ktx->GLType) {
+			glTexImage2D(GL_TEXTURE_2D, i, ktx->GLInternalFormat, w, h, 0, ktx->GLFormat, ktx->GLType, level);
+		} else {
+			glCompressedTexImage2D(GL_TEXTURE_2D, i, ktx->GLInternalFormat, w, h, 0, ktx->LevelSizes[i], level);
+		}
+	}
+
+	// A file with no levels wants them made.
+	if(!ktx->NumLevels && fill) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	t.HasMipmaps = numLevels > 1 || !ktx->NumLevels;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Texture_MinFilter(&t));
+
+	GLint swizzle[4];
+	for(u32 i = 0; i < 4; i++) swizzle[i] = Texture_SwizzleChannel(ktx->Swizzle[i]);
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
 
+	GLenum err = glGetError();
 	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if(err != GL_NO_ERROR) {
+		Log(ERROR, "[Render] Texture KTX upload fail: %s (%d)", GL_ErrorToString(err), err);
+		Texture_Free(t);
+		return (Texture){0};
+	}
+
+	t.InternalFormat = ktx->GLInternalFormat;
+	t.SRGB           = ktx->GLInternalFormat == GL_SRGB8_ALPHA8 ||
+	         ktx->GLInternalFormat == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT ||
+	         ktx->GLInternalFormat == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+
+	return t;
+}
+
+// KTX files carry GL's own enums and every mip level, so it all goes straight to GL.
+static Texture Texture_FromKTX(const u8* data, u32 size) {
+	Image_KTX ktx;
+	if(!Image_ParseKTX(data, size, &ktx)) {
+		Log(ERROR, "[Render] Texture KTX load fail - the file is broken.", "");
+		return (Texture){0};
+	}
+
+	return Texture_InitKTX(&ktx, 1);
+}
+
+// stb_image writes its error and fills its zlib tables through globals, so only
+// one thread decodes at a time. The error is a string literal, it's fine to keep.
+static Job_Mutex Texture_DecodeLock;
+
+static u8* Texture_DecodeFile(const char* file, i32* w, i32* h, i32* nComp, const char** error) {
+	Job_Lock(&Texture_DecodeLock);
+	u8* pixels = stbi_load(file, w, h, nComp, 0);
+	if(!pixels && error) *error = stbi_failure_reason();
+	Job_Unlock(&Texture_DecodeLock);
+	return pixels;
+}
+
+static u8* Texture_DecodeMemory(const u8* data, u32 size, i32* w, i32* h, i32* nComp, const char** error) {
+	Job_Lock(&Texture_DecodeLock);
+	u8* pixels = stbi_load_from_memory(data, size, w, h, nComp, 0);
+	if(!pixels && error) *error = stbi_failure_reason();
+	Job_Unlock(&Texture_DecodeLock);
+	return pixels;
 }
 
 Texture Texture_FromFile(const char* filename) {
-	stbi_set_flip_vertically_on_load(0);
+	u32 len = strlen(filename);
+	if(len > 4 && strcmp(filename + len - 4, ".ktx") == 0) {
+		u32 size;
+		const u8* data = File_Map(filename, &size);
+		if(!data) {
+			Log(ERROR, "[Render] Texture %s load fail - file doens't exist.", filename);
+			return (Texture){0};
+		}
+
+		Texture t = Texture_FromKTX(data, size);
+		File_Unmap(data, size);
+		return t;
+	}
 
 	i32 w, h, nComp;
-	u8* Data = stbi_load(filename, &w, &h, &nComp, 0);
+	u8* Data = Texture_DecodeFile(filename, &w, &h, &nComp, NULL);
 
 	if(!Data) {
 		Log(ERROR, "[Render] Texture %s load fail - file doens't exist.", filename);
 		return (Texture){0};
 	}
 
-	enum Texture_Format fmt;
-	switch(nComp) {
-		case 1: fmt = Format_Red; break;
-		case 2: fmt = Format_RG; break;
-		case 3: fmt = Format_RGB; break;
-		case 4: fmt = Format_RGBA; break;
+	Texture t = Texture_FromPixels(Data, w, h, nComp);
+
+	stbi_image_free(Data);
+
+	return t;
+}
+
+Texture Texture_FromMemory(const u8* data, u32 size) {
+	if(Image_IsKTX(data, size)) return Texture_FromKTX(data, size);
+
+	i32 w, h, nComp;
+	const char* error;
+	u8* Data = Texture_DecodeMemory(data, size, &w, &h, &nComp, &error);
+
+	if(!Data) {
+		Log(ERROR, "[Render] Texture decode fail - %s.", error);
+		return (Texture){0};
 	}
 
-	Texture t = Texture_Init(w, h, fmt, Filter_Linear, Wrap_Repeat);
-	Texture_SetData(&t, Data, w, h, 1);
+	Texture t = Texture_FromPixels(Data, w, h, nComp);
 
 	stbi_image_free(Data);
 
@@ -419,6 +633,316 @@ Texture Texture_FromFile(const char* filename) {
 }
 void Texture_Free(Texture t) { glDeleteTextures(1, &t.Id); }
 
+u64 Texture_MemorySize(const Texture* t) {
+	u64 blocks = (u64) ((t->Width + 3) / 4) * ((t->Height + 3) / 4);
+	u64 pixels = (u64) t->Width * t->Height;
+	u64 bytes;
+
+	switch(t->InternalFormat) {
+		case GL_R8: bytes = pixels; break;
+		case GL_RG8: bytes = pixels * 2; break;
+
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1: bytes = blocks * 8; break;
+
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2: bytes = blocks * 16; break;
+
+		// RGB is padded out to 4 bytes by most drivers anyway.
+		default: bytes = pixels * 4; break;
+	}
+
+	// A full chain of mipmaps adds a third.
+	return (t->HasMipmaps ? bytes + bytes / 3 : bytes);
+}
+
+//
+// Async textures
+//
+
+typedef struct Texture_Load Texture_Load;
+
+struct Texture_Load {
+	char* File;
+	Texture* Target;
+	Texture_LoadedFunc OnLoaded;
+	void* Data;
+
+	// Filled in by the worker, and only looked at once the counter gets to zero.
+	Job_Counter Decoded;
+	const char* Error; // Set if the file couldn't be loaded.
+	u8* Levels[IMAGE_MAX_LEVELS];
+	u32 NumLevels;
+	i32 Width, Height, NumComp;
+	bool8 SRGB; // Only means anything with 3 or 4 channels.
+
+	// A .ktx file stays mapped until it's up, its levels point into the mapping.
+	bool8 IsKTX;
+	Image_KTX KTX;
+	const u8* Mapped;
+	u32 MappedSize;
+
+	// The real texture, it replaces the placeholder once every row of every level is up.
+	Texture Staging;
+	u32 Level, NextRow; // For compressed levels, rows of 4x4 blocks.
+};
+
+static struct {
+	Texture_Load** Loads; // In the order they were asked for.
+	u32 NumLoads, Capacity;
+
+	GLuint PBO; // Orphaned before each upload, so there's no waiting on the last one.
+	u32 Budget;
+} Texture_Async = {.Budget = TEXTURE_UPLOAD_BUDGET_DEFAULT};
+
+// Mipmaps get made here too, so glGenerateMipmap() doesn't hold up the render thread.
+// KTX files already have theirs, so they only get checked.
+static void Texture_Decode(void* data) {
+	Texture_Load* l = data;
+
+	l->Mapped = File_Map(l->File, &l->MappedSize);
+	if(!l->Mapped) {
+		l->Error = "the file can't be opened";
+		return;
+	}
+
+	if(Image_IsKTX(l->Mapped, l->MappedSize)) {
+		l->IsKTX = 1;
+		if(!Image_ParseKTX(l->Mapped, l->MappedSize, &l->KTX)) {
+			l->Error = "the KTX file is broken";
+		} else if(!l->KTX.RowBytes[0]) {
+			l->Error = "its compressed format can't be uploaded bit by bit";
+		} else {
+			l->Width     = l->KTX.Width;
+			l->Height    = l->KTX.Height;
+			l->NumLevels = MAX(l->KTX.NumLevels, 1);
+		}
+		return;
+	}
+
+	l->Levels[0] = Texture_DecodeMemory(l->Mapped, l->MappedSize, &l->Width, &l->Height, &l->NumComp, &l->Error);
+	File_Unmap(l->Mapped, l->MappedSize);
+	l->Mapped = NULL;
+	if(!l->Levels[0]) return;
+
+	Image_MipOptions options = {.Filter = ImageMipFilter_Kaiser, .SRGB = l->SRGB && l->NumComp >= 3};
+	l->NumLevels             = Image_NumLevels(l->Width, l->Height);
+
+	// Too big for mipmaps, it can still go up without them.
+	if(!Image_GenMips(l->Levels, l->Width, l->Height, l->NumComp, l->NumLevels, &options)) l->NumLevels = 1;
+}
+
+static void Texture_FreeLevels(Texture_Load* l) {
+	if(l->Mapped) File_Unmap(l->Mapped, l->MappedSize);
+	if(l->IsKTX) return;
+
+	if(l->Levels[0]) stbi_image_free(l->Levels[0]);
+	for(u32 i = 1; i < l->NumLevels; i++) Free(l->Levels[i]);
+}
+
+void Texture_FromFileAsync(Texture* t, const char* file, bool8 srgb, Texture_LoadedFunc onLoaded, void* data) {
+	static const u8 placeholder[4] = {128, 128, 128, 255};
+
+	*t = Texture_Init(1, 1, Format_RGBA, Filter_Linear, Wrap_Repeat);
+	Texture_SetData(t, placeholder, 1, 1, 0);
+
+	Texture_Load* l = Allocate(sizeof(Texture_Load));
+	memset(l, 0, sizeof(Texture_Load));
+	l->File = Allocate(strlen(file) + 1);
+	strcpy(l->File, file);
+	l->Target   = t;
+	l->OnLoaded = onLoaded;
+	l->Data     = data;
+	l->SRGB     = srgb;
+
+	if(Texture_Async.NumLoads == Texture_Async.Capacity) {
+		Texture_Async.Capacity = MAX(Texture_Async.Capacity * 2, 16);
+		Texture_Async.Loads    = Reallocate(Texture_Async.Loads, sizeof(Texture_Load*) * Texture_Async.Capacity);
+	}
+	Texture_Async.Loads[Texture_Async.NumLoads++] = l;
+
+	Job_Run(Texture_Decode, l, &l->Decoded);
+}
+
+void Texture_SetUploadBudget(u32 bytesPerFrame) { Texture_Async.Budget = bytesPerFrame; }
+
+u32 Texture_NumLoading(void) { return Texture_Async.NumLoads; }
+
+// Make the real texture, with room for every level. Returns 0 if GL wouldn't have it.
+static bool8 Texture_InitStaging(Texture_Load* l) {
+	if(l->IsKTX) {
+		l->Staging = Texture_InitKTX(&l->KTX, 0);
+		return l->Staging.Id != 0;
+	}
+
+	enum Texture_Format fmt = l->NumComp == 1 ? Format_Red
+	                        : l->NumComp == 2 ? Format_RG
+	                        : l->NumComp == 3 ? Format_RGB
+	                                          : Format_RGBA;
+	l->Staging = Texture_Init(l->Width, l->Height, fmt, l->Target->Filter, l->Target->Wrap);
+
+	// Texture_Init() always makes it linear, so the first level gets made again as sRGB.
+	if(l->SRGB && l->NumComp >= 3) {
+		l->Staging.SRGB = 1;
+		Texture_SetData(&l->Staging, NULL, l->Width, l->Height, 0);
+	}
+
+	// Texture_Init() only makes room for the first level.
+	glBindTexture(GL_TEXTURE_2D, l->Staging.Id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, l->NumLevels - 1);
+	for(u32 i = 1; i < l->NumLevels; i++) {
+		glTexImage2D(GL_TEXTURE_2D, i, l->Staging.InternalFormat, MAX(l->Width >> i, 1), MAX(l->Height >> i, 1), 0,
+		             l->Staging.Format, GL_UNSIGNED_BYTE, NULL);
+	}
+	l->Staging.HasMipmaps = l->NumLevels > 1;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Texture_MinFilter(&l->Staging));
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return l->Staging.Id != 0;
+}
+
+// Upload as many rows as there's budget left for, a level at a time.
+// Returns 1 once every level is up.
+static bool8 Texture_UploadRows(Texture_Load* l, u32* budget, bool8* uploadedAny) {
+	bool8 compressed = l->IsKTX && !l->KTX.GLType;
+
+	// Rows from stb_image and mipmaps are packed tightly, KTX pads them to 4 bytes.
+	glBindTexture(GL_TEXTURE_2D, l->Staging.Id);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, l->IsKTX ? 4 : 1);
+
+	while(l->Level < l->NumLevels) {
+		u32 width    = MAX(l->Width >> l->Level, 1);
+		u32 height   = MAX(l->Height >> l->Level, 1);
+		u32 numRows  = compressed ? (height + 3) / 4 : height;
+		u32 rowBytes = l->IsKTX ? l->KTX.RowBytes[l->Level] : width * l->NumComp;
+		u32 rows     = MIN(*budget / rowBytes, numRows - l->NextRow);
+		if(!rows && !*uploadedAny) rows = 1;
+		if(!rows) break;
+
+		const u8* level = l->IsKTX ? l->KTX.Levels[l->Level] : l->Levels[l->Level];
+		u32 size        = rows * rowBytes;
+		const u8* src   = level + (u64) l->NextRow * rowBytes;
+		const void* ptr = src;
+
+		if(!Texture_Async.PBO) glGenBuffers(1, &Texture_Async.PBO);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Texture_Async.PBO);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+		void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if(dst) {
+			memcpy(dst, src, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			ptr = NULL; // An offset into the buffer.
+		} else {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		if(compressed) {
+			// Whole rows of blocks, the last one can be cut short by the edge.
+			u32 y = l->NextRow * 4;
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, l->Level, 0, y, width, MIN(rows * 4, height - y),
+			                          l->KTX.GLInternalFormat, size, ptr);
+		} else if(l->IsKTX) {
+			glTexSubImage2D(GL_TEXTURE_2D, l->Level, 0, l->NextRow, width, rows, l->KTX.GLFormat, l->KTX.GLType, ptr);
+		} else {
+			glTexSubImage2D(GL_TEXTURE_2D, l->Level, 0, l->NextRow, width, rows, l->Staging.Format, GL_UNSIGNED_BYTE, ptr);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		l->NextRow += rows;
+		*budget -= MIN(*budget, size);
+		*uploadedAny = 1;
+
+		if(l->NextRow == numRows) {
+			l->Level++;
+			l->NextRow = 0;
+		}
+	}
+
+	// A KTX file with no levels wants them made, like Texture_FromKTX() does.
+	bool8 done = l->Level == l->NumLevels;
+	if(done && l->IsKTX && !l->KTX.NumLevels) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return done;
+}
+
+void Texture_UpdateAsync(void) {
+	u32 budget        = Texture_Async.Budget;
+	bool8 uploadedAny = 0;
+	u32 kept          = 0;
+
+	// With no workers nobody else takes jobs off this thread's queue,
+	// so images get decoded here, one a frame.
+	bool8 canWait = Job_NumThreads() <= 1;
+
+	// Callbacks can start more loads, which land at the end and get looked at in this same loop.
+	for(u32 i = 0; i < Texture_Async.NumLoads; i++) {
+		Texture_Load* l = Texture_Async.Loads[i];
+		bool8 loaded    = 0;
+
+		if(canWait && !Job_IsDone(&l->Decoded)) {
+			Job_Wait(&l->Decoded);
+			canWait = 0;
+		}
+
+		if(!Job_IsDone(&l->Decoded)) {
+			Texture_Async.Loads[kept++] = l;
+			continue;
+		}
+
+		if(l->Error) {
+			Log(ERROR, "[Render] Texture %s load fail - %s.", l->File, l->Error);
+		} else if(!l->Staging.Id && !Texture_InitStaging(l)) {
+			Log(ERROR, "[Render] Texture %s load fail - the texture couldn't be made.", l->File);
+		} else if(!Texture_UploadRows(l, &budget, &uploadedAny)) {
+			Texture_Async.Loads[kept++] = l;
+			continue;
+		} else {
+			Texture_Free(*l->Target);
+			*l->Target = l->Staging;
+			loaded     = 1;
+		}
+
+		Texture_FreeLevels(l);
+		if(l->OnLoaded) l->OnLoaded(l->Target, loaded, l->Data);
+
+		Free(l->File);
+		Free(l);
+	}
+
+	Texture_Async.NumLoads = kept;
+}
+
+void Texture_CancelAsync(void) {
+	for(u32 i = 0; i < Texture_Async.NumLoads; i++) {
+		Texture_Load* l = Texture_Async.Loads[i];
+
+		// Job_Shutdown() runs everything that was queued, so once the workers
+		// are gone every decode has finished and there's nothing to wait for.
+		if(!Job_IsDone(&l->Decoded)) Job_Wait(&l->Decoded);
+
+		Texture_FreeLevels(l);
+		if(l->Staging.Id) Texture_Free(l->Staging);
+		Free(l->File);
+		Free(l);
+	}
+
+	if(Texture_Async.PBO) glDeleteBuffers(1, &Texture_Async.PBO);
+	Free(Texture_Async.Loads);
+
+	Texture_Async.Loads    = NULL;
+	Texture_Async.NumLoads = Texture_Async.Capacity = 0;
+	Texture_Async.PBO      = 0;
+}
+
 //
 // RT
 //
@@ -568,25 +1092,20 @@ void R2D_Init() {
 	RectShader = Shader_FromFile("res/shaders/ui/rect.glsl");
 	TextShader = Shader_FromFile("res/shaders/ui/text.glsl");
 
-	Texture* tex = malloc(sizeof(Texture) * 3);
-	tex[0] = Texture_FromFile("res/textures/font_mono_6x12.png"),
-	tex[1] = Texture_FromFile("res/textures/font_mono_7x15.png"),
-	tex[2] = Texture_FromFile("res/textures/font_mono_15x29.png");
-
 	Font_Small = (Spritesheet){
-	    .Texture      = tex,
+	    .Texture      = Res_Texture_GetOrLoad("res/textures/font_mono_6x12.ktx"),
 	    .SpriteWidth  = 6,
 	    .SpriteHeight = 12,
 	};
 
 	Font_Medium = (Spritesheet){
-	    .Texture      = tex + 1,
+	    .Texture      = Res_Texture_GetOrLoad("res/textures/font_mono_7x15.ktx"),
 	    .SpriteWidth  = 7,
 	    .SpriteHeight = 15,
 	};
 
 	Font_Large = (Spritesheet){
-	    .Texture      = tex + 2,
+	    .Texture      = Res_Texture_GetOrLoad("res/textures/font_mono_15x29.ktx"),
 	    .SpriteWidth  = 15,
 	    .SpriteHeight = 29,
 	};
@@ -1077,6 +1596,30 @@ void R3D_DrawWireSphere(Camera cam, Vec3 center, r32 radius, RGBA color) {
 
 DEF_ARRAY(NodePtr, R3D_Node*);
 DECL_ARRAY(NodePtr, R3D_Node*);
+DECL_ARRAY(Node, R3D_Node);
+
+R3D_Node* R3D_Node_Create(enum R3D_Node_Type type) {
+	R3D_Node* res = Allocate(sizeof(R3D_Node));
+	memset(res, 0, sizeof(R3D_Node));
+
+	res->Type           = type;
+	res->LocalTransform = Transform3D_Default;
+	return res;
+}
+
+static void R3D_Node_FreeChildren(R3D_Node* n) {
+	for(u32 i = 0; i < n->Children.Size; i++) R3D_Node_FreeChildren(&n->Children.Data[i]);
+
+	if(n->Type == Node_Actor) glDeleteVertexArrays(1, &n->Actor.VAO);
+	Array_Node_Free(&n->Children);
+}
+
+void R3D_Node_Free(R3D_Node* n) {
+	if(!n) return;
+
+	R3D_Node_FreeChildren(n);
+	Free(n);
+}
 
 void R3D_CalcTransform(const R3D_Node* r, Mat4 out) {
 	if(r == NULL) {
@@ -0,0 +1,259 @@
+#include "../Res.h"
+
+#include <string.h>
+
+typedef struct Res_Texture Res_Texture;
+typedef struct Res_Path Res_Path;
+
+// A loaded texture, shared by every path whose file had the same contents.
+struct Res_Texture {
+	Texture Texture; // Has to be first, the Texture* handed out is also a Res_Texture*.
+
+	u128 Content; // MD5 of the file it came from.
+	u64 Bytes;
+	u32 RefCount;
+	u32 Index; // Where it is in Res_State.Textures.
+
+	// Textures with no references, most recently used first.
+	Res_Texture *Prev, *Next;
+};
+
+// Paths are interned for good, they only lose their texture when it's freed.
+struct Res_Path {
+	char* Path; // NULL for an empty slot.
+	u64 Hash;
+	Res_Texture* Texture;
+};
+
+static struct {
+	Res_Path* Paths; // Open addressing, kept at most 3/4 full.
+	u32 PathMask, NumPaths;
+
+	Res_Texture** Textures;
+	u32 NumTextures, TextureCapacity;
+
+	Res_Texture *UnusedFirst, *UnusedLast;
+
+	Res_Stats Stats;
+} Res_State;
+
+static Res_Path* Res_FindPath(const char* path, u64 hash) {
+	if(!Res_State.Paths) return NULL;
+
+	u32 slot = hash & Res_State.PathMask;
+	while(Res_State.Paths[slot].Path) {
+		Res_Path* p = &Res_State.Paths[slot];
+		if(p->Hash == hash && strcmp(p->Path, path) == 0) return p;
+		slot = (slot + 1) & Res_State.PathMask;
+	}
+
+	return NULL;
+}
+
+// Find the path, or add it if it isn't there yet.
+static Res_Path* Res_InternPath(const char* path, u64 hash) {
+	Res_Path* p = Res_FindPath(path, hash);
+	if(p) return p;
+
+	u32 capacity = Res_State.Paths ? Res_State.PathMask + 1 : 0;
+	if((Res_State.NumPaths + 1) * 4 > capacity * 3) {
+		u32 newCapacity = MAX(capacity * 2, 64);
+		Res_Path* paths = Allocate(sizeof(Res_Path) * newCapacity);
+		memset(paths, 0, sizeof(Res_Path) * newCapacity);
+
+		for(u32 i = 0; i < capacity; i++) {
+			if(!Res_State.Paths[i].Path) continue;
+
+			u32 slot = Res_State.Paths[i].Hash & (newCapacity - 1);
+			while(paths[slot].Path) slot = (slot + 1) & (newCapacity - 1);
+			paths[slot] = Res_State.Paths[i];
+		}
+
+		Free(Res_State.Paths);
+		Res_State.Paths    = paths;
+		Res_State.PathMask = newCapacity - 1;
+	}
+
+	u32 slot = hash & Res_State.PathMask;
+	while(Res_State.Paths[slot].Path) slot = (slot + 1) & Res_State.PathMask;
+
+	u32 len = strlen(path);
+	p       = &Res_State.Paths[slot];
+	p->Path = Allocate(len + 1);
+	memcpy(p->Path, path, len + 1);
+	p->Hash    = hash;
+	p->Texture = NULL;
+
+	Res_State.NumPaths++;
+	return p;
+}
+
+// Only misses look for a texture by its contents, and they've just read a whole file,
+// so going through all of them is cheap enough.
+static Res_Texture* Res_FindContent(const u128* content) {
+	for(u32 i = 0; i < Res_State.NumTextures; i++)
+		if(Hash_Equal(&Res_State.Textures[i]->Content, content)) return Res_State.Textures[i];
+	return NULL;
+}
+
+static void Res_Unlink(Res_Texture* t) {
+	if(t->Prev) t->Prev->Next = t->Next;
+	else Res_State.UnusedFirst = t->Next;
+
+	if(t->Next) t->Next->Prev = t->Prev;
+	else Res_State.UnusedLast = t->Prev;
+
+	t->Prev = t->Next = NULL;
+	Res_State.Stats.Unused--;
+}
+
+static void Res_Acquire(Res_Texture* t) {
+	if(t->RefCount++ == 0) Res_Unlink(t);
+}
+
+static void Res_FreeTexture(Res_Texture* t) {
+	// Paths keep pointing at their texture, so they have to be looked through.
+	// This only happens on eviction, which shouldn't be often.
+	for(u32 i = 0; i <= Res_State.PathMask && Res_State.Paths; i++)
+		if(Res_State.Paths[i].Texture == t) Res_State.Paths[i].Texture = NULL;
+
+	Res_Texture* last = Res_State.Textures[--Res_State.NumTextures];
+	Res_State.Textures[t->Index] = last;
+	last->Index = t->Index;
+
+	Res_State.Stats.Textures--;
+	Res_State.Stats.BytesResident -= t->Bytes;
+
+	Texture_Free(t->Texture);
+	Free(t);
+}
+
+// Free the least recently used textures nothing holds on to, until they all fit in the budget.
+static void Res_Evict() {
+	if(!Res_State.Stats.Budget) return;
+
+	while(Res_State.Stats.BytesResident > Res_State.Stats.Budget && Res_State.UnusedLast) {
+		Res_Texture* t = Res_State.UnusedLast;
+		Res_Unlink(t);
+
+		Log(INFO, "[Res] Evicting texture %u (%lu bytes).", t->Texture.Id, (unsigned long) t->Bytes);
+		Res_FreeTexture(t);
+		Res_State.Stats.Evicted++;
+	}
+}
+
+bool8 Res_Texture_InCache(const char* filename) {
+	Res_Path* p = Res_FindPath(filename, Hash_FNV1a((const u8*) filename, strlen(filename)));
+	return p && p->Texture;
+}
+
+Texture* Res_Texture_GetOrLoad(const char* filename) {
+	u64 hash    = Hash_FNV1a((const u8*) filename, strlen(filename));
+	Res_Path* p = Res_FindPath(filename, hash);
+
+	if(p && p->Texture) {
+		Res_State.Stats.Hits++;
+		Res_Acquire(p->Texture);
+		return &p->Texture->Texture;
+	}
+
+	Res_State.Stats.Misses++;
+
+	u32 size;
+	u8* data = File_ReadToBuffer_Alloc(filename, &size);
+	if(!data) {
+		Log(ERROR, "[Res] Texture %s load fail - file doesn't exist.", filename);
+		return NULL;
+	}
+
+	u128 content   = Hash_MD5(data, size);
+	Res_Texture* t = Res_FindContent(&content);
+
+	if(t) {
+		Res_State.Stats.Deduped++;
+		Res_Acquire(t);
+	} else {
+		Texture tex = Texture_FromMemory(data, size);
+		if(!tex.Id) {
+			Log(ERROR, "[Res] Texture %s load fail.", filename);
+			Free(data);
+			return NULL;
+		}
+
+		t = Allocate(sizeof(Res_Texture));
+		memset(t, 0, sizeof(Res_Texture));
+		t->Texture  = tex;
+		t->Content  = content;
+		t->Bytes    = Texture_MemorySize(&tex);
+		t->RefCount = 1;
+
+		if(Res_State.NumTextures == Res_State.TextureCapacity) {
+			Res_State.TextureCapacity = MAX(Res_State.TextureCapacity * 2, 16);
+			Res_State.Textures =
+			    Reallocate(Res_State.Textures, sizeof(Res_Texture*) * Res_State.TextureCapacity);
+		}
+		t->Index = Res_State.NumTextures;
+		Res_State.Textures[Res_State.NumTextures++] = t;
+
+		Res_State.Stats.Textures++;
+		Res_State.Stats.BytesResident += t->Bytes;
+	}
+
+	Free(data);
+
+	Res_InternPath(filename, hash)->Texture = t;
+
+	// The new texture is held on to, so it can't be the one that goes.
+	Res_Evict();
+
+	return &t->Texture;
+}
+
+void Res_Texture_Release(Texture* texture) {
+	if(!texture) return;
+
+	Res_Texture* t = (Res_Texture*) texture;
+	if(!t->RefCount) {
+		Log(WARN, "[Res] Texture %u released more times than it was loaded.", texture->Id);
+		return;
+	}
+
+	if(--t->RefCount) return;
+
+	t->Prev = NULL;
+	t->Next = Res_State.UnusedFirst;
+	if(t->Next) t->Next->Prev = t;
+	else Res_State.UnusedLast = t;
+	Res_State.UnusedFirst = t;
+	Res_State.Stats.Unused++;
+
+	Res_Evict();
+}
+
+void Res_SetBudget(u64 bytes) {
+	Res_State.Stats.Budget = bytes;
+	Res_Evict();
+}
+
+Res_Stats Res_GetStats(void) { return Res_State.Stats; }
+
+void Res_FreeAll(void) {
+	for(u32 i = 0; i < Res_State.NumTextures; i++) {
+		Texture_Free(Res_State.Textures[i]->Texture);
+		Free(Res_State.Textures[i]);
+	}
+
+	for(u32 i = 0; i <= Res_State.PathMask && Res_State.Paths; i++)
+		Free(Res_State.Paths[i].Path);
+
+	Free(Res_State.Textures);
+	Free(Res_State.Paths);
+
+	Res_Stats stats = Res_State.Stats;
+	memset(&Res_State, 0, sizeof(Res_State));
+
+	// Hits and misses carry on counting, only what's loaded is gone.
+	Res_State.Stats          = stats;
+	Res_State.Stats.Textures = Res_State.Stats.Unused = 0;
+	Res_State.Stats.BytesResident = 0;
+}
@@ -1,5 +1,6 @@
 #include "../Utils.h"
 #include "../Common.h"
+#include "../Mesh.h"
 
 DEF_ARRAY(Vec2, Vec2);
 DEF_ARRAY(Vec3, Vec3);
@@ -13,15 +14,40 @@ void WObj_ToGPUModel(GPUModel* out, const WObj_Object* obj) {
 	glBindVertexArray(out->VAO);
 	glGenBuffers(3, out->VBOs);
 	glGenBuffers(1, &out->ElementBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, out->ElementBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-	             sizeof(u32) * obj->NumIndices,
-	             obj->Indices,
-	             GL_STATIC_DRAW);
 
 	out->NumVertices = obj->NumVertices;
 	out->NumIndices  = obj->NumIndices;
 
+	out->MeshletBuffer  = 0;
+	out->Meshlets       = NULL;
+	out->MeshletCounts  = NULL;
+	out->MeshletOffsets = NULL;
+	out->MeshletRanges  = NULL;
+
+	// Put the full mesh and all of its LODs in one element buffer.
+	out->NumLODs       = obj->NumLODs + 1;
+	out->LODOffsets[0] = 0;
+	out->LODCounts[0]  = obj->NumIndices;
+	out->LODErrors[0]  = 0;
+
+	u32 totalIndices = obj->NumIndices;
+	for(u32 i = 0; i < obj->NumLODs; i++) {
+		out->LODOffsets[i + 1] = totalIndices;
+		out->LODCounts[i + 1]  = obj->LODs[i].NumIndices;
+		out->LODErrors[i + 1]  = obj->LODs[i].Error;
+		totalIndices += obj->LODs[i].NumIndices;
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, out->ElementBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(u32) * totalIndices, NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(u32) * obj->NumIndices, obj->Indices);
+
+	for(u32 i = 0; i < obj->NumLODs; i++)
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+		                sizeof(u32) * out->LODOffsets[i + 1],
+		                sizeof(u32) * out->LODCounts[i + 1],
+		                obj->LODs[i].Indices);
+
 	Array_Vec3 Positions = {0};
 	Array_Vec2 UVs       = {0};
 	Array_Vec3 Normals   = {0};
@@ -59,8 +85,248 @@ void WObj_ToGPUModel(GPUModel* out, const WObj_Object* obj) {
 	Array_Vec3_Free(&Normals);
 }
 
-void GPUModel_Render(const GPUModel* model) {
+void GPUModel_Free(GPUModel* model) {
+	GPUModel_FreeMeshlets(model);
+
+	glDeleteBuffers(3, model->VBOs);
+	glDeleteBuffers(1, &model->ElementBuffer);
+	glDeleteVertexArrays(1, &model->VAO);
+
+	model->VAO           = 0;
+	model->ElementBuffer = 0;
+	model->NumVertices   = 0;
+	model->NumIndices    = 0;
+	model->NumLODs       = 0;
+	memset(model->VBOs, 0, sizeof(model->VBOs));
+}
+
+void GPUModel_Render(const GPUModel* model) { GPUModel_RenderLOD(model, 0); }
+
+void GPUModel_RenderLOD(const GPUModel* model, u32 lod) {
+	if(lod >= model->NumLODs) lod = model->NumLODs ? model->NumLODs - 1 : 0;
+
+	u32 offset = model->NumLODs ? model->LODOffsets[lod] : 0;
+	u32 count  = model->NumLODs ? model->LODCounts[lod] : model->NumIndices;
+
 	glBindVertexArray(model->VAO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->ElementBuffer);
-	glDrawElements(GL_TRIANGLES, model->NumIndices, GL_UNSIGNED_INT, NULL);
+	glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*) (sizeof(u32) * offset));
+}
+
+u32 GPUModel_SelectLOD(const GPUModel* model,
+                       Camera cam,
+                       Transform3D transform,
+                       r32 screenHeight,
+                       r32 maxPixelError) {
+	return Mesh_SelectLOD(
+	    model->LODErrors, model->NumLODs, cam, transform, screenHeight, maxPixelError);
+}
+
+void GPUModel_SetMeshlets(GPUModel* model, const Mesh_Meshlets* meshlets) {
+	u32* indices = Allocate(sizeof(u32) * MAX(meshlets->NumTriangles * 3, 1));
+	Mesh_Meshlets_Unpack(meshlets, indices);
+
+	if(!model->MeshletBuffer) glGenBuffers(1, &model->MeshletBuffer);
+
+	glBindVertexArray(model->VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->MeshletBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+	             sizeof(u32) * meshlets->NumTriangles * 3,
+	             indices,
+	             GL_STATIC_DRAW);
+	Free(indices);
+
+	// At most one draw range per meshlet.
+	u32 maxRanges         = MAX(meshlets->NumMeshlets, 1);
+	model->Meshlets       = meshlets;
+	model->MeshletCounts  = Reallocate(model->MeshletCounts, sizeof(GLsizei) * maxRanges);
+	model->MeshletOffsets = Reallocate(model->MeshletOffsets, sizeof(void*) * maxRanges);
+	model->MeshletRanges  = Reallocate(model->MeshletRanges, sizeof(u32) * maxRanges * 2);
+}
+
+void GPUModel_FreeMeshlets(GPUModel* model) {
+	if(model->MeshletBuffer) glDeleteBuffers(1, &model->MeshletBuffer);
+	Free(model->MeshletCounts);
+	Free(model->MeshletOffsets);
+	Free(model->MeshletRanges);
+
+	model->MeshletBuffer  = 0;
+	model->Meshlets       = NULL;
+	model->MeshletCounts  = NULL;
+	model->MeshletOffsets = NULL;
+	model->MeshletRanges  = NULL;
+}
+
+u32 GPUModel_RenderMeshlets(GPUModel* model, Camera cam, Transform3D transform) {
+	if(!model->Meshlets) {
+		GPUModel_Render(model);
+		return model->NumIndices / 3;
+	}
+
+	u32* first    = model->MeshletRanges;
+	u32* count    = first + MAX(model->Meshlets->NumMeshlets, 1);
+	u32 numRanges = Mesh_Meshlets_Cull(model->Meshlets, cam, transform, first, count);
+
+	u32 numIndices = 0;
+	for(u32 i = 0; i < numRanges; i++) {
+		model->MeshletOffsets[i] = (void*) (sizeof(u32) * (size_t) first[i]);
+		model->MeshletCounts[i]  = count[i];
+		numIndices += count[i];
+	}
+
+	if(!numRanges) return 0;
+
+	glBindVertexArray(model->VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->MeshletBuffer);
+	glMultiDrawElements(GL_TRIANGLES,
+	                    model->MeshletCounts,
+	                    GL_UNSIGNED_INT,
+	                    (const void* const*) model->MeshletOffsets,
+	                    numRanges);
+
+	return numIndices / 3;
+}
+
+// Every buffer view is uploaded at most once, the actors using it share the GL buffer.
+static GLuint GLTF_ViewBuffer(GLuint* buffers, const GLTF_Asset* asset, const GLTF_BufferView* view) {
+	u32 i = view - asset->bufferViews;
+
+	if(!buffers[i]) {
+		glGenBuffers(1, &buffers[i]);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER,
+		             view->length,
+		             view->buffer->data + view->offset,
+		             GL_STATIC_DRAW);
+	}
+
+	return buffers[i];
+}
+
+static void GLTF_SetAttrib(GLuint* buffers, const GLTF_Asset* asset, u32 location, const GLTF_Accessor* a) {
+	if(!a || !a->bufferView) return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, GLTF_ViewBuffer(buffers, asset, a->bufferView));
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location,
+	                      GLTF_Accessor_NumComponents(a),
+	                      a->componentType,
+	                      a->normalized,
+	                      a->bufferView->stride,
+	                      (void*) (size_t) a->byteOffset);
+}
+
+static void GLTF_ToActor(Actor* out, const GLTF_Primitive* p, GLuint* buffers, const GLTF_Asset* asset) {
+	*out = (Actor){.RenderMode = RenderMode_Lit, .CastShadow = 1, .Mode = p->mode};
+
+	glGenVertexArrays(1, &out->VAO);
+	glBindVertexArray(out->VAO);
+
+	// Same attribute locations as GPUModel.
+	GLTF_SetAttrib(buffers, asset, 0, p->position);
+	GLTF_SetAttrib(buffers, asset, 1, p->texCoord);
+	GLTF_SetAttrib(buffers, asset, 2, p->normal);
+
+	if(p->indices && p->indices->bufferView) {
+		// The element buffer is VAO state, it isn't kept in ElementBuffer since it's shared.
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GLTF_ViewBuffer(buffers, asset, p->indices->bufferView));
+		out->IndexType   = p->indices->componentType;
+		out->IndexOffset = p->indices->byteOffset;
+		out->Count       = p->indices->count;
+	} else {
+		out->Count = (p->position ? p->position->count : 0);
+	}
+
+	glBindVertexArray(0);
+}
+
+// Returns whether the node or any of its children has a bounding box.
+static bool8 GLTF_BuildNode(R3D_Node* out,
+                            const R3D_Node* parent,
+                            const GLTF_Node* n,
+                            GLuint* buffers,
+                            const GLTF_Asset* asset) {
+	out->Parent = parent;
+	out->Type   = Node_None;
+
+	if(n->transformType == Transform_TRS) {
+		out->LocalTransform = n->trs;
+	} else {
+		Mat4 m;
+		Mat4_Copy(m, n->matrix);
+		out->LocalTransform = Mat4_Decompose(m);
+	}
+
+	// A single primitive goes straight into the node, more get a child node each.
+	u32 numPrims    = (n->mesh ? n->mesh->numPrimitives : 0);
+	u32 numExtra    = (numPrims > 1 ? numPrims : 0);
+	u32 numChildren = numExtra + n->numChildren;
+
+	Array_Node_Prealloc(&out->Children, numChildren);
+	if(numChildren) memset(out->Children.Data, 0, sizeof(R3D_Node) * numChildren);
+	out->Children.Size = numChildren;
+
+	bool8 hasBox = 0;
+	for(u32 i = 0; i < numPrims; i++) {
+		const GLTF_Primitive* p = &n->mesh->primitives[i];
+		R3D_Node* node          = out;
+
+		if(numExtra) {
+			node                 = &out->Children.Data[i];
+			node->Parent         = out;
+			node->LocalTransform = Transform3D_Default;
+		}
+
+		node->Type = Node_Actor;
+		GLTF_ToActor(&node->Actor, p, buffers, asset);
+
+		if(p->position && p->position->hasMinMax) {
+			AABB box = {p->position->min.vec3, p->position->max.vec3};
+
+			node->LocalBox = box;
+			node->SumBox   = box;
+			out->LocalBox  = (hasBox ? AABB_Add(out->LocalBox, box) : box);
+			hasBox         = 1;
+		}
+	}
+
+	out->SumBox = out->LocalBox;
+	for(u32 i = 0; i < n->numChildren; i++) {
+		R3D_Node* child = &out->Children.Data[numExtra + i];
+		if(!GLTF_BuildNode(child, out, n->children[i], buffers, asset)) continue;
+
+		AABB box    = AABB_ApplyTransform3D(child->SumBox, child->LocalTransform);
+		out->SumBox = (hasBox ? AABB_Add(out->SumBox, box) : box);
+		hasBox      = 1;
+	}
+
+	return hasBox;
+}
+
+R3D_Node* GLTF_ToNodes(const GLTF_Asset* asset, const GLTF_Scene* scene) {
+	if(!asset || !scene) return NULL;
+
+	GLuint* buffers = Allocate(sizeof(GLuint) * MAX(asset->numBufferViews, 1));
+	memset(buffers, 0, sizeof(GLuint) * asset->numBufferViews);
+
+	R3D_Node* root = R3D_Node_Create(Node_None);
+	Array_Node_Prealloc(&root->Children, scene->numRootNodes);
+	if(scene->numRootNodes) memset(root->Children.Data, 0, sizeof(R3D_Node) * scene->numRootNodes);
+	root->Children.Size = scene->numRootNodes;
+
+	bool8 hasBox = 0;
+	for(u32 i = 0; i < scene->numRootNodes; i++) {
+		R3D_Node* child = &root->Children.Data[i];
+		if(!GLTF_BuildNode(child, root, scene->rootNodes[i], buffers, asset)) continue;
+
+		AABB box     = AABB_ApplyTransform3D(child->SumBox, child->LocalTransform);
+		root->SumBox = (hasBox ? AABB_Add(root->SumBox, box) : box);
+		hasBox       = 1;
+	}
+
+	// The VAOs keep the buffers alive, so the names can go now.
+	glDeleteBuffers(asset->numBufferViews, buffers);
+	Free(buffers);
+
+	return root;
 }
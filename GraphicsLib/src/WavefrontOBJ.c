@@ -482,6 +482,7 @@ WObj_Library* WObj_FromFile(const char* filename) {
 		Object.NumIndices  = Indices.Size;
 		Object.Vertices    = Vertices.Data;
 		Object.Indices     = Indices.Data;
+		Object.NumLODs     = 0;
 
 		Log(INFO, "[WObj]    Loaded \"%s\" with %d faces.", Object.Name, obj->Faces.Size);
 
@@ -552,6 +553,9 @@ void WObj_Library_Free(WObj_Library* l) {
 		Free(l->Objects[i].Vertices);
 		Free(l->Objects[i].Indices);
 		Free(l->Objects[i].Name);
+
+		for(u32 j = 0; j < l->Objects[i].NumLODs; ++j)
+			Free(l->Objects[i].LODs[j].Indices);
 	}
 
 	for(u32 i = 0; i < l->NumMaterials; ++i) {
@@ -0,0 +1,222 @@
+// JSONBench - how fast JSON gets read, events only and into a whole tree.
+//
+// With no files it makes up two documents about 20 MB each, a glTF-style one full of
+// floats and one full of short strings. Build it with `make jsonbench`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../GraphicsLib/Common.h"
+#include "../GraphicsLib/JSON.h"
+
+static u32 Seed = 1;
+
+static u32 Rand(void) {
+	Seed = Seed * 1664525u + 1013904223u;
+	return Seed >> 8;
+}
+
+static r64 RandFloat(void) { return Rand() / (r64) (1 << 24); }
+
+static r64 Now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Accessors and nodes like a big glTF has, mostly numbers. Names have an escape now and then.
+static char* MakeFloatDoc(u32* outSize) {
+	JSON_Writer w;
+	JSON_Writer_Init(&w, 1);
+	JSON_Writer_BeginObject(&w);
+
+	JSON_Writer_Key(&w, "accessors");
+	JSON_Writer_BeginArray(&w);
+	for(u32 i = 0; i < 40000; i++) {
+		JSON_Writer_BeginObject(&w);
+		JSON_Writer_Key(&w, "bufferView");
+		JSON_Writer_Integer(&w, i);
+		JSON_Writer_Key(&w, "componentType");
+		JSON_Writer_Integer(&w, 5126);
+		JSON_Writer_Key(&w, "count");
+		JSON_Writer_Integer(&w, Rand() % 100000 + 1);
+		JSON_Writer_Key(&w, "type");
+		JSON_Writer_String(&w, "VEC3");
+		JSON_Writer_Key(&w, "min");
+		JSON_Writer_BeginArray(&w);
+		for(u32 c = 0; c < 3; c++) JSON_Writer_Number(&w, RandFloat());
+		JSON_Writer_EndArray(&w);
+		JSON_Writer_Key(&w, "max");
+		JSON_Writer_BeginArray(&w);
+		for(u32 c = 0; c < 3; c++) JSON_Writer_Number(&w, RandFloat());
+		JSON_Writer_EndArray(&w);
+		JSON_Writer_EndObject(&w);
+	}
+	JSON_Writer_EndArray(&w);
+
+	JSON_Writer_Key(&w, "nodes");
+	JSON_Writer_BeginArray(&w);
+	for(u32 i = 0; i < 40000; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), i % 16 ? "node %u" : "node\t%u", i);
+
+		JSON_Writer_BeginObject(&w);
+		JSON_Writer_Key(&w, "name");
+		JSON_Writer_String(&w, name);
+		JSON_Writer_Key(&w, "translation");
+		JSON_Writer_BeginArray(&w);
+		for(u32 c = 0; c < 3; c++) JSON_Writer_Number(&w, RandFloat() * 200 - 100);
+		JSON_Writer_EndArray(&w);
+		JSON_Writer_Key(&w, "children");
+		JSON_Writer_BeginArray(&w);
+		for(u32 c = 0; c < 3; c++) JSON_Writer_Integer(&w, i * 3 + c);
+		JSON_Writer_EndArray(&w);
+		JSON_Writer_EndObject(&w);
+	}
+	JSON_Writer_EndArray(&w);
+
+	JSON_Writer_EndObject(&w);
+	JSON_Writer_Finish(&w);
+	return JSON_Writer_Detach(&w, outSize);
+}
+
+// Lots of little objects of short strings, like a scene or a config file.
+static char* MakeStringDoc(u32* outSize) {
+	JSON_Writer w;
+	JSON_Writer_Init(&w, 4);
+	JSON_Writer_BeginArray(&w);
+
+	for(u32 i = 0; i < 60000; i++) {
+		char buf[64];
+
+		JSON_Writer_BeginObject(&w);
+		JSON_Writer_Key(&w, "name");
+		snprintf(buf, sizeof(buf), "node_%u", i);
+		JSON_Writer_String(&w, buf);
+		JSON_Writer_Key(&w, "tags");
+		JSON_Writer_BeginArray(&w);
+		for(u32 t = 0; t < 8; t++) {
+			snprintf(buf, sizeof(buf), "t%u", Rand() % 64);
+			JSON_Writer_String(&w, buf);
+		}
+		JSON_Writer_EndArray(&w);
+		JSON_Writer_Key(&w, "path");
+		snprintf(buf, sizeof(buf), "res/models/%.*s.gltf", (i32) (Rand() % 24 + 4), "abcdefghijklmnopqrstuvwxyz0123");
+		JSON_Writer_String(&w, buf);
+		JSON_Writer_Key(&w, "flag");
+		JSON_Writer_Boolean(&w, Rand() & 1);
+		JSON_Writer_Key(&w, "id");
+		JSON_Writer_Integer(&w, i);
+		JSON_Writer_EndObject(&w);
+	}
+
+	JSON_Writer_EndArray(&w);
+	JSON_Writer_Finish(&w);
+	return JSON_Writer_Detach(&w, outSize);
+}
+
+// Best of `runs`, in seconds. Returns a negative time if the document doesn't read.
+static r64 TimeEvents(const char* str, u32 size, u32 runs) {
+	r64 best = 1e9;
+	for(u32 i = 0; i < runs; i++) {
+		JSON_Reader r;
+		enum JSON_Event e;
+
+		r64 start = Now();
+		JSON_Reader_Init(&r, str, size);
+		while((e = JSON_Reader_Next(&r)) > JSON_Event_End) {}
+		r64 t = Now() - start;
+
+		if(e != JSON_Event_End) return -1;
+		best = MIN(best, t);
+	}
+	return best;
+}
+
+static r64 TimeTree(const char* str, u32 size, u32 runs) {
+	r64 best = 1e9;
+	for(u32 i = 0; i < runs; i++) {
+		r64 start    = Now();
+		JSON_Value v = JSON_FromString_N(str, size);
+		r64 t        = Now() - start;
+
+		bool8 ok = v.Type != JSON_Error;
+		JSON_Free(&v);
+		if(!ok) return -1;
+		best = MIN(best, t);
+	}
+	return best;
+}
+
+static bool8 Bench(const char* name, const char* str, u32 size, u32 runs) {
+	r64 events = TimeEvents(str, size, runs);
+	r64 tree   = TimeTree(str, size, runs);
+	if(events < 0 || tree < 0) {
+		fprintf(stderr, "%s isn't valid JSON.\n", name);
+		return 0;
+	}
+
+	r64 mb = size / 1e6;
+	printf("%-24s %7.1f MB   events %7.1f ms (%6.1f MB/s)   tree %7.1f ms (%6.1f MB/s)\n",
+	       name,
+	       mb,
+	       events * 1e3,
+	       mb / events,
+	       tree * 1e3,
+	       mb / tree);
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	i32 runs       = 15;
+	bool8 anyFiles = 0;
+	bool8 ok       = 1;
+
+	for(i32 i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+			runs = atoi(argv[++i]);
+			runs = MAX(runs, 1);
+		} else if(argv[i][0] == '-') {
+			printf("Usage: jsonbench [--runs <n>] [file.json...]\n"
+			       "\n"
+			       "  Times reading every file as events with JSON_Reader and as a tree with\n"
+			       "  JSON_FromString_N(), best of <n> runs (15 by default). With no files it\n"
+			       "  makes up a float-heavy and a string-heavy document instead.\n");
+			return 1;
+		} else {
+			anyFiles = 1;
+		}
+	}
+
+	for(i32 i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--runs") == 0) {
+			i++;
+			continue;
+		}
+
+		u32 size;
+		u8* data = File_ReadToBuffer_Alloc(argv[i], &size);
+		if(!data) {
+			fprintf(stderr, "Couldn't read %s.\n", argv[i]);
+			ok = 0;
+			continue;
+		}
+		ok &= Bench(argv[i], (const char*) data, size, runs);
+		Free(data);
+	}
+
+	if(!anyFiles) {
+		u32 size;
+		char* doc = MakeFloatDoc(&size);
+		ok &= Bench("float-heavy", doc, size, runs);
+		Free(doc);
+
+		doc = MakeStringDoc(&size);
+		ok &= Bench("string-heavy", doc, size, runs);
+		Free(doc);
+	}
+
+	return !ok;
+}
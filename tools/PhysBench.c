@@ -0,0 +1,377 @@
+// PhysBench - how long PhysWorld_Update() takes, and whether stacks settle.
+//
+// The moving scene scatters unit cubes at about 1/8 density and moves them straight through
+// each other, bouncing off the walls of the space they're in, so the time is almost all
+// broadphase. A tenth of them are static. They can be bunched up into a few clusters instead,
+// be different sizes, or sit on a floor, to see which broadphase suits what.
+//
+// The other scenes drop boxes on the ground and let the solver stack them, then say when
+// everything fell asleep and whether energy ever went up. Build it with `make physbench`.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../GraphicsLib/Common.h"
+#include "../GraphicsLib/Phys.h"
+
+static const char* BroadphaseNames[] = {"sap", "tree", "grid"};
+static const char* SceneNames[]      = {"moving", "tower", "pyramid", "pile"};
+
+enum { Scene_Moving, Scene_Tower, Scene_Pyramid, Scene_Pile };
+
+typedef struct {
+	i32 Scene, Broadphase;
+	i32 Bodies, Frames, Check;
+	r32 Speed;
+	bool8 Clustered, Mixed, Floor;
+} Options;
+
+static u32 Seed = 1;
+
+static r32 RandFloat(void) {
+	Seed = Seed * 1664525u + 1013904223u;
+	return (Seed >> 8) / (r32) (1 << 24);
+}
+
+// Roughly normal, from -3 to 3.
+static r32 RandGauss(void) {
+	r32 sum = 0;
+	for(u32 i = 0; i < 6; i++) sum += RandFloat();
+	return sum - 3;
+}
+
+static r64 Now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static i32 ComparePairs(const void* a, const void* b) {
+	const PhysPair *x = a, *y = b;
+	if(x->A != y->A) return x->A < y->A ? -1 : 1;
+	return (x->B > y->B) - (x->B < y->B);
+}
+
+// Compare the world's pairs against every pair of boxes. Returns how many are wrong.
+// The tree finds pairs with fattened boxes, so pairs that don't really overlap are let off.
+static u32 CheckPairs(const PhysWorld* world) {
+	u32 n = world->Objects.Size, numPairs, numFound = 0;
+	const PhysPair* pairs = PhysWorld_GetPairs(world, &numPairs);
+
+	AABB* boxes = Allocate(sizeof(AABB) * n);
+	for(u32 i = 0; i < n; i++)
+		boxes[i] = AABB_ApplyTransform3D(world->Objects.Data[i].AABB, world->Objects.Data[i].Transform);
+
+	PhysPair* found = Allocate(sizeof(PhysPair) * (numPairs + 1));
+	for(u32 i = 0; i < numPairs; i++)
+		if(world->Broadphase != PhysBroadphase_Tree || AABB_Intersect(boxes[pairs[i].A], boxes[pairs[i].B]))
+			found[numFound++] = pairs[i];
+	qsort(found, numFound, sizeof(PhysPair), ComparePairs);
+
+	// Both lists come out sorted, so they're walked side by side.
+	u32 wrong = 0, next = 0;
+	for(u32 a = 0; a < n; a++) {
+		bool8 staticA = world->Objects.Data[a].Type == PhysObject_Static;
+		for(u32 b = a + 1; b < n; b++) {
+			if(staticA && world->Objects.Data[b].Type == PhysObject_Static) continue;
+			if(!AABB_Intersect(boxes[a], boxes[b])) continue;
+
+			while(next < numFound && (found[next].A < a || (found[next].A == a && found[next].B < b))) {
+				next++;
+				wrong++;
+			}
+			if(next < numFound && found[next].A == a && found[next].B == b)
+				next++;
+			else
+				wrong++;
+		}
+	}
+	wrong += numFound - next;
+
+	Free(boxes);
+	Free(found);
+	return wrong;
+}
+
+static void Usage() {
+	printf("Usage: physbench [options]\n"
+	       "\n"
+	       "  --scene <s>       moving by default, or tower (10 boxes), pyramid (55 boxes)\n"
+	       "                    or pile (144 boxes falling in a heap).\n"
+	       "  --frames <n>      How many updates to time after the first, 100 by default,\n"
+	       "                    or 1200 for the stacks.\n"
+	       "  --broadphase <b>  sap, tree or grid, sap by default.\n"
+	       "  --workers <n>     Start the job system with <n> workers, 0 for one per core.\n"
+	       "\n"
+	       "Only for the moving scene:\n"
+	       "  --bodies <n>      How many cubes, 10000 by default.\n"
+	       "  --speed <s>       Fastest speed along each axis in m/s, 3 by default.\n"
+	       "  --layout <l>      uniform, or clustered into 8 bunches. uniform by default.\n"
+	       "  --mixed           Cubes from 0.5 to 1.5 m across instead of all 1 m.\n"
+	       "  --floor           Put one big static box under everything.\n"
+	       "  --check <n>       Check the pairs against every pair of boxes every <n> frames.\n");
+}
+
+static bool8 RunMoving(const Options* opt) {
+	const r32 dt   = 1 / 60.0f;
+	const r32 side = cbrtf(opt->Bodies) * 2;
+
+	PhysWorld world;
+	PhysWorld_Init(&world);
+	world.Gravity    = 0;
+	world.Broadphase = opt->Broadphase;
+	Array_PhysObject_Prealloc(&world.Objects, opt->Bodies + opt->Floor);
+
+	// Velocities are kept here, rigid bodies without mass don't move by themselves.
+	Vec3* velocities = Allocate(sizeof(Vec3) * opt->Bodies);
+
+	Vec3 centres[8];
+	for(u32 k = 0; k < 8; k++) centres[k] = V3(RandFloat() * side, RandFloat() * side, RandFloat() * side);
+
+	for(i32 i = 0; i < opt->Bodies; i++) {
+		r32 half = opt->Mixed ? 0.25f + RandFloat() * 0.5f : 0.5f;
+
+		PhysObject o = {0};
+		o.Type       = i % 10 == 0 ? PhysObject_Static : PhysObject_RigidBody;
+		o.Transform  = Transform3D_Default;
+		o.AABB       = (AABB){.Min = V3(-half, -half, -half), .Max = V3(half, half, half)};
+
+		if(opt->Clustered) {
+			Vec3 c               = centres[i % 8];
+			r32 spread           = side * 0.08f;
+			o.Transform.Position = V3(c.x + RandGauss() * spread, c.y + RandGauss() * spread, c.z + RandGauss() * spread);
+		} else {
+			o.Transform.Position = V3(RandFloat() * side, RandFloat() * side, RandFloat() * side);
+		}
+		Array_PhysObject_Push(&world.Objects, &o);
+
+		velocities[i] = V3(0, 0, 0);
+		if(o.Type != PhysObject_Static)
+			velocities[i] = Vec3_MultScal(V3(RandFloat() * 2 - 1, RandFloat() * 2 - 1, RandFloat() * 2 - 1), opt->Speed);
+	}
+
+	if(opt->Floor) {
+		PhysObject o = {0};
+		o.Type       = PhysObject_Static;
+		o.Transform  = Transform3D_Default;
+		o.AABB       = (AABB){.Min = V3(-side, -1, -side), .Max = V3(side * 2, 0.2f, side * 2)};
+		Array_PhysObject_Push(&world.Objects, &o);
+	}
+
+	r64 start = Now();
+	PhysWorld_Update(&world, dt);
+	r64 first = Now() - start;
+
+	r64 total = 0;
+	u32 wrong = 0;
+	for(i32 f = 1; f <= opt->Frames; f++) {
+		for(i32 i = 0; i < opt->Bodies; i++) {
+			Vec3* p = &world.Objects.Data[i].Transform.Position;
+			r32* v  = velocities[i].d;
+			for(u32 k = 0; k < 3; k++) {
+				p->d[k] += v[k] * dt;
+				if((p->d[k] < 0 && v[k] < 0) || (p->d[k] > side && v[k] > 0)) v[k] = -v[k];
+			}
+		}
+
+		start = Now();
+		PhysWorld_Update(&world, dt);
+		total += Now() - start;
+
+		if(opt->Check && f % opt->Check == 0) wrong += CheckPairs(&world);
+	}
+
+	u32 numPairs;
+	PhysWorld_GetPairs(&world, &numPairs);
+	printf("%d bodies, %s: first update %.1f ms, then %.2f ms per update, %u pairs\n",
+	       opt->Bodies,
+	       BroadphaseNames[opt->Broadphase],
+	       first * 1e3,
+	       total * 1e3 / opt->Frames,
+	       numPairs);
+	if(opt->Check) printf("%u pairs were wrong.\n", wrong);
+
+	Free(velocities);
+	PhysWorld_Free(&world);
+
+	return wrong == 0;
+}
+
+static void AddBox(PhysWorld* world, bool8 dynamic, Vec3 position, Quat rotation, Vec3 halfExtents, r32 mass) {
+	PhysObject o         = {0};
+	o.Type               = dynamic ? PhysObject_RigidBody : PhysObject_Static;
+	o.Mass               = mass;
+	o.Friction           = 0.6f;
+	o.Transform          = Transform3D_Default;
+	o.Transform.Position = position;
+	o.Transform.Rotation = rotation;
+	o.Shape              = PhysShape_Box(halfExtents);
+	o.AABB               = PhysShape_AABB(&o.Shape);
+	Array_PhysObject_Push(&world->Objects, &o);
+}
+
+// Kinetic and potential energy of every rigid body, the same inertia the solver uses for boxes.
+static r64 Energy(const PhysWorld* world) {
+	r64 energy = 0;
+	for(u32 i = 0; i < world->Objects.Size; i++) {
+		const PhysObject* o = &world->Objects.Data[i];
+		if(o->Type != PhysObject_RigidBody) continue;
+
+		Vec3 h = o->Shape.HalfExtents;
+		r32 m  = o->Mass;
+
+		Vec3 inertia = V3(m / 3 * (h.y * h.y + h.z * h.z), m / 3 * (h.x * h.x + h.z * h.z), m / 3 * (h.x * h.x + h.y * h.y));
+
+		// The spin around the box's own axes.
+		Mat4 rot;
+		Mat4_RotateQuat(rot, Quat_Conjugate(o->Transform.Rotation));
+		Vec4 w = Mat4_MultVec4(rot, V4_V3(o->AngularVelocity, 0));
+
+		energy += 0.5 * m * Vec3_Dot(o->Velocity, o->Velocity);
+		energy += 0.5 * (inertia.x * w.x * w.x + inertia.y * w.y * w.y + inertia.z * w.z * w.z);
+		energy += m * world->Gravity * o->Transform.Position.y;
+	}
+	return energy;
+}
+
+static bool8 RunStack(const Options* opt) {
+	const r32 dt = 1 / 60.0f;
+
+	PhysWorld world;
+	PhysWorld_Init(&world);
+	world.Broadphase = opt->Broadphase;
+
+	Quat upright = Transform3D_Default.Rotation;
+	AddBox(&world, 0, V3(0, -0.5f, 0), upright, V3(50, 0.5f, 50), 0);
+
+	if(opt->Scene == Scene_Tower) {
+		for(u32 i = 0; i < 10; i++) AddBox(&world, 1, V3(0, 0.5f + i, 0), upright, V3(0.5f, 0.5f, 0.5f), 1);
+	} else if(opt->Scene == Scene_Pyramid) {
+		for(u32 row = 0; row < 10; row++)
+			for(u32 i = 0; i < 10 - row; i++)
+				AddBox(&world, 1, V3((i - (10 - row) / 2.0f) * 1.05f, 0.5f + row, 0), upright, V3(0.5f, 0.5f, 0.5f), 1);
+	} else {
+		// Boxes of all shapes, turned every which way and dropped from a little apart.
+		for(u32 layer = 0; layer < 4; layer++) {
+			for(u32 i = 0; i < 6; i++) {
+				for(u32 j = 0; j < 6; j++) {
+					Vec3 p = V3(i * 1.6f - 4 + RandFloat() * 0.2f, 1 + layer * 1.6f, j * 1.6f - 4 + RandFloat() * 0.2f);
+					Quat q = Quat_Norm((Quat){.x = RandFloat(), .y = RandFloat(), .z = RandFloat(), .w = 1});
+					AddBox(&world, 1, p, q, V3(0.3f + RandFloat() * 0.3f, 0.3f, 0.4f), 1 + (u32) (RandFloat() * 3));
+				}
+			}
+		}
+	}
+
+	u32 numBoxes = world.Objects.Size - 1;
+	r64 total    = 0, startEnergy = 0, maxEnergy = -1e30;
+	i32 sleptAt  = -1;
+
+	for(i32 f = 0; f <= opt->Frames; f++) {
+		r64 start = Now();
+		PhysWorld_Update(&world, dt);
+		if(f > 0) total += Now() - start;
+
+		// Energy comes in as the boxes first get pushed apart, it's only counted from there.
+		r64 energy = Energy(&world);
+		if(f == 0)
+			startEnergy = energy;
+		else
+			maxEnergy = MAX(maxEnergy, energy);
+
+		u32 asleep = 0;
+		for(u32 i = 1; i < world.Objects.Size; i++) asleep += world.Objects.Data[i].Asleep;
+		if(asleep == numBoxes && sleptAt < 0) sleptAt = f;
+	}
+
+	printf("%s, %u boxes, %s: %.1f us per update, ",
+	       SceneNames[opt->Scene],
+	       numBoxes,
+	       BroadphaseNames[opt->Broadphase],
+	       total * 1e6 / opt->Frames);
+	if(sleptAt >= 0)
+		printf("all asleep at frame %d\n", sleptAt);
+	else
+		printf("still awake after %d frames\n", opt->Frames);
+	printf("Energy started at %.2f J and went up to at most %.2f J.\n", startEnergy, maxEnergy);
+
+	PhysWorld_Free(&world);
+
+	return maxEnergy <= startEnergy;
+}
+
+int main(int argc, char** argv) {
+	Options opt = {.Scene = Scene_Moving, .Broadphase = PhysBroadphase_SweepAndPrune, .Bodies = 10000, .Speed = 3};
+	i32 workers = -1;
+
+	for(i32 i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			opt.Scene        = -1;
+			for(i32 s = 0; s < 4; s++)
+				if(strcmp(name, SceneNames[s]) == 0) opt.Scene = s;
+			if(opt.Scene < 0) {
+				fprintf(stderr, "Unknown scene %s.\n", name);
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--bodies") == 0 && i + 1 < argc) {
+			opt.Bodies = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			opt.Frames = atoi(argv[++i]);
+			if(opt.Frames < 1) {
+				Usage();
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+			opt.Speed = atof(argv[++i]);
+		} else if(strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			opt.Broadphase   = -1;
+			for(i32 b = 0; b < 3; b++)
+				if(strcmp(name, BroadphaseNames[b]) == 0) opt.Broadphase = b;
+			if(opt.Broadphase < 0) {
+				fprintf(stderr, "Unknown broadphase %s.\n", name);
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			if(strcmp(name, "uniform") == 0) {
+				opt.Clustered = 0;
+			} else if(strcmp(name, "clustered") == 0) {
+				opt.Clustered = 1;
+			} else {
+				fprintf(stderr, "Unknown layout %s.\n", name);
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--mixed") == 0) {
+			opt.Mixed = 1;
+		} else if(strcmp(argv[i], "--floor") == 0) {
+			opt.Floor = 1;
+		} else if(strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+			workers = atoi(argv[++i]);
+			workers = MAX(workers, 0);
+		} else if(strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+			opt.Check = atoi(argv[++i]);
+		} else {
+			Usage();
+			return 1;
+		}
+	}
+
+	if(opt.Bodies < 2 || opt.Check < 0) {
+		Usage();
+		return 1;
+	}
+	if(!opt.Frames) opt.Frames = opt.Scene == Scene_Moving ? 100 : 1200;
+
+	if(workers >= 0) Job_Init(workers);
+
+	bool8 ok = opt.Scene == Scene_Moving ? RunMoving(&opt) : RunStack(&opt);
+
+	if(workers >= 0) Job_Shutdown();
+
+	return !ok;
+}
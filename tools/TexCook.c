@@ -0,0 +1,180 @@
+// TexCook - turns images into .ktx files that load without any decoding.
+//
+// Every mip level gets made and compressed ahead of time, so loading one is
+// just handing the file to GL. Build it with `make texcook`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../GraphicsLib/Common.h"
+#include "../GraphicsLib/Image.h"
+#include "../GraphicsLib/stb_image.h"
+
+static const char* FormatNames[ImageFormat_Count] = {"r8", "rg8", "rgba8", "bc1", "bc3", "bc4", "bc5"};
+
+static void Usage() {
+	printf("Usage: texcook [options] <image> <output.ktx>\n"
+	       "\n"
+	       "  --format <fmt>  r8, rg8, rgba8, bc1, bc3, bc4 or bc5.\n"
+	       "                  Defaults to bc1 for opaque images and bc3 for ones with alpha.\n"
+	       "  --channel <c>   Take r8 or bc4 from r, g, b or a instead of red, bc4 by default.\n"
+	       "  --mask          Same as --channel a, and the texture reads back as (1, 1, 1, x),\n"
+	       "                  for font atlases and the like that only use alpha.\n"
+	       "  --srgb          The colours are sRGB, for rgba8, bc1 and bc3.\n"
+	       "  --linear        The colours aren't sRGB, they're data like normals, so mipmaps\n"
+	       "                  average them as they are. Otherwise rgba8, bc1 and bc3 mipmaps\n"
+	       "                  are averaged as linear light.\n"
+	       "  --filter <f>    box or kaiser for making mipmaps, kaiser by default.\n"
+	       "  --cutout <a>    Alpha is tested against <a> (0 to 1) rather than blended, so\n"
+	       "                  every mipmap keeps as many pixels above it as the full image.\n"
+	       "  --no-mips       Only write the full size image.\n");
+}
+
+int main(int argc, char** argv) {
+	const char *in = NULL, *out = NULL;
+	i32 format = -1, channel = -1;
+	bool8 mask = 0, srgb = 0, linear = 0, mips = 1;
+	Image_MipOptions mipOptions = {.Filter = ImageMipFilter_Kaiser};
+
+	for(i32 i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			for(i32 f = 0; f < ImageFormat_Count; f++)
+				if(strcmp(name, FormatNames[f]) == 0) format = f;
+			if(format < 0) {
+				fprintf(stderr, "Unknown format %s.\n", name);
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--channel") == 0 && i + 1 < argc) {
+			const char* c = strchr("rgba", argv[++i][0]);
+			if(!c || !argv[i][0] || argv[i][1]) {
+				fprintf(stderr, "The channel has to be r, g, b or a.\n");
+				return 1;
+			}
+			channel = c - "rgba";
+		} else if(strcmp(argv[i], "--mask") == 0) {
+			mask    = 1;
+			channel = 3;
+		} else if(strcmp(argv[i], "--srgb") == 0) {
+			srgb = 1;
+		} else if(strcmp(argv[i], "--linear") == 0) {
+			linear = 1;
+		} else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			if(strcmp(name, "box") == 0) {
+				mipOptions.Filter = ImageMipFilter_Box;
+			} else if(strcmp(name, "kaiser") == 0) {
+				mipOptions.Filter = ImageMipFilter_Kaiser;
+			} else {
+				fprintf(stderr, "Unknown filter %s.\n", name);
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--cutout") == 0 && i + 1 < argc) {
+			mipOptions.AlphaCutoff = atof(argv[++i]);
+			if(mipOptions.AlphaCutoff <= 0 || mipOptions.AlphaCutoff >= 1) {
+				fprintf(stderr, "The cutout has to be between 0 and 1.\n");
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--no-mips") == 0) {
+			mips = 0;
+		} else if(!in) {
+			in = argv[i];
+		} else if(!out) {
+			out = argv[i];
+		} else {
+			Usage();
+			return 1;
+		}
+	}
+
+	if(!in || !out) {
+		Usage();
+		return 1;
+	}
+
+	i32 w, h, nComp;
+	u8* pixels = stbi_load(in, &w, &h, &nComp, 4);
+	if(!pixels) {
+		fprintf(stderr, "Couldn't load %s: %s.\n", in, stbi_failure_reason());
+		return 1;
+	}
+
+	if(format < 0) {
+		bool8 opaque = 1;
+		for(i32 i = 0; i < w * h && opaque; i++) opaque = pixels[i * 4 + 3] == 255;
+		format = (mask || channel >= 0) ? ImageFormat_BC4 : opaque ? ImageFormat_BC1 : ImageFormat_BC3;
+	}
+
+	bool8 oneChannel = format == ImageFormat_R8 || format == ImageFormat_BC4;
+	if(mask && !oneChannel) {
+		fprintf(stderr, "--mask only goes with r8 or bc4.\n");
+		return 1;
+	}
+	if(channel >= 0 && !oneChannel) {
+		fprintf(stderr, "--channel only goes with r8 or bc4.\n");
+		return 1;
+	}
+	if(srgb && linear) {
+		fprintf(stderr, "--srgb and --linear don't go together.\n");
+		return 1;
+	}
+	if(srgb && format != ImageFormat_RGBA8 && format != ImageFormat_BC1 && format != ImageFormat_BC3) {
+		fprintf(stderr, "%s can't be sRGB.\n", FormatNames[format]);
+		return 1;
+	}
+
+	// Colours are nearly always sRGB, even when the texture doesn't say so.
+	mipOptions.SRGB = !linear && (format == ImageFormat_RGBA8 || format == ImageFormat_BC1 || format == ImageFormat_BC3);
+
+	Job_Init(0);
+	clock_t start = clock();
+
+	u32 numLevels = mips ? Image_NumLevels(w, h) : 1;
+
+	// Mipmaps are made from all four channels, the one that's wanted gets picked out after.
+	u8* pixelLevels[IMAGE_MAX_LEVELS] = {pixels};
+	if(!Image_GenMips(pixelLevels, w, h, 4, numLevels, &mipOptions)) {
+		fprintf(stderr, "Couldn't make mipmaps for %s, try --no-mips.\n", in);
+		stbi_image_free(pixels);
+		Job_Shutdown();
+		return 1;
+	}
+
+	u8* levels[IMAGE_MAX_LEVELS];
+	u32 total = 0;
+
+	for(u32 i = 0; i < numLevels; i++) {
+		u32 lw = MAX(w >> i, 1), lh = MAX(h >> i, 1);
+		u8* level = pixelLevels[i];
+
+		// Encoding always reads red first, so the channel that's wanted goes there.
+		if(channel > 0)
+			for(u32 p = 0; p < lw * lh; p++) level[p * 4] = level[p * 4 + channel];
+
+		levels[i] = Allocate(Image_Size(format, lw, lh));
+		Image_Encode(format, level, lw, lh, levels[i]);
+		total += Image_Size(format, lw, lh);
+
+		if(level != pixels) Free(level);
+	}
+
+	bool8 ok = Image_WriteKTX(out, format, srgb, mask ? "111r" : NULL, w, h, numLevels, (const u8* const*) levels);
+
+	printf("%s: %dx%d, %u levels of %s, %u KB of video memory instead of %u KB as RGBA8 (%.1f ms)\n",
+	       out,
+	       w,
+	       h,
+	       numLevels,
+	       FormatNames[format],
+	       total / 1024,
+	       (u32) (w * h * 4 * (mips ? 4 / 3.0 : 1)) / 1024,
+	       (clock() - start) * 1000.0 / CLOCKS_PER_SEC);
+
+	for(u32 i = 0; i < numLevels; i++) Free(levels[i]);
+	stbi_image_free(pixels);
+	Job_Shutdown();
+
+	return !ok;
+}
@@ -0,0 +1,313 @@
+// TriTriBench - checks TriTri_Intersect() against a slow but sure test, and times it
+// alone and four triangles at a time through TriTri_CountHits().
+//
+// Pairs of triangles are made up in a few families that used to go wrong: random ones,
+// ones lying in the same plane, and ones that only just touch at a corner or an edge.
+// Each pair is checked against a separating axis test done in doubles. The pairs can be
+// saved to a file and checked again later. Build it with `make tritribench`.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../GraphicsLib/Common.h"
+#include "../GraphicsLib/Phys.h"
+
+enum {
+	Family_Random,
+	Family_PlaneX, // All six corners on x = 3
+	Family_PlaneY, // y = 3
+	Family_PlaneZ, // z = 3
+	Family_Tilted, // x + y + z = 5
+	Family_Touching,
+	Family_Count,
+};
+
+static const char* FamilyNames[Family_Count] = {"random", "plane x = 3", "plane y = 3", "plane z = 3", "plane x+y+z = 5", "touching"};
+
+// As saved in a corpus file.
+typedef struct {
+	u32 Family;
+	Vec3 A[3], B[3];
+} TriPair;
+
+static u32 Seed = 7;
+
+static u32 Rand(void) {
+	Seed = Seed * 1664525u + 1013904223u;
+	return Seed >> 8;
+}
+
+static r32 RandFloat(void) { return Rand() / (r32) (1 << 24); }
+static Vec3 RandVec(void) { return V3(RandFloat() * 2 - 1, RandFloat() * 2 - 1, RandFloat() * 2 - 1); }
+static r32 RandGrid(void) { return (r32) (Rand() % 9) - 4; } // Whole numbers from -4 to 4
+
+static r64 Now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Apart from the random ones, corners are on whole or half numbers, so the reference gets them exactly.
+static void MakePair(TriPair* p, u32 family) {
+	p->Family = family;
+
+	if(family == Family_Random) {
+		for(u32 i = 0; i < 3; i++) {
+			p->A[i] = RandVec();
+			p->B[i] = RandVec();
+		}
+	} else if(family == Family_Touching) {
+		// B starts on one of A's corners or the middle of one of its edges.
+		for(u32 i = 0; i < 3; i++) p->A[i] = V3(RandGrid(), RandGrid(), RandGrid());
+		u32 k   = Rand() % 3;
+		p->B[0] = p->A[k];
+		if(Rand() & 1) p->B[0] = Vec3_MultScal(Vec3_Add(p->A[k], p->A[(k + 1) % 3]), 0.5f);
+		p->B[1] = V3(RandGrid(), RandGrid(), RandGrid());
+		p->B[2] = V3(RandGrid(), RandGrid(), RandGrid());
+	} else {
+		for(u32 i = 0; i < 6; i++) {
+			Vec3* v = i < 3 ? &p->A[i] : &p->B[i - 3];
+			r32 u   = RandGrid(), w = RandGrid();
+			if(family == Family_Tilted) {
+				*v = V3(u, w, 5 - u - w);
+			} else {
+				u32 axis             = family - Family_PlaneX;
+				v->d[axis]           = 3;
+				v->d[(axis + 1) % 3] = u;
+				v->d[(axis + 2) % 3] = w;
+			}
+		}
+	}
+}
+
+//
+// The reference, every axis that could separate two triangles, in doubles.
+//
+
+typedef struct {
+	r64 x, y, z;
+} DVec3;
+
+static DVec3 D3_Sub(DVec3 a, DVec3 b) { return (DVec3){a.x - b.x, a.y - b.y, a.z - b.z}; }
+static r64 D3_Dot(DVec3 a, DVec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+static DVec3 D3_Cross(DVec3 a, DVec3 b) {
+	return (DVec3){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+static bool8 Separates(DVec3 axis, const DVec3* a, const DVec3* b) {
+	if(D3_Dot(axis, axis) == 0) return 0;
+
+	r64 minA = INFINITY, maxA = -INFINITY, minB = INFINITY, maxB = -INFINITY;
+	for(u32 i = 0; i < 3; i++) {
+		r64 pa = D3_Dot(axis, a[i]), pb = D3_Dot(axis, b[i]);
+		minA   = MIN(minA, pa);
+		maxA   = MAX(maxA, pa);
+		minB   = MIN(minB, pb);
+		maxB   = MAX(maxB, pb);
+	}
+	return maxA < minB || maxB < minA;
+}
+
+// Triangles squashed into a line have no normal of their own, so the plane that the
+// family put them in is tried as well.
+static bool8 Reference(const TriPair* p) {
+	DVec3 a[3], b[3];
+	for(u32 i = 0; i < 3; i++) {
+		a[i] = (DVec3){p->A[i].x, p->A[i].y, p->A[i].z};
+		b[i] = (DVec3){p->B[i].x, p->B[i].y, p->B[i].z};
+	}
+
+	DVec3 plane = {p->Family == Family_PlaneX || p->Family == Family_Tilted,
+	               p->Family == Family_PlaneY || p->Family == Family_Tilted,
+	               p->Family == Family_PlaneZ || p->Family == Family_Tilted};
+
+	DVec3 ea[3] = {D3_Sub(a[1], a[0]), D3_Sub(a[2], a[1]), D3_Sub(a[0], a[2])};
+	DVec3 eb[3] = {D3_Sub(b[1], b[0]), D3_Sub(b[2], b[1]), D3_Sub(b[0], b[2])};
+	DVec3 na    = D3_Cross(ea[0], ea[1]);
+	DVec3 nb    = D3_Cross(eb[0], eb[1]);
+
+	if(Separates(na, a, b) || Separates(nb, a, b)) return 0;
+
+	for(u32 i = 0; i < 3; i++) {
+		for(u32 j = 0; j < 3; j++)
+			if(Separates(D3_Cross(ea[i], eb[j]), a, b)) return 0;
+
+		// In the plane, for triangles that lie in the same one.
+		if(Separates(D3_Cross(na, ea[i]), a, b) || Separates(D3_Cross(nb, eb[i]), a, b) ||
+		   Separates(D3_Cross(nb, ea[i]), a, b) || Separates(D3_Cross(na, eb[i]), a, b) ||
+		   Separates(D3_Cross(plane, ea[i]), a, b) || Separates(D3_Cross(plane, eb[i]), a, b) ||
+		   Separates(ea[i], a, b) || Separates(eb[i], a, b))
+			return 0;
+	}
+
+	return 1;
+}
+
+//
+// Checking and timing
+//
+
+static void PrintPair(const TriPair* p, bool8 got) {
+	const Vec3 *a = p->A, *b = p->B;
+	printf("  %s: got %s, a = (%g %g %g) (%g %g %g) (%g %g %g), b = (%g %g %g) (%g %g %g) (%g %g %g)\n",
+	       FamilyNames[p->Family],
+	       got ? "a hit" : "a miss",
+	       a[0].x, a[0].y, a[0].z, a[1].x, a[1].y, a[1].z, a[2].x, a[2].y, a[2].z,
+	       b[0].x, b[0].y, b[0].z, b[1].x, b[1].y, b[1].z, b[2].x, b[2].y, b[2].z);
+}
+
+// Returns how many pairs TriTri_Intersect() got wrong, the first few get printed.
+static u32 CheckPairs(const TriPair* pairs, u32 numPairs) {
+	u32 checked[Family_Count] = {0}, hits[Family_Count] = {0}, wrong[Family_Count] = {0};
+	u32 total = 0;
+
+	for(u32 i = 0; i < numPairs; i++) {
+		const TriPair* p = &pairs[i];
+		bool8 want       = Reference(p);
+		bool8 got        = TriTri_Intersect(p->A, p->B).Occurred;
+
+		checked[p->Family]++;
+		hits[p->Family] += want;
+		if(got != want) {
+			if(total++ < 10) PrintPair(p, got);
+			wrong[p->Family]++;
+		}
+	}
+
+	for(u32 f = 0; f < Family_Count; f++) {
+		if(!checked[f]) continue;
+		printf("%-16s %8u pairs, %8u hit, %u wrong\n", FamilyNames[f], checked[f], hits[f], wrong[f]);
+	}
+	return total;
+}
+
+static void PrintRate(const char* name, r64 numPairs, r64 elapsed, u32 hits) {
+	printf("%-8s %.0f pairs in %.1f ms, %.1f million pairs a second, %.1f%% hit\n",
+	       name,
+	       numPairs,
+	       elapsed * 1e3,
+	       numPairs / elapsed / 1e6,
+	       hits * 100 / numPairs);
+}
+
+// One triangle against lots of small ones around it, like a hull's BVH leaves. Times
+// TriTri_Intersect() on each pair, then TriTri_CountHits() four at a time.
+// Returns whether both found the same hits.
+static bool8 Throughput(u32 numQueries) {
+	enum { NumTris = 4096 };
+	static Vec3 tris[NumTris][3];
+	static TriHull_TriBlock blocks[NumTris / 4];
+	Vec3 queries[256][3];
+
+	for(u32 i = 0; i < NumTris; i++) {
+		Vec3 centre = Vec3_MultScal(RandVec(), 2);
+		for(u32 k = 0; k < 3; k++) tris[i][k] = Vec3_Add(centre, Vec3_MultScal(RandVec(), 0.3f));
+
+		TriHull_TriBlock* b = &blocks[i / 4];
+		for(u32 c = 0; c < 3; c++) {
+			b->V0[c][i % 4] = tris[i][0].d[c];
+			b->E1[c][i % 4] = tris[i][1].d[c] - tris[i][0].d[c];
+			b->E2[c][i % 4] = tris[i][2].d[c] - tris[i][0].d[c];
+		}
+	}
+	for(u32 i = 0; i < 256; i++)
+		for(u32 k = 0; k < 3; k++) queries[i][k] = Vec3_MultScal(RandVec(), 0.5f);
+
+	r64 numPairs = (r64) numQueries * NumTris;
+
+	u32 hits  = 0;
+	r64 start = Now();
+	for(u32 i = 0; i < numQueries; i++)
+		for(u32 j = 0; j < NumTris; j++) hits += TriTri_Intersect(queries[i % 256], tris[j]).Occurred;
+	PrintRate("scalar", numPairs, Now() - start, hits);
+
+	u32 blockHits = 0;
+	start         = Now();
+	for(u32 i = 0; i < numQueries; i++) blockHits += TriTri_CountHits(queries[i % 256], tris[0], blocks, NumTris);
+	PrintRate("blocks", numPairs, Now() - start, blockHits);
+
+	if(blockHits != hits) printf("The blocks found %u hits, one at a time found %u.\n", blockHits, hits);
+	return blockHits == hits;
+}
+
+static void Usage() {
+	printf("Usage: tritribench [options]\n"
+	       "\n"
+	       "  --pairs <n>    Pairs of each family to check, 100000 by default.\n"
+	       "  --save <file>  Write the pairs into a corpus file too.\n"
+	       "  --load <file>  Check the pairs in a corpus file instead of making new ones.\n"
+	       "  --time <n>     Time <n> triangles against 4096 others each, one pair at a time\n"
+	       "                 and four at a time, 200 by default. 0 skips the timing.\n");
+}
+
+int main(int argc, char** argv) {
+	i32 numEach = 100000, numQueries = 200;
+	const char *save = NULL, *load = NULL;
+
+	for(i32 i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--pairs") == 0 && i + 1 < argc) {
+			numEach = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+			save = argv[++i];
+		} else if(strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+			load = argv[++i];
+		} else if(strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+			numQueries = atoi(argv[++i]);
+		} else {
+			Usage();
+			return 1;
+		}
+	}
+
+	if(numEach < 1 || numQueries < 0) {
+		Usage();
+		return 1;
+	}
+
+	TriPair* pairs;
+	u32 numPairs;
+
+	if(load) {
+		u32 size;
+		u8* data = File_ReadToBuffer_Alloc(load, &size);
+		if(!data || size % sizeof(TriPair)) {
+			fprintf(stderr, "Couldn't read a corpus from %s.\n", load);
+			return 1;
+		}
+
+		pairs    = (TriPair*) data;
+		numPairs = size / sizeof(TriPair);
+		for(u32 i = 0; i < numPairs; i++) {
+			if(pairs[i].Family >= Family_Count) {
+				fprintf(stderr, "%s isn't a corpus, pair %u has no family.\n", load, i);
+				return 1;
+			}
+		}
+	} else {
+		numPairs = numEach * Family_Count;
+		pairs    = Allocate(sizeof(TriPair) * numPairs);
+		for(u32 i = 0; i < numPairs; i++) MakePair(&pairs[i], i / numEach);
+	}
+
+	if(save) {
+		FILE* f = fopen(save, "wb");
+		if(!f || fwrite(pairs, sizeof(TriPair), numPairs, f) != numPairs) {
+			fprintf(stderr, "Couldn't write %s.\n", save);
+			if(f) fclose(f);
+			return 1;
+		}
+		fclose(f);
+	}
+
+	u32 wrong = CheckPairs(pairs, numPairs);
+	Free(pairs);
+
+	bool8 same = 1;
+	if(numQueries) same = Throughput(numQueries);
+
+	return wrong != 0 || !same;
+}